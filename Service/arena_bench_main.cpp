@@ -0,0 +1,206 @@
+﻿/*!
+ * @brief 单页分析堆分配次数的对比工具 kpdf-arenabench。
+ *
+ * 用法：kpdf-arenabench [--page 页码] [--iterations N] 文件.pdf
+ *
+ * 与查看器读取页面几何的任务相同，对同一页反复执行注释与链接分析（PageAnnotations::load、
+ * PdfLinkIndex::load），分别使用直通模式的 arena（每个临时缓冲区单独向堆申请，即改用 arena 之前的行为）
+ * 和正常的 arena，输出每次分析的 operator new 次数、arena 服务的请求数与申请的块数以及耗时。
+ * 未指定页码时选择注释最多的一页。QString 的缓冲区由 Qt 以 malloc 分配，两种模式相同，不在统计之内。
+ *
+ * @author LiuYe
+ * @date 2026-10-19
+ * @copyright (c) 2013-2026 Honghu Yuntu Corporation
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+
+#include "annotation_index.h"
+#include "fpdf_annot.h"
+#include "monotonic_arena.h"
+#include "pdf_links.h"
+
+namespace
+{
+    std::atomic<long long> g_nHeapAllocations(0);
+
+    struct BenchResult
+    {
+        double dHeapAllocations;      // 每次分析的 operator new 次数
+        double dArenaRequests;        // 每次分析由 arena 服务的请求数
+        double dArenaChunks;          // 每次分析 arena 申请的块数
+        double dMicroseconds;         // 每次分析的耗时
+
+        BenchResult()
+            : dHeapAllocations(0.0), dArenaRequests(0.0), dArenaChunks(0.0), dMicroseconds(0.0)
+        {
+        }
+    };
+
+    // 分析一次页面，arena 在返回前销毁，与查看器的任务一致
+    void analyzePage(const FPDF_DOCUMENT pDocument, const FPDF_PAGE pPage, const bool bPassthrough,
+        size_t* pRequests, size_t* pChunks)
+    {
+        MonotonicArena scratch(bPassthrough);
+        PageAnnotations annotations;
+        PdfLinkIndex links;
+        annotations.load(pPage, &scratch);
+        links.load(pDocument, pPage, &scratch);
+        *pRequests += scratch.allocationCount();
+        *pChunks += scratch.chunkCount();
+    }
+
+    BenchResult runBench(const FPDF_DOCUMENT pDocument, const FPDF_PAGE pPage, const bool bPassthrough,
+        const int nIterations)
+    {
+        size_t nRequests = 0;
+        size_t nChunks = 0;
+        analyzePage(pDocument, pPage, bPassthrough, &nRequests, &nChunks); // 预热，排除 PDFium 的首次解析
+
+        nRequests = 0;
+        nChunks = 0;
+        const long long nHeapBefore = g_nHeapAllocations.load();
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (int i = 0; i < nIterations; ++i)
+        {
+            analyzePage(pDocument, pPage, bPassthrough, &nRequests, &nChunks);
+        }
+        const std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+
+        BenchResult result;
+        result.dHeapAllocations = static_cast<double>(g_nHeapAllocations.load() - nHeapBefore) / nIterations;
+        result.dArenaRequests = static_cast<double>(nRequests) / nIterations;
+        result.dArenaChunks = static_cast<double>(nChunks) / nIterations;
+        result.dMicroseconds = elapsed.count() / nIterations;
+        return result;
+    }
+
+    int busiestPage(const FPDF_DOCUMENT pDocument)
+    {
+        int nBest = 0;
+        int nBestCount = -1;
+        const int nPageCount = FPDF_GetPageCount(pDocument);
+        for (int i = 0; i < nPageCount; ++i)
+        {
+            const FPDF_PAGE pPage = FPDF_LoadPage(pDocument, i);
+            if (!pPage)
+            {
+                continue;
+            }
+            const int nCount = FPDFPage_GetAnnotCount(pPage);
+            if (nCount > nBestCount)
+            {
+                nBest = i;
+                nBestCount = nCount;
+            }
+            FPDF_ClosePage(pPage);
+        }
+        return nBest;
+    }
+
+    void printResult(const char* pLabel, const BenchResult& result)
+    {
+        std::cout << pLabel << ": " << result.dHeapAllocations << " heap allocations, " << result.dArenaRequests
+                  << " scratch requests, " << result.dArenaChunks << " chunks, " << result.dMicroseconds
+                  << " us per page\n";
+    }
+}
+
+void* operator new(const std::size_t nBytes)
+{
+    ++g_nHeapAllocations;
+    if (void* pMemory = std::malloc(nBytes ? nBytes : 1))
+    {
+        return pMemory;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](const std::size_t nBytes)
+{
+    return ::operator new(nBytes);
+}
+
+void operator delete(void* pMemory) noexcept
+{
+    std::free(pMemory);
+}
+
+void operator delete[](void* pMemory) noexcept
+{
+    std::free(pMemory);
+}
+
+int main(int argc, char* argv[])
+{
+    int nPage = -1;
+    int nIterations = 200;
+    const char* pFile = nullptr;
+    for (int i = 1; i < argc; ++i)
+    {
+        const bool bHasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--page") == 0 && bHasValue)
+        {
+            nPage = std::max(1, std::atoi(argv[++i])) - 1;
+        }
+        else if (std::strcmp(argv[i], "--iterations") == 0 && bHasValue)
+        {
+            nIterations = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (argv[i][0] == '-' || pFile)
+        {
+            pFile = nullptr;
+            break;
+        }
+        else
+        {
+            pFile = argv[i];
+        }
+    }
+    if (!pFile)
+    {
+        std::cerr << "usage: kpdf-arenabench [--page N] [--iterations N] FILE.pdf\n";
+        return 2;
+    }
+
+    FPDF_InitLibrary();
+    const FPDF_DOCUMENT pDocument = FPDF_LoadDocument(pFile, nullptr);
+    if (!pDocument)
+    {
+        std::cerr << pFile << ": failed to open (error " << FPDF_GetLastError() << ")\n";
+        FPDF_DestroyLibrary();
+        return 1;
+    }
+
+    if (nPage < 0)
+    {
+        nPage = busiestPage(pDocument);
+    }
+    const FPDF_PAGE pPage = FPDF_LoadPage(pDocument, nPage);
+    if (!pPage)
+    {
+        std::cerr << pFile << ": failed to load page " << nPage + 1 << '\n';
+        FPDF_CloseDocument(pDocument);
+        FPDF_DestroyLibrary();
+        return 1;
+    }
+
+    std::cout << "page " << nPage + 1 << ": " << FPDFPage_GetAnnotCount(pPage) << " annotations, " << nIterations
+              << " iterations\n";
+    const BenchResult heap = runBench(pDocument, pPage, true, nIterations);
+    const BenchResult arena = runBench(pDocument, pPage, false, nIterations);
+    printResult("without arena", heap);
+    printResult("with arena   ", arena);
+    std::cout << "heap allocations saved per page: " << heap.dHeapAllocations - arena.dHeapAllocations << '\n';
+
+    FPDF_ClosePage(pPage);
+    FPDF_CloseDocument(pDocument);
+    FPDF_DestroyLibrary();
+    return 0;
+}
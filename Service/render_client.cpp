@@ -0,0 +1,341 @@
+﻿/*!
+ * @brief 本地渲染服务同步客户端的实现。
+ *
+ * @author LiuYe
+ * @date 2026-10-19
+ * @copyright (c) 2013-2026 Honghu Yuntu Corporation
+ */
+
+#include "render_client.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace
+{
+    const char* statusText(const uint32_t nStatus)
+    {
+        switch (nStatus)
+        {
+        case ServiceOk:
+            return "ok";
+        case ServiceBadRequest:
+            return "bad request";
+        case ServiceUnknownDocument:
+            return "unknown document";
+        case ServiceOpenFailed:
+            return "open failed";
+        case ServicePageOutOfRange:
+            return "page out of range";
+        case ServiceRenderFailed:
+            return "render failed";
+        default:
+            return "unknown status";
+        }
+    }
+}
+
+RenderedPage::RenderedPage()
+    : m_nFd(-1), m_pPixels(nullptr), m_nBytes(0), m_nWidth(0), m_nHeight(0), m_nStride(0), m_bCached(false)
+{
+}
+
+RenderedPage::~RenderedPage()
+{
+    reset();
+}
+
+RenderedPage::RenderedPage(RenderedPage&& other)
+    : m_nFd(other.m_nFd), m_pPixels(other.m_pPixels), m_nBytes(other.m_nBytes), m_nWidth(other.m_nWidth),
+      m_nHeight(other.m_nHeight), m_nStride(other.m_nStride), m_bCached(other.m_bCached)
+{
+    other.m_nFd = -1;
+    other.m_pPixels = nullptr;
+}
+
+RenderedPage& RenderedPage::operator=(RenderedPage&& other)
+{
+    if (this != &other)
+    {
+        reset();
+        m_nFd = other.m_nFd;
+        m_pPixels = other.m_pPixels;
+        m_nBytes = other.m_nBytes;
+        m_nWidth = other.m_nWidth;
+        m_nHeight = other.m_nHeight;
+        m_nStride = other.m_nStride;
+        m_bCached = other.m_bCached;
+        other.m_nFd = -1;
+        other.m_pPixels = nullptr;
+    }
+    return *this;
+}
+
+void RenderedPage::reset()
+{
+    if (m_pPixels)
+    {
+        ::munmap(const_cast<uint8_t*>(m_pPixels), m_nBytes);
+        m_pPixels = nullptr;
+    }
+    if (m_nFd >= 0)
+    {
+        ::close(m_nFd);
+        m_nFd = -1;
+    }
+}
+
+DocumentMetadata::DocumentMetadata()
+    : nPageCount(0), nFileVersion(0)
+{
+}
+
+ServiceStatistics::ServiceStatistics()
+    : nDocuments(0), nCachedPages(0), nCacheBytes(0), nCacheHits(0), nCacheMisses(0), nRequests(0)
+{
+}
+
+RenderClient::RenderClient()
+    : m_nSocket(-1), m_nNextRequest(1), m_nStatus(ServiceOk)
+{
+}
+
+RenderClient::~RenderClient()
+{
+    disconnect();
+}
+
+bool RenderClient::connect(const std::string& strSocketPath)
+{
+    disconnect();
+
+    struct sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strSocketPath.size() >= sizeof(address.sun_path))
+    {
+        m_strError = "socket path too long";
+        return false;
+    }
+    std::strcpy(address.sun_path, strSocketPath.c_str());
+
+    m_nSocket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (m_nSocket < 0
+        || ::connect(m_nSocket, reinterpret_cast<const struct sockaddr*>(&address), sizeof(address)) != 0)
+    {
+        m_strError = strSocketPath + ": " + std::strerror(errno);
+        disconnect();
+        return false;
+    }
+    ::fcntl(m_nSocket, F_SETFD, FD_CLOEXEC);
+    return true;
+}
+
+void RenderClient::disconnect()
+{
+    if (m_nSocket >= 0)
+    {
+        ::close(m_nSocket);
+        m_nSocket = -1;
+    }
+}
+
+bool RenderClient::call(const uint16_t nType, const ServiceWriter& request, std::vector<uint8_t>& vecReply, int* pFd)
+{
+    m_nStatus = ServiceBadRequest;
+    if (m_nSocket < 0)
+    {
+        m_strError = "not connected";
+        return false;
+    }
+
+    const uint32_t nRequestId = m_nNextRequest++;
+    const ServiceFrameHeader header(nType, nRequestId, static_cast<uint32_t>(request.data().size()));
+    ServiceFrameHeader replyHeader;
+    int nFd = -1;
+    if (!sendServiceFrame(m_nSocket, header, request.data())
+        || !receiveServiceFrame(m_nSocket, replyHeader, vecReply, &nFd))
+    {
+        m_strError = "connection lost";
+        disconnect();
+        return false;
+    }
+    if (replyHeader.nType != (nType | kServiceReplyFlag) || replyHeader.nRequestId != nRequestId
+        || vecReply.size() < 4)
+    {
+        if (nFd >= 0)
+        {
+            ::close(nFd);
+        }
+        m_strError = "unexpected reply";
+        disconnect();
+        return false;
+    }
+
+    ServiceReader reader(vecReply);
+    m_nStatus = reader.readU32();
+    if (m_nStatus != ServiceOk)
+    {
+        if (nFd >= 0)
+        {
+            ::close(nFd);
+        }
+        const std::string strMessage = reader.readString();
+        m_strError = statusText(m_nStatus);
+        if (!strMessage.empty())
+        {
+            m_strError += ": " + strMessage;
+        }
+        return false;
+    }
+
+    vecReply.erase(vecReply.begin(), vecReply.begin() + 4);
+    if (pFd)
+    {
+        *pFd = nFd;
+    }
+    else if (nFd >= 0)
+    {
+        ::close(nFd);
+    }
+    m_strError.clear();
+    return true;
+}
+
+bool RenderClient::open(const std::string& strPath, const std::string& strPassword, uint64_t* pDocument,
+    uint32_t* pPageCount)
+{
+    ServiceWriter request;
+    request.writeString(strPath);
+    request.writeString(strPassword);
+    std::vector<uint8_t> vecReply;
+    if (!call(ServiceOpen, request, vecReply))
+    {
+        return false;
+    }
+    ServiceReader reader(vecReply);
+    *pDocument = reader.readU64();
+    const uint32_t nPageCount = reader.readU32();
+    if (pPageCount)
+    {
+        *pPageCount = nPageCount;
+    }
+    return reader.isValid();
+}
+
+bool RenderClient::close(const uint64_t nDocument)
+{
+    ServiceWriter request;
+    request.writeU64(nDocument);
+    std::vector<uint8_t> vecReply;
+    return call(ServiceClose, request, vecReply);
+}
+
+bool RenderClient::render(const uint64_t nDocument, const uint32_t nPage, const uint32_t nScalePercent,
+    const uint32_t nFlags, RenderedPage& page)
+{
+    page.reset();
+    ServiceWriter request;
+    request.writeU64(nDocument);
+    request.writeU32(nPage);
+    request.writeU32(nScalePercent);
+    request.writeU32(nFlags);
+    std::vector<uint8_t> vecReply;
+    int nFd = -1;
+    if (!call(ServiceRender, request, vecReply, &nFd))
+    {
+        return false;
+    }
+
+    ServiceReader reader(vecReply);
+    page.m_nFd = nFd;
+    page.m_nWidth = reader.readU32();
+    page.m_nHeight = reader.readU32();
+    page.m_nStride = reader.readU32();
+    const uint32_t nFormat = reader.readU32();
+    page.m_nBytes = reader.readU64();
+    page.m_bCached = reader.readU8() != 0;
+    if (!reader.isValid() || nFd < 0 || nFormat != ServicePixelBgrx
+        || page.m_nBytes < static_cast<uint64_t>(page.m_nStride) * page.m_nHeight)
+    {
+        m_strError = "malformed render reply";
+        page.reset();
+        return false;
+    }
+
+    void* pPixels = ::mmap(nullptr, page.m_nBytes, PROT_READ, MAP_SHARED, nFd, 0);
+    if (pPixels == MAP_FAILED)
+    {
+        m_strError = std::string("mmap: ") + std::strerror(errno);
+        page.reset();
+        return false;
+    }
+    page.m_pPixels = static_cast<const uint8_t*>(pPixels);
+    return true;
+}
+
+bool RenderClient::text(const uint64_t nDocument, const uint32_t nPage, std::string& strText)
+{
+    ServiceWriter request;
+    request.writeU64(nDocument);
+    request.writeU32(nPage);
+    std::vector<uint8_t> vecReply;
+    if (!call(ServiceText, request, vecReply))
+    {
+        return false;
+    }
+    ServiceReader reader(vecReply);
+    strText = reader.readString();
+    return reader.isValid();
+}
+
+bool RenderClient::metadata(const uint64_t nDocument, DocumentMetadata& metadata)
+{
+    ServiceWriter request;
+    request.writeU64(nDocument);
+    std::vector<uint8_t> vecReply;
+    if (!call(ServiceMetadata, request, vecReply))
+    {
+        return false;
+    }
+    ServiceReader reader(vecReply);
+    metadata.nPageCount = reader.readU32();
+    metadata.nFileVersion = reader.readU32();
+    const uint32_t nEntries = reader.readU32();
+    metadata.vecEntries.clear();
+    for (uint32_t i = 0; i < nEntries && reader.isValid(); ++i)
+    {
+        const std::string strKey = reader.readString();
+        metadata.vecEntries.push_back(std::make_pair(strKey, reader.readString()));
+    }
+    metadata.vecPageSizes.clear();
+    for (uint32_t i = 0; i < metadata.nPageCount && reader.isValid(); ++i)
+    {
+        const double dWidth = reader.readF64();
+        metadata.vecPageSizes.push_back(std::make_pair(dWidth, reader.readF64()));
+    }
+    return reader.isValid();
+}
+
+bool RenderClient::statistics(ServiceStatistics& statistics)
+{
+    std::vector<uint8_t> vecReply;
+    if (!call(ServiceStats, ServiceWriter(), vecReply))
+    {
+        return false;
+    }
+    ServiceReader reader(vecReply);
+    statistics.nDocuments = reader.readU32();
+    statistics.nCachedPages = reader.readU32();
+    statistics.nCacheBytes = reader.readU64();
+    statistics.nCacheHits = reader.readU64();
+    statistics.nCacheMisses = reader.readU64();
+    statistics.nRequests = reader.readU64();
+    return reader.isValid();
+}
@@ -0,0 +1,158 @@
+﻿/*!
+ * @brief 本地渲染服务的同步客户端。
+ *
+ * `RenderClient` 封装 service_protocol.h 中的请求，供命令行客户端、压测工具和其他内部工具链接使用。
+ * 渲染结果以 `RenderedPage` 返回，像素直接映射服务端的共享内存，析构时解除映射。
+ *
+ * 一个 `RenderClient` 对应一条连接，不能在多个线程中同时使用。
+ *
+ * @author LiuYe
+ * @date 2026-10-19
+ * @copyright (c) 2013-2026 Honghu Yuntu Corporation
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "service_protocol.h"
+
+/*!
+ * @brief 服务端渲染的页面，只读映射的 BGRx 像素。
+ *
+ * @date 2026.10.19
+ */
+class RenderedPage
+{
+public:
+    RenderedPage();
+    ~RenderedPage();
+
+    RenderedPage(RenderedPage&& other);
+    RenderedPage& operator=(RenderedPage&& other);
+
+    // 解除映射并关闭描述符
+    void reset();
+
+    bool isValid() const
+    {
+        return m_pPixels != nullptr;
+    }
+
+    const uint8_t* pixels() const
+    {
+        return m_pPixels;
+    }
+
+    uint32_t width() const
+    {
+        return m_nWidth;
+    }
+
+    uint32_t height() const
+    {
+        return m_nHeight;
+    }
+
+    uint32_t stride() const
+    {
+        return m_nStride;
+    }
+
+    // 是否命中服务端缓存
+    bool isCached() const
+    {
+        return m_bCached;
+    }
+
+    RenderedPage(const RenderedPage&) = delete;
+    RenderedPage& operator=(const RenderedPage&) = delete;
+
+private:
+    friend class RenderClient;
+
+    int m_nFd;
+    const uint8_t* m_pPixels;
+    uint64_t m_nBytes;
+    uint32_t m_nWidth;
+    uint32_t m_nHeight;
+    uint32_t m_nStride;
+    bool m_bCached;
+};
+
+/*!
+ * @brief 文档元数据。
+ */
+struct DocumentMetadata
+{
+    uint32_t nPageCount;
+    uint32_t nFileVersion;                                      // 例如 17 表示 PDF 1.7
+    std::vector<std::pair<std::string, std::string>> vecEntries; // Title、Author 等信息字典条目
+    std::vector<std::pair<double, double>> vecPageSizes;         // 各页宽、高（点）
+
+    DocumentMetadata();
+};
+
+/*!
+ * @brief 服务端统计。
+ */
+struct ServiceStatistics
+{
+    uint32_t nDocuments;
+    uint32_t nCachedPages;
+    uint64_t nCacheBytes;
+    uint64_t nCacheHits;
+    uint64_t nCacheMisses;
+    uint64_t nRequests;
+
+    ServiceStatistics();
+};
+
+/*!
+ * @brief 渲染服务客户端。请求失败时返回 false，原因见 lastError()。
+ *
+ * @date 2026.10.19
+ */
+class RenderClient
+{
+public:
+    RenderClient();
+    ~RenderClient();
+
+    bool connect(const std::string& strSocketPath = defaultServiceSocketPath());
+    void disconnect();
+
+    bool open(const std::string& strPath, const std::string& strPassword, uint64_t* pDocument,
+        uint32_t* pPageCount = nullptr);
+    bool close(uint64_t nDocument);
+    bool render(uint64_t nDocument, uint32_t nPage, uint32_t nScalePercent, uint32_t nFlags, RenderedPage& page);
+    bool text(uint64_t nDocument, uint32_t nPage, std::string& strText);
+    bool metadata(uint64_t nDocument, DocumentMetadata& metadata);
+    bool statistics(ServiceStatistics& statistics);
+
+    const std::string& lastError() const
+    {
+        return m_strError;
+    }
+
+    // 最近一次应答的状态码，连接或协议错误时为 ServiceBadRequest
+    uint32_t lastStatus() const
+    {
+        return m_nStatus;
+    }
+
+    RenderClient(const RenderClient&) = delete;
+    RenderClient& operator=(const RenderClient&) = delete;
+
+private:
+    // 发送请求并接收应答；成功时 vecReply 为状态码之后的负载
+    bool call(uint16_t nType, const ServiceWriter& request, std::vector<uint8_t>& vecReply, int* pFd = nullptr);
+
+    int m_nSocket;
+    uint32_t m_nNextRequest;
+    uint32_t m_nStatus;
+    std::string m_strError;
+};
@@ -0,0 +1,170 @@
+﻿/*!
+ * @brief 渲染服务命令行客户端 kpdf-client。
+ *
+ * 用法：
+ *     kpdf-client [--socket 路径] info 文件.pdf
+ *     kpdf-client [--socket 路径] render 文件.pdf 页码 [缩放百分比] 输出.ppm
+ *     kpdf-client [--socket 路径] text 文件.pdf 页码
+ *     kpdf-client [--socket 路径] stats
+ *
+ * 页码从 0 开始。渲染结果写成 PPM（P6），便于在脚本中比对。
+ *
+ * @author LiuYe
+ * @date 2026-10-19
+ * @copyright (c) 2013-2026 Honghu Yuntu Corporation
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "render_client.h"
+
+namespace
+{
+    int usage()
+    {
+        std::cerr << "usage: kpdf-client [--socket PATH] info FILE\n"
+                     "       kpdf-client [--socket PATH] render FILE PAGE [SCALE_PERCENT] OUT.ppm\n"
+                     "       kpdf-client [--socket PATH] text FILE PAGE\n"
+                     "       kpdf-client [--socket PATH] stats\n";
+        return 2;
+    }
+
+    int fail(const RenderClient& client)
+    {
+        std::cerr << "kpdf-client: " << client.lastError() << '\n';
+        return 1;
+    }
+
+    // BGRx 转为 PPM 的 RGB
+    bool writePpm(const RenderedPage& page, const std::string& strPath)
+    {
+        std::ofstream file(strPath.c_str(), std::ios::binary);
+        file << "P6\n" << page.width() << ' ' << page.height() << "\n255\n";
+        std::vector<char> vecRow(page.width() * 3);
+        for (uint32_t y = 0; y < page.height(); ++y)
+        {
+            const uint8_t* pPixel = page.pixels() + static_cast<size_t>(y) * page.stride();
+            for (uint32_t x = 0; x < page.width(); ++x, pPixel += 4)
+            {
+                vecRow[x * 3] = static_cast<char>(pPixel[2]);
+                vecRow[x * 3 + 1] = static_cast<char>(pPixel[1]);
+                vecRow[x * 3 + 2] = static_cast<char>(pPixel[0]);
+            }
+            file.write(&vecRow[0], static_cast<std::streamsize>(vecRow.size()));
+        }
+        return static_cast<bool>(file);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::string strSocket = defaultServiceSocketPath();
+    std::vector<std::string> vecArgs;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--socket") == 0 && i + 1 < argc)
+        {
+            strSocket = argv[++i];
+        }
+        else
+        {
+            vecArgs.push_back(argv[i]);
+        }
+    }
+    if (vecArgs.empty())
+    {
+        return usage();
+    }
+
+    RenderClient client;
+    if (!client.connect(strSocket))
+    {
+        return fail(client);
+    }
+
+    const std::string& strCommand = vecArgs[0];
+    if (strCommand == "stats")
+    {
+        ServiceStatistics statistics;
+        if (!client.statistics(statistics))
+        {
+            return fail(client);
+        }
+        std::cout << "documents: " << statistics.nDocuments << '\n'
+                  << "cached pages: " << statistics.nCachedPages << '\n'
+                  << "cache bytes: " << statistics.nCacheBytes << '\n'
+                  << "cache hits: " << statistics.nCacheHits << '\n'
+                  << "cache misses: " << statistics.nCacheMisses << '\n'
+                  << "requests: " << statistics.nRequests << '\n';
+        return 0;
+    }
+    if (vecArgs.size() < 2)
+    {
+        return usage();
+    }
+
+    uint64_t nDocument = 0;
+    uint32_t nPageCount = 0;
+    if (!client.open(vecArgs[1], std::string(), &nDocument, &nPageCount))
+    {
+        return fail(client);
+    }
+
+    if (strCommand == "info")
+    {
+        DocumentMetadata metadata;
+        if (!client.metadata(nDocument, metadata))
+        {
+            return fail(client);
+        }
+        std::cout << "pages: " << metadata.nPageCount << '\n'
+                  << "version: " << metadata.nFileVersion / 10 << '.' << metadata.nFileVersion % 10 << '\n';
+        for (size_t i = 0; i < metadata.vecEntries.size(); ++i)
+        {
+            std::cout << metadata.vecEntries[i].first << ": " << metadata.vecEntries[i].second << '\n';
+        }
+        for (size_t i = 0; i < metadata.vecPageSizes.size(); ++i)
+        {
+            std::cout << "page " << i << ": " << metadata.vecPageSizes[i].first << " x "
+                      << metadata.vecPageSizes[i].second << " pt\n";
+        }
+    }
+    else if (strCommand == "render" && (vecArgs.size() == 4 || vecArgs.size() == 5))
+    {
+        const uint32_t nPage = static_cast<uint32_t>(std::strtoul(vecArgs[2].c_str(), nullptr, 10));
+        const uint32_t nScale = vecArgs.size() == 5
+            ? static_cast<uint32_t>(std::strtoul(vecArgs[3].c_str(), nullptr, 10)) : 100;
+        RenderedPage page;
+        if (!client.render(nDocument, nPage, nScale, 0, page))
+        {
+            return fail(client);
+        }
+        if (!writePpm(page, vecArgs.back()))
+        {
+            std::cerr << "kpdf-client: failed to write " << vecArgs.back() << '\n';
+            return 1;
+        }
+        std::cout << page.width() << 'x' << page.height() << (page.isCached() ? " (cached)" : "") << '\n';
+    }
+    else if (strCommand == "text" && vecArgs.size() == 3)
+    {
+        std::string strText;
+        if (!client.text(nDocument, static_cast<uint32_t>(std::strtoul(vecArgs[2].c_str(), nullptr, 10)), strText))
+        {
+            return fail(client);
+        }
+        std::cout << strText << '\n';
+    }
+    else
+    {
+        return usage();
+    }
+
+    client.close(nDocument);
+    return 0;
+}
@@ -0,0 +1,199 @@
+﻿/*!
+ * @brief 渲染服务压测工具 kpdf-loadgen。
+ *
+ * 用法：kpdf-loadgen [--socket 路径] [--connections N] [--requests N] [--scale 百分比] [--seed N] 文件.pdf...
+ *
+ * 每条连接在独立线程中打开全部文档，随机选择文档和页码发送渲染请求，并读取返回像素的第一个
+ * 字节以确认共享内存可用。结束时输出吞吐量、延迟分位数以及服务端缓存命中率的变化。
+ *
+ * @author LiuYe
+ * @date 2026-10-19
+ * @copyright (c) 2013-2026 Honghu Yuntu Corporation
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "render_client.h"
+
+namespace
+{
+    struct LoadOptions
+    {
+        std::string strSocket;
+        int nConnections;
+        int nRequests;                // 每条连接的请求数
+        uint32_t nScalePercent;
+        unsigned int nSeed;
+        std::vector<std::string> vecFiles;
+
+        LoadOptions()
+            : strSocket(defaultServiceSocketPath()), nConnections(4), nRequests(200), nScalePercent(100), nSeed(1)
+        {
+        }
+    };
+
+    std::mutex g_oResultMutex;
+    std::vector<double> g_vecLatencies;   // 毫秒
+    std::atomic<int> g_nFailures(0);
+    std::atomic<int> g_nCached(0);
+
+    void runConnection(const LoadOptions& options, const int nIndex)
+    {
+        RenderClient client;
+        if (!client.connect(options.strSocket))
+        {
+            std::cerr << "connection " << nIndex << ": " << client.lastError() << '\n';
+            g_nFailures += options.nRequests;
+            return;
+        }
+
+        std::vector<std::pair<uint64_t, uint32_t>> vecDocuments;
+        for (size_t i = 0; i < options.vecFiles.size(); ++i)
+        {
+            uint64_t nDocument = 0;
+            uint32_t nPageCount = 0;
+            if (client.open(options.vecFiles[i], std::string(), &nDocument, &nPageCount) && nPageCount > 0)
+            {
+                vecDocuments.push_back(std::make_pair(nDocument, nPageCount));
+            }
+            else
+            {
+                std::cerr << options.vecFiles[i] << ": " << client.lastError() << '\n';
+            }
+        }
+        if (vecDocuments.empty())
+        {
+            g_nFailures += options.nRequests;
+            return;
+        }
+
+        std::mt19937 random(options.nSeed + static_cast<unsigned int>(nIndex));
+        std::vector<double> vecLatencies;
+        vecLatencies.reserve(static_cast<size_t>(options.nRequests));
+        volatile uint8_t nSink = 0;
+        for (int i = 0; i < options.nRequests; ++i)
+        {
+            const std::pair<uint64_t, uint32_t>& document = vecDocuments[random() % vecDocuments.size()];
+            const uint32_t nPage = static_cast<uint32_t>(random() % document.second);
+
+            const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            RenderedPage page;
+            if (!client.render(document.first, nPage, options.nScalePercent, 0, page))
+            {
+                ++g_nFailures;
+                if (!client.connect(options.strSocket))
+                {
+                    break;
+                }
+                continue;
+            }
+            nSink = nSink ^ page.pixels()[0];
+            const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            vecLatencies.push_back(elapsed.count());
+            g_nCached += page.isCached() ? 1 : 0;
+        }
+
+        std::lock_guard<std::mutex> lock(g_oResultMutex);
+        g_vecLatencies.insert(g_vecLatencies.end(), vecLatencies.begin(), vecLatencies.end());
+    }
+
+    double percentile(const std::vector<double>& vecSorted, const double dRatio)
+    {
+        if (vecSorted.empty())
+        {
+            return 0.0;
+        }
+        const size_t nIndex = std::min(vecSorted.size() - 1, static_cast<size_t>(dRatio * vecSorted.size()));
+        return vecSorted[nIndex];
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    LoadOptions options;
+    for (int i = 1; i < argc; ++i)
+    {
+        const bool bHasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--socket") == 0 && bHasValue)
+        {
+            options.strSocket = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--connections") == 0 && bHasValue)
+        {
+            options.nConnections = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--requests") == 0 && bHasValue)
+        {
+            options.nRequests = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--scale") == 0 && bHasValue)
+        {
+            options.nScalePercent = static_cast<uint32_t>(std::max(1, std::atoi(argv[++i])));
+        }
+        else if (std::strcmp(argv[i], "--seed") == 0 && bHasValue)
+        {
+            options.nSeed = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (argv[i][0] == '-')
+        {
+            options.vecFiles.clear();
+            break;
+        }
+        else
+        {
+            options.vecFiles.push_back(argv[i]);
+        }
+    }
+    if (options.vecFiles.empty())
+    {
+        std::cerr << "usage: kpdf-loadgen [--socket PATH] [--connections N] [--requests N] [--scale PERCENT] "
+                     "[--seed N] FILE.pdf...\n";
+        return 2;
+    }
+
+    RenderClient statsClient;
+    ServiceStatistics before;
+    const bool bStats = statsClient.connect(options.strSocket) && statsClient.statistics(before);
+
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::vector<std::thread> vecThreads;
+    for (int i = 0; i < options.nConnections; ++i)
+    {
+        vecThreads.push_back(std::thread(runConnection, std::cref(options), i));
+    }
+    for (size_t i = 0; i < vecThreads.size(); ++i)
+    {
+        vecThreads[i].join();
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::sort(g_vecLatencies.begin(), g_vecLatencies.end());
+    const size_t nDone = g_vecLatencies.size();
+    std::cout << "requests: " << nDone << " ok, " << g_nFailures.load() << " failed, " << g_nCached.load()
+              << " served from cache\n"
+              << "elapsed: " << elapsed.count() << " s, " << (elapsed.count() > 0 ? nDone / elapsed.count() : 0.0)
+              << " req/s\n"
+              << "latency ms: p50 " << percentile(g_vecLatencies, 0.50) << ", p95 "
+              << percentile(g_vecLatencies, 0.95) << ", p99 " << percentile(g_vecLatencies, 0.99) << ", max "
+              << (nDone ? g_vecLatencies.back() : 0.0) << '\n';
+
+    ServiceStatistics after;
+    if (bStats && statsClient.statistics(after))
+    {
+        const uint64_t nHits = after.nCacheHits - before.nCacheHits;
+        const uint64_t nMisses = after.nCacheMisses - before.nCacheMisses;
+        std::cout << "service cache: " << nHits << " hits, " << nMisses << " misses, " << after.nCachedPages
+                  << " pages / " << after.nCacheBytes / (1024 * 1024) << " MB resident\n";
+    }
+    return g_nFailures.load() == 0 ? 0 : 1;
+}
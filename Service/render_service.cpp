@@ -0,0 +1,785 @@
+﻿/*!
+ * @brief 无界面的本地渲染服务的实现。
+ *
+ * @author LiuYe
+ * @date 2026-10-19
+ * @copyright (c) 2013-2026 Honghu Yuntu Corporation
+ */
+
+#include "render_service.h"
+
+#include <QString>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "fpdf_doc.h"
+#include "fpdf_text.h"
+#include "pdf_document_registry.h"
+#include "pdfium_executor.h"
+#include "pdfium_utils.h"
+
+namespace
+{
+    // 单页位图的上限，防止恶意或错误的缩放耗尽内存
+    const qint64 kMaxRenderPixels = 256ll * 1024 * 1024 / 4;
+    const uint32_t kMaxScalePercent = 1600;
+    const uint32_t kAllowedRenderFlags = FPDF_ANNOT | FPDF_LCD_TEXT | FPDF_GRAYSCALE | FPDF_PRINTING
+        | FPDF_RENDER_NO_SMOOTHTEXT | FPDF_RENDER_NO_SMOOTHIMAGE | FPDF_RENDER_NO_SMOOTHPATH;
+
+    ServiceReply statusReply(const ServiceStatus eStatus, const std::string& strMessage = std::string())
+    {
+        ServiceWriter writer;
+        writer.writeU32(eStatus);
+        if (!strMessage.empty())
+        {
+            writer.writeString(strMessage);
+        }
+        ServiceReply reply;
+        reply.vecPayload = writer.data();
+        return reply;
+    }
+
+    /*!
+     * @brief 创建匿名共享内存。Linux 上使用可密封的 memfd，其他平台使用立即取消链接的 POSIX 共享内存。
+     */
+    int createSharedBuffer(const uint64_t nBytes)
+    {
+#if defined(__linux__) && defined(MFD_ALLOW_SEALING)
+        const int nFd = ::memfd_create("kpdf-render", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+#else
+        static std::atomic<unsigned> s_nSerial(0);
+        char aName[64];
+        std::snprintf(aName, sizeof(aName), "/kpdf-render-%d-%u", static_cast<int>(::getpid()), s_nSerial++);
+        const int nFd = ::shm_open(aName, O_RDWR | O_CREAT | O_EXCL, 0600);
+        if (nFd >= 0)
+        {
+            ::shm_unlink(aName);
+        }
+#endif
+        if (nFd < 0)
+        {
+            return -1;
+        }
+        if (::ftruncate(nFd, static_cast<off_t>(nBytes)) != 0)
+        {
+            ::close(nFd);
+            return -1;
+        }
+        return nFd;
+    }
+
+    // 禁止再修改内容和大小，客户端拿到的缓冲区与缓存中的完全一致
+    void sealSharedBuffer(const int nFd)
+    {
+#if defined(F_ADD_SEALS) && defined(F_SEAL_WRITE)
+        ::fcntl(nFd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL);
+#else
+        (void)nFd;
+#endif
+    }
+
+    std::string toStdString(const QString& strValue)
+    {
+        const QByteArray utf8 = strValue.toUtf8();
+        return std::string(utf8.constData(), static_cast<size_t>(utf8.size()));
+    }
+
+    // PDFium 返回的 UTF-16LE 字符串（含结尾的 0）
+    QString fromPdfiumUtf16(const std::vector<unsigned short>& vecBuffer)
+    {
+        size_t nLength = vecBuffer.size();
+        while (nLength > 0 && vecBuffer[nLength - 1] == 0)
+        {
+            --nLength;
+        }
+        return QString::fromUtf16(vecBuffer.empty() ? nullptr : &vecBuffer[0], static_cast<int>(nLength));
+    }
+}
+
+ServiceReply::ServiceReply()
+    : nFd(-1)
+{
+}
+
+RenderService::Options::Options()
+    : strSocketPath(defaultServiceSocketPath()), nSocketMode(0600), nCacheBytes(512ll * 1024 * 1024), nMaxDocuments(64),
+      nMaxConnections(64)
+{
+}
+
+RenderService::DocumentEntry::DocumentEntry()
+    : nOpenCount(0), nLastUsed(0)
+{
+}
+
+bool RenderService::RenderKey::operator<(const RenderKey& other) const
+{
+    if (nDocumentId != other.nDocumentId)
+    {
+        return nDocumentId < other.nDocumentId;
+    }
+    if (nPage != other.nPage)
+    {
+        return nPage < other.nPage;
+    }
+    if (nScalePercent != other.nScalePercent)
+    {
+        return nScalePercent < other.nScalePercent;
+    }
+    return nFlags < other.nFlags;
+}
+
+RenderService::RenderService(const Options& options)
+    : m_oOptions(options), m_nListenSocket(-1), m_nCacheBytes(0), m_nUseSerial(0), m_nCacheHits(0),
+      m_nCacheMisses(0), m_nRequests(0)
+{
+    m_aWakePipe[0] = -1;
+    m_aWakePipe[1] = -1;
+}
+
+RenderService::~RenderService()
+{
+    if (m_nListenSocket >= 0)
+    {
+        ::close(m_nListenSocket);
+    }
+    for (int i = 0; i < 2; ++i)
+    {
+        if (m_aWakePipe[i] >= 0)
+        {
+            ::close(m_aWakePipe[i]);
+        }
+    }
+}
+
+bool RenderService::listen(std::string& strError)
+{
+    struct sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (m_oOptions.strSocketPath.size() >= sizeof(address.sun_path))
+    {
+        strError = "socket path too long: " + m_oOptions.strSocketPath;
+        return false;
+    }
+    std::strcpy(address.sun_path, m_oOptions.strSocketPath.c_str());
+
+    if (::pipe(m_aWakePipe) != 0)
+    {
+        strError = std::string("pipe: ") + std::strerror(errno);
+        return false;
+    }
+    ::fcntl(m_aWakePipe[0], F_SETFD, FD_CLOEXEC);
+    ::fcntl(m_aWakePipe[1], F_SETFD, FD_CLOEXEC);
+
+    m_nListenSocket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (m_nListenSocket < 0)
+    {
+        strError = std::string("socket: ") + std::strerror(errno);
+        return false;
+    }
+    ::fcntl(m_nListenSocket, F_SETFD, FD_CLOEXEC);
+
+    // 残留的套接字文件：能连上说明已有服务在运行，否则删除后重新绑定
+    const int nProbe = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    const bool bInUse = nProbe >= 0
+        && ::connect(nProbe, reinterpret_cast<const struct sockaddr*>(&address), sizeof(address)) == 0;
+    if (nProbe >= 0)
+    {
+        ::close(nProbe);
+    }
+    if (bInUse)
+    {
+        strError = "another service is listening on " + m_oOptions.strSocketPath;
+        return false;
+    }
+    ::unlink(m_oOptions.strSocketPath.c_str());
+
+    if (::bind(m_nListenSocket, reinterpret_cast<const struct sockaddr*>(&address), sizeof(address)) != 0
+        || ::chmod(m_oOptions.strSocketPath.c_str(), m_oOptions.nSocketMode) != 0
+        || ::listen(m_nListenSocket, SOMAXCONN) != 0)
+    {
+        strError = m_oOptions.strSocketPath + ": " + std::strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+void RenderService::run()
+{
+    for (;;)
+    {
+        reapConnections(false);
+        size_t nConnections = 0;
+        {
+            std::lock_guard<std::mutex> lock(m_oConnectionsMutex);
+            nConnections = m_lstConnections.size();
+        }
+        // 连接数达到上限时不接受新连接，新连接留在监听队列中，较快地轮询等待已有连接结束
+        const bool bAccepting = nConnections < static_cast<size_t>(m_oOptions.nMaxConnections);
+
+        struct pollfd aPoll[2];
+        aPoll[0].fd = bAccepting ? m_nListenSocket : -1;
+        aPoll[0].events = POLLIN;
+        aPoll[0].revents = 0;
+        aPoll[1].fd = m_aWakePipe[0];
+        aPoll[1].events = POLLIN;
+        aPoll[1].revents = 0;
+        const int nReady = ::poll(aPoll, 2, bAccepting ? 1000 : 100);
+        if (nReady < 0 && errno != EINTR)
+        {
+            break;
+        }
+        if (nReady > 0 && (aPoll[1].revents & POLLIN))
+        {
+            break;
+        }
+
+        if (nReady <= 0 || !(aPoll[0].revents & POLLIN))
+        {
+            continue;
+        }
+
+        const int nSocket = ::accept(m_nListenSocket, nullptr, nullptr);
+        if (nSocket < 0)
+        {
+            continue;
+        }
+        ::fcntl(nSocket, F_SETFD, FD_CLOEXEC);
+
+        std::lock_guard<std::mutex> lock(m_oConnectionsMutex);
+        std::unique_ptr<Connection> pConnection(new Connection);
+        pConnection->nSocket = nSocket;
+        pConnection->bFinished = false;
+        Connection* pRaw = pConnection.get();
+        m_lstConnections.push_back(std::move(pConnection));
+        pRaw->oThread = std::thread(&RenderService::serveConnection, this, pRaw);
+    }
+
+    ::close(m_nListenSocket);
+    m_nListenSocket = -1;
+    ::unlink(m_oOptions.strSocketPath.c_str());
+    reapConnections(true);
+}
+
+void RenderService::stop()
+{
+    if (m_aWakePipe[1] >= 0)
+    {
+        const char c = 'q';
+        const ssize_t nWritten = ::write(m_aWakePipe[1], &c, 1);
+        (void)nWritten;
+    }
+}
+
+/*!
+ * @brief 回收已结束的连接线程；bAll 为 true 时先断开全部连接再全部回收。
+ */
+void RenderService::reapConnections(const bool bAll)
+{
+    std::list<std::unique_ptr<Connection>> lstFinished;
+    {
+        std::lock_guard<std::mutex> lock(m_oConnectionsMutex);
+        for (std::list<std::unique_ptr<Connection>>::iterator it = m_lstConnections.begin();
+            it != m_lstConnections.end();)
+        {
+            if (bAll)
+            {
+                ::shutdown((*it)->nSocket, SHUT_RDWR);
+            }
+            if (bAll || (*it)->bFinished)
+            {
+                lstFinished.push_back(std::move(*it));
+                it = m_lstConnections.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+    for (std::list<std::unique_ptr<Connection>>::iterator it = lstFinished.begin(); it != lstFinished.end(); ++it)
+    {
+        (*it)->oThread.join();
+        ::close((*it)->nSocket);
+    }
+}
+
+/*!
+ * @brief 连接线程：依次读取请求，交给执行线程处理，发回应答。
+ *
+ * 同一连接上的请求按顺序应答；不同连接的请求在执行线程上按到达顺序交错执行。
+ */
+void RenderService::serveConnection(Connection* pConnection)
+{
+    std::shared_ptr<OpenedDocuments> pOpened = std::make_shared<OpenedDocuments>();
+    ServiceFrameHeader header;
+    std::vector<uint8_t> vecPayload;
+    while (receiveServiceFrame(pConnection->nSocket, header, vecPayload))
+    {
+        const uint16_t nType = header.nType;
+        const std::vector<uint8_t> vecRequest = vecPayload;
+        const QFuture<ServiceReply> future = PdfiumExecutor::instance().run<ServiceReply>(
+            [this, nType, vecRequest, pOpened](QFutureInterface<ServiceReply>&)
+            {
+                return handleRequest(nType, vecRequest, *pOpened);
+            });
+        const ServiceReply reply = future.result();
+
+        const ServiceFrameHeader replyHeader(static_cast<uint16_t>(nType | kServiceReplyFlag), header.nRequestId,
+            static_cast<uint32_t>(reply.vecPayload.size()));
+        const bool bSent = sendServiceFrame(pConnection->nSocket, replyHeader, reply.vecPayload, reply.nFd);
+        if (reply.nFd >= 0)
+        {
+            ::close(reply.nFd);
+        }
+        if (!bSent)
+        {
+            break;
+        }
+    }
+
+    // 断开的客户端未关闭的文档视为关闭
+    PdfiumExecutor::instance().post([this, pOpened]()
+        {
+            releaseDocuments(*pOpened);
+        });
+    pConnection->bFinished = true;
+}
+
+ServiceReply RenderService::handleRequest(const uint16_t nType, const std::vector<uint8_t>& vecPayload,
+    OpenedDocuments& opened)
+{
+    ++m_nRequests;
+    ServiceReader reader(vecPayload);
+    switch (nType)
+    {
+    case ServiceOpen:
+        return handleOpen(reader, opened);
+    case ServiceClose:
+        return handleClose(reader, opened);
+    case ServiceRender:
+        return handleRender(reader, opened);
+    case ServiceText:
+        return handleText(reader, opened);
+    case ServiceMetadata:
+        return handleMetadata(reader, opened);
+    case ServiceStats:
+        return handleStats();
+    default:
+        return statusReply(ServiceBadRequest, "unknown message type");
+    }
+}
+
+/*!
+ * @brief 打开文档。同一文件已打开时共享同一文档，返回同一句柄。
+ *
+ * 加密文档例外：登记表中的文档可能是其他客户端以正确密码打开的，直接复用会绕过密码。
+ * 因此加密文档每次都以本次提供的密码重新打开（密码错误时打开失败），也不放入登记表。
+ */
+ServiceReply RenderService::handleOpen(ServiceReader& reader, OpenedDocuments& opened)
+{
+    const std::string strPath = reader.readString();
+    const std::string strPassword = reader.readString();
+    if (!reader.isValid() || strPath.empty())
+    {
+        return statusReply(ServiceBadRequest);
+    }
+
+    const QString strFile = QString::fromUtf8(strPath.c_str(), static_cast<int>(strPath.size()));
+    PdfDocumentPtr pDocument = PdfDocumentRegistry::instance().find(strFile);
+    if (pDocument && FPDF_GetSecurityHandlerRevision(pDocument->handle()) != -1)
+    {
+        pDocument.reset();
+    }
+    if (!pDocument)
+    {
+        pDocument = PdfDocument::create();
+        QString strError;
+        if (!pDocument->map(strFile, strError)
+            || !pDocument->load(QByteArray(strPassword.c_str(), static_cast<int>(strPassword.size())), strError))
+        {
+            return statusReply(ServiceOpenFailed, toStdString(strError));
+        }
+        if (FPDF_GetSecurityHandlerRevision(pDocument->handle()) == -1)
+        {
+            pDocument = PdfDocumentRegistry::instance().insert(pDocument);
+        }
+    }
+
+    DocumentEntry& entry = m_hashDocuments[pDocument->id()];
+    entry.pDocument = pDocument;
+    ++entry.nOpenCount;
+    entry.nLastUsed = ++m_nUseSerial;
+    opened.insert(pDocument->id());
+    evictDocuments();
+
+    ServiceWriter writer;
+    writer.writeU32(ServiceOk);
+    writer.writeU64(pDocument->id());
+    writer.writeU32(static_cast<uint32_t>(FPDF_GetPageCount(pDocument->handle())));
+    ServiceReply reply;
+    reply.vecPayload = writer.data();
+    return reply;
+}
+
+ServiceReply RenderService::handleClose(ServiceReader& reader, OpenedDocuments& opened)
+{
+    const quint64 nDocumentId = reader.readU64();
+    if (!reader.isValid())
+    {
+        return statusReply(ServiceBadRequest);
+    }
+    const OpenedDocuments::iterator it = opened.find(nDocumentId);
+    if (it == opened.end())
+    {
+        return statusReply(ServiceUnknownDocument);
+    }
+    opened.erase(it);
+    OpenedDocuments closed;
+    closed.insert(nDocumentId);
+    releaseDocuments(closed);
+    return statusReply(ServiceOk);
+}
+
+/*!
+ * @brief 渲染页面。缓存命中时直接复用共享内存，未命中时把页面直接渲染进新的共享内存。
+ */
+ServiceReply RenderService::handleRender(ServiceReader& reader, const OpenedDocuments& opened)
+{
+    RenderKey key;
+    key.nDocumentId = reader.readU64();
+    key.nPage = reader.readU32();
+    key.nScalePercent = reader.readU32();
+    key.nFlags = reader.readU32() & kAllowedRenderFlags;
+    if (!reader.isValid() || key.nScalePercent == 0 || key.nScalePercent > kMaxScalePercent)
+    {
+        return statusReply(ServiceBadRequest);
+    }
+    DocumentEntry* pEntry = openedDocument(key.nDocumentId, opened);
+    if (!pEntry)
+    {
+        return statusReply(ServiceUnknownDocument);
+    }
+    const FPDF_DOCUMENT pDocument = pEntry->pDocument->handle();
+    if (key.nPage >= static_cast<uint32_t>(FPDF_GetPageCount(pDocument)))
+    {
+        return statusReply(ServicePageOutOfRange);
+    }
+
+    ServiceReply reply;
+    const std::map<RenderKey, std::list<CachedRender>::iterator>::iterator itCached = m_mapRenders.find(key);
+    const CachedRender* pRender = nullptr;
+    CachedRender uncached;
+    bool bHit = false;
+    if (itCached != m_mapRenders.end())
+    {
+        ++m_nCacheHits;
+        bHit = true;
+        m_lstRenders.splice(m_lstRenders.begin(), m_lstRenders, itCached->second);
+        pRender = &*itCached->second;
+        reply.nFd = ::dup(pRender->nFd);
+    }
+    else
+    {
+        ++m_nCacheMisses;
+        const FPDF_PAGE page = FPDF_LoadPage(pDocument, static_cast<int>(key.nPage));
+        if (!page)
+        {
+            return statusReply(ServiceRenderFailed, "failed to load page");
+        }
+        const double dScale = key.nScalePercent / 100.0;
+        const int nWidth = std::max(1, static_cast<int>(FPDF_GetPageWidth(page) * dScale));
+        const int nHeight = std::max(1, static_cast<int>(FPDF_GetPageHeight(page) * dScale));
+        if (static_cast<qint64>(nWidth) * nHeight > kMaxRenderPixels)
+        {
+            FPDF_ClosePage(page);
+            return statusReply(ServiceBadRequest, "page too large at this scale");
+        }
+
+        uncached.key = key;
+        uncached.nWidth = static_cast<uint32_t>(nWidth);
+        uncached.nHeight = static_cast<uint32_t>(nHeight);
+        uncached.nStride = uncached.nWidth * 4;
+        uncached.nBytes = static_cast<uint64_t>(uncached.nStride) * uncached.nHeight;
+        uncached.nFd = createSharedBuffer(uncached.nBytes);
+        void* pPixels = uncached.nFd >= 0
+            ? ::mmap(nullptr, uncached.nBytes, PROT_READ | PROT_WRITE, MAP_SHARED, uncached.nFd, 0) : MAP_FAILED;
+        const bool bRendered = pPixels != MAP_FAILED
+            && renderPdfPageToBuffer(page, pPixels, nWidth, nHeight, static_cast<int>(uncached.nStride),
+                static_cast<int>(key.nFlags));
+        if (pPixels != MAP_FAILED)
+        {
+            ::munmap(pPixels, uncached.nBytes);
+        }
+        FPDF_ClosePage(page);
+        if (!bRendered)
+        {
+            if (uncached.nFd >= 0)
+            {
+                ::close(uncached.nFd);
+            }
+            return statusReply(ServiceRenderFailed, "failed to render page");
+        }
+        sealSharedBuffer(uncached.nFd);
+
+        if (static_cast<qint64>(uncached.nBytes) <= m_oOptions.nCacheBytes)
+        {
+            m_lstRenders.push_front(uncached);
+            m_mapRenders[key] = m_lstRenders.begin();
+            m_nCacheBytes += static_cast<qint64>(uncached.nBytes);
+            pRender = &m_lstRenders.front();
+            reply.nFd = ::dup(uncached.nFd);
+        }
+        else
+        {
+            // 超出整个预算的位图不缓存，描述符直接交给应答
+            pRender = &uncached;
+            reply.nFd = uncached.nFd;
+        }
+    }
+    pEntry->nLastUsed = ++m_nUseSerial;
+
+    ServiceWriter writer;
+    writer.writeU32(ServiceOk);
+    writer.writeU32(pRender->nWidth);
+    writer.writeU32(pRender->nHeight);
+    writer.writeU32(pRender->nStride);
+    writer.writeU32(ServicePixelBgrx);
+    writer.writeU64(pRender->nBytes);
+    writer.writeU8(bHit ? 1 : 0);
+    reply.vecPayload = writer.data();
+
+    // 刚发出的位图排在最前，不会在这里被淘汰
+    trimRenders();
+    return reply;
+}
+
+ServiceReply RenderService::handleText(ServiceReader& reader, const OpenedDocuments& opened)
+{
+    const quint64 nDocumentId = reader.readU64();
+    const uint32_t nPage = reader.readU32();
+    if (!reader.isValid())
+    {
+        return statusReply(ServiceBadRequest);
+    }
+    DocumentEntry* pEntry = openedDocument(nDocumentId, opened);
+    if (!pEntry)
+    {
+        return statusReply(ServiceUnknownDocument);
+    }
+    const FPDF_DOCUMENT pDocument = pEntry->pDocument->handle();
+    if (nPage >= static_cast<uint32_t>(FPDF_GetPageCount(pDocument)))
+    {
+        return statusReply(ServicePageOutOfRange);
+    }
+
+    const FPDF_PAGE page = FPDF_LoadPage(pDocument, static_cast<int>(nPage));
+    const FPDF_TEXTPAGE textPage = page ? FPDFText_LoadPage(page) : nullptr;
+    if (!textPage)
+    {
+        if (page)
+        {
+            FPDF_ClosePage(page);
+        }
+        return statusReply(ServiceRenderFailed, "failed to load page text");
+    }
+    const int nCount = FPDFText_CountChars(textPage);
+    std::vector<unsigned short> vecText(static_cast<size_t>(std::max(0, nCount)) + 1, 0);
+    if (nCount > 0)
+    {
+        FPDFText_GetText(textPage, 0, nCount, &vecText[0]);
+    }
+    FPDFText_ClosePage(textPage);
+    FPDF_ClosePage(page);
+    pEntry->nLastUsed = ++m_nUseSerial;
+
+    ServiceWriter writer;
+    writer.writeU32(ServiceOk);
+    writer.writeString(toStdString(fromPdfiumUtf16(vecText)));
+    ServiceReply reply;
+    reply.vecPayload = writer.data();
+    return reply;
+}
+
+ServiceReply RenderService::handleMetadata(ServiceReader& reader, const OpenedDocuments& opened)
+{
+    const quint64 nDocumentId = reader.readU64();
+    if (!reader.isValid())
+    {
+        return statusReply(ServiceBadRequest);
+    }
+    DocumentEntry* pEntry = openedDocument(nDocumentId, opened);
+    if (!pEntry)
+    {
+        return statusReply(ServiceUnknownDocument);
+    }
+    const FPDF_DOCUMENT pDocument = pEntry->pDocument->handle();
+    const int nPageCount = FPDF_GetPageCount(pDocument);
+    int nVersion = 0;
+    FPDF_GetFileVersion(pDocument, &nVersion);
+
+    static const char* const kTags[] =
+    {
+        "Title", "Author", "Subject", "Keywords", "Creator", "Producer", "CreationDate", "ModDate"
+    };
+    std::vector<std::pair<std::string, std::string>> vecEntries;
+    for (size_t i = 0; i < sizeof(kTags) / sizeof(kTags[0]); ++i)
+    {
+        const unsigned long nBytes = FPDF_GetMetaText(pDocument, kTags[i], nullptr, 0);
+        if (nBytes <= 2)
+        {
+            continue;
+        }
+        std::vector<unsigned short> vecBuffer((nBytes + 1) / 2, 0);
+        FPDF_GetMetaText(pDocument, kTags[i], &vecBuffer[0], nBytes);
+        vecEntries.push_back(std::make_pair(std::string(kTags[i]), toStdString(fromPdfiumUtf16(vecBuffer))));
+    }
+
+    ServiceWriter writer;
+    writer.writeU32(ServiceOk);
+    writer.writeU32(static_cast<uint32_t>(nPageCount));
+    writer.writeU32(static_cast<uint32_t>(nVersion));
+    writer.writeU32(static_cast<uint32_t>(vecEntries.size()));
+    for (size_t i = 0; i < vecEntries.size(); ++i)
+    {
+        writer.writeString(vecEntries[i].first);
+        writer.writeString(vecEntries[i].second);
+    }
+    for (int i = 0; i < nPageCount; ++i)
+    {
+        FS_SIZEF size;
+        size.width = 0.0f;
+        size.height = 0.0f;
+        FPDF_GetPageSizeByIndexF(pDocument, i, &size);
+        writer.writeF64(size.width);
+        writer.writeF64(size.height);
+    }
+    pEntry->nLastUsed = ++m_nUseSerial;
+
+    ServiceReply reply;
+    reply.vecPayload = writer.data();
+    return reply;
+}
+
+ServiceReply RenderService::handleStats()
+{
+    ServiceWriter writer;
+    writer.writeU32(ServiceOk);
+    writer.writeU32(static_cast<uint32_t>(m_hashDocuments.size()));
+    writer.writeU32(static_cast<uint32_t>(m_lstRenders.size()));
+    writer.writeU64(static_cast<uint64_t>(m_nCacheBytes));
+    writer.writeU64(m_nCacheHits);
+    writer.writeU64(m_nCacheMisses);
+    writer.writeU64(m_nRequests);
+    ServiceReply reply;
+    reply.vecPayload = writer.data();
+    return reply;
+}
+
+RenderService::DocumentEntry* RenderService::document(const quint64 nDocumentId)
+{
+    const QHash<quint64, DocumentEntry>::iterator it = m_hashDocuments.find(nDocumentId);
+    return it != m_hashDocuments.end() ? &it.value() : nullptr;
+}
+
+RenderService::DocumentEntry* RenderService::openedDocument(const quint64 nDocumentId, const OpenedDocuments& opened)
+{
+    return opened.count(nDocumentId) > 0 ? document(nDocumentId) : nullptr;
+}
+
+void RenderService::releaseDocuments(const OpenedDocuments& opened)
+{
+    for (OpenedDocuments::const_iterator it = opened.begin(); it != opened.end(); ++it)
+    {
+        DocumentEntry* pEntry = document(*it);
+        if (pEntry && pEntry->nOpenCount > 0)
+        {
+            --pEntry->nOpenCount;
+        }
+    }
+    evictDocuments();
+}
+
+/*!
+ * @brief 文档数超过上限时，关闭没有客户端打开、最久未使用的文档及其缓存位图。
+ */
+void RenderService::evictDocuments()
+{
+    while (m_hashDocuments.size() > m_oOptions.nMaxDocuments)
+    {
+        QHash<quint64, DocumentEntry>::iterator itOldest = m_hashDocuments.end();
+        for (QHash<quint64, DocumentEntry>::iterator it = m_hashDocuments.begin(); it != m_hashDocuments.end(); ++it)
+        {
+            if (it.value().nOpenCount == 0
+                && (itOldest == m_hashDocuments.end() || it.value().nLastUsed < itOldest.value().nLastUsed))
+            {
+                itOldest = it;
+            }
+        }
+        if (itOldest == m_hashDocuments.end())
+        {
+            return;
+        }
+        removeRenders(itOldest.key());
+        m_hashDocuments.erase(itOldest);
+    }
+}
+
+void RenderService::removeRenders(const quint64 nDocumentId)
+{
+    for (std::list<CachedRender>::iterator it = m_lstRenders.begin(); it != m_lstRenders.end();)
+    {
+        if (it->key.nDocumentId == nDocumentId)
+        {
+            ::close(it->nFd);
+            m_nCacheBytes -= static_cast<qint64>(it->nBytes);
+            m_mapRenders.erase(it->key);
+            it = m_lstRenders.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+// 超出预算时从最久未使用的位图开始淘汰；客户端已映射的内存在其解除映射前仍然有效
+void RenderService::trimRenders()
+{
+    while (m_nCacheBytes > m_oOptions.nCacheBytes && !m_lstRenders.empty())
+    {
+        const CachedRender& render = m_lstRenders.back();
+        ::close(render.nFd);
+        m_nCacheBytes -= static_cast<qint64>(render.nBytes);
+        m_mapRenders.erase(render.key);
+        m_lstRenders.pop_back();
+    }
+}
+
+void RenderService::releaseAll()
+{
+    PdfiumExecutor::instance().run<bool>([this](QFutureInterface<bool>&)
+        {
+            for (std::list<CachedRender>::iterator it = m_lstRenders.begin(); it != m_lstRenders.end(); ++it)
+            {
+                ::close(it->nFd);
+            }
+            m_lstRenders.clear();
+            m_mapRenders.clear();
+            m_nCacheBytes = 0;
+            m_hashDocuments.clear();
+            return true;
+        }).waitForFinished();
+}
@@ -0,0 +1,156 @@
+﻿/*!
+ * @brief 无界面的本地渲染服务。
+ *
+ * `RenderService` 在 Unix 域套接字上接受连接，按 service_protocol.h 中的协议应答打开、渲染、
+ * 取文本和取元数据请求。它复用桌面端的 PDFium 执行线程、文档映射和文档登记表：
+ * - 所有请求都在同一个 PDFium 执行线程上处理，服务状态只在该线程上访问，不需要加锁；
+ *   每个连接一个线程，只负责收发帧并等待执行线程的结果，连接数达到上限时暂停接受新连接；
+ * - 连接只能访问自己打开的文档；加密文档不在连接之间共享，每次打开都以提供的密码重新校验；
+ * - 文档在最后一个客户端关闭后仍保持打开，超过上限时才按最近使用顺序关闭；
+ * - 渲染结果写入密封的共享内存（memfd），按字节预算以 LRU 缓存，命中时直接把同一块内存的
+ *   描述符发给客户端，像素不经过套接字复制。
+ *
+ * @author LiuYe
+ * @date 2026-10-19
+ * @copyright (c) 2013-2026 Honghu Yuntu Corporation
+ */
+
+#pragma once
+
+#include <QHash>
+
+#include <atomic>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "pdf_document.h"
+#include "service_protocol.h"
+
+/*!
+ * @brief 一次请求的应答：负载与可选的共享内存描述符（由发送方发送后关闭）。
+ */
+struct ServiceReply
+{
+    std::vector<uint8_t> vecPayload;
+    int nFd;
+
+    ServiceReply();
+};
+
+/*!
+ * @brief 本地渲染服务。
+ *
+ * @date 2026.10.19
+ */
+class RenderService
+{
+public:
+    struct Options
+    {
+        std::string strSocketPath;
+        unsigned int nSocketMode;     // 套接字文件权限
+        qint64 nCacheBytes;           // 渲染缓存的内存预算
+        int nMaxDocuments;            // 保持打开的文档上限
+        int nMaxConnections;          // 同时服务的连接上限，每个连接占用一个线程
+
+        Options();
+    };
+
+    explicit RenderService(const Options& options);
+    ~RenderService();
+
+    // 创建并监听套接字；已有服务在同一路径上运行时失败
+    bool listen(std::string& strError);
+
+    // 接受连接直到 stop()，返回前断开全部连接并等待连接线程结束
+    void run();
+
+    // 请求 run() 返回，可在信号处理函数中调用
+    void stop();
+
+    // 关闭全部文档并释放渲染缓存，应在执行线程停止前调用
+    void releaseAll();
+
+    RenderService(const RenderService&) = delete;
+    RenderService& operator=(const RenderService&) = delete;
+
+private:
+    struct Connection
+    {
+        std::thread oThread;
+        int nSocket;
+        std::atomic<bool> bFinished;
+    };
+
+    struct RenderKey
+    {
+        quint64 nDocumentId;
+        uint32_t nPage;
+        uint32_t nScalePercent;
+        uint32_t nFlags;
+
+        bool operator<(const RenderKey& other) const;
+    };
+
+    struct CachedRender
+    {
+        RenderKey key;
+        int nFd;                      // 密封的共享内存
+        uint32_t nWidth;
+        uint32_t nHeight;
+        uint32_t nStride;
+        uint64_t nBytes;
+    };
+
+    struct DocumentEntry
+    {
+        PdfDocumentPtr pDocument;
+        int nOpenCount;               // 各连接未关闭的 Open 次数
+        quint64 nLastUsed;
+
+        DocumentEntry();
+    };
+
+    typedef std::multiset<quint64> OpenedDocuments;
+
+    void serveConnection(Connection* pConnection);
+    void reapConnections(bool bAll);
+
+    // 以下函数只在执行线程上调用
+    ServiceReply handleRequest(uint16_t nType, const std::vector<uint8_t>& vecPayload, OpenedDocuments& opened);
+    ServiceReply handleOpen(ServiceReader& reader, OpenedDocuments& opened);
+    ServiceReply handleClose(ServiceReader& reader, OpenedDocuments& opened);
+    ServiceReply handleRender(ServiceReader& reader, const OpenedDocuments& opened);
+    ServiceReply handleText(ServiceReader& reader, const OpenedDocuments& opened);
+    ServiceReply handleMetadata(ServiceReader& reader, const OpenedDocuments& opened);
+    ServiceReply handleStats();
+    DocumentEntry* document(quint64 nDocumentId);
+    // 请求中的文档编号只在本连接打开过时有效，其他连接打开的文档视为不存在
+    DocumentEntry* openedDocument(quint64 nDocumentId, const OpenedDocuments& opened);
+    void releaseDocuments(const OpenedDocuments& opened);
+    void evictDocuments();
+    void removeRenders(quint64 nDocumentId);
+    void trimRenders();
+
+    Options m_oOptions;
+    int m_nListenSocket;
+    int m_aWakePipe[2];
+    std::mutex m_oConnectionsMutex;
+    std::list<std::unique_ptr<Connection>> m_lstConnections;
+
+    // 执行线程上的状态
+    QHash<quint64, DocumentEntry> m_hashDocuments;
+    std::list<CachedRender> m_lstRenders;                                   // 最近使用的在前
+    std::map<RenderKey, std::list<CachedRender>::iterator> m_mapRenders;
+    qint64 m_nCacheBytes;
+    quint64 m_nUseSerial;
+    quint64 m_nCacheHits;
+    quint64 m_nCacheMisses;
+    quint64 m_nRequests;
+};
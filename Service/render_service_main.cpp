@@ -0,0 +1,101 @@
+﻿/*!
+ * @brief 本地渲染服务 kpdf-renderd 的入口。
+ *
+ * 用法：kpdf-renderd [--socket 路径] [--socket-mode 八进制权限] [--cache-mb 兆字节] [--max-documents 数量]
+ *                   [--max-connections 数量]
+ *
+ * 收到 SIGINT/SIGTERM 后断开全部连接，关闭文档并退出。
+ *
+ * @author LiuYe
+ * @date 2026-10-19
+ * @copyright (c) 2013-2026 Honghu Yuntu Corporation
+ */
+
+#include <algorithm>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include "pdfium_executor.h"
+#include "pdfium_runtime.h"
+#include "render_service.h"
+
+namespace
+{
+    RenderService* g_pService = nullptr;
+
+    void onSignal(int)
+    {
+        if (g_pService)
+        {
+            g_pService->stop();
+        }
+    }
+
+    void printUsage()
+    {
+        std::cerr << "usage: kpdf-renderd [--socket PATH] [--socket-mode OCTAL] [--cache-mb N] [--max-documents N]\n"
+                     "                    [--max-connections N]\n";
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    RenderService::Options options;
+    for (int i = 1; i < argc; ++i)
+    {
+        const bool bHasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--socket") == 0 && bHasValue)
+        {
+            options.strSocketPath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--socket-mode") == 0 && bHasValue)
+        {
+            options.nSocketMode = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 8));
+        }
+        else if (std::strcmp(argv[i], "--cache-mb") == 0 && bHasValue)
+        {
+            options.nCacheBytes = std::atoll(argv[++i]) * 1024 * 1024;
+        }
+        else if (std::strcmp(argv[i], "--max-documents") == 0 && bHasValue)
+        {
+            options.nMaxDocuments = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--max-connections") == 0 && bHasValue)
+        {
+            options.nMaxConnections = std::max(1, std::atoi(argv[++i]));
+        }
+        else
+        {
+            printUsage();
+            return 2;
+        }
+    }
+
+    {
+        RenderService service(options);
+        std::string strError;
+        if (!service.listen(strError))
+        {
+            std::cerr << "kpdf-renderd: " << strError << '\n';
+            return 1;
+        }
+
+        g_pService = &service;
+        std::signal(SIGINT, onSignal);
+        std::signal(SIGTERM, onSignal);
+        std::signal(SIGPIPE, SIG_IGN);
+
+        std::cerr << "kpdf-renderd: listening on " << options.strSocketPath << '\n';
+        service.run();
+        g_pService = nullptr;
+
+        service.releaseAll();
+    }
+
+    // 文档在执行线程上依次关闭，最后一个文档关闭时销毁 PDFium 库
+    PdfiumRuntime::instance().shutdown();
+    PdfiumExecutor::instance().shutdown();
+    return 0;
+}
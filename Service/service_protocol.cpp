@@ -0,0 +1,362 @@
+﻿/*!
+ * @brief 本地渲染服务二进制协议的实现。
+ *
+ * @author LiuYe
+ * @date 2026-10-19
+ * @copyright (c) 2013-2026 Honghu Yuntu Corporation
+ */
+
+#include "service_protocol.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace
+{
+    const size_t kHeaderSize = 16;
+
+    void putU16(uint8_t* p, const uint16_t nValue)
+    {
+        p[0] = static_cast<uint8_t>(nValue);
+        p[1] = static_cast<uint8_t>(nValue >> 8);
+    }
+
+    void putU32(uint8_t* p, const uint32_t nValue)
+    {
+        for (int i = 0; i < 4; ++i)
+        {
+            p[i] = static_cast<uint8_t>(nValue >> (8 * i));
+        }
+    }
+
+    uint16_t getU16(const uint8_t* p)
+    {
+        return static_cast<uint16_t>(p[0] | (p[1] << 8));
+    }
+
+    uint32_t getU32(const uint8_t* p)
+    {
+        uint32_t nValue = 0;
+        for (int i = 3; i >= 0; --i)
+        {
+            nValue = (nValue << 8) | p[i];
+        }
+        return nValue;
+    }
+
+    void encodeHeader(const ServiceFrameHeader& header, uint8_t* p)
+    {
+        putU32(p, header.nMagic);
+        putU16(p + 4, header.nVersion);
+        putU16(p + 6, header.nType);
+        putU32(p + 8, header.nRequestId);
+        putU32(p + 12, header.nLength);
+    }
+
+    void closePassedFds(struct msghdr& message)
+    {
+        for (struct cmsghdr* pControl = CMSG_FIRSTHDR(&message); pControl; pControl = CMSG_NXTHDR(&message, pControl))
+        {
+            if (pControl->cmsg_level == SOL_SOCKET && pControl->cmsg_type == SCM_RIGHTS)
+            {
+                const size_t nCount = (pControl->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+                for (size_t i = 0; i < nCount; ++i)
+                {
+                    int nFd = -1;
+                    std::memcpy(&nFd, CMSG_DATA(pControl) + i * sizeof(int), sizeof(int));
+                    ::close(nFd);
+                }
+            }
+        }
+    }
+
+    /*!
+     * @brief 读满 nSize 字节；期间收到的第一个描述符写入 *pPassedFd，多余的关闭。
+     */
+    bool receiveFully(const int nSocket, uint8_t* pBuffer, size_t nSize, int* pPassedFd)
+    {
+        while (nSize > 0)
+        {
+            struct iovec vector;
+            vector.iov_base = pBuffer;
+            vector.iov_len = nSize;
+
+            union
+            {
+                struct cmsghdr header;
+                char aBuffer[CMSG_SPACE(sizeof(int))];
+            } control;
+
+            struct msghdr message;
+            std::memset(&message, 0, sizeof(message));
+            message.msg_iov = &vector;
+            message.msg_iovlen = 1;
+            message.msg_control = control.aBuffer;
+            message.msg_controllen = sizeof(control.aBuffer);
+
+            int nFlags = 0;
+#ifdef MSG_CMSG_CLOEXEC
+            nFlags |= MSG_CMSG_CLOEXEC;
+#endif
+            const ssize_t nRead = ::recvmsg(nSocket, &message, nFlags);
+            if (nRead < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (nRead <= 0)
+            {
+                closePassedFds(message);
+                return false;
+            }
+
+            const struct cmsghdr* pControl = CMSG_FIRSTHDR(&message);
+            if (pControl && pControl->cmsg_level == SOL_SOCKET && pControl->cmsg_type == SCM_RIGHTS
+                && pPassedFd && *pPassedFd < 0 && pControl->cmsg_len >= CMSG_LEN(sizeof(int)))
+            {
+                std::memcpy(pPassedFd, CMSG_DATA(pControl), sizeof(int));
+            }
+            else
+            {
+                closePassedFds(message);
+            }
+            pBuffer += nRead;
+            nSize -= static_cast<size_t>(nRead);
+        }
+        return true;
+    }
+}
+
+ServiceFrameHeader::ServiceFrameHeader()
+    : nMagic(kServiceProtocolMagic), nVersion(kServiceProtocolVersion), nType(0), nRequestId(0), nLength(0)
+{
+}
+
+ServiceFrameHeader::ServiceFrameHeader(const uint16_t nMessageType, const uint32_t nRequest,
+    const uint32_t nPayloadLength)
+    : nMagic(kServiceProtocolMagic), nVersion(kServiceProtocolVersion), nType(nMessageType), nRequestId(nRequest),
+      nLength(nPayloadLength)
+{
+}
+
+void ServiceWriter::writeU8(const uint8_t nValue)
+{
+    m_vecData.push_back(nValue);
+}
+
+void ServiceWriter::writeU32(const uint32_t nValue)
+{
+    for (int i = 0; i < 4; ++i)
+    {
+        m_vecData.push_back(static_cast<uint8_t>(nValue >> (8 * i)));
+    }
+}
+
+void ServiceWriter::writeU64(const uint64_t nValue)
+{
+    for (int i = 0; i < 8; ++i)
+    {
+        m_vecData.push_back(static_cast<uint8_t>(nValue >> (8 * i)));
+    }
+}
+
+void ServiceWriter::writeF64(const double dValue)
+{
+    uint64_t nBits = 0;
+    std::memcpy(&nBits, &dValue, sizeof(nBits));
+    writeU64(nBits);
+}
+
+void ServiceWriter::writeString(const std::string& strValue)
+{
+    writeU32(static_cast<uint32_t>(strValue.size()));
+    m_vecData.insert(m_vecData.end(), strValue.begin(), strValue.end());
+}
+
+ServiceReader::ServiceReader(const uint8_t* pData, const size_t nSize)
+    : m_pData(pData), m_nSize(nSize), m_nOffset(0), m_bValid(true)
+{
+}
+
+ServiceReader::ServiceReader(const std::vector<uint8_t>& vecData)
+    : m_pData(vecData.empty() ? nullptr : &vecData[0]), m_nSize(vecData.size()), m_nOffset(0), m_bValid(true)
+{
+}
+
+bool ServiceReader::take(const size_t nBytes, const uint8_t** ppData)
+{
+    if (!m_bValid || m_nSize - m_nOffset < nBytes)
+    {
+        m_bValid = false;
+        return false;
+    }
+    *ppData = m_pData + m_nOffset;
+    m_nOffset += nBytes;
+    return true;
+}
+
+uint8_t ServiceReader::readU8()
+{
+    const uint8_t* p = nullptr;
+    return take(1, &p) ? p[0] : 0;
+}
+
+uint32_t ServiceReader::readU32()
+{
+    const uint8_t* p = nullptr;
+    return take(4, &p) ? getU32(p) : 0;
+}
+
+uint64_t ServiceReader::readU64()
+{
+    const uint8_t* p = nullptr;
+    if (!take(8, &p))
+    {
+        return 0;
+    }
+    return static_cast<uint64_t>(getU32(p)) | (static_cast<uint64_t>(getU32(p + 4)) << 32);
+}
+
+double ServiceReader::readF64()
+{
+    const uint64_t nBits = readU64();
+    double dValue = 0.0;
+    std::memcpy(&dValue, &nBits, sizeof(dValue));
+    return dValue;
+}
+
+std::string ServiceReader::readString()
+{
+    const uint32_t nLength = readU32();
+    const uint8_t* p = nullptr;
+    if (!take(nLength, &p))
+    {
+        return std::string();
+    }
+    return std::string(reinterpret_cast<const char*>(p), nLength);
+}
+
+/*!
+ * @brief 帧头与负载在一次 sendmsg 中发出，描述符附在第一段数据上；未发完的部分继续发送。
+ */
+bool sendServiceFrame(const int nSocket, const ServiceFrameHeader& header, const std::vector<uint8_t>& vecPayload,
+    const int nPassFd)
+{
+    uint8_t aHeader[kHeaderSize];
+    encodeHeader(header, aHeader);
+
+    struct iovec aVectors[2];
+    aVectors[0].iov_base = aHeader;
+    aVectors[0].iov_len = kHeaderSize;
+    aVectors[1].iov_base = vecPayload.empty() ? nullptr : const_cast<uint8_t*>(&vecPayload[0]);
+    aVectors[1].iov_len = vecPayload.size();
+
+    union
+    {
+        struct cmsghdr header;
+        char aBuffer[CMSG_SPACE(sizeof(int))];
+    } control;
+
+    struct msghdr message;
+    std::memset(&message, 0, sizeof(message));
+    message.msg_iov = aVectors;
+    message.msg_iovlen = vecPayload.empty() ? 1 : 2;
+    if (nPassFd >= 0)
+    {
+        std::memset(control.aBuffer, 0, sizeof(control.aBuffer));
+        message.msg_control = control.aBuffer;
+        message.msg_controllen = sizeof(control.aBuffer);
+        struct cmsghdr* pControl = CMSG_FIRSTHDR(&message);
+        pControl->cmsg_level = SOL_SOCKET;
+        pControl->cmsg_type = SCM_RIGHTS;
+        pControl->cmsg_len = CMSG_LEN(sizeof(int));
+        std::memcpy(CMSG_DATA(pControl), &nPassFd, sizeof(int));
+    }
+
+    int nFlags = 0;
+#ifdef MSG_NOSIGNAL
+    nFlags |= MSG_NOSIGNAL;
+#endif
+    size_t nRemaining = kHeaderSize + vecPayload.size();
+    while (nRemaining > 0)
+    {
+        const ssize_t nSent = ::sendmsg(nSocket, &message, nFlags);
+        if (nSent < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (nSent <= 0)
+        {
+            return false;
+        }
+        nRemaining -= static_cast<size_t>(nSent);
+
+        // 描述符只随第一段发送；跳过已发送的数据
+        message.msg_control = nullptr;
+        message.msg_controllen = 0;
+        size_t nSkip = static_cast<size_t>(nSent);
+        while (message.msg_iovlen > 0 && nSkip >= message.msg_iov[0].iov_len)
+        {
+            nSkip -= message.msg_iov[0].iov_len;
+            ++message.msg_iov;
+            --message.msg_iovlen;
+        }
+        if (message.msg_iovlen > 0)
+        {
+            message.msg_iov[0].iov_base = static_cast<uint8_t*>(message.msg_iov[0].iov_base) + nSkip;
+            message.msg_iov[0].iov_len -= nSkip;
+        }
+    }
+    return true;
+}
+
+bool receiveServiceFrame(const int nSocket, ServiceFrameHeader& header, std::vector<uint8_t>& vecPayload,
+    int* pPassedFd)
+{
+    int nPassedFd = -1;
+    uint8_t aHeader[kHeaderSize];
+    bool bOk = receiveFully(nSocket, aHeader, kHeaderSize, &nPassedFd);
+    if (bOk)
+    {
+        header.nMagic = getU32(aHeader);
+        header.nVersion = getU16(aHeader + 4);
+        header.nType = getU16(aHeader + 6);
+        header.nRequestId = getU32(aHeader + 8);
+        header.nLength = getU32(aHeader + 12);
+        bOk = header.nMagic == kServiceProtocolMagic && header.nVersion == kServiceProtocolVersion
+            && header.nLength <= kServiceMaxPayload;
+    }
+    if (bOk)
+    {
+        vecPayload.resize(header.nLength);
+        bOk = header.nLength == 0 || receiveFully(nSocket, &vecPayload[0], header.nLength, &nPassedFd);
+    }
+
+    if (!bOk || !pPassedFd)
+    {
+        if (nPassedFd >= 0)
+        {
+            ::close(nPassedFd);
+        }
+        nPassedFd = -1;
+    }
+    if (pPassedFd)
+    {
+        *pPassedFd = nPassedFd;
+    }
+    return bOk;
+}
+
+std::string defaultServiceSocketPath()
+{
+    const char* pRuntimeDir = std::getenv("XDG_RUNTIME_DIR");
+    if (pRuntimeDir && *pRuntimeDir)
+    {
+        return std::string(pRuntimeDir) + "/kpdf-render.sock";
+    }
+    return "/tmp/kpdf-render-" + std::to_string(static_cast<unsigned long>(::getuid())) + ".sock";
+}
@@ -0,0 +1,156 @@
+﻿/*!
+ * @brief 本地渲染服务的二进制协议。
+ *
+ * 客户端与 `kpdf-renderd` 通过 Unix 域套接字交换帧。每帧由 16 字节帧头和负载组成，整数均为小端序：
+ *
+ *     uint32 magic        'KPRS'
+ *     uint16 version      kServiceProtocolVersion
+ *     uint16 type         ServiceMessageType，应答在请求类型上置 kServiceReplyFlag
+ *     uint32 requestId    应答原样带回
+ *     uint32 length       负载字节数，不超过 kServiceMaxPayload
+ *
+ * 应答负载以 uint32 状态码（ServiceStatus）开头，成功时其后为各消息的结果。字符串编码为
+ * uint32 长度加 UTF-8 字节。渲染结果的像素不在负载中传输：服务端把位图放在共享内存中，
+ * 以 SCM_RIGHTS 随应答帧传递只读的文件描述符，客户端 mmap 即可读取。
+ *
+ * 各消息的负载：
+ * - Open      请求：string 路径、string 密码；应答：uint64 文档句柄、uint32 页数
+ * - Close     请求：uint64 文档句柄；应答：无
+ * - Render    请求：uint64 文档句柄、uint32 页码、uint32 缩放百分比、uint32 渲染标志（FPDF_ANNOT 等）；
+ *             应答：uint32 宽、uint32 高、uint32 行字节数、uint32 像素格式、uint64 缓冲区字节数、
+ *             uint8 是否命中缓存，附带共享内存描述符
+ * - Text      请求：uint64 文档句柄、uint32 页码；应答：string 页面文本
+ * - Metadata  请求：uint64 文档句柄；应答：uint32 页数、uint32 文件版本、uint32 条目数及各条目的
+ *             string 键与 string 值、各页 float64 宽与高（点）
+ * - Stats     请求：无；应答：uint32 文档数、uint32 缓存位图数、uint64 缓存字节数、uint64 命中数、
+ *             uint64 未命中数、uint64 请求总数
+ *
+ * 本文件只依赖 POSIX，客户端和压测工具不需要 Qt 与 PDFium。
+ *
+ * @author LiuYe
+ * @date 2026-10-19
+ * @copyright (c) 2013-2026 Honghu Yuntu Corporation
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+const uint32_t kServiceProtocolMagic = 0x5352504B;    // 字节序列 "KPRS"
+const uint16_t kServiceProtocolVersion = 1;
+const uint16_t kServiceReplyFlag = 0x8000;
+const uint32_t kServiceMaxPayload = 16 * 1024 * 1024;
+
+enum ServiceMessageType
+{
+    ServiceOpen = 1,
+    ServiceClose = 2,
+    ServiceRender = 3,
+    ServiceText = 4,
+    ServiceMetadata = 5,
+    ServiceStats = 6
+};
+
+enum ServiceStatus
+{
+    ServiceOk = 0,
+    ServiceBadRequest = 1,            // 帧或负载格式错误、未知消息
+    ServiceUnknownDocument = 2,       // 文档句柄无效或已被淘汰
+    ServiceOpenFailed = 3,
+    ServicePageOutOfRange = 4,
+    ServiceRenderFailed = 5
+};
+
+// 渲染结果的像素格式
+enum ServicePixelFormat
+{
+    ServicePixelBgrx = 1              // 每像素 4 字节，依次为 B、G、R、未用
+};
+
+/*!
+ * @brief 帧头。
+ */
+struct ServiceFrameHeader
+{
+    uint32_t nMagic;
+    uint16_t nVersion;
+    uint16_t nType;
+    uint32_t nRequestId;
+    uint32_t nLength;
+
+    ServiceFrameHeader();
+    ServiceFrameHeader(uint16_t nMessageType, uint32_t nRequest, uint32_t nPayloadLength);
+};
+
+/*!
+ * @brief 负载编码。
+ *
+ * @date 2026.10.19
+ */
+class ServiceWriter
+{
+public:
+    void writeU8(uint8_t nValue);
+    void writeU32(uint32_t nValue);
+    void writeU64(uint64_t nValue);
+    void writeF64(double dValue);
+    void writeString(const std::string& strValue);
+
+    const std::vector<uint8_t>& data() const
+    {
+        return m_vecData;
+    }
+
+private:
+    std::vector<uint8_t> m_vecData;
+};
+
+/*!
+ * @brief 负载解码，越界后所有读取返回 0 且 isValid() 为 false。
+ *
+ * @date 2026.10.19
+ */
+class ServiceReader
+{
+public:
+    ServiceReader(const uint8_t* pData, size_t nSize);
+    explicit ServiceReader(const std::vector<uint8_t>& vecData);
+
+    uint8_t readU8();
+    uint32_t readU32();
+    uint64_t readU64();
+    double readF64();
+    std::string readString();
+
+    bool isValid() const
+    {
+        return m_bValid;
+    }
+
+    bool atEnd() const
+    {
+        return m_nOffset == m_nSize;
+    }
+
+private:
+    bool take(size_t nBytes, const uint8_t** ppData);
+
+    const uint8_t* m_pData;
+    size_t m_nSize;
+    size_t m_nOffset;
+    bool m_bValid;
+};
+
+// 发送一帧；nPassFd 不为 -1 时以 SCM_RIGHTS 随帧传递该描述符
+bool sendServiceFrame(int nSocket, const ServiceFrameHeader& header, const std::vector<uint8_t>& vecPayload,
+    int nPassFd = -1);
+
+// 接收一帧；随帧传来的描述符写入 *pPassedFd（没有时为 -1），由调用方关闭
+bool receiveServiceFrame(int nSocket, ServiceFrameHeader& header, std::vector<uint8_t>& vecPayload,
+    int* pPassedFd = nullptr);
+
+// 默认套接字路径：$XDG_RUNTIME_DIR/kpdf-render.sock，未设置时为 /tmp/kpdf-render-<uid>.sock
+std::string defaultServiceSocketPath();
@@ -0,0 +1,248 @@
+﻿/*!
+ * @brief 注释列表排序与过滤引擎的实现。
+ *
+ * 排序与过滤都在调用线程内一次完成，调用方已把它们放到后台线程执行，这里不再向线程池
+ * 派发子任务并阻塞等待，以免占满线程池后互相等待。比较只读取构建记录时预计算好的排序键，
+ * 不会在比较过程中解析文本或转换大小写。
+ *
+ * @author LiuYe
+ * @date 2026-10-19
+ * @copyright (c) 2013-2026 Honghu Yuntu Corporation
+ */
+
+#include "AnnotationSortFilter.h"
+
+#include <QColor>
+
+#include <algorithm>
+
+namespace
+{
+    // 颜色排序键：色相在最高位，其次饱和度和亮度；无彩色排在最前
+    quint32 colorSortKey(const QColor& color)
+    {
+        int h = 0;
+        int s = 0;
+        int v = 0;
+        color.getHsv(&h, &s, &v);
+        return (static_cast<quint32>(h + 1) << 16) | (static_cast<quint32>(s) << 8) | static_cast<quint32>(v);
+    }
+
+    template <typename T>
+    int compareValue(const T& a, const T& b)
+    {
+        return a < b ? -1 : (b < a ? 1 : 0);
+    }
+}
+
+AnnotationRecord::AnnotationRecord()
+    : nPage(-1), bHasColor(false), color(0), nColorKey(0), dLength(0.0)
+{
+}
+
+AnnotationFilter::AnnotationFilter()
+    : nPageMin(-1), nPageMax(-1), bColor(false), color(0)
+{
+}
+
+/*!
+ * @brief 判断过滤条件是否为空，即所有记录都能通过。
+ */
+bool AnnotationFilter::isEmpty() const
+{
+    return strGroup.isEmpty() && nPageMin < 0 && nPageMax < 0 && !bColor && strText.isEmpty();
+}
+
+bool AnnotationFilter::operator==(const AnnotationFilter& other) const
+{
+    return strGroup == other.strGroup && nPageMin == other.nPageMin && nPageMax == other.nPageMax
+        && bColor == other.bColor && (!bColor || color == other.color) && strText == other.strText;
+}
+
+/*!
+ * @brief 判断一条记录是否满足过滤条件。
+ *
+ * @param record 待检查的记录
+ * @return 满足返回 true
+ */
+bool AnnotationFilter::matches(const AnnotationRecord& record) const
+{
+    if (!strGroup.isEmpty() && record.strGroup != strGroup)
+    {
+        return false;
+    }
+    if (nPageMin >= 0 && record.nPage < nPageMin)
+    {
+        return false;
+    }
+    if (nPageMax >= 0 && (record.nPage < 0 || record.nPage > nPageMax))
+    {
+        return false;
+    }
+    if (bColor && (!record.bHasColor || record.color != color))
+    {
+        return false;
+    }
+    if (!strText.isEmpty() && !record.strContent.contains(strText) && !record.strRemark.contains(strText))
+    {
+        return false;
+    }
+    return true;
+}
+
+/*!
+ * @brief 判断当前条件是否比 other 更严格。
+ *
+ * 若成立，则当前条件的结果一定是 other 结果的子集，只需在 other 的结果中继续筛选，
+ * 输入框逐字输入时即可只扫描上一次剩下的行。
+ *
+ * @param other 上一次已经生效的过滤条件
+ * @return 更严格或相同时返回 true
+ */
+bool AnnotationFilter::isRefinementOf(const AnnotationFilter& other) const
+{
+    if (!other.strGroup.isEmpty() && other.strGroup != strGroup)
+    {
+        return false;
+    }
+    if (other.nPageMin >= 0 && (nPageMin < 0 || nPageMin < other.nPageMin))
+    {
+        return false;
+    }
+    if (other.nPageMax >= 0 && (nPageMax < 0 || nPageMax > other.nPageMax))
+    {
+        return false;
+    }
+    if (other.bColor && (!bColor || color != other.color))
+    {
+        return false;
+    }
+    return strText.contains(other.strText);
+}
+
+/*!
+ * @brief 根据一行的单元格文本构建排序与过滤记录。
+ *
+ * @param strGroup 所属分组名称
+ * @param pTexts 指向 AnnotationColumnCount 个单元格文本的数组
+ * @return 预计算好键值的记录
+ */
+AnnotationRecord AnnotationSortFilter::makeRecord(const QString& strGroup, const QString* pTexts)
+{
+    AnnotationRecord record;
+    record.strGroup = strGroup;
+    record.strType = pTexts[AnnotationColumnType].toCaseFolded();
+
+    bool bOk = false;
+    const int nPage = pTexts[AnnotationColumnPage].toInt(&bOk);
+    record.nPage = bOk ? nPage : -1;
+
+    const QColor color(pTexts[AnnotationColumnColor].trimmed());
+    if (color.isValid())
+    {
+        record.bHasColor = true;
+        record.color = color.rgb();
+        record.nColorKey = colorSortKey(color);
+    }
+
+    const double dLength = pTexts[AnnotationColumnLength].toDouble(&bOk);
+    record.dLength = bOk ? dLength : 0.0;
+
+    record.strContent = pTexts[AnnotationColumnContent].toCaseFolded();
+    record.strRemark = pTexts[AnnotationColumnRemark].toCaseFolded();
+    return record;
+}
+
+AnnotationRowList AnnotationSortFilter::allRows(const quint32 nCount)
+{
+    AnnotationRowList rows(nCount);
+    for (quint32 i = 0; i < nCount; ++i)
+    {
+        rows[i] = i;
+    }
+    return rows;
+}
+
+int AnnotationSortFilter::compare(const AnnotationRecord& a, const AnnotationRecord& b, const int nColumn)
+{
+    switch (nColumn)
+    {
+    case AnnotationColumnType:
+    {
+        const int nGroup = QString::compare(a.strGroup, b.strGroup);
+        return nGroup != 0 ? nGroup : QString::compare(a.strType, b.strType);
+    }
+    case AnnotationColumnPage:
+        return compareValue(a.nPage, b.nPage);
+    case AnnotationColumnColor:
+        if (a.bHasColor != b.bHasColor)
+        {
+            return a.bHasColor ? 1 : -1;
+        }
+        return compareValue(a.nColorKey, b.nColorKey);
+    case AnnotationColumnLength:
+        return compareValue(a.dLength, b.dLength);
+    case AnnotationColumnContent:
+        return QString::compare(a.strContent, b.strContent);
+    case AnnotationColumnRemark:
+        return QString::compare(a.strRemark, b.strRemark);
+    default:
+        return 0;
+    }
+}
+
+/*!
+ * @brief 排序行序号。
+ *
+ * 比较相等时按原始行号排序，结果稳定；在调用线程内完成，不派发子任务。
+ *
+ * @param records 记录快照
+ * @param rows 需要排序的行序号
+ * @param nColumn 排序列
+ * @param bAscending 是否升序
+ * @return 排序后的行序号
+ */
+AnnotationRowList AnnotationSortFilter::sortRows(const AnnotationRecordSnapshot& records, AnnotationRowList rows,
+    const int nColumn, const bool bAscending)
+{
+    const AnnotationRecordList& list = *records;
+    std::sort(rows.begin(), rows.end(), [&list, nColumn, bAscending](const quint32 a, const quint32 b)
+        {
+            const int nResult = AnnotationSortFilter::compare(list[a], list[b], nColumn);
+            if (nResult == 0)
+            {
+                return a < b; // 相等时按原始行号，保证稳定
+            }
+            return bAscending ? nResult < 0 : nResult > 0;
+        });
+    return rows;
+}
+
+/*!
+ * @brief 筛选满足条件的行。
+ *
+ * @param records 记录快照
+ * @param candidates 候选行，全量过滤时为所有行，增量过滤时为上一次的结果
+ * @param filter 过滤条件
+ * @return 满足条件的行，保持 candidates 中的先后顺序
+ */
+AnnotationRowList AnnotationSortFilter::filterRows(const AnnotationRecordSnapshot& records,
+    const AnnotationRowList& candidates, const AnnotationFilter& filter)
+{
+    if (filter.isEmpty())
+    {
+        return candidates;
+    }
+
+    const AnnotationRecordList& list = *records;
+    AnnotationRowList result;
+    for (size_t i = 0; i < candidates.size(); ++i)
+    {
+        const quint32 nRow = candidates[i];
+        if (filter.matches(list[nRow]))
+        {
+            result.push_back(nRow);
+        }
+    }
+    return result;
+}
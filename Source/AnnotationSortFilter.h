@@ -0,0 +1,105 @@
+﻿/*!
+ * @brief 注释列表的排序与过滤引擎。
+ *
+ * 本文件定义了 `AnnotationRecord`、`AnnotationFilter` 和 `AnnotationSortFilter`，
+ * 为注释树（`TreeWidgetManager`）提供基于预计算排序键的多列排序和增量过滤。
+ * 记录集合以只读快照的形式在线程间共享，排序与过滤可在后台线程执行，
+ * 不会阻塞 GUI 线程。
+ *
+ * @author LiuYe
+ * @date 2026-10-19
+ * @copyright (c) 2013-2026 Honghu Yuntu Corporation
+ */
+
+#pragma once
+
+#include <QString>
+#include <QRgb>
+#include <memory>
+#include <vector>
+
+/*!
+ * @brief 注释列表的列索引，与树形控件的列标题一一对应。
+ */
+enum AnnotationColumn
+{
+    AnnotationColumnType = 0,
+    AnnotationColumnPage,
+    AnnotationColumnColor,
+    AnnotationColumnLength,
+    AnnotationColumnContent,
+    AnnotationColumnRemark,
+    AnnotationColumnCount
+};
+
+/*!
+ * @brief 单条注释的排序键与过滤键。
+ *
+ * 所有字符串均在构建时做过大小写折叠，排序和过滤时不再做任何转换。
+ */
+struct AnnotationRecord
+{
+    QString strGroup;     // 所属分组（父节点文本）
+    QString strType;      // 类型列，已折叠大小写
+    int nPage;            // 页码，无效时为 -1
+    bool bHasColor;       // 颜色列是否为有效颜色
+    QRgb color;           // 颜色列的原始颜色
+    quint32 nColorKey;    // 颜色排序键（色相、饱和度、亮度打包）
+    double dLength;       // 长度列，无效时为 0
+    QString strContent;   // 内容列，已折叠大小写
+    QString strRemark;    // 备注列，已折叠大小写
+
+    AnnotationRecord();
+};
+
+typedef std::vector<AnnotationRecord> AnnotationRecordList;
+typedef std::shared_ptr<const AnnotationRecordList> AnnotationRecordSnapshot;
+typedef std::vector<quint32> AnnotationRowList;
+
+/*!
+ * @brief 注释过滤条件：类型、页码范围、颜色以及内容/备注中的子串。
+ */
+struct AnnotationFilter
+{
+    QString strGroup;     // 分组过滤，为空表示不限
+    int nPageMin;         // 最小页码，-1 表示不限
+    int nPageMax;         // 最大页码，-1 表示不限
+    bool bColor;          // 是否按颜色过滤
+    QRgb color;           // 过滤颜色
+    QString strText;      // 内容或备注需要包含的子串，已折叠大小写
+
+    AnnotationFilter();
+
+    bool isEmpty() const;
+    bool operator==(const AnnotationFilter& other) const;
+    bool matches(const AnnotationRecord& record) const;
+
+    // 当前条件的结果是否必然是 other 结果的子集，用于增量过滤
+    bool isRefinementOf(const AnnotationFilter& other) const;
+};
+
+/*!
+ * @brief 注释排序与过滤的算法集合。
+ *
+ * 所有函数都只读取记录快照，可在任意线程调用，并在调用线程内完成，不会再向线程池派发任务。
+ */
+class AnnotationSortFilter
+{
+public:
+    // 根据单元格文本构建一条记录
+    static AnnotationRecord makeRecord(const QString& strGroup, const QString* pTexts);
+
+    // 生成 [0, nCount) 的行序号
+    static AnnotationRowList allRows(quint32 nCount);
+
+    // 按指定列和方向对 rows 排序，相等时按行号保持稳定
+    static AnnotationRowList sortRows(const AnnotationRecordSnapshot& records, AnnotationRowList rows,
+        int nColumn, bool bAscending);
+
+    // 从 candidates 中筛选满足条件的行，结果保持 candidates 的顺序
+    static AnnotationRowList filterRows(const AnnotationRecordSnapshot& records,
+        const AnnotationRowList& candidates, const AnnotationFilter& filter);
+
+    // 比较两条记录在指定列上的大小
+    static int compare(const AnnotationRecord& a, const AnnotationRecord& b, int nColumn);
+};
@@ -9,6 +9,7 @@
  * - 创建两个图层（蓝色和绿色），并实现图层的覆盖和可见性切换。
  * - 通过工具栏上的按钮，实现对绿色区域的显隐控制。
  * - 通过鼠标事件实现分割条的拖动，来调整绿色区域的高度。
+ * - 在蓝色图层的工具栏右侧承载多文档标签页工作区 `DocumentWorkspace`。
  *
  * @author LiuYe
  * @date 2024-09-27
@@ -16,14 +17,43 @@
  */
 
 #include "CustomTreeWidget.h"
+#include "DocumentWorkspace.h"
+#include "TwoLayerSample.h"
+#include "outline_panel.h"
+#include "performance_hud.h"
+#include "startup_profiler.h"
 #include <QVBoxLayout>
 #include <QPainter>
 #include <QMouseEvent>
 #include <QToolButton>
+#include <QMenu>
+#include <QScrollArea>
+#include <QScreen>
+#include <QStyle>
+#include <QTabWidget>
 #include <QApplication>
+#include <QWindow>
 
 #include <QDebug>
 
+namespace
+{
+    // 切换按钮的动态属性，表示绿色区域是否展开，样式表按该属性选择样式
+    const char* const kPanelOpenProperty = "panelOpen";
+
+    // 无法取得显示器刷新率时假定 60 Hz
+    const int kDefaultFrameIntervalMs = 16;
+
+    // 以调色板填充背景。容器上的样式表会让全部子控件改由 QStyleSheetStyle 绘制，包括注释树等项视图
+    void fillBackground(QWidget* pWidget, const QColor& color)
+    {
+        QPalette palette = pWidget->palette();
+        palette.setColor(QPalette::Window, color);
+        pWidget->setPalette(palette);
+        pWidget->setAutoFillBackground(true);
+    }
+}
+
  // CBlueLayer 构造函数
  /*!
   * @brief 构造函数，初始化蓝色图层并添加工具栏。
@@ -33,9 +63,9 @@
   * @param pParent 父窗口对象
   */
 CBlueLayer::CBlueLayer(QWidget* pParent)
-    : QWidget(pParent), m_pToolBar(new QToolBar("Control ToolBar", this))
+    : QWidget(pParent), m_pToolBar(new QToolBar("Control ToolBar", this)), m_bShownMarked(false)
 {
-    setStyleSheet("background-color: blue;");
+    fillBackground(this, Qt::blue);
     m_pToolBar->setOrientation(Qt::Vertical); // 设置工具栏垂直方向
     m_pToolBar->setGeometry(0, 0, 30, height()); // 工具栏初始大小
 }
@@ -59,6 +89,13 @@ void CBlueLayer::paintEvent(QPaintEvent* pEvent)
     // 在蓝色区域内绘制一个白色矩形
     const QRect rect(width() / 4, height() / 4, width() / 2, height() / 2);
     painter.drawRect(rect);
+
+    // 蓝色图层铺满主窗口，它的首次绘制即窗口首帧；之后的绘制不再记录
+    if (!m_bShownMarked)
+    {
+        m_bShownMarked = true;
+        StartupProfiler::instance().mark(StartupProfiler::WindowShown);
+    }
 }
 
 /*!
@@ -69,12 +106,138 @@ void CBlueLayer::paintEvent(QPaintEvent* pEvent)
  * @param pParent 父窗口对象
  */
 CGreenLayer::CGreenLayer(QWidget* pParent)
-    : QWidget(pParent), m_bDragging(false), m_nInitialHeight(0)
+    : QWidget(pParent), m_pTreeWidget(nullptr), m_pTreeManager(nullptr), m_pOutlinePanel(nullptr), m_pViewer(nullptr),
+    m_pContents(nullptr), m_bSnapshot(false), m_bDragging(false), m_nInitialHeight(0)
 {
-    setStyleSheet("background-color: green;");
+    fillBackground(this, QColor(0, 128, 0)); // 样式表中的 green
     setFixedHeight(0); // 初始状态为隐藏
 }
 
+/*!
+ * @brief 处理大小变化事件，绿色区域首次展开时创建注释树面板。
+ *
+ * @param pEvent 指向大小变化事件的指针
+ */
+void CGreenLayer::resizeEvent(QResizeEvent* pEvent)
+{
+    QWidget::resizeEvent(pEvent);
+    if (height() > 0 && !m_pTreeWidget)
+    {
+        createContents();
+    }
+}
+
+/*!
+ * @brief 设置当前标签页的查看器。
+ *
+ * 书签面板尚未创建时只记录下来，不读取书签。
+ *
+ * @param pViewer 当前标签页的查看器，没有标签页时为 nullptr
+ */
+void CGreenLayer::setViewer(PDFViewer* pViewer)
+{
+    m_pViewer = pViewer;
+    if (m_pOutlinePanel)
+    {
+        m_pOutlinePanel->setViewer(pViewer);
+    }
+}
+
+/*!
+ * @brief 创建注释页（过滤栏和注释树）、书签页与性能页。
+ *
+ * 树形控件的最小尺寸较大，放在滚动区域中，不影响绿色区域的高度调整。
+ */
+void CGreenLayer::createContents()
+{
+    QVBoxLayout* pLayout = new QVBoxLayout(this);
+    pLayout->setContentsMargins(0, 0, 0, 0);
+    pLayout->setSpacing(0);
+
+    QTabWidget* pTabWidget = new QTabWidget(this);
+    pTabWidget->setDocumentMode(true);
+    pLayout->addWidget(pTabWidget);
+    m_pContents = pTabWidget;
+
+    QWidget* pAnnotationPage = new QWidget(pTabWidget);
+    QVBoxLayout* pAnnotationLayout = new QVBoxLayout(pAnnotationPage);
+    pAnnotationLayout->setContentsMargins(0, 0, 0, 0);
+    pAnnotationLayout->setSpacing(0);
+
+    m_pTreeWidget = new QTreeWidget;
+    m_pTreeManager = new TreeWidgetManager(m_pTreeWidget, this);
+    m_pTreeManager->setupTreeWidget();
+
+    QScrollArea* pScrollArea = new QScrollArea(pAnnotationPage);
+    pScrollArea->setWidget(m_pTreeWidget);
+    pAnnotationLayout->addWidget(m_pTreeManager->createFilterBar(pAnnotationPage));
+    pAnnotationLayout->addWidget(pScrollArea, 1);
+    pTabWidget->addTab(pAnnotationPage, "Annotations");
+
+    m_pOutlinePanel = new OutlinePanel(pTabWidget);
+    m_pOutlinePanel->setViewer(m_pViewer);
+    pTabWidget->addTab(m_pOutlinePanel, "Outline");
+
+    // 性能面板只在其标签页可见时采样
+    pTabWidget->addTab(new PerformanceHud(pTabWidget), "Performance");
+
+    // 从折叠状态拖开时内容在拖动中创建，拖动结束后才显示
+    if (m_bSnapshot)
+    {
+        m_pContents->hide();
+    }
+}
+
+/*!
+ * @brief 以当前内容的快照代替面板内容。
+ *
+ * 隐藏的控件不参与布局，拖动期间高度的每次变化只需重绘快照，不再对注释树、书签树等重新布局；
+ * 面板变高时快照以下的部分只绘制背景。
+ */
+void CGreenLayer::beginSnapshot()
+{
+    if (m_bSnapshot)
+    {
+        return;
+    }
+    m_bSnapshot = true;
+    if (m_pContents && height() > 0)
+    {
+        m_oSnapshot = m_pContents->grab();
+        m_pContents->hide();
+    }
+}
+
+void CGreenLayer::endSnapshot()
+{
+    if (!m_bSnapshot)
+    {
+        return;
+    }
+    m_bSnapshot = false;
+    m_oSnapshot = QPixmap();
+    if (m_pContents)
+    {
+        m_pContents->show();
+    }
+    update();
+}
+
+/*!
+ * @brief 快照显示期间在背景上绘制快照，背景由调色板填充。
+ *
+ * @param pEvent 指向绘制事件的指针
+ */
+void CGreenLayer::paintEvent(QPaintEvent* pEvent)
+{
+    QPainter painter(this);
+    if (!m_oSnapshot.isNull())
+    {
+        painter.drawPixmap(0, 0, m_oSnapshot);
+    }
+    QWidget::paintEvent(pEvent);
+}
+
 /*!
  * @brief 处理鼠标按下事件，开始拖动绿色区域。
  *
@@ -133,9 +296,10 @@ void CGreenLayer::mouseReleaseEvent(QMouseEvent* pEvent)
  * @param pParent 父窗口对象
  */
 CAMainWindow::CAMainWindow(QWidget* pParent)
-    : QWidget(pParent), m_bDragging(false), m_nInitialHeight(0)
+    : QWidget(pParent), m_bDragging(false), m_nInitialHeight(0), m_nPendingHeight(0),
+    m_nFrameIntervalMs(kDefaultFrameIntervalMs)
 {
-    setStyleSheet("background-color: blue;"); // 设置整个窗口背景为蓝色
+    fillBackground(this, Qt::blue); // 设置整个窗口背景为蓝色
 
     QVBoxLayout* pMainLayout = new QVBoxLayout(this);
     pMainLayout->setContentsMargins(0, 0, 0, 0);
@@ -146,19 +310,77 @@ CAMainWindow::CAMainWindow(QWidget* pParent)
     m_pBlueLayer->setGeometry(0, 0, this->width(), this->height());
     m_pBlueLayer->show();
 
+    // 初始化文档工作区，占据工具栏右侧区域，位于绿色图层之下
+    m_pWorkspace = new DocumentWorkspace(m_pBlueLayer);
+    fillBackground(m_pWorkspace, Qt::white);
+    m_pWorkspace->setGeometry(30, 0, this->width() - 30, this->height());
+
     // 初始化绿色图层
     m_pGreenLayer = new CGreenLayer(this);
+    connect(m_pWorkspace, &DocumentWorkspace::currentViewerChanged, this, [this](PDFViewer* pViewer)
+        {
+            m_pGreenLayer->setViewer(pViewer);
+        });
     m_pGreenLayer->setGeometry(30, this->height(), this->width() - 30, 0);
     m_pGreenLayer->raise();
 
     // 创建分割条
     m_pDragBar = new QFrame(this);
-    m_pDragBar->setStyleSheet("background-color: grey;");
+    fillBackground(m_pDragBar, QColor(128, 128, 128)); // 样式表中的 grey
     m_pDragBar->setCursor(Qt::SizeVerCursor);
     m_pDragBar->setGeometry(30, this->height() - 5, this->width(), 5);
     m_pDragBar->installEventFilter(this);
 
     // 在工具栏添加 Action
+    m_pOpenAction = m_pBlueLayer->toolBar()->addAction("O");
+    m_pOpenAction->setToolTip("Open PDF files");
+    m_pOpenAction->setShortcut(QKeySequence::Open);
+    connect(m_pOpenAction, &QAction::triggered, m_pWorkspace, &DocumentWorkspace::promptOpen);
+
+    // 依次切换原始、暗色、高对比度颜色方案
+    m_pColorSchemeAction = m_pBlueLayer->toolBar()->addAction("D");
+    m_pColorSchemeAction->setToolTip("Color scheme: " + colorSchemeName(ColorSchemeNormal));
+    m_pColorSchemeAction->setShortcut(QKeySequence(Qt::CTRL + Qt::SHIFT + Qt::Key_D));
+    connect(m_pColorSchemeAction, &QAction::triggered, this, [this]()
+        {
+            const ColorScheme eNext = static_cast<ColorScheme>((m_pWorkspace->colorScheme() + 1) % ColorSchemeCount);
+            m_pWorkspace->setColorScheme(eNext);
+            m_pColorSchemeAction->setToolTip("Color scheme: " + colorSchemeName(eNext));
+        });
+
+    // 以 8 位灰度渲染页面，降低位图内存
+    m_pGrayscaleAction = m_pBlueLayer->toolBar()->addAction("G");
+    m_pGrayscaleAction->setToolTip("Grayscale rendering");
+    m_pGrayscaleAction->setShortcut(QKeySequence(Qt::CTRL + Qt::SHIFT + Qt::Key_G));
+    m_pGrayscaleAction->setCheckable(true);
+    connect(m_pGrayscaleAction, &QAction::toggled, m_pWorkspace, &DocumentWorkspace::setGrayscale);
+
+    // 页面适应窗口宽度，调整窗口大小时先缩放现有位图
+    m_pFitWidthAction = m_pBlueLayer->toolBar()->addAction("W");
+    m_pFitWidthAction->setToolTip("Fit page to window width");
+    m_pFitWidthAction->setShortcut(QKeySequence(Qt::CTRL + Qt::SHIFT + Qt::Key_W));
+    m_pFitWidthAction->setCheckable(true);
+    connect(m_pFitWidthAction, &QAction::toggled, m_pWorkspace, &DocumentWorkspace::setFitToWidth);
+
+    // 合并、拆分、提取、拼版页面，在工作进程中执行
+    QMenu* pPagesMenu = new QMenu(this);
+    connect(pPagesMenu->addAction("Merge PDF files..."), &QAction::triggered, m_pWorkspace,
+        &DocumentWorkspace::promptMerge);
+    connect(pPagesMenu->addAction("Split current document..."), &QAction::triggered, m_pWorkspace,
+        &DocumentWorkspace::promptSplit);
+    connect(pPagesMenu->addAction("Extract pages from current document..."), &QAction::triggered, m_pWorkspace,
+        &DocumentWorkspace::promptExtract);
+    connect(pPagesMenu->addAction("Impose pages (N-up / tiles)..."), &QAction::triggered, m_pWorkspace,
+        &DocumentWorkspace::promptImpose);
+    m_pPagesAction = m_pBlueLayer->toolBar()->addAction("P");
+    m_pPagesAction->setToolTip("Merge, split, extract or impose pages");
+    m_pPagesAction->setMenu(pPagesMenu);
+    QWidget* pPagesWidget = m_pBlueLayer->toolBar()->widgetForAction(m_pPagesAction);
+    if (QToolButton* pPagesButton = qobject_cast<QToolButton*>(pPagesWidget))
+    {
+        pPagesButton->setPopupMode(QToolButton::InstantPopup);
+    }
+
     m_pToggleAction = m_pBlueLayer->toolBar()->addAction("A");
     connect(m_pToggleAction, &QAction::triggered, this, [this]()
         {
@@ -169,22 +391,23 @@ CAMainWindow::CAMainWindow(QWidget* pParent)
             }
         });
 
-    // 获取关联的 QToolButton
+    // 获取关联的 QToolButton；展开与折叠的样式由同一份样式表按 panelOpen 属性选择，状态变化时不再替换样式表
     QWidget* pWidget = m_pBlueLayer->toolBar()->widgetForAction(m_pToggleAction);
     if (QToolButton* pButton = qobject_cast<QToolButton*>(pWidget))
     {
         pButton->setCheckable(true);
+        pButton->setProperty(kPanelOpenProperty, false);
         pButton->setStyleSheet("QToolButton { "
             "background-color: lightgray; "
             "border: 1px solid black; "
             "color: blue; "
             "padding: 5px; "
             "border-radius: 4px; }"
+            "QToolButton[panelOpen=\"true\"] { "
+            "background-color: red; "
+            "color: white; }"
             "QToolButton:hover { "
-            "background-color: lightblue; }"
-            "QToolButton:checked { "
-            "background-color: green; "
-            "color: white; }");
+            "background-color: lightblue; }");
 
         connect(pButton, &QToolButton::toggled, this, &CAMainWindow::toggleGreenLayer);
     }
@@ -217,40 +440,38 @@ void CAMainWindow::toggleGreenLayer(const bool checked) const
 /*!
  * @brief 更新工具按钮的状态和样式。
  *
- * 根据绿色区域的高度，更新工具按钮的选中状态和样式。
+ * 根据绿色区域的高度，更新工具按钮的选中状态和 panelOpen 属性。只有属性改变时才重新应用样式，
+ * 拖动分割条时高度的连续变化不会引起样式重算。
  */
 void CAMainWindow::updateToggleAction() const
 {
     QWidget* pWidget = m_pBlueLayer->toolBar()->widgetForAction(m_pToggleAction);
     if (QToolButton* pButton = qobject_cast<QToolButton*>(pWidget))
     {
-        if (m_pGreenLayer->height() > 0)
-        {
-            pButton->setChecked(true);
-            pButton->setStyleSheet("QToolButton { "
-                "background-color: red; "
-                "color: white; "
-                "padding: 5px; "
-                "border: 1px solid black; "
-                "border-radius: 4px; }"
-                "QToolButton:hover { "
-                "background-color: lightblue; }");
-        }
-        else
+        const bool bOpen = m_pGreenLayer->height() > 0;
+        pButton->setChecked(bOpen);
+        if (pButton->property(kPanelOpenProperty).toBool() != bOpen)
         {
-            pButton->setChecked(false);
-            pButton->setStyleSheet("QToolButton { "
-                "background-color: lightgray; "
-                "color: blue; "
-                "padding: 5px; "
-                "border: 1px solid black; "
-                "border-radius: 4px; }"
-                "QToolButton:hover { "
-                "background-color: lightblue; }");
+            pButton->setProperty(kPanelOpenProperty, bOpen);
+            pButton->style()->unpolish(pButton);
+            pButton->style()->polish(pButton);
         }
     }
 }
 
+/*!
+ * @brief 设置绿色区域的高度，并把分割条移到其上沿。
+ *
+ * @param nHeight 绿色区域的高度
+ */
+void CAMainWindow::applyPanelHeight(const int nHeight)
+{
+    m_pGreenLayer->setFixedHeight(nHeight);
+    m_pGreenLayer->setGeometry(30, m_pBlueLayer->height() - nHeight, this->width() - 30, nHeight);
+    m_pDragBar->move(30, m_pGreenLayer->y() - m_pDragBar->height());
+    updateToggleAction(); // 更新按钮状态以同步绿色区域高度
+}
+
 /*!
  * @brief 处理窗口大小变化事件，调整控件布局。
  *
@@ -261,6 +482,7 @@ void CAMainWindow::updateToggleAction() const
 void CAMainWindow::resizeEvent(QResizeEvent* pEvent)
 {
     m_pBlueLayer->setGeometry(0, 0, this->width(), this->height());
+    m_pWorkspace->setGeometry(30, 0, this->width() - 30, this->height());
     m_pDragBar->setGeometry(30, m_pBlueLayer->height() - m_pGreenLayer->height() - m_pDragBar->height(),
         this->width() - 30, 5);
     m_pGreenLayer->setGeometry(30, m_pBlueLayer->height() - m_pGreenLayer->height(), this->width() - 30,
@@ -271,7 +493,9 @@ void CAMainWindow::resizeEvent(QResizeEvent* pEvent)
 /*!
  * @brief 处理事件过滤器，用于实现分割条的拖动功能。
  *
- * 根据鼠标事件，检测并处理分割条的拖动，以调整绿色区域的高度。
+ * 根据鼠标事件，检测并处理分割条的拖动，以调整绿色区域的高度。鼠标移动只记录目标高度，
+ * 距上一次调整不足一帧时等到下一帧再应用，鼠标事件比显示器刷新更频繁时每帧只调整一次几何；
+ * 拖动期间绿色区域显示快照。
  *
  * @param pObj 事件发生的对象
  * @param pEvent 事件对象指针
@@ -289,6 +513,13 @@ bool CAMainWindow::eventFilter(QObject* pObj, QEvent* pEvent)
                 m_bDragging = true;
                 m_oDragStartPosition = pMouseEvent->globalPos();
                 m_nInitialHeight = m_pGreenLayer->height();
+                m_nPendingHeight = m_nInitialHeight;
+                const QScreen* pScreen = window()->windowHandle() ? window()->windowHandle()->screen()
+                    : QGuiApplication::primaryScreen();
+                m_nFrameIntervalMs = pScreen && pScreen->refreshRate() > 1.0
+                    ? std::max(1, qRound(1000.0 / pScreen->refreshRate())) : kDefaultFrameIntervalMs;
+                m_oLastDragFrame.invalidate();
+                m_pGreenLayer->beginSnapshot();
                 return true;
             }
         }
@@ -298,20 +529,25 @@ bool CAMainWindow::eventFilter(QObject* pObj, QEvent* pEvent)
             if (m_bDragging)
             {
                 const int dy = m_oDragStartPosition.y() - pMouseEvent->globalPos().y();
-                const int newHeight = std::max(0, m_nInitialHeight + dy);
-                m_pGreenLayer->setFixedHeight(newHeight);
-                m_pGreenLayer->setGeometry(30, m_pBlueLayer->height() - newHeight, this->width() - 30, newHeight);
-                m_pDragBar->move(30, m_pGreenLayer->y() - m_pDragBar->height());
-                updateToggleAction(); // 更新按钮状态以同步绿色区域高度
+                m_nPendingHeight = std::max(0, m_nInitialHeight + dy);
+                if (!m_oDragFrameTimer.isActive())
+                {
+                    const qint64 nElapsed = m_oLastDragFrame.isValid()
+                        ? m_oLastDragFrame.elapsed() : m_nFrameIntervalMs;
+                    m_oDragFrameTimer.start(static_cast<int>(std::max<qint64>(0, m_nFrameIntervalMs - nElapsed)), this);
+                }
                 return true;
             }
         }
         if (pEvent->type() == QEvent::MouseButtonRelease)
         {
             const QMouseEvent* pMouseEvent = dynamic_cast<QMouseEvent*>(pEvent);
-            if (pMouseEvent->button() == Qt::LeftButton)
+            if (pMouseEvent->button() == Qt::LeftButton && m_bDragging)
             {
                 m_bDragging = false;
+                m_oDragFrameTimer.stop();
+                applyPanelHeight(m_nPendingHeight);
+                m_pGreenLayer->endSnapshot();
                 return true;
             }
         }
@@ -319,3 +555,19 @@ bool CAMainWindow::eventFilter(QObject* pObj, QEvent* pEvent)
     return QWidget::eventFilter(pObj, pEvent);
 }
 
+/*!
+ * @brief 在帧定时器到期时应用拖动中记录的高度。
+ *
+ * @param pEvent 定时器事件
+ */
+void CAMainWindow::timerEvent(QTimerEvent* pEvent)
+{
+    if (pEvent->timerId() != m_oDragFrameTimer.timerId())
+    {
+        QWidget::timerEvent(pEvent);
+        return;
+    }
+    m_oDragFrameTimer.stop();
+    m_oLastDragFrame.start();
+    applyPanelHeight(m_nPendingHeight);
+}
@@ -15,10 +15,18 @@
 
 #include <QToolBar>
 #include <QAction>
+#include <QBasicTimer>
+#include <QElapsedTimer>
 #include <QFrame>
+#include <QPixmap>
 #include <QPoint>
 
 class QVBoxLayout;
+class QTreeWidget;
+class DocumentWorkspace;
+class OutlinePanel;
+class PDFViewer;
+class TreeWidgetManager;
 
 /*!
  * @brief 蓝色图层类，负责绘制并提供工具栏用于控制绿色区域。
@@ -46,12 +54,15 @@ protected:
 
 private:
     QToolBar* m_pToolBar; // 工具栏
+    bool m_bShownMarked;  // 是否已记录窗口首帧
 };
 
 /*!
  * @brief 绿色图层类，提供拖动调整高度的功能。
  *
  * `CGreenLayer` 类继承自 `QWidget`，能够通过鼠标事件调整自身的高度，实现绿色区域的可伸缩性。
+ * 区域内的注释树面板和书签面板在首次展开时才创建，不占用启动时间。
+ * 拖动分割条期间面板显示拖动开始时的快照，面板内容不随每次高度变化重新布局和绘制。
  *
  * @param pParent 父窗口对象，默认为 nullptr
  * @date 2024.09.29
@@ -61,12 +72,28 @@ class CGreenLayer : public QWidget
 public:
     explicit CGreenLayer(QWidget* pParent = nullptr);
 
+    void setViewer(PDFViewer* pViewer); // 书签面板跟随当前标签页
+
+    void beginSnapshot(); // 以当前内容的快照代替面板内容，拖动调整高度时使用
+    void endSnapshot(); // 恢复面板内容
+
 protected:
+    void paintEvent(QPaintEvent* pEvent) override;
     void mousePressEvent(QMouseEvent* pEvent) override;
     void mouseMoveEvent(QMouseEvent* pEvent) override;
     void mouseReleaseEvent(QMouseEvent* pEvent) override;
+    void resizeEvent(QResizeEvent* pEvent) override;
 
 private:
+    void createContents(); // 创建注释树面板和书签面板
+
+    QTreeWidget* m_pTreeWidget;
+    TreeWidgetManager* m_pTreeManager;
+    OutlinePanel* m_pOutlinePanel;
+    PDFViewer* m_pViewer; // 当前标签页的查看器，书签面板创建时使用
+    QWidget* m_pContents; // 标签页控件，快照显示期间隐藏
+    QPixmap m_oSnapshot; // 拖动期间显示的快照，为空表示显示实际内容
+    bool m_bSnapshot;
     bool m_bDragging;
     QPoint m_oDragStartPosition;
     int m_nInitialHeight;
@@ -88,9 +115,15 @@ class CAMainWindow : public QWidget
 public:
     explicit CAMainWindow(QWidget* pParent = nullptr);
 
+    DocumentWorkspace* workspace() const
+    {
+        return m_pWorkspace;
+    } // 多文档标签页工作区
+
 protected:
     void resizeEvent(QResizeEvent* pEvent) override;
     bool eventFilter(QObject* pObj, QEvent* pEvent) override;
+    void timerEvent(QTimerEvent* pEvent) override;
 
 private slots:
     void toggleGreenLayer(const bool checked) const;
@@ -100,9 +133,20 @@ private:
     CGreenLayer* m_pGreenLayer;
     QFrame* m_pDragBar;
     QAction* m_pToggleAction; // 用于控制绿色区域的Action
+    QAction* m_pOpenAction; // 打开文档的Action
+    QAction* m_pColorSchemeAction; // 循环切换页面颜色方案的Action
+    QAction* m_pGrayscaleAction; // 切换灰度渲染的Action
+    QAction* m_pFitWidthAction; // 切换页面适应窗口宽度的Action
+    QAction* m_pPagesAction; // 合并、拆分、提取、拼版页面的Action
+    DocumentWorkspace* m_pWorkspace; // 位于蓝色图层工具栏右侧的文档工作区
     bool m_bDragging;
     QPoint m_oDragStartPosition;
     int m_nInitialHeight;
+    int m_nPendingHeight; // 拖动中尚未应用的绿色区域高度
+    int m_nFrameIntervalMs; // 显示器一帧的时长，拖动时每帧最多调整一次高度
+    QBasicTimer m_oDragFrameTimer;
+    QElapsedTimer m_oLastDragFrame; // 距上一次应用高度的时间
 
     void updateToggleAction() const; // 更新Action状态
+    void applyPanelHeight(int nHeight); // 设置绿色区域高度并移动分割条
 };
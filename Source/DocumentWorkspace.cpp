@@ -0,0 +1,566 @@
+﻿/*!
+ * @brief 多文档标签页工作区的实现。
+ *
+ * @author LiuYe
+ * @date 2026-10-19
+ * @copyright (c) 2013-2026 Honghu Yuntu Corporation
+ */
+
+#include "DocumentWorkspace.h"
+
+#include <algorithm>
+
+#include <QEvent>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QInputDialog>
+#include <QMessageBox>
+#include <QProgressDialog>
+#include <QScrollArea>
+#include <QScrollBar>
+#include <QTimer>
+
+#include "pdf_viewer.h"
+#include "render_cache.h"
+#include "render_scheduler.h"
+
+namespace
+{
+    // 页面周围区域的颜色，暗色方案下更深
+    QPalette::ColorRole scrollAreaRole(const ColorScheme eColorScheme)
+    {
+        return eColorScheme == ColorSchemeNormal ? QPalette::Dark : QPalette::Shadow;
+    }
+}
+
+/*!
+ * @brief 构造函数，初始化可关闭、可拖动排序的标签页。
+ *
+ * @param pParent 父窗口对象
+ */
+DocumentWorkspace::DocumentWorkspace(QWidget* pParent)
+    : QTabWidget(pParent), m_pActiveViewer(nullptr), m_eColorScheme(ColorSchemeNormal), m_bGrayscale(false),
+    m_bFitToWidth(false), m_pAssemblyRunner(new PageAssemblyRunner(this)), m_pAssemblyProgress(nullptr)
+{
+    setTabsClosable(true);
+    setMovable(true);
+    setDocumentMode(true);
+
+    connect(this, &QTabWidget::currentChanged, this, &DocumentWorkspace::onCurrentChanged);
+    connect(this, &QTabWidget::tabCloseRequested, this, &DocumentWorkspace::onTabCloseRequested);
+
+    connect(m_pAssemblyRunner, &PageAssemblyRunner::jobFinished, this, [this](const PageAssemblyResult& result)
+        {
+            if (result.bSucceeded)
+            {
+                m_lstAssemblyOutputs << result.strOutput;
+            }
+            else
+            {
+                m_lstAssemblyErrors << result.strError;
+            }
+        });
+    connect(m_pAssemblyRunner, &PageAssemblyRunner::progress, this, [this](const int nFinished, const int nTotal)
+        {
+            if (m_pAssemblyProgress)
+            {
+                m_pAssemblyProgress->setMaximum(nTotal);
+                m_pAssemblyProgress->setValue(nFinished);
+            }
+        });
+    connect(m_pAssemblyRunner, &PageAssemblyRunner::finished, this, &DocumentWorkspace::onAssemblyFinished);
+}
+
+/*!
+ * @brief 在新标签页中打开文档。
+ *
+ * 查看器立即创建并显示占位画面，文档在后台加载；新标签页成为当前标签页。
+ *
+ * @param strPath 文档路径
+ * @return 新建的查看器
+ */
+PDFViewer* DocumentWorkspace::openDocument(const QString& strPath)
+{
+    QScrollArea* pScrollArea = new QScrollArea(this);
+    pScrollArea->setAlignment(Qt::AlignHCenter | Qt::AlignTop);
+    pScrollArea->setBackgroundRole(scrollAreaRole(m_eColorScheme));
+
+    PDFViewer* pViewer = new PDFViewer(QString(), pScrollArea);
+    pViewer->setActive(false);
+    pViewer->setColorScheme(m_eColorScheme);
+    pViewer->setGrayscale(m_bGrayscale);
+    pScrollArea->setWidget(pViewer);
+    pScrollArea->viewport()->installEventFilter(this);
+    applyFitWidth(pScrollArea);
+
+    const int nIndex = addTab(pScrollArea, QFileInfo(strPath).fileName());
+    setTabToolTip(nIndex, QFileInfo(strPath).absoluteFilePath());
+    pViewer->openDocument(strPath);
+
+    connect(pViewer, &PDFViewer::saveFinished, this,
+        [this, pViewer](const bool bSucceeded, const int nSkippedEdits, const QString& strError)
+        {
+            onSaveFinished(pViewer, bSucceeded, nSkippedEdits, strError);
+        });
+
+    // 首页就绪时若该标签页在前台，注册为当前文档
+    connect(pViewer->loader(), &PdfDocumentLoader::firstPageRendered, this, [this, pViewer]()
+        {
+            if (pViewer == m_pActiveViewer)
+            {
+                pViewer->setActive(true);
+            }
+        });
+
+    setCurrentIndex(nIndex);
+    return pViewer;
+}
+
+void DocumentWorkspace::openDocuments(const QStringList& lstPaths)
+{
+    for (int i = 0; i < lstPaths.size(); ++i)
+    {
+        openDocument(lstPaths[i]);
+    }
+}
+
+PDFViewer* DocumentWorkspace::viewerAt(const int nIndex) const
+{
+    const QScrollArea* pScrollArea = qobject_cast<QScrollArea*>(widget(nIndex));
+    return pScrollArea ? qobject_cast<PDFViewer*>(pScrollArea->widget()) : nullptr;
+}
+
+PDFViewer* DocumentWorkspace::currentViewer() const
+{
+    return viewerAt(currentIndex());
+}
+
+/*!
+ * @brief 切换颜色方案。
+ *
+ * 前台标签页立即换用缓存中该方案的位图或请求渲染；后台标签页在切回时再渲染。
+ * 各方案的位图在缓存中分别保存，来回切换时已渲染过的页面不再重新渲染。
+ *
+ * @param eColorScheme 新的颜色方案
+ */
+void DocumentWorkspace::setColorScheme(const ColorScheme eColorScheme)
+{
+    m_eColorScheme = eColorScheme;
+    for (int i = 0; i < count(); ++i)
+    {
+        if (QScrollArea* pScrollArea = qobject_cast<QScrollArea*>(widget(i)))
+        {
+            pScrollArea->setBackgroundRole(scrollAreaRole(eColorScheme));
+        }
+        if (PDFViewer* pViewer = viewerAt(i))
+        {
+            pViewer->setColorScheme(eColorScheme);
+        }
+    }
+}
+
+/*!
+ * @brief 切换灰度渲染。
+ *
+ * 灰度位图每像素 1 字节，同样的缓存预算可以容纳四倍的页面；彩色与灰度位图在缓存中分别保存。
+ *
+ * @param bGrayscale 是否以灰度渲染
+ */
+void DocumentWorkspace::setGrayscale(const bool bGrayscale)
+{
+    m_bGrayscale = bGrayscale;
+    for (int i = 0; i < count(); ++i)
+    {
+        if (PDFViewer* pViewer = viewerAt(i))
+        {
+            pViewer->setGrayscale(bGrayscale);
+        }
+    }
+}
+
+/*!
+ * @brief 切换适应宽度。
+ *
+ * 拖动窗口边缘时查看器每帧只缩放现有位图，大小稳定后渲染级别变化了才重新渲染。
+ *
+ * @param bFitToWidth 页面是否适应窗口宽度
+ */
+void DocumentWorkspace::setFitToWidth(const bool bFitToWidth)
+{
+    m_bFitToWidth = bFitToWidth;
+    for (int i = 0; i < count(); ++i)
+    {
+        if (QScrollArea* pScrollArea = qobject_cast<QScrollArea*>(widget(i)))
+        {
+            applyFitWidth(pScrollArea);
+        }
+    }
+}
+
+bool DocumentWorkspace::eventFilter(QObject* pWatched, QEvent* pEvent)
+{
+    if (pEvent->type() == QEvent::Resize)
+    {
+        QScrollArea* pScrollArea = qobject_cast<QScrollArea*>(pWatched->parent());
+        if (pScrollArea && pScrollArea->viewport() == pWatched)
+        {
+            applyFitWidth(pScrollArea);
+        }
+    }
+    return QTabWidget::eventFilter(pWatched, pEvent);
+}
+
+void DocumentWorkspace::applyFitWidth(QScrollArea* pScrollArea)
+{
+    PDFViewer* pViewer = qobject_cast<PDFViewer*>(pScrollArea->widget());
+    if (!pViewer)
+    {
+        return;
+    }
+    // 始终预留垂直滚动条的宽度，页面高度越过视口时滚动条出现不会再次改变页面宽度
+    const int nWidth = pScrollArea->maximumViewportSize().width()
+        - pScrollArea->verticalScrollBar()->sizeHint().width();
+    pViewer->setFitWidth(m_bFitToWidth ? std::max(1, nWidth) : 0);
+}
+
+void DocumentWorkspace::promptOpen()
+{
+    const QStringList lstPaths = QFileDialog::getOpenFileNames(this, "Open PDF Files", QString(),
+        "PDF Files (*.pdf)");
+    openDocuments(lstPaths);
+}
+
+void DocumentWorkspace::promptMerge()
+{
+    const QStringList lstSources = QFileDialog::getOpenFileNames(this, "Select PDF Files to Merge", QString(),
+        "PDF Files (*.pdf)");
+    if (lstSources.size() < 2)
+    {
+        return;
+    }
+    const QString strOutput = QFileDialog::getSaveFileName(this, "Save Merged PDF As", QString(),
+        "PDF Files (*.pdf)");
+    if (!strOutput.isEmpty())
+    {
+        runAssembly(planMerge(lstSources, strOutput));
+    }
+}
+
+void DocumentWorkspace::promptSplit()
+{
+    PDFViewer* pViewer = currentViewer();
+    if (!pViewer)
+    {
+        return;
+    }
+    const QString strRanges = QInputDialog::getText(this, "Split Document",
+        "Page ranges, one output file per range (e.g. 1-20; 21-35; 36):");
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+    const QStringList lstRanges = strRanges.split(';', Qt::SkipEmptyParts);
+#else
+    const QStringList lstRanges = strRanges.split(';', QString::SkipEmptyParts);
+#endif
+    if (lstRanges.isEmpty())
+    {
+        return;
+    }
+    const QString strOutput = QFileDialog::getSaveFileName(this, "Save Split Files As", pViewer->filePath(),
+        "PDF Files (*.pdf)");
+    if (!strOutput.isEmpty())
+    {
+        runAssembly(planSplit(pViewer->filePath(), lstRanges, strOutput));
+    }
+}
+
+void DocumentWorkspace::promptExtract()
+{
+    PDFViewer* pViewer = currentViewer();
+    if (!pViewer)
+    {
+        return;
+    }
+    const QString strPages = QInputDialog::getText(this, "Extract Pages", "Pages to extract (e.g. 1,3,5-7):");
+    if (strPages.trimmed().isEmpty())
+    {
+        return;
+    }
+    const QString strOutput = QFileDialog::getSaveFileName(this, "Save Extracted Pages As", QString(),
+        "PDF Files (*.pdf)");
+    if (!strOutput.isEmpty())
+    {
+        runAssembly(planExtract(pViewer->filePath(), strPages, strOutput));
+    }
+}
+
+/*!
+ * @brief 拼版审图用的打印文件。
+ *
+ * 源页面以表单 XObject 引用，输出保持矢量，千页级的审图册也只需数秒、文件很小。
+ */
+void DocumentWorkspace::promptImpose()
+{
+    const QStringList lstLayouts = QStringList() << "2 pages per sheet" << "4 pages per sheet"
+        << "8 pages per sheet" << "Tile onto A3 sheets" << "Tile onto A4 sheets";
+    bool bOk = false;
+    const QString strLayout = QInputDialog::getItem(this, "Impose Pages", "Layout:", lstLayouts, 1, false, &bOk);
+    if (!bOk)
+    {
+        return;
+    }
+    PageImposition imposition;
+    const int nLayout = lstLayouts.indexOf(strLayout);
+    if (nLayout < 3)
+    {
+        imposition.eLayout = PageImposition::NUp;
+        imposition.nPagesPerSheet = 2 << nLayout;
+    }
+    else
+    {
+        imposition.eLayout = PageImposition::Tiles;
+        parseSheetSize(nLayout == 3 ? "a3" : "a4", imposition.oSheetSize);
+    }
+
+    const QStringList lstSources = QFileDialog::getOpenFileNames(this, "Select PDF Files to Impose", QString(),
+        "PDF Files (*.pdf)");
+    if (lstSources.isEmpty())
+    {
+        return;
+    }
+    const QString strOutput = QFileDialog::getSaveFileName(this, "Save Imposed PDF As", QString(),
+        "PDF Files (*.pdf)");
+    if (!strOutput.isEmpty())
+    {
+        runAssembly(planImpose(lstSources, imposition, strOutput));
+    }
+}
+
+/*!
+ * @brief 在工作进程中执行装配任务。
+ *
+ * 每个输出文件由一个工作进程生成，互不相关的输出文件并行生成，界面线程与 PDFium 执行线程都不受影响。
+ *
+ * @param vecJobs 装配任务，每个任务生成一个文件
+ */
+void DocumentWorkspace::runAssembly(const QVector<PageAssemblyJob>& vecJobs)
+{
+    if (m_pAssemblyRunner->isRunning())
+    {
+        QMessageBox::information(this, "Pages", "Another merge, split or extract operation is still running.");
+        return;
+    }
+
+    m_lstAssemblyOutputs.clear();
+    m_lstAssemblyErrors.clear();
+    if (!m_pAssemblyProgress)
+    {
+        m_pAssemblyProgress = new QProgressDialog("Assembling PDF files...", "Cancel", 0, 1, this);
+        m_pAssemblyProgress->setWindowModality(Qt::NonModal);
+        m_pAssemblyProgress->setMinimumDuration(500);
+        connect(m_pAssemblyProgress, &QProgressDialog::canceled, m_pAssemblyRunner, &PageAssemblyRunner::cancel);
+    }
+    m_pAssemblyProgress->setMaximum(vecJobs.size());
+    m_pAssemblyProgress->setValue(0);
+    m_pAssemblyRunner->start(vecJobs);
+}
+
+/*!
+ * @brief 报告装配结果；只生成了一个文件时在新标签页中打开。
+ *
+ * @param report 本批任务的汇总
+ */
+void DocumentWorkspace::onAssemblyFinished(const PageAssemblyReport& report)
+{
+    if (m_pAssemblyProgress)
+    {
+        m_pAssemblyProgress->reset();
+    }
+
+    QString strMessage = QStringLiteral("%1 file(s), %2 pages in %3 s (%4 pages/s).")
+        .arg(report.nFiles).arg(report.nPages).arg(report.nMilliseconds / 1000.0, 0, 'f', 2)
+        .arg(report.pagesPerSecond(), 0, 'f', 1);
+    if (report.bCanceled)
+    {
+        strMessage += "\nCanceled.";
+    }
+    if (!m_lstAssemblyErrors.isEmpty())
+    {
+        strMessage += "\n\n" + m_lstAssemblyErrors.join('\n');
+        QMessageBox::warning(this, "Pages", strMessage);
+    }
+    else
+    {
+        QMessageBox::information(this, "Pages", strMessage);
+    }
+
+    if (m_lstAssemblyOutputs.size() == 1 && !report.bCanceled)
+    {
+        openDocument(m_lstAssemblyOutputs.first());
+    }
+}
+
+/*!
+ * @brief 报告保存结果。
+ *
+ * 成功且全部编辑都已写入时不打扰用户；失败或取消时显示原因，有编辑未能写入时给出数量。
+ * 共享同一文档的标签页重新读取注释。
+ *
+ * @param pViewer 发起保存的查看器
+ * @param bSucceeded 文件是否已写入
+ * @param nSkippedEdits 未能写回文档的注释编辑数
+ * @param strError 失败原因
+ */
+void DocumentWorkspace::onSaveFinished(PDFViewer* pViewer, const bool bSucceeded, const int nSkippedEdits,
+    const QString& strError)
+{
+    // 保存时编辑已写回共享的 PDFium 文档（即使写盘失败），删除会改变注释下标，
+    // 共享该文档的标签页都重新读取注释；依赖外观流的注释画在页面位图里，显示该页的标签页重新渲染
+    for (int i = 0; i < count(); ++i)
+    {
+        PDFViewer* pOther = viewerAt(i);
+        if (pOther && pOther->documentId() == pViewer->documentId())
+        {
+            pOther->reloadAnnotations();
+            if (pOther->pageIndex() == pViewer->pageIndex())
+            {
+                pOther->reloadPage();
+            }
+        }
+    }
+
+    const QString strName = QFileInfo(pViewer->filePath()).fileName();
+    if (!bSucceeded)
+    {
+        QMessageBox::warning(this, "Save", QStringLiteral("%1 was not saved: %2").arg(strName, strError));
+    }
+    else if (nSkippedEdits > 0)
+    {
+        QMessageBox::warning(this, "Save", QStringLiteral("%1 was saved, but %2 annotation edit(s) could not be "
+            "written to the document.").arg(strName).arg(nSkippedEdits));
+    }
+
+    // 等待保存的标签页保存成功后再关闭，失败时保留以便用户处理；信号由查看器发出，删除推迟到返回事件循环之后
+    if (m_setClosingViewers.remove(pViewer) && bSucceeded)
+    {
+        QTimer::singleShot(0, this, [this, pViewer]()
+            {
+                for (int i = 0; i < count(); ++i)
+                {
+                    if (viewerAt(i) == pViewer)
+                    {
+                        onTabCloseRequested(i);
+                        return;
+                    }
+                }
+            });
+    }
+}
+
+/*!
+ * @brief 切换标签页：旧标签页降为后台，新标签页立即显示缓存内容并请求全分辨率渲染。
+ *
+ * @param nIndex 新的当前标签页下标
+ */
+void DocumentWorkspace::onCurrentChanged(const int nIndex)
+{
+    PDFViewer* pViewer = viewerAt(nIndex);
+    if (pViewer == m_pActiveViewer)
+    {
+        return;
+    }
+
+    if (m_pActiveViewer)
+    {
+        m_pActiveViewer->setActive(false);
+    }
+    m_pActiveViewer = pViewer;
+    if (m_pActiveViewer)
+    {
+        m_pActiveViewer->setActive(true);
+    }
+    emit currentViewerChanged(m_pActiveViewer);
+}
+
+/*!
+ * @brief 关闭标签页，释放该文档的缓存和尚未开始的渲染请求。
+ *
+ * 同一文件在其他标签页中仍然打开时共享同一文档，此时保留缓存。
+ *
+ * @param nIndex 要关闭的标签页下标
+ */
+void DocumentWorkspace::onTabCloseRequested(const int nIndex)
+{
+    PDFViewer* pViewer = viewerAt(nIndex);
+    if (pViewer && !confirmClose(pViewer))
+    {
+        return;
+    }
+
+    QWidget* pPage = widget(nIndex);
+    if (pViewer == m_pActiveViewer)
+    {
+        m_pActiveViewer = nullptr;
+        emit currentViewerChanged(nullptr);
+    }
+
+    const quint64 nDocumentId = pViewer ? pViewer->documentId() : 0;
+    removeTab(nIndex);
+    delete pPage;
+
+    bool bShared = false;
+    for (int i = 0; i < count(); ++i)
+    {
+        const PDFViewer* pOther = viewerAt(i);
+        bShared = bShared || (pOther && pOther->documentId() == nDocumentId);
+    }
+    if (nDocumentId != 0 && !bShared)
+    {
+        RenderScheduler::instance().cancelDocument(nDocumentId);
+        RenderCache::instance().removeDocument(nDocumentId);
+    }
+
+    // removeTab 可能已切换当前标签页，保证其处于前台
+    onCurrentChanged(currentIndex());
+}
+
+/*!
+ * @brief 关闭标签页前处理未保存的编辑与进行中的保存。
+ *
+ * 保存进行中时不打断写盘，等保存成功后再关闭；有未保存的编辑时询问保存、放弃或取消，
+ * 选择保存则启动保存并同样等其成功。保存完成后若又有新的编辑，再次关闭时会重新询问。
+ *
+ * @param pViewer 要关闭的查看器
+ * @return 是否可以立即关闭
+ */
+bool DocumentWorkspace::confirmClose(PDFViewer* pViewer)
+{
+    if (m_setClosingViewers.contains(pViewer))
+    {
+        return false;
+    }
+
+    const QString strName = QFileInfo(pViewer->filePath()).fileName();
+    if (pViewer->isSaving())
+    {
+        m_setClosingViewers.insert(pViewer);
+        QMessageBox::information(this, "Close", QStringLiteral("%1 is being saved and will close when the save "
+            "finishes.").arg(strName));
+        return false;
+    }
+    if (!pViewer->hasUnsavedEdits())
+    {
+        return true;
+    }
+
+    const QMessageBox::StandardButton eChoice = QMessageBox::question(this, "Close",
+        QStringLiteral("%1 has unsaved annotation edits. Save them before closing?").arg(strName),
+        QMessageBox::Save | QMessageBox::Discard | QMessageBox::Cancel, QMessageBox::Save);
+    if (eChoice == QMessageBox::Discard)
+    {
+        return true;
+    }
+    if (eChoice == QMessageBox::Save && pViewer->saveAnnotations())
+    {
+        m_setClosingViewers.insert(pViewer);
+    }
+    return false;
+}
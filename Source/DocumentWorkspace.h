@@ -0,0 +1,104 @@
+﻿/*!
+ * @brief 多文档标签页工作区的头文件。
+ *
+ * 本文件定义了 `DocumentWorkspace` 类。每个标签页承载一个 `PDFViewer`，全部标签页共享同一个
+ * `RenderScheduler` 和同一个 `RenderCache` 内存预算：当前标签页的渲染请求优先执行，
+ * 切到后台的标签页只保留低分辨率位图。
+ *
+ * @author LiuYe
+ * @date 2026-10-19
+ * @copyright (c) 2013-2026 Honghu Yuntu Corporation
+ */
+
+#pragma once
+
+#include <QSet>
+#include <QStringList>
+#include <QTabWidget>
+
+#include "color_scheme.h"
+#include "page_assembly.h"
+
+class PDFViewer;
+class QProgressDialog;
+class QScrollArea;
+
+/*!
+ * @brief 以标签页方式同时打开多个文档的工作区。
+ *
+ * @param pParent 父窗口对象，默认为 nullptr
+ * @date 2026.10.19
+ */
+class DocumentWorkspace : public QTabWidget
+{
+    Q_OBJECT
+
+public:
+    explicit DocumentWorkspace(QWidget* pParent = nullptr);
+
+    // 在新标签页中打开文档并切换到该标签页
+    PDFViewer* openDocument(const QString& strPath);
+    void openDocuments(const QStringList& lstPaths);
+
+    PDFViewer* viewerAt(int nIndex) const;
+    PDFViewer* currentViewer() const;
+
+    // 全部标签页使用同一颜色方案，新打开的文档沿用
+    void setColorScheme(ColorScheme eColorScheme);
+    ColorScheme colorScheme() const
+    {
+        return m_eColorScheme;
+    }
+
+    // 全部标签页以 8 位灰度渲染，新打开的文档沿用
+    void setGrayscale(bool bGrayscale);
+    bool isGrayscale() const
+    {
+        return m_bGrayscale;
+    }
+
+    // 全部标签页的页面适应窗口宽度，新打开的文档沿用
+    void setFitToWidth(bool bFitToWidth);
+    bool isFitToWidth() const
+    {
+        return m_bFitToWidth;
+    }
+
+signals:
+    void currentViewerChanged(PDFViewer* pViewer); // 前台查看器变化，没有标签页时为 nullptr
+
+public slots:
+    void promptOpen(); // 弹出文件对话框选择要打开的文档
+    void promptMerge(); // 选择若干文档合并为一个文件
+    void promptSplit(); // 按页码范围把当前文档拆分为多个文件
+    void promptExtract(); // 把当前文档的指定页提取为一个文件
+    void promptImpose(); // 选择若干文档按 N-up 或平铺方式拼版
+
+protected:
+    bool eventFilter(QObject* pWatched, QEvent* pEvent) override;
+
+private slots:
+    void onCurrentChanged(int nIndex);
+    void onTabCloseRequested(int nIndex);
+
+private:
+    // 在工作进程中执行装配任务，进度对话框可取消，结束时报告吞吐量
+    void runAssembly(const QVector<PageAssemblyJob>& vecJobs);
+    void onAssemblyFinished(const PageAssemblyReport& report);
+    // 保存失败、取消或有编辑未能写入时告知用户
+    void onSaveFinished(PDFViewer* pViewer, bool bSucceeded, int nSkippedEdits, const QString& strError);
+    // 关闭标签页前确认未保存的编辑；返回 false 时保留标签页，等待保存完成后再次尝试关闭
+    bool confirmClose(PDFViewer* pViewer);
+    // 按滚动区域当前的大小设置查看器的适应宽度
+    void applyFitWidth(QScrollArea* pScrollArea);
+
+    PDFViewer* m_pActiveViewer; // 当前处于前台的查看器
+    ColorScheme m_eColorScheme; // 页面颜色方案
+    bool m_bGrayscale; // 是否以灰度渲染页面
+    bool m_bFitToWidth; // 页面是否适应窗口宽度
+    PageAssemblyRunner* m_pAssemblyRunner; // 合并、拆分、提取的工作进程调度
+    QProgressDialog* m_pAssemblyProgress;
+    QStringList m_lstAssemblyOutputs; // 本批成功生成的文件
+    QStringList m_lstAssemblyErrors;
+    QSet<PDFViewer*> m_setClosingViewers; // 等待保存完成后关闭的查看器
+};
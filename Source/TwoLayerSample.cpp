@@ -6,9 +6,10 @@
  * 转换成一个可交互、可编辑的树形结构，便于显示和操作复杂的数据。
  *
  * 该文件的主要功能包括：
- * 1. 加载 QSS 样式表文件来定制 QTreeWidget 的外观。
- * 2. 初始化 QTreeWidget 的列标题并设置父子项，以及相关属性如背景色、字体等。
- * 3. 响应 QTreeWidget 的列头点击事件并显示对应的提示信息。
+ * 1. 以调色板、委托与代理样式（tree_theme.h）定制 QTreeWidget 的外观，不使用样式表。
+ * 2. 初始化 QTreeWidget 的列标题并设置父子项。
+ * 3. 响应 QTreeWidget 的列头点击事件，按该列的预计算排序键在后台排序。
+ * 4. 提供过滤栏，按类型、页码范围、颜色和内容/备注子串增量过滤。
  *
  * @author LiuYe
  * @date 2024-09-27
@@ -17,11 +18,55 @@
 
 
 #include "TwoLayerSample.h"
+#include "tree_theme.h"
 
-#include <QMessageBox>
 #include <QHeaderView>
-#include <QFont>
-#include <QFile>
+#include <QTimer>
+#include <QColor>
+#include <QComboBox>
+#include <QSpinBox>
+#include <QLineEdit>
+#include <QHBoxLayout>
+#include <QSet>
+#include <QtConcurrent/QtConcurrentRun>
+
+#include <algorithm>
+
+namespace {
+    // 注释树节点类型，用于识别携带排序名次的节点
+    const int kAnnotationItemType = QTreeWidgetItem::UserType + 1;
+
+    /*!
+     * @brief 携带排序名次的注释树节点。
+     *
+     * 后台排序完成后只把名次写入节点，再交给 QTreeWidget::sortItems 在模型内部重排，
+     * 比较时只读整数，展开、隐藏和选中状态随持久索引保留。
+     */
+    class AnnotationTreeItem : public QTreeWidgetItem {
+    public:
+        explicit AnnotationTreeItem(QTreeWidget* pParent) : QTreeWidgetItem(pParent, kAnnotationItemType), m_nRank(0) {}
+        explicit AnnotationTreeItem(QTreeWidgetItem* pParent)
+            : QTreeWidgetItem(pParent, kAnnotationItemType), m_nRank(0) {}
+
+        void setRank(const quint32 nRank) { m_nRank = nRank; }
+
+        bool operator<(const QTreeWidgetItem& other) const override {
+            if (other.type() != kAnnotationItemType) {
+                return QTreeWidgetItem::operator<(other);
+            }
+            return m_nRank < static_cast<const AnnotationTreeItem&>(other).m_nRank;
+        }
+
+    private:
+        quint32 m_nRank;
+    };
+
+    void setItemRank(QTreeWidgetItem* pItem, const quint32 nRank) {
+        if (pItem->type() == kAnnotationItemType) {
+            static_cast<AnnotationTreeItem*>(pItem)->setRank(nRank);
+        }
+    }
+}
 
  /*!
   * @brief TreeWidgetManager 构造函数，用于初始化树形控件管理器。
@@ -33,28 +78,35 @@
   * @date 2024.09.29
   */
 TreeWidgetManager::TreeWidgetManager(QTreeWidget* treeWidget, QObject* parent)
-    : QObject(parent), m_pTreeWidget(treeWidget) {
+    : QObject(parent), m_pTreeWidget(treeWidget), m_pRecords(std::make_shared<AnnotationRecordList>()),
+    m_nRecordsVersion(0), m_nSortColumn(-1), m_bSortAscending(true), m_bSortPending(false),
+    m_pSortWatcher(new QFutureWatcher<AnnotationRowList>(this)), m_nSortVersion(0), m_bFilterPending(false),
+    m_pFilterWatcher(new QFutureWatcher<AnnotationRowList>(this)), m_nFilterVersion(0),
+    m_pFilterTimer(new QTimer(this)), m_pGroupCombo(nullptr), m_pPageMinSpin(nullptr), m_pPageMaxSpin(nullptr),
+    m_pColorEdit(nullptr), m_pTextEdit(nullptr) {
+    connect(m_pSortWatcher, &QFutureWatcher<AnnotationRowList>::finished, this, &TreeWidgetManager::onSortFinished);
+    connect(m_pFilterWatcher, &QFutureWatcher<AnnotationRowList>::finished, this, &TreeWidgetManager::onFilterFinished);
+
+    // 连续输入时合并为一次过滤
+    m_pFilterTimer->setSingleShot(true);
+    m_pFilterTimer->setInterval(80);
+    connect(m_pFilterTimer, &QTimer::timeout, this, &TreeWidgetManager::startFilter);
 }
 
 /*!
  * @brief 初始化和设置 QTreeWidget 的各项属性、外观和内容。
  *
- * setupTreeWidget() 函数负责配置树形控件，包括设置样式、添加列标题、添加父子节点并设置可编辑性等。
- * 它还配置了各个父子项的字体、背景颜色，并设置列宽和整体控件的大小。
+ * setupTreeWidget() 函数负责配置树形控件，包括设置外观、添加列标题、添加父子节点并设置可编辑性等，
+ * 并设置列宽和整体控件的大小。字体（16pt）与分组行的灰色背景由 applyTreeTheme() 统一设置，
+ * 节点上不再逐项保存字体和背景。
  *
  * @author LiuYe
  * @date 2024.09.29
  */
 void TreeWidgetManager::setupTreeWidget() {
 
-    QFile file(":/styles.qss"); // 假设文件放在资源文件中
-    if (file.open(QFile::ReadOnly)) {
-        const QString styleSheet = QLatin1String(file.readAll());
-        m_pTreeWidget->setStyleSheet(styleSheet); // 设置样式表
-    }
-    else {
-        qWarning("无法加载QSS文件");
-    }
+    // 样式表按单元格匹配规则，大量注释时滚动很慢；改用调色板、委托与代理样式
+    applyTreeTheme(m_pTreeWidget);
 
     // 设置列标题
     m_pTreeWidget->setColumnCount(6);
@@ -65,22 +117,13 @@ void TreeWidgetManager::setupTreeWidget() {
     m_pTreeWidget->header()->setSectionsClickable(true);
     QObject::connect(m_pTreeWidget->header(), &QHeaderView::sectionClicked, this, &TreeWidgetManager::onHeaderClicked);
 
-    // 设置整个树的字体大小
-    QFont font = m_pTreeWidget->font();
-    font.setPointSize(16); // 设置字体大小为16
-    m_pTreeWidget->setFont(font);
-
-    // 添加父节点 "Length" 并设置背景颜色
-    QTreeWidgetItem* lengthItem = new QTreeWidgetItem(m_pTreeWidget);
+    // 添加父节点 "Length"
+    QTreeWidgetItem* lengthItem = new AnnotationTreeItem(m_pTreeWidget);
     lengthItem->setText(0, "Length");
-    lengthItem->setFont(0, font);  // 设置字体大小
-    for (int i = 0; i < m_pTreeWidget->columnCount(); ++i) {
-        lengthItem->setBackground(i, QBrush(Qt::gray));  // 将背景颜色设置为灰色
-    }
 
     // 添加子节点并使其可编辑
     for (int i = 1; i <= 3; ++i) {
-        QTreeWidgetItem* subItem = new QTreeWidgetItem(lengthItem);
+        QTreeWidgetItem* subItem = new AnnotationTreeItem(lengthItem);
         subItem->setText(0, QString("Length %1").arg(i));
         subItem->setText(1, QString::number(i)); // 设置页面号
         subItem->setText(4, QString("Editable content %1").arg(i)); // 设置内容
@@ -88,17 +131,13 @@ void TreeWidgetManager::setupTreeWidget() {
     }
     lengthItem->setExpanded(true);
 
-    // 添加父节点 "Area" 并设置背景颜色
-    QTreeWidgetItem* areaItem = new QTreeWidgetItem(m_pTreeWidget);
+    // 添加父节点 "Area"
+    QTreeWidgetItem* areaItem = new AnnotationTreeItem(m_pTreeWidget);
     areaItem->setText(0, "Area");
-    areaItem->setFont(0, font);  // 设置字体大小
-    for (int i = 0; i < m_pTreeWidget->columnCount(); ++i) {
-        areaItem->setBackground(i, QBrush(Qt::gray));  // 设置灰色背景
-    }
 
     // 添加子节点并使其可编辑
     for (int i = 1; i <= 2; ++i) {
-        QTreeWidgetItem* subItem = new QTreeWidgetItem(areaItem);
+        QTreeWidgetItem* subItem = new AnnotationTreeItem(areaItem);
         subItem->setText(0, QString("Area %1").arg(i));
         subItem->setText(1, QString::number(i + 3)); // 设置页面号
         subItem->setText(4, QString("Editable content %1").arg(i + 3)); // 设置内容
@@ -106,17 +145,13 @@ void TreeWidgetManager::setupTreeWidget() {
     }
     areaItem->setExpanded(true);
 
-    // 添加父节点 "Text" 并设置背景颜色
-    QTreeWidgetItem* textItem = new QTreeWidgetItem(m_pTreeWidget);
+    // 添加父节点 "Text"
+    QTreeWidgetItem* textItem = new AnnotationTreeItem(m_pTreeWidget);
     textItem->setText(0, "Text");
-    textItem->setFont(0, font);  // 设置字体大小
-    for (int i = 0; i < m_pTreeWidget->columnCount(); ++i) {
-        textItem->setBackground(i, QBrush(Qt::gray));  // 设置灰色背景
-    }
 
     // 添加子节点并使其可编辑
     for (int i = 1; i <= 2; ++i) {
-        QTreeWidgetItem* subItem = new QTreeWidgetItem(textItem);
+        QTreeWidgetItem* subItem = new AnnotationTreeItem(textItem);
         subItem->setText(0, QString("Text %1").arg(i));
         subItem->setText(1, QString::number(i + 5)); // 设置页面号
         subItem->setText(4, QString("Editable content %1").arg(i + 5)); // 设置内容
@@ -132,18 +167,340 @@ void TreeWidgetManager::setupTreeWidget() {
 
     // 设置控件的最小尺寸
     m_pTreeWidget->setMinimumSize(1800, 1200);
+
+    m_pTreeWidget->header()->setSortIndicatorShown(false);
+    QObject::connect(m_pTreeWidget, &QTreeWidget::itemChanged, this, &TreeWidgetManager::onItemChanged);
+    rebuildRecords();
+}
+
+/*!
+ * @brief 根据树中的全部子节点重新生成排序/过滤记录。
+ *
+ * 每个父节点视为一个分组，其子节点各对应一行记录。批量加载注释后调用一次即可，
+ * 后续的排序和过滤只读取这里预计算的键值。
+ *
+ * @date 2026.10.19
+ */
+void TreeWidgetManager::rebuildRecords() {
+    std::shared_ptr<AnnotationRecordList> pRecords = std::make_shared<AnnotationRecordList>();
+    m_vecItems.clear();
+    m_hashRows.clear();
+    m_vecVisible.clear();
+
+    QString texts[AnnotationColumnCount];
+    for (int i = 0; i < m_pTreeWidget->topLevelItemCount(); ++i) {
+        QTreeWidgetItem* groupItem = m_pTreeWidget->topLevelItem(i);
+        const QString group = groupItem->text(AnnotationColumnType);
+        for (int j = 0; j < groupItem->childCount(); ++j) {
+            QTreeWidgetItem* subItem = groupItem->child(j);
+            for (int c = 0; c < AnnotationColumnCount; ++c) {
+                texts[c] = subItem->text(c);
+            }
+            m_hashRows.insert(subItem, static_cast<quint32>(m_vecItems.size()));
+            m_vecItems.push_back(subItem);
+            m_vecVisible.push_back(subItem->isHidden() ? 0 : 1);
+            pRecords->push_back(AnnotationSortFilter::makeRecord(group, texts));
+        }
+    }
+
+    m_pRecords = pRecords;
+    ++m_nRecordsVersion;
+    m_oAppliedFilter = AnnotationFilter();
+    m_vecFilteredRows = AnnotationSortFilter::allRows(static_cast<quint32>(m_vecItems.size()));
+
+    if (m_pGroupCombo) {
+        const QString current = m_pGroupCombo->currentData().toString();
+        const QSignalBlocker blocker(m_pGroupCombo);
+        m_pGroupCombo->clear();
+        m_pGroupCombo->addItem(tr("All types"), QString());
+        for (int i = 0; i < m_pTreeWidget->topLevelItemCount(); ++i) {
+            const QString group = m_pTreeWidget->topLevelItem(i)->text(AnnotationColumnType);
+            m_pGroupCombo->addItem(group, group);
+        }
+        m_pGroupCombo->setCurrentIndex(std::max(0, m_pGroupCombo->findData(current)));
+    }
+    scheduleFilter();
+}
+
+/*!
+ * @brief 创建注释过滤栏。
+ *
+ * 过滤栏包含类型、页码范围、颜色和内容/备注搜索框，任一输入变化都会在短暂延迟后触发过滤。
+ * 输入框逐字输入时新条件比旧条件更严格，只在上一次结果中继续筛选。
+ *
+ * @param pParent 过滤栏的父窗口
+ * @return 过滤栏控件
+ * @date 2026.10.19
+ */
+QWidget* TreeWidgetManager::createFilterBar(QWidget* pParent) {
+    QWidget* pBar = new QWidget(pParent);
+    QHBoxLayout* pLayout = new QHBoxLayout(pBar);
+    pLayout->setContentsMargins(0, 0, 0, 0);
+
+    m_pGroupCombo = new QComboBox(pBar);
+    m_pGroupCombo->addItem(tr("All types"), QString());
+    for (int i = 0; i < m_pTreeWidget->topLevelItemCount(); ++i) {
+        const QString group = m_pTreeWidget->topLevelItem(i)->text(AnnotationColumnType);
+        m_pGroupCombo->addItem(group, group);
+    }
+
+    // 页码为 0 时表示不限
+    m_pPageMinSpin = new QSpinBox(pBar);
+    m_pPageMinSpin->setRange(0, 999999);
+    m_pPageMinSpin->setSpecialValueText(tr("From page"));
+    m_pPageMaxSpin = new QSpinBox(pBar);
+    m_pPageMaxSpin->setRange(0, 999999);
+    m_pPageMaxSpin->setSpecialValueText(tr("To page"));
+
+    m_pColorEdit = new QLineEdit(pBar);
+    m_pColorEdit->setPlaceholderText(tr("Color (#RRGGBB)"));
+    m_pTextEdit = new QLineEdit(pBar);
+    m_pTextEdit->setPlaceholderText(tr("Search content / remark"));
+    m_pTextEdit->setClearButtonEnabled(true);
+
+    pLayout->addWidget(m_pGroupCombo);
+    pLayout->addWidget(m_pPageMinSpin);
+    pLayout->addWidget(m_pPageMaxSpin);
+    pLayout->addWidget(m_pColorEdit);
+    pLayout->addWidget(m_pTextEdit, 1);
+
+    connect(m_pGroupCombo, static_cast<void (QComboBox::*)(int)>(&QComboBox::currentIndexChanged),
+        this, &TreeWidgetManager::scheduleFilter);
+    connect(m_pPageMinSpin, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged),
+        this, &TreeWidgetManager::scheduleFilter);
+    connect(m_pPageMaxSpin, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged),
+        this, &TreeWidgetManager::scheduleFilter);
+    connect(m_pColorEdit, &QLineEdit::textChanged, this, &TreeWidgetManager::scheduleFilter);
+    connect(m_pTextEdit, &QLineEdit::textChanged, this, &TreeWidgetManager::scheduleFilter);
+    return pBar;
 }
 
 /*!
  * @brief 当点击树形控件的列标题时触发。
  *
- * 此槽函数将在用户点击 QTreeWidget 的列标题时被调用，显示相应列名的消息框。
+ * 此槽函数将在用户点击 QTreeWidget 的列标题时被调用，按该列排序；重复点击同一列时切换升降序。
+ * 排序在后台线程中进行，完成后在模型内部按名次重排节点。
  *
  * @param index 被点击的列索引。
  * @date 2024.09.29
  */
 void TreeWidgetManager::onHeaderClicked(const int index) {
-    QStringList headers = { "Type", "Page", "Color", "Length", "Content", "Remark" };
-    QMessageBox::information(nullptr, "Header Clicked", headers[index] + " header was clicked");
+    if (index < 0 || index >= AnnotationColumnCount) {
+        return;
+    }
+
+    m_bSortAscending = (index == m_nSortColumn) ? !m_bSortAscending : true;
+    m_nSortColumn = index;
+    m_pTreeWidget->header()->setSortIndicatorShown(true);
+    m_pTreeWidget->header()->setSortIndicator(index, m_bSortAscending ? Qt::AscendingOrder : Qt::DescendingOrder);
+    startSort();
 }
 
+/*!
+ * @brief 单元格被编辑后刷新该行的排序/过滤记录。
+ *
+ * 记录快照可能正被后台线程读取，这里复制一份再修改，不影响正在进行的排序或过滤。
+ *
+ * @param pItem 被编辑的节点
+ * @param nColumn 被编辑的列
+ * @date 2026.10.19
+ */
+void TreeWidgetManager::onItemChanged(QTreeWidgetItem* pItem, int nColumn) {
+    Q_UNUSED(nColumn);
+    const QHash<QTreeWidgetItem*, quint32>::const_iterator it = m_hashRows.constFind(pItem);
+    if (it == m_hashRows.constEnd() || !pItem->parent()) {
+        return;
+    }
+
+    QString texts[AnnotationColumnCount];
+    for (int c = 0; c < AnnotationColumnCount; ++c) {
+        texts[c] = pItem->text(c);
+    }
+
+    std::shared_ptr<AnnotationRecordList> pRecords = std::make_shared<AnnotationRecordList>(*m_pRecords);
+    (*pRecords)[it.value()] = AnnotationSortFilter::makeRecord(pItem->parent()->text(AnnotationColumnType), texts);
+    m_pRecords = pRecords;
+    ++m_nRecordsVersion;
+
+    // 已生效的结果不再可靠，下一次过滤从全部行开始
+    m_oAppliedFilter = AnnotationFilter();
+    m_vecFilteredRows = AnnotationSortFilter::allRows(static_cast<quint32>(m_vecItems.size()));
+    scheduleFilter();
+}
+
+void TreeWidgetManager::startSort() {
+    if (m_nSortColumn < 0) {
+        return;
+    }
+    if (m_pSortWatcher->isRunning()) {
+        m_bSortPending = true;
+        return;
+    }
+
+    const AnnotationRecordSnapshot records = m_pRecords;
+    const int nColumn = m_nSortColumn;
+    const bool bAscending = m_bSortAscending;
+    m_nSortVersion = m_nRecordsVersion;
+    m_bSortPending = false;
+    m_pSortWatcher->setFuture(QtConcurrent::run([records, nColumn, bAscending]() {
+        return AnnotationSortFilter::sortRows(records,
+            AnnotationSortFilter::allRows(static_cast<quint32>(records->size())), nColumn, bAscending);
+    }));
+}
+
+void TreeWidgetManager::onSortFinished() {
+    if (m_bSortPending || m_nSortVersion != m_nRecordsVersion) {
+        m_bSortPending = false;
+        startSort();
+        return;
+    }
+    applyOrder(m_pSortWatcher->result());
+}
+
+/*!
+ * @brief 按排序结果重排树节点。
+ *
+ * 只把排序结果写成各节点的名次，再由 QTreeWidget::sortItems 在模型内部按名次重排，
+ * 每个分组只发出一次布局变化，不再逐个取出和插回节点；展开和隐藏状态随持久索引保留。
+ * 按类型列排序时分组本身也按首次出现的顺序重排，否则分组保持原有顺序。
+ *
+ * @param order 排序后的行序号
+ */
+void TreeWidgetManager::applyOrder(const AnnotationRowList& order) {
+    if (order.size() != m_vecItems.size()) {
+        return;
+    }
+
+    for (size_t i = 0; i < order.size(); ++i) {
+        setItemRank(m_vecItems[order[i]], static_cast<quint32>(i));
+    }
+
+    const int nGroups = m_pTreeWidget->topLevelItemCount();
+    for (int i = 0; i < nGroups; ++i) {
+        setItemRank(m_pTreeWidget->topLevelItem(i), static_cast<quint32>(i));
+    }
+    if (m_nSortColumn == AnnotationColumnType) {
+        QSet<QTreeWidgetItem*> ranked;
+        for (size_t i = 0; i < order.size(); ++i) {
+            QTreeWidgetItem* groupItem = m_vecItems[order[i]]->parent();
+            if (!ranked.contains(groupItem)) {
+                setItemRank(groupItem, static_cast<quint32>(ranked.size()));
+                ranked.insert(groupItem);
+            }
+        }
+        // 没有子节点的分组排在最后，保持原有顺序
+        for (int i = 0; i < nGroups; ++i) {
+            QTreeWidgetItem* groupItem = m_pTreeWidget->topLevelItem(i);
+            if (!ranked.contains(groupItem)) {
+                setItemRank(groupItem, static_cast<quint32>(nGroups + i));
+            }
+        }
+    }
+
+    const QSignalBlocker blocker(m_pTreeWidget);
+    m_pTreeWidget->setUpdatesEnabled(false);
+    // 名次已包含方向，始终按升序重排；sortItems 会改写排序指示器，重排后恢复
+    m_pTreeWidget->sortItems(m_nSortColumn, Qt::AscendingOrder);
+    m_pTreeWidget->header()->setSortIndicator(m_nSortColumn,
+        m_bSortAscending ? Qt::AscendingOrder : Qt::DescendingOrder);
+    m_pTreeWidget->setUpdatesEnabled(true);
+}
+
+/*!
+ * @brief 读取过滤栏当前的过滤条件。
+ */
+AnnotationFilter TreeWidgetManager::currentFilter() const {
+    AnnotationFilter filter;
+    if (m_pGroupCombo) {
+        filter.strGroup = m_pGroupCombo->currentData().toString();
+    }
+    if (m_pPageMinSpin && m_pPageMinSpin->value() > 0) {
+        filter.nPageMin = m_pPageMinSpin->value();
+    }
+    if (m_pPageMaxSpin && m_pPageMaxSpin->value() > 0) {
+        filter.nPageMax = m_pPageMaxSpin->value();
+    }
+    if (m_pColorEdit) {
+        const QColor color(m_pColorEdit->text().trimmed());
+        if (color.isValid()) {
+            filter.bColor = true;
+            filter.color = color.rgb();
+        }
+    }
+    if (m_pTextEdit) {
+        filter.strText = m_pTextEdit->text().toCaseFolded();
+    }
+    return filter;
+}
+
+void TreeWidgetManager::scheduleFilter() {
+    m_pFilterTimer->start();
+}
+
+/*!
+ * @brief 在后台线程执行过滤。
+ *
+ * 新条件比已生效条件更严格时只扫描上一次的结果，否则扫描全部行；
+ * 过滤进行中再有输入时，等本次完成后再以最新条件重新过滤。
+ *
+ * @date 2026.10.19
+ */
+void TreeWidgetManager::startFilter() {
+    if (m_pFilterWatcher->isRunning()) {
+        m_bFilterPending = true;
+        return;
+    }
+
+    const AnnotationFilter filter = currentFilter();
+    m_bFilterPending = false;
+    if (filter == m_oAppliedFilter) {
+        applyVisibleRows(m_vecFilteredRows);
+        return;
+    }
+
+    const AnnotationRecordSnapshot records = m_pRecords;
+    const AnnotationRowList candidates = filter.isRefinementOf(m_oAppliedFilter)
+        ? m_vecFilteredRows : AnnotationSortFilter::allRows(static_cast<quint32>(records->size()));
+    m_oRunningFilter = filter;
+    m_nFilterVersion = m_nRecordsVersion;
+    m_pFilterWatcher->setFuture(QtConcurrent::run([records, candidates, filter]() {
+        return AnnotationSortFilter::filterRows(records, candidates, filter);
+    }));
+}
+
+void TreeWidgetManager::onFilterFinished() {
+    if (m_nFilterVersion == m_nRecordsVersion) {
+        m_oAppliedFilter = m_oRunningFilter;
+        m_vecFilteredRows = m_pFilterWatcher->result();
+        applyVisibleRows(m_vecFilteredRows);
+    }
+    if (m_bFilterPending || m_nFilterVersion != m_nRecordsVersion) {
+        startFilter();
+    }
+}
+
+/*!
+ * @brief 按过滤结果显示或隐藏节点。
+ *
+ * 只切换可见性发生变化的节点，逐字输入时通常只有少量节点需要隐藏。
+ *
+ * @param rows 需要显示的行，按行号升序
+ */
+void TreeWidgetManager::applyVisibleRows(const AnnotationRowList& rows) {
+    std::vector<char> visible(m_vecItems.size(), 0);
+    for (size_t i = 0; i < rows.size(); ++i) {
+        if (rows[i] < visible.size()) {
+            visible[rows[i]] = 1;
+        }
+    }
+
+    const QSignalBlocker blocker(m_pTreeWidget);
+    m_pTreeWidget->setUpdatesEnabled(false);
+    for (size_t i = 0; i < m_vecItems.size(); ++i) {
+        if (visible[i] != m_vecVisible[i]) {
+            m_vecItems[i]->setHidden(!visible[i]);
+        }
+    }
+    m_pTreeWidget->setUpdatesEnabled(true);
+    m_vecVisible.swap(visible);
+}
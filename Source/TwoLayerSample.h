@@ -13,6 +13,15 @@
 #pragma once
 
 #include <QTreeWidget>
+#include <QFutureWatcher>
+#include <QHash>
+
+#include "AnnotationSortFilter.h"
+
+class QComboBox;
+class QSpinBox;
+class QLineEdit;
+class QTimer;
 
 /*!
  * @brief 管理 QTreeWidget 控件的类，提供初始化和事件处理功能。
@@ -30,11 +39,49 @@ class TreeWidgetManager : public QObject {
 public:
     explicit TreeWidgetManager(QTreeWidget* treeWidget, QObject* parent = nullptr);
     void setupTreeWidget(); // Function to set up the tree structure
+    void rebuildRecords(); // 根据当前节点重新生成排序/过滤记录
+    QWidget* createFilterBar(QWidget* pParent); // 创建过滤栏
 
 private slots:
-    static void onHeaderClicked(int index); // Slot for handling header click
+    void onHeaderClicked(int index); // Slot for handling header click
+    void onItemChanged(QTreeWidgetItem* pItem, int nColumn); // 单元格编辑后刷新对应记录
+    void onSortFinished();
+    void onFilterFinished();
+    void scheduleFilter(); // 输入变化后延迟触发过滤
+    void startFilter();
 
 private:
+    void startSort();
+    void applyOrder(const AnnotationRowList& order);
+    void applyVisibleRows(const AnnotationRowList& rows);
+    AnnotationFilter currentFilter() const;
+
     QTreeWidget* m_pTreeWidget; // Pointer to QTreeWidget
+
+    AnnotationRecordSnapshot m_pRecords;          // 排序/过滤记录快照，可在后台线程只读访问
+    quint64 m_nRecordsVersion;                    // 快照版本，用于丢弃过期的后台结果
+    std::vector<QTreeWidgetItem*> m_vecItems;     // 行号 -> 节点
+    QHash<QTreeWidgetItem*, quint32> m_hashRows;  // 节点 -> 行号
+    std::vector<char> m_vecVisible;               // 每行当前是否可见
+
+    int m_nSortColumn;
+    bool m_bSortAscending;
+    bool m_bSortPending;                          // 排序进行中又有新的请求
+    QFutureWatcher<AnnotationRowList>* m_pSortWatcher;
+    quint64 m_nSortVersion;
+
+    AnnotationFilter m_oAppliedFilter;            // 已生效的过滤条件
+    AnnotationRowList m_vecFilteredRows;          // 已生效的过滤结果，按行号升序
+    AnnotationFilter m_oRunningFilter;            // 正在后台执行的过滤条件
+    bool m_bFilterPending;                        // 过滤进行中又有新的输入
+    QFutureWatcher<AnnotationRowList>* m_pFilterWatcher;
+    quint64 m_nFilterVersion;
+    QTimer* m_pFilterTimer;
+
+    QComboBox* m_pGroupCombo;
+    QSpinBox* m_pPageMinSpin;
+    QSpinBox* m_pPageMaxSpin;
+    QLineEdit* m_pColorEdit;
+    QLineEdit* m_pTextEdit;
 };
 
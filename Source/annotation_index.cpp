@@ -0,0 +1,448 @@
+﻿/*!
+ * @brief 单页注释几何缓存与命中测试的实现。
+ *
+ * @author LiuYe
+ * @date 2026-10-19
+ * @copyright (c) 2013-2026 Honghu Yuntu Corporation
+ */
+
+#include "annotation_index.h"
+
+#include "fpdf_annot.h"
+#include "monotonic_arena.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    bool boundsContain(const QRectF& oBounds, const QPointF& oPoint, const double dTolerance)
+    {
+        return oPoint.x() >= oBounds.left() - dTolerance && oPoint.x() <= oBounds.right() + dTolerance
+            && oPoint.y() >= oBounds.top() - dTolerance && oPoint.y() <= oBounds.bottom() + dTolerance;
+    }
+
+    // 点到线段的距离
+    double segmentDistance(const QPointF& oPoint, const QPointF& a, const QPointF& b)
+    {
+        const double dx = b.x() - a.x();
+        const double dy = b.y() - a.y();
+        const double dLengthSquared = dx * dx + dy * dy;
+        double t = 0.0;
+        if (dLengthSquared > 0.0)
+        {
+            t = ((oPoint.x() - a.x()) * dx + (oPoint.y() - a.y()) * dy) / dLengthSquared;
+            t = std::max(0.0, std::min(1.0, t));
+        }
+        const double px = a.x() + t * dx - oPoint.x();
+        const double py = a.y() + t * dy - oPoint.y();
+        return std::sqrt(px * px + py * py);
+    }
+
+    bool nearPath(const AnnotationPath& path, const QPointF& oPoint, const double dDistance, const bool bClosed)
+    {
+        if (path.size() == 1)
+        {
+            return segmentDistance(oPoint, path[0], path[0]) <= dDistance;
+        }
+        for (size_t i = 0; i + 1 < path.size(); ++i)
+        {
+            if (segmentDistance(oPoint, path[i], path[i + 1]) <= dDistance)
+            {
+                return true;
+            }
+        }
+        return bClosed && path.size() > 2 && segmentDistance(oPoint, path.back(), path.front()) <= dDistance;
+    }
+
+    // 奇偶规则判断点是否在多边形内
+    bool insidePolygon(const AnnotationPath& path, const QPointF& oPoint)
+    {
+        bool bInside = false;
+        for (size_t i = 0, j = path.size() - 1; i < path.size(); j = i++)
+        {
+            const QPointF& a = path[i];
+            const QPointF& b = path[j];
+            if ((a.y() > oPoint.y()) != (b.y() > oPoint.y())
+                && oPoint.x() < (b.x() - a.x()) * (oPoint.y() - a.y()) / (b.y() - a.y()) + a.x())
+            {
+                bInside = !bInside;
+            }
+        }
+        return bInside;
+    }
+
+    QColor readColor(FPDF_ANNOTATION annot, const FPDFANNOT_COLORTYPE type)
+    {
+        unsigned int r = 0;
+        unsigned int g = 0;
+        unsigned int b = 0;
+        unsigned int a = 0;
+        if (!FPDFAnnot_GetColor(annot, type, &r, &g, &b, &a))
+        {
+            return QColor();
+        }
+        return QColor(r, g, b, a);
+    }
+
+    // 带外观流的注释读不到颜色，按类型给出与常见阅读器一致的默认色
+    QColor defaultColor(const int nSubtype)
+    {
+        switch (nSubtype)
+        {
+        case FPDF_ANNOT_HIGHLIGHT:
+            return QColor(255, 255, 0);
+        case FPDF_ANNOT_TEXT:
+        case FPDF_ANNOT_FREETEXT:
+            return QColor(255, 200, 0);
+        default:
+            return QColor(255, 0, 0);
+        }
+    }
+
+    AnnotationPath toPath(const ArenaVector<FS_POINTF>& vecPoints)
+    {
+        AnnotationPath path;
+        path.reserve(vecPoints.size());
+        for (size_t i = 0; i < vecPoints.size(); ++i)
+        {
+            path.push_back(QPointF(vecPoints[i].x, vecPoints[i].y));
+        }
+        return path;
+    }
+}
+
+AnnotationGeometry::AnnotationGeometry()
+    : nId(-1), nAnnotIndex(-1), nSubtype(FPDF_ANNOT_UNKNOWN), fBorderWidth(1.0f), bHidden(false)
+{
+}
+
+PageAnnotations::PageAnnotations()
+    : m_nNextId(0)
+{
+}
+
+/*!
+ * @brief 读取页面上的全部注释并批量构建空间索引。
+ *
+ * 弹出窗口（Popup）注释不在页面上绘制，也不参与命中测试，因此不缓存。
+ *
+ * @param page 已加载的页面
+ * @param pScratch 临时缓冲区所用的 arena，由调用方在整页分析结束后一次释放
+ */
+void PageAnnotations::load(FPDF_PAGE page, MonotonicArena* pScratch)
+{
+    clear();
+    if (!page)
+    {
+        return;
+    }
+    MonotonicArena localScratch;
+    MonotonicArena& scratch = pScratch ? *pScratch : localScratch;
+
+    const int nCount = FPDFPage_GetAnnotCount(page);
+    m_vecItems.reserve(nCount);
+    std::vector<std::pair<int, QRectF>> vecEntries;
+    vecEntries.reserve(nCount);
+    for (int i = 0; i < nCount; ++i)
+    {
+        FPDF_ANNOTATION annot = FPDFPage_GetAnnot(page, i);
+        if (!annot)
+        {
+            continue;
+        }
+
+        AnnotationGeometry geometry = readGeometry(annot, scratch);
+        FPDFPage_CloseAnnot(annot);
+        if (geometry.nSubtype == FPDF_ANNOT_POPUP)
+        {
+            continue;
+        }
+
+        geometry.nId = m_nNextId++;
+        geometry.nAnnotIndex = i;
+        m_mapSlots[geometry.nId] = m_vecItems.size();
+        vecEntries.push_back(std::make_pair(geometry.nId, geometry.oBounds));
+        m_vecItems.push_back(geometry);
+    }
+    m_oIndex.build(vecEntries);
+}
+
+void PageAnnotations::clear()
+{
+    m_vecItems.clear();
+    m_mapSlots.clear();
+    m_oIndex.clear();
+}
+
+const AnnotationGeometry* PageAnnotations::find(const int nId) const
+{
+    const std::unordered_map<int, size_t>::const_iterator it = m_mapSlots.find(nId);
+    return it == m_mapSlots.end() ? nullptr : &m_vecItems[it->second];
+}
+
+/*!
+ * @brief 命中测试。
+ *
+ * @param oPoint 页面坐标点
+ * @param dTolerance 允许的误差，单位为 PDF 点
+ * @return 命中的最上层注释 id，未命中返回 -1
+ */
+int PageAnnotations::hitTest(const QPointF& oPoint, const double dTolerance) const
+{
+    m_vecHitCandidates.clear();
+    m_oIndex.queryPoint(oPoint, dTolerance, m_vecHitCandidates);
+
+    int nHit = -1;
+    int nTopIndex = -1;
+    for (size_t i = 0; i < m_vecHitCandidates.size(); ++i)
+    {
+        const AnnotationGeometry* pGeometry = find(m_vecHitCandidates[i]);
+        if (pGeometry && !pGeometry->bHidden && pGeometry->nAnnotIndex > nTopIndex
+            && containsPoint(*pGeometry, oPoint, dTolerance))
+        {
+            nHit = pGeometry->nId;
+            nTopIndex = pGeometry->nAnnotIndex;
+        }
+    }
+    return nHit;
+}
+
+void PageAnnotations::queryRect(const QRectF& oRect, std::vector<int>& vecIds) const
+{
+    m_oIndex.queryRect(oRect, vecIds);
+}
+
+int PageAnnotations::add(AnnotationGeometry geometry)
+{
+    geometry.nId = m_nNextId++;
+    m_mapSlots[geometry.nId] = m_vecItems.size();
+    m_oIndex.insert(geometry.nId, geometry.oBounds);
+    m_vecItems.push_back(geometry);
+    return geometry.nId;
+}
+
+bool PageAnnotations::update(const AnnotationGeometry& geometry)
+{
+    const std::unordered_map<int, size_t>::const_iterator it = m_mapSlots.find(geometry.nId);
+    if (it == m_mapSlots.end())
+    {
+        return false;
+    }
+
+    const bool bMoved = m_vecItems[it->second].oBounds != geometry.oBounds;
+    m_vecItems[it->second] = geometry;
+    if (bMoved)
+    {
+        m_oIndex.insert(geometry.nId, geometry.oBounds);
+    }
+    return true;
+}
+
+/*!
+ * @brief 删除注释，绘制顺序在其后的注释下标依次前移，与 PDFium 的注释数组保持一致。
+ */
+bool PageAnnotations::remove(const int nId)
+{
+    const std::unordered_map<int, size_t>::iterator it = m_mapSlots.find(nId);
+    if (it == m_mapSlots.end())
+    {
+        return false;
+    }
+
+    const size_t nSlot = it->second;
+    const int nAnnotIndex = m_vecItems[nSlot].nAnnotIndex;
+    m_mapSlots.erase(it);
+    m_oIndex.remove(nId);
+
+    if (nSlot + 1 != m_vecItems.size())
+    {
+        m_vecItems[nSlot] = m_vecItems.back();
+        m_mapSlots[m_vecItems[nSlot].nId] = nSlot;
+    }
+    m_vecItems.pop_back();
+
+    for (size_t i = 0; i < m_vecItems.size(); ++i)
+    {
+        if (m_vecItems[i].nAnnotIndex > nAnnotIndex)
+        {
+            --m_vecItems[i].nAnnotIndex;
+        }
+    }
+    return true;
+}
+
+/*!
+ * @brief 读取单个注释的几何信息。
+ *
+ * 直线、折线、多边形、墨迹读取其顶点；文本标记类注释（高亮、下划线等）读取四边形；
+ * 其余类型只使用注释矩形。
+ *
+ * @param annot 注释句柄
+ * @param scratch 临时缓冲区所用的 arena
+ * @return 几何信息，nId 与 nAnnotIndex 由调用方填写
+ */
+AnnotationGeometry PageAnnotations::readGeometry(FPDF_ANNOTATION annot, MonotonicArena& scratch)
+{
+    AnnotationGeometry geometry;
+    geometry.nSubtype = FPDFAnnot_GetSubtype(annot);
+
+    FS_RECTF rect;
+    if (FPDFAnnot_GetRect(annot, &rect))
+    {
+        geometry.oBounds = QRectF(QPointF(rect.left, rect.bottom), QPointF(rect.right, rect.top)).normalized();
+    }
+
+    geometry.oColor = readColor(annot, FPDFANNOT_COLORTYPE_Color);
+    if (!geometry.oColor.isValid())
+    {
+        geometry.oColor = defaultColor(geometry.nSubtype);
+    }
+    geometry.oInteriorColor = readColor(annot, FPDFANNOT_COLORTYPE_InteriorColor);
+
+    float fHorizontalRadius = 0.0f;
+    float fVerticalRadius = 0.0f;
+    float fBorderWidth = 0.0f;
+    if (FPDFAnnot_GetBorder(annot, &fHorizontalRadius, &fVerticalRadius, &fBorderWidth))
+    {
+        geometry.fBorderWidth = fBorderWidth;
+    }
+    geometry.bHidden = (FPDFAnnot_GetFlags(annot) & FPDF_ANNOT_FLAG_HIDDEN) != 0;
+
+    switch (geometry.nSubtype)
+    {
+    case FPDF_ANNOT_LINE:
+    {
+        FS_POINTF start;
+        FS_POINTF end;
+        if (FPDFAnnot_GetLine(annot, &start, &end))
+        {
+            AnnotationPath path;
+            path.push_back(QPointF(start.x, start.y));
+            path.push_back(QPointF(end.x, end.y));
+            geometry.vecPaths.push_back(path);
+        }
+        break;
+    }
+    case FPDF_ANNOT_POLYGON:
+    case FPDF_ANNOT_POLYLINE:
+    {
+        const unsigned long nPoints = FPDFAnnot_GetVertices(annot, nullptr, 0);
+        if (nPoints > 0)
+        {
+            ArenaVector<FS_POINTF> vecPoints(nPoints, FS_POINTF(), ArenaAllocator<FS_POINTF>(scratch));
+            FPDFAnnot_GetVertices(annot, vecPoints.data(), nPoints);
+            geometry.vecPaths.push_back(toPath(vecPoints));
+        }
+        break;
+    }
+    case FPDF_ANNOT_INK:
+    {
+        const unsigned long nPathCount = FPDFAnnot_GetInkListCount(annot);
+        for (unsigned long i = 0; i < nPathCount; ++i)
+        {
+            const unsigned long nPoints = FPDFAnnot_GetInkListPath(annot, i, nullptr, 0);
+            if (nPoints > 0)
+            {
+                ArenaVector<FS_POINTF> vecPoints(nPoints, FS_POINTF(), ArenaAllocator<FS_POINTF>(scratch));
+                FPDFAnnot_GetInkListPath(annot, i, vecPoints.data(), nPoints);
+                geometry.vecPaths.push_back(toPath(vecPoints));
+            }
+        }
+        break;
+    }
+    default:
+        if (FPDFAnnot_HasAttachmentPoints(annot))
+        {
+            const size_t nQuads = FPDFAnnot_CountAttachmentPoints(annot);
+            for (size_t i = 0; i < nQuads; ++i)
+            {
+                FS_QUADPOINTSF quad;
+                if (FPDFAnnot_GetAttachmentPoints(annot, i, &quad))
+                {
+                    // 四边形顶点按 1-2-4-3 的顺序连成多边形
+                    AnnotationPath path;
+                    path.push_back(QPointF(quad.x1, quad.y1));
+                    path.push_back(QPointF(quad.x2, quad.y2));
+                    path.push_back(QPointF(quad.x4, quad.y4));
+                    path.push_back(QPointF(quad.x3, quad.y3));
+                    geometry.vecPaths.push_back(path);
+                }
+            }
+        }
+        break;
+    }
+
+    const unsigned long nBytes = FPDFAnnot_GetStringValue(annot, "Contents", nullptr, 0);
+    if (nBytes > sizeof(FPDF_WCHAR))
+    {
+        ArenaVector<FPDF_WCHAR> vecBuffer(nBytes / sizeof(FPDF_WCHAR), 0, ArenaAllocator<FPDF_WCHAR>(scratch));
+        FPDFAnnot_GetStringValue(annot, "Contents", vecBuffer.data(), nBytes);
+        geometry.strContents = QString::fromUtf16(vecBuffer.data(), static_cast<int>(vecBuffer.size()) - 1);
+    }
+    return geometry;
+}
+
+/*!
+ * @brief 按注释类型精确判断点是否落在注释上。
+ */
+bool PageAnnotations::containsPoint(const AnnotationGeometry& geometry, const QPointF& oPoint, const double dTolerance)
+{
+    if (!boundsContain(geometry.oBounds, oPoint, dTolerance))
+    {
+        return false;
+    }
+
+    const double dDistance = dTolerance + geometry.fBorderWidth * 0.5;
+    switch (geometry.nSubtype)
+    {
+    case FPDF_ANNOT_LINE:
+    case FPDF_ANNOT_POLYLINE:
+    case FPDF_ANNOT_INK:
+        for (size_t i = 0; i < geometry.vecPaths.size(); ++i)
+        {
+            if (nearPath(geometry.vecPaths[i], oPoint, dDistance, false))
+            {
+                return true;
+            }
+        }
+        return geometry.vecPaths.empty();
+    case FPDF_ANNOT_POLYGON:
+        for (size_t i = 0; i < geometry.vecPaths.size(); ++i)
+        {
+            const AnnotationPath& path = geometry.vecPaths[i];
+            if (nearPath(path, oPoint, dDistance, true) || (path.size() > 2 && insidePolygon(path, oPoint)))
+            {
+                return true;
+            }
+        }
+        return geometry.vecPaths.empty();
+    case FPDF_ANNOT_CIRCLE:
+    {
+        const QPointF oCenter = geometry.oBounds.center();
+        const double rx = geometry.oBounds.width() * 0.5 + dTolerance;
+        const double ry = geometry.oBounds.height() * 0.5 + dTolerance;
+        if (rx <= 0.0 || ry <= 0.0)
+        {
+            return true;
+        }
+        const double nx = (oPoint.x() - oCenter.x()) / rx;
+        const double ny = (oPoint.y() - oCenter.y()) / ry;
+        return nx * nx + ny * ny <= 1.0;
+    }
+    default:
+        if (geometry.vecPaths.empty())
+        {
+            return true;
+        }
+        for (size_t i = 0; i < geometry.vecPaths.size(); ++i)
+        {
+            const AnnotationPath& path = geometry.vecPaths[i];
+            if (path.size() > 2 && (insidePolygon(path, oPoint) || nearPath(path, oPoint, dTolerance, true)))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+}
@@ -0,0 +1,99 @@
+﻿/*!
+ * @brief 单页注释的几何缓存与命中测试。
+ *
+ * 本文件定义了 `AnnotationGeometry` 和 `PageAnnotations`。`PageAnnotations` 在页面加载时
+ * 一次性读取该页全部注释的包围盒、顶点、颜色等几何信息，并建立 `SpatialIndex`，
+ * 此后鼠标悬停和点击的命中测试只查询缓存，不再调用 PDFium。
+ *
+ * @author LiuYe
+ * @date 2026-10-19
+ * @copyright (c) 2013-2026 Honghu Yuntu Corporation
+ */
+
+#pragma once
+
+#include <QColor>
+#include <QPointF>
+#include <QRectF>
+#include <QString>
+
+#include <unordered_map>
+#include <vector>
+
+#include "fpdfview.h"
+#include "spatial_index.h"
+
+class MonotonicArena;
+
+typedef std::vector<QPointF> AnnotationPath;
+
+/*!
+ * @brief 一个注释在页面坐标系（PDF 用户空间，y 轴向上）中的几何信息。
+ */
+struct AnnotationGeometry
+{
+    int nId;                          // 页内稳定编号，增删其他注释后不变
+    int nAnnotIndex;                  // 在 PDFium 注释数组中的下标，同时表示绘制顺序
+    int nSubtype;                     // FPDF_ANNOT_* 子类型
+    QRectF oBounds;                   // 注释矩形，top() 为最小 y
+    std::vector<AnnotationPath> vecPaths; // 直线、折线、多边形、墨迹或四边形顶点
+    QColor oColor;                    // 边框/线条颜色
+    QColor oInteriorColor;            // 填充颜色，无效表示不填充
+    float fBorderWidth;               // 线宽，单位为 PDF 点
+    bool bHidden;                     // 是否带隐藏标志
+    QString strContents;              // Contents 文本
+
+    AnnotationGeometry();
+};
+
+/*!
+ * @brief 一页注释的几何缓存及空间索引。
+ *
+ * 负责从 PDFium 读取注释几何、维护 id 到几何的映射，并在增加、移动、删除注释时
+ * 增量更新空间索引。命中测试先用空间索引筛出候选，再按注释类型做精确判断，
+ * 重叠时返回绘制顺序最靠上的注释。
+ *
+ * @date 2026.10.19
+ */
+class PageAnnotations
+{
+public:
+    PageAnnotations();
+
+    // 读取页面上的全部注释，已有内容被替换；读取过程中的临时缓冲区从 pScratch 分配，为空时使用局部 arena
+    void load(FPDF_PAGE page, MonotonicArena* pScratch = nullptr);
+    void clear();
+
+    const AnnotationGeometry* find(int nId) const;
+    const std::vector<AnnotationGeometry>& items() const
+    {
+        return m_vecItems;
+    }
+
+    // 返回包含该页面坐标点的最上层注释 id，未命中返回 -1
+    // 鼠标移动时逐次调用，候选 id 复用成员缓冲区，不分配内存；因此不能在多个线程上同时调用
+    int hitTest(const QPointF& oPoint, double dTolerance) const;
+
+    // 查询与页面坐标矩形相交的注释 id
+    void queryRect(const QRectF& oRect, std::vector<int>& vecIds) const;
+
+    // 增加注释并返回分配的 id
+    int add(AnnotationGeometry geometry);
+
+    // 以新的几何替换同 id 注释，用于移动、改色等编辑
+    bool update(const AnnotationGeometry& geometry);
+
+    bool remove(int nId);
+
+    // 从 PDFium 注释句柄读取几何信息，顶点与字符串的临时缓冲区从 scratch 分配
+    static AnnotationGeometry readGeometry(FPDF_ANNOTATION annot, MonotonicArena& scratch);
+
+private:
+    static bool containsPoint(const AnnotationGeometry& geometry, const QPointF& oPoint, double dTolerance);
+
+    std::vector<AnnotationGeometry> m_vecItems;       // 紧凑存储，删除时与末尾交换
+    std::unordered_map<int, size_t> m_mapSlots;       // id -> m_vecItems 下标
+    SpatialIndex m_oIndex;
+    int m_nNextId;
+    mutable std::vector<int> m_vecHitCandidates;      // hitTest 的候选 id，保留容量供下次使用
+};
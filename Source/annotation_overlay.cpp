@@ -0,0 +1,477 @@
+﻿/*!
+ * @brief 注释矢量叠加层的实现。
+ *
+ * 几何类注释（直线、折线、多边形、矩形、椭圆、墨迹）以及文本标记类注释（高亮、下划线、
+ * 删除线、波浪线）按其顶点绘制。依赖外观流的注释（便笺、图章、自由文本等）已在页面位图中，
+ * 只有尚未出现在位图中的新增注释才以矩形示意，自由文本另绘制文字。表单控件与链接不在叠加层中绘制。
+ *
+ * @author LiuYe
+ * @date 2026-10-19
+ * @copyright (c) 2013-2026 Honghu Yuntu Corporation
+ */
+
+#include "annotation_overlay.h"
+
+#include "fpdf_annot.h"
+#include "pdfium_utils.h"
+
+#include <QFont>
+#include <QPainter>
+#include <QPolygonF>
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // 查询可见注释时在窗口区域外额外扩展的余量（页面坐标），覆盖超出注释矩形的线宽
+    const double kQueryMargin = 8.0;
+
+    bool paintOrderLess(const AnnotationGeometry* a, const AnnotationGeometry* b)
+    {
+        return a->nAnnotIndex < b->nAnnotIndex;
+    }
+
+    bool isTextMarkup(const int nSubtype)
+    {
+        return nSubtype == FPDF_ANNOT_HIGHLIGHT || nSubtype == FPDF_ANNOT_UNDERLINE
+            || nSubtype == FPDF_ANNOT_STRIKEOUT || nSubtype == FPDF_ANNOT_SQUIGGLY;
+    }
+
+    QPointF midPoint(const QPointF& a, const QPointF& b)
+    {
+        return (a + b) * 0.5;
+    }
+
+    // 四边形顶点按 1-2-4-3 存放：0 左上、1 右上、2 右下、3 左下
+    void addMarkupLine(QPainterPath& path, const AnnotationPath& quad, const int nSubtype)
+    {
+        if (nSubtype == FPDF_ANNOT_STRIKEOUT)
+        {
+            path.moveTo(midPoint(quad[0], quad[3]));
+            path.lineTo(midPoint(quad[1], quad[2]));
+            return;
+        }
+
+        if (nSubtype == FPDF_ANNOT_UNDERLINE)
+        {
+            path.moveTo(quad[3]);
+            path.lineTo(quad[2]);
+            return;
+        }
+
+        // 波浪线：沿底边折线起伏，振幅取行高的 1/8
+        const QPointF oBase = quad[3];
+        const QPointF oDirection = quad[2] - quad[3];
+        const double dLength = std::sqrt(QPointF::dotProduct(oDirection, oDirection));
+        const QPointF oUp = (quad[0] - quad[3]) * 0.125;
+        const double dStep = std::max(1.0, std::sqrt(QPointF::dotProduct(oUp, oUp)) * 2.0);
+        const int nSteps = std::max(1, static_cast<int>(dLength / dStep));
+        path.moveTo(oBase);
+        for (int i = 1; i <= nSteps; ++i)
+        {
+            const QPointF oPoint = oBase + oDirection * (static_cast<double>(i) / nSteps);
+            path.lineTo(i % 2 != 0 ? oPoint + oUp : oPoint);
+        }
+    }
+}
+
+AnnotationOverlay::AnnotationOverlay()
+    : m_nAnnotCount(0)
+{
+}
+
+void AnnotationOverlay::load(FPDF_PAGE page, MonotonicArena* pScratch)
+{
+    clear();
+    m_oAnnotations.load(page, pScratch);
+    m_nAnnotCount = page ? FPDFPage_GetAnnotCount(page) : 0;
+}
+
+void AnnotationOverlay::copySubtypeVisibility(const AnnotationOverlay& other)
+{
+    m_setHiddenSubtypes = other.m_setHiddenSubtypes;
+}
+
+void AnnotationOverlay::clear()
+{
+    m_mapPaths.clear();
+    m_oAnnotations.clear();
+    m_nAnnotCount = 0;
+    m_vecRemovedIndices.clear();
+    m_mapEditFlags.clear();
+    m_setAdded.clear();
+    m_setAwaitingRaster.clear();
+}
+
+/*!
+ * @brief 绘制与暴露区域相交的可见注释。
+ *
+ * 先用空间索引筛出暴露区域内的注释，再按 PDFium 中的绘制顺序依次绘制，
+ * 因此局部重绘的开销只与该区域内的注释数量有关。
+ *
+ * @param painter 已在窗口上开始绘制的画笔
+ * @param oPageToDevice 页面坐标到窗口坐标的变换
+ * @param oExposed 需要重绘的窗口区域
+ */
+void AnnotationOverlay::paint(QPainter& painter, const QTransform& oPageToDevice, const QRect& oExposed) const
+{
+    const QRectF oPageRect = oPageToDevice.inverted().mapRect(QRectF(oExposed))
+        .adjusted(-kQueryMargin, -kQueryMargin, kQueryMargin, kQueryMargin);
+    std::vector<int> vecIds;
+    m_oAnnotations.queryRect(oPageRect, vecIds);
+
+    std::vector<const AnnotationGeometry*> vecVisible;
+    vecVisible.reserve(vecIds.size());
+    for (size_t i = 0; i < vecIds.size(); ++i)
+    {
+        const AnnotationGeometry* pGeometry = m_oAnnotations.find(vecIds[i]);
+        if (pGeometry && !pGeometry->bHidden && isSubtypeVisible(pGeometry->nSubtype))
+        {
+            vecVisible.push_back(pGeometry);
+        }
+    }
+    std::sort(vecVisible.begin(), vecVisible.end(), paintOrderLess);
+
+    painter.save();
+    painter.setClipRect(oExposed);
+    painter.setRenderHint(QPainter::Antialiasing, true);
+    for (size_t i = 0; i < vecVisible.size(); ++i)
+    {
+        paintAnnotation(painter, oPageToDevice, *vecVisible[i]);
+    }
+    painter.restore();
+}
+
+void AnnotationOverlay::paintAnnotation(QPainter& painter, const QTransform& oPageToDevice,
+    const AnnotationGeometry& geometry) const
+{
+    if (geometry.nSubtype == FPDF_ANNOT_WIDGET || geometry.nSubtype == FPDF_ANNOT_LINK)
+    {
+        return;
+    }
+
+    // 图章、便笺等依赖外观流的注释已由 PDFium 画进页面位图；新增的注释在保存并重新读取页面之前位图中还没有，
+    // 先按几何外形示意
+    if (!isOverlayAnnotationSubtype(geometry.nSubtype) && m_setAdded.count(geometry.nId) == 0
+        && m_setAwaitingRaster.count(geometry.nId) == 0)
+    {
+        return;
+    }
+
+    const QPainterPath& path = pathFor(geometry);
+    painter.setWorldTransform(oPageToDevice);
+    painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+
+    QPen pen(geometry.oColor, geometry.fBorderWidth);
+    pen.setCapStyle(Qt::RoundCap);
+    pen.setJoinStyle(Qt::RoundJoin);
+    if (geometry.fBorderWidth <= 0.0f)
+    {
+        pen = QPen(Qt::NoPen);
+    }
+
+    if (geometry.nSubtype == FPDF_ANNOT_HIGHLIGHT)
+    {
+        // 与纸面高亮笔一致，用正片叠底保证下方文字仍可见
+        painter.setCompositionMode(QPainter::CompositionMode_Multiply);
+        painter.fillPath(path, geometry.oColor);
+        return;
+    }
+
+    if (isTextMarkup(geometry.nSubtype))
+    {
+        // 文本标记线宽随行高变化
+        const double dLineWidth = geometry.vecPaths.empty() || geometry.vecPaths[0].size() != 4 ? 1.0
+            : std::max(0.5, std::fabs(geometry.vecPaths[0][0].y() - geometry.vecPaths[0][3].y()) / 14.0);
+        painter.strokePath(path, QPen(geometry.oColor, dLineWidth, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin));
+        return;
+    }
+
+    if (geometry.nSubtype == FPDF_ANNOT_TEXT)
+    {
+        painter.fillPath(path, geometry.oColor);
+        painter.strokePath(path, QPen(geometry.oColor.darker(160), 1.0));
+        return;
+    }
+
+    const bool bClosed = geometry.nSubtype != FPDF_ANNOT_LINE && geometry.nSubtype != FPDF_ANNOT_POLYLINE
+        && geometry.nSubtype != FPDF_ANNOT_INK;
+    if (bClosed && geometry.oInteriorColor.isValid())
+    {
+        painter.fillPath(path, geometry.oInteriorColor);
+    }
+    painter.strokePath(path, pen);
+
+    if (geometry.nSubtype == FPDF_ANNOT_FREETEXT && !geometry.strContents.isEmpty())
+    {
+        // 文字在窗口坐标下绘制，避免页面坐标 y 轴翻转导致文字倒置
+        const QRectF oDeviceRect = oPageToDevice.mapRect(geometry.oBounds);
+        const double dPixelsPerPoint = std::sqrt(std::fabs(oPageToDevice.determinant()));
+        QFont font = painter.font();
+        font.setPixelSize(std::max(6, static_cast<int>(10.0 * dPixelsPerPoint)));
+        painter.resetTransform();
+        painter.setFont(font);
+        painter.setPen(geometry.oColor);
+        painter.drawText(oDeviceRect.adjusted(2, 2, -2, -2), Qt::TextWordWrap, geometry.strContents);
+    }
+}
+
+/*!
+ * @brief 取得注释在页面坐标系下的路径，首次使用时构建并缓存。
+ */
+const QPainterPath& AnnotationOverlay::pathFor(const AnnotationGeometry& geometry) const
+{
+    const std::unordered_map<int, QPainterPath>::const_iterator it = m_mapPaths.find(geometry.nId);
+    if (it != m_mapPaths.end())
+    {
+        return it->second;
+    }
+
+    QPainterPath path;
+    const double dInset = std::max(0.0f, geometry.fBorderWidth) * 0.5;
+    switch (geometry.nSubtype)
+    {
+    case FPDF_ANNOT_LINE:
+    case FPDF_ANNOT_POLYLINE:
+    case FPDF_ANNOT_INK:
+        for (size_t i = 0; i < geometry.vecPaths.size(); ++i)
+        {
+            const AnnotationPath& points = geometry.vecPaths[i];
+            for (size_t j = 0; j < points.size(); ++j)
+            {
+                if (j == 0)
+                {
+                    path.moveTo(points[j]);
+                }
+                else
+                {
+                    path.lineTo(points[j]);
+                }
+            }
+        }
+        break;
+    case FPDF_ANNOT_CIRCLE:
+        path.addEllipse(geometry.oBounds.adjusted(dInset, dInset, -dInset, -dInset));
+        break;
+    case FPDF_ANNOT_SQUARE:
+        path.addRect(geometry.oBounds.adjusted(dInset, dInset, -dInset, -dInset));
+        break;
+    default:
+        if (geometry.vecPaths.empty())
+        {
+            path.addRect(geometry.oBounds);
+            break;
+        }
+        for (size_t i = 0; i < geometry.vecPaths.size(); ++i)
+        {
+            const AnnotationPath& points = geometry.vecPaths[i];
+            if (isTextMarkup(geometry.nSubtype) && geometry.nSubtype != FPDF_ANNOT_HIGHLIGHT && points.size() == 4)
+            {
+                addMarkupLine(path, points, geometry.nSubtype);
+                continue;
+            }
+            QPolygonF polygon;
+            for (size_t j = 0; j < points.size(); ++j)
+            {
+                polygon << points[j];
+            }
+            path.addPolygon(polygon);
+            path.closeSubpath();
+        }
+        break;
+    }
+
+    return m_mapPaths.insert(std::make_pair(geometry.nId, path)).first->second;
+}
+
+/*!
+ * @brief 注释的绘制范围，在注释矩形基础上包含线宽。
+ */
+QRectF AnnotationOverlay::paintBounds(const int nId) const
+{
+    const AnnotationGeometry* pGeometry = m_oAnnotations.find(nId);
+    if (!pGeometry)
+    {
+        return QRectF();
+    }
+    const double dMargin = std::max(1.0f, pGeometry->fBorderWidth);
+    return pGeometry->oBounds.adjusted(-dMargin, -dMargin, dMargin, dMargin);
+}
+
+/*!
+ * @brief 新增注释，绘制顺序位于现有注释之上。
+ *
+ * @param geometry 注释几何，nId 与 nAnnotIndex 由叠加层分配
+ * @param pId 可选，接收分配的 id
+ * @return 需要重绘的页面区域
+ */
+QRectF AnnotationOverlay::addAnnotation(const AnnotationGeometry& geometry, int* pId)
+{
+    // 保存时新增注释追加在 PDFium 注释数组末尾
+    AnnotationGeometry added = geometry;
+    added.nAnnotIndex = m_nAnnotCount++;
+
+    const int nId = m_oAnnotations.add(added);
+    m_setAdded.insert(nId);
+    if (pId)
+    {
+        *pId = nId;
+    }
+    return paintBounds(nId);
+}
+
+QRectF AnnotationOverlay::moveAnnotation(const int nId, const QPointF& oOffset)
+{
+    const AnnotationGeometry* pGeometry = m_oAnnotations.find(nId);
+    if (!pGeometry)
+    {
+        return QRectF();
+    }
+
+    const QRectF oBefore = paintBounds(nId);
+    AnnotationGeometry moved = *pGeometry;
+    moved.oBounds.translate(oOffset);
+    for (size_t i = 0; i < moved.vecPaths.size(); ++i)
+    {
+        AnnotationPath& points = moved.vecPaths[i];
+        for (size_t j = 0; j < points.size(); ++j)
+        {
+            points[j] += oOffset;
+        }
+    }
+    m_oAnnotations.update(moved);
+    m_mapPaths.erase(nId);
+    if (m_setAdded.count(nId) == 0)
+    {
+        m_mapEditFlags[nId] |= AnnotationEdit::Moved;
+    }
+    return oBefore.united(paintBounds(nId));
+}
+
+QRectF AnnotationOverlay::setAnnotationColor(const int nId, const QColor& oColor)
+{
+    const AnnotationGeometry* pGeometry = m_oAnnotations.find(nId);
+    if (!pGeometry || pGeometry->oColor == oColor)
+    {
+        return QRectF();
+    }
+
+    AnnotationGeometry recolored = *pGeometry;
+    recolored.oColor = oColor;
+    m_oAnnotations.update(recolored);
+    if (m_setAdded.count(nId) == 0)
+    {
+        m_mapEditFlags[nId] |= AnnotationEdit::Recolored;
+    }
+    return paintBounds(nId);
+}
+
+QRectF AnnotationOverlay::removeAnnotation(const int nId)
+{
+    const AnnotationGeometry* pGeometry = m_oAnnotations.find(nId);
+    if (!pGeometry)
+    {
+        return QRectF();
+    }
+
+    // 已同步的注释记录其当前下标，保存时按同样的顺序在 PDFium 中删除；
+    // 其余注释的下标由 PageAnnotations::remove 同步前移，与 PDFium 删除后的数组保持一致
+    if (m_setAdded.erase(nId) == 0)
+    {
+        m_vecRemovedIndices.push_back(pGeometry->nAnnotIndex);
+        m_mapEditFlags.erase(nId);
+    }
+
+    const QRectF oBefore = paintBounds(nId);
+    m_oAnnotations.remove(nId);
+    m_mapPaths.erase(nId);
+    m_setAwaitingRaster.erase(nId);
+    --m_nAnnotCount;
+    return oBefore;
+}
+
+/*!
+ * @brief 按子类型显隐注释。
+ *
+ * @return 该类型全部注释区域的并集，状态未变化时为空
+ */
+QRectF AnnotationOverlay::setSubtypeVisible(const int nSubtype, const bool bVisible)
+{
+    if (isSubtypeVisible(nSubtype) == bVisible)
+    {
+        return QRectF();
+    }
+
+    if (bVisible)
+    {
+        m_setHiddenSubtypes.erase(nSubtype);
+    }
+    else
+    {
+        m_setHiddenSubtypes.insert(nSubtype);
+    }
+
+    QRectF oDirty;
+    const std::vector<AnnotationGeometry>& items = m_oAnnotations.items();
+    for (size_t i = 0; i < items.size(); ++i)
+    {
+        if (items[i].nSubtype == nSubtype)
+        {
+            oDirty = oDirty.united(paintBounds(items[i].nId));
+        }
+    }
+    return oDirty;
+}
+
+bool AnnotationOverlay::isSubtypeVisible(const int nSubtype) const
+{
+    return m_setHiddenSubtypes.count(nSubtype) == 0;
+}
+
+bool AnnotationOverlay::hasUnsavedEdits() const
+{
+    return !m_vecRemovedIndices.empty() || !m_mapEditFlags.empty() || !m_setAdded.empty();
+}
+
+/*!
+ * @brief 取出自上次保存以来的编辑。
+ *
+ * 记录在取出后清空：编辑一经交给执行线程写入 PDFium 文档即视为已同步，
+ * 即使随后写文件失败，文档中的修改仍在，下一次保存会把它们一并写出。
+ */
+AnnotationEdits AnnotationOverlay::takeEdits()
+{
+    AnnotationEdits edits;
+    edits.vecRemovedIndices.swap(m_vecRemovedIndices);
+
+    for (std::unordered_map<int, int>::const_iterator it = m_mapEditFlags.begin(); it != m_mapEditFlags.end(); ++it)
+    {
+        const AnnotationGeometry* pGeometry = m_oAnnotations.find(it->first);
+        if (pGeometry)
+        {
+            AnnotationEdit edit;
+            edit.geometry = *pGeometry;
+            edit.nFlags = it->second;
+            edits.vecModified.push_back(edit);
+        }
+    }
+    m_mapEditFlags.clear();
+
+    for (std::unordered_set<int>::const_iterator it = m_setAdded.begin(); it != m_setAdded.end(); ++it)
+    {
+        const AnnotationGeometry* pGeometry = m_oAnnotations.find(*it);
+        if (pGeometry)
+        {
+            edits.vecAdded.push_back(*pGeometry);
+            if (!isOverlayAnnotationSubtype(pGeometry->nSubtype))
+            {
+                m_setAwaitingRaster.insert(*it);
+            }
+        }
+    }
+    m_setAdded.clear();
+    std::sort(edits.vecAdded.begin(), edits.vecAdded.end(),
+        [](const AnnotationGeometry& a, const AnnotationGeometry& b) { return a.nAnnotIndex < b.nAnnotIndex; });
+    return edits;
+}
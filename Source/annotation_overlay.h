@@ -0,0 +1,118 @@
+﻿/*!
+ * @brief 注释矢量叠加层。
+ *
+ * 注释按能否由几何数据如实还原分为两类（见 `isOverlayAnnotationSubtype`）：
+ * - 文本标记、直线、折线、多边形、墨迹、矩形、椭圆不画进页面位图，由 `AnnotationOverlay` 根据缓存的
+ *   几何在位图之上用 QPainter 实时绘制，增加、移动、改色、按类型显隐只需重绘受影响的区域，
+ *   不需要 PDFium 重新光栅化页面；
+ * - 图章、便笺、自由文本、附件等外观只存在于外观流中，由 PDFium 画进页面位图，叠加层只负责命中测试
+ *   与选中；新增的这类注释在保存后页面重新渲染之前按几何外形示意。
+ *
+ * @author LiuYe
+ * @date 2026-10-19
+ * @copyright (c) 2013-2026 Honghu Yuntu Corporation
+ */
+
+#pragma once
+
+#include <QPainterPath>
+#include <QRectF>
+#include <QTransform>
+
+#include <unordered_map>
+#include <unordered_set>
+
+#include "annotation_index.h"
+
+class QPainter;
+
+/*!
+ * @brief 一个已同步到 PDFium 的注释自上次保存以来的修改。
+ */
+struct AnnotationEdit
+{
+    enum Flag
+    {
+        Moved = 0x1,                  // 矩形及顶点改变
+        Recolored = 0x2               // 颜色改变
+    };
+
+    AnnotationGeometry geometry;      // 修改后的几何，nAnnotIndex 为删除操作全部执行后的下标
+    int nFlags;                       // Flag 的组合
+};
+
+/*!
+ * @brief 自上次保存以来的注释编辑记录，保存时按删除、修改、新增的顺序写回 PDFium。
+ */
+struct AnnotationEdits
+{
+    std::vector<int> vecRemovedIndices;       // 按发生顺序记录的被删注释在 PDFium 中的下标
+    std::vector<AnnotationEdit> vecModified;  // 被修改的已有注释
+    std::vector<AnnotationGeometry> vecAdded; // 新增注释，按绘制顺序排列
+
+    bool isEmpty() const
+    {
+        return vecRemovedIndices.empty() && vecModified.empty() && vecAdded.empty();
+    }
+};
+
+/*!
+ * @brief 一页注释的矢量叠加层。
+ *
+ * 持有该页的注释几何与空间索引，并按注释缓存页面坐标系下的 QPainterPath。
+ * 所有编辑函数返回需要重绘的页面坐标区域（编辑前后区域的并集），由调用方换算为窗口区域后重绘。
+ *
+ * @date 2026.10.19
+ */
+class AnnotationOverlay
+{
+public:
+    AnnotationOverlay();
+
+    // 从页面读取注释，替换已有内容；临时缓冲区从 pScratch 分配，见 PageAnnotations::load
+    void load(FPDF_PAGE page, MonotonicArena* pScratch = nullptr);
+    void clear();
+
+    const PageAnnotations& annotations() const
+    {
+        return m_oAnnotations;
+    }
+
+    // 绘制与 oExposed（窗口坐标）相交的可见注释
+    void paint(QPainter& painter, const QTransform& oPageToDevice, const QRect& oExposed) const;
+
+    // 编辑操作，返回需要重绘的页面坐标区域
+    QRectF addAnnotation(const AnnotationGeometry& geometry, int* pId = nullptr);
+    QRectF moveAnnotation(int nId, const QPointF& oOffset);
+    QRectF setAnnotationColor(int nId, const QColor& oColor);
+    QRectF removeAnnotation(int nId);
+
+    // 按注释子类型显隐，返回受影响注释区域的并集
+    QRectF setSubtypeVisible(int nSubtype, bool bVisible);
+    bool isSubtypeVisible(int nSubtype) const;
+    // 沿用另一叠加层的显隐设置，重新读取页面注释后调用
+    void copySubtypeVisibility(const AnnotationOverlay& other);
+
+    // 注释绘制范围（含线宽），页面坐标
+    QRectF paintBounds(int nId) const;
+
+    // 是否存在尚未保存的编辑
+    bool hasUnsavedEdits() const;
+
+    // 取出自上次保存以来的编辑并清空记录，此后这些编辑视为已同步到 PDFium
+    AnnotationEdits takeEdits();
+
+private:
+    const QPainterPath& pathFor(const AnnotationGeometry& geometry) const;
+    void paintAnnotation(QPainter& painter, const QTransform& oPageToDevice, const AnnotationGeometry& geometry) const;
+
+    PageAnnotations m_oAnnotations;
+    std::unordered_set<int> m_setHiddenSubtypes;               // 被过滤掉的注释子类型
+    mutable std::unordered_map<int, QPainterPath> m_mapPaths;  // id -> 页面坐标系下的路径缓存
+
+    int m_nAnnotCount;                                 // PDFium 中该页注释数量（含未缓存的弹出窗口）
+    std::vector<int> m_vecRemovedIndices;              // 已同步注释被删除时的 PDFium 下标
+    std::unordered_map<int, int> m_mapEditFlags;       // 已同步注释 id -> AnnotationEdit::Flag
+    std::unordered_set<int> m_setAdded;                // 尚未同步到 PDFium 的新增注释 id
+    std::unordered_set<int> m_setAwaitingRaster;       // 已同步、但页面位图中还没有的依赖外观流的新增注释 id
+};
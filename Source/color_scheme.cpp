@@ -0,0 +1,89 @@
+﻿/*!
+ * @brief 页面显示的颜色方案的实现。
+ *
+ * @author LiuYe
+ * @date 2026-10-19
+ * @copyright (c) 2013-2026 Honghu Yuntu Corporation
+ */
+
+#include "color_scheme.h"
+
+QString colorSchemeName(const ColorScheme eScheme)
+{
+    switch (eScheme)
+    {
+    case ColorSchemeDark:
+        return QStringLiteral("Dark");
+    case ColorSchemeHighContrast:
+        return QStringLiteral("High contrast");
+    default:
+        return QStringLiteral("Normal");
+    }
+}
+
+FPDF_DWORD colorSchemeBackground(const ColorScheme eScheme)
+{
+    switch (eScheme)
+    {
+    case ColorSchemeDark:
+        return 0xFF1E1E1E;
+    case ColorSchemeHighContrast:
+        return 0xFF000000;
+    default:
+        return 0xFFFFFFFF;
+    }
+}
+
+QColor colorSchemeBackgroundColor(const ColorScheme eScheme)
+{
+    switch (eScheme)
+    {
+    case ColorSchemeDark:
+        return QColor(40, 40, 40);
+    case ColorSchemeHighContrast:
+        return QColor(0, 0, 0);
+    default:
+        return QColor(236, 236, 236);
+    }
+}
+
+QColor colorSchemeForegroundColor(const ColorScheme eScheme)
+{
+    switch (eScheme)
+    {
+    case ColorSchemeDark:
+        return QColor(170, 170, 170);
+    case ColorSchemeHighContrast:
+        return QColor(255, 255, 255);
+    default:
+        return QColor(110, 110, 110);
+    }
+}
+
+bool colorSchemeFor(const ColorScheme eScheme, FPDF_COLORSCHEME* pColorScheme)
+{
+    switch (eScheme)
+    {
+    case ColorSchemeDark:
+        // 填充取略亮于背景的灰色，表格底纹等区域仍可分辨
+        pColorScheme->path_fill_color = 0xFF2E2E2E;
+        pColorScheme->path_stroke_color = 0xFF9A9A9A;
+        pColorScheme->text_fill_color = 0xFFD4D4D4;
+        pColorScheme->text_stroke_color = 0xFFD4D4D4;
+        return true;
+    case ColorSchemeHighContrast:
+        pColorScheme->path_fill_color = 0xFF000000;
+        pColorScheme->path_stroke_color = 0xFFFFFF00;
+        pColorScheme->text_fill_color = 0xFFFFFFFF;
+        pColorScheme->text_stroke_color = 0xFFFFFFFF;
+        return true;
+    default:
+        return false;
+    }
+}
+
+int colorSchemeRenderFlags(const ColorScheme eScheme)
+{
+    // 单一填充色下相邻填充区域的边界不可见，高对比度方案改为描边显示
+    return eScheme == ColorSchemeHighContrast ? FPDF_CONVERT_FILL_TO_STROKE : 0;
+}
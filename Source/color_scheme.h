@@ -0,0 +1,45 @@
+﻿/*!
+ * @brief 页面显示的颜色方案。
+ *
+ * 暗色与高对比度方案由 PDFium 在光栅化时直接使用 `FPDF_COLORSCHEME` 替换路径与文字的颜色，
+ * 图像保持原样，不需要在渲染后对像素做反色等二次处理。颜色方案是渲染缓存键的一部分，
+ * 同一页面在不同方案下的位图分别缓存，切换回已渲染过的方案时直接使用缓存。
+ *
+ * @author LiuYe
+ * @date 2026-10-19
+ * @copyright (c) 2013-2026 Honghu Yuntu Corporation
+ */
+
+#pragma once
+
+#include <QColor>
+#include <QString>
+
+#include "fpdfview.h"
+
+/*!
+ * @brief 颜色方案，数值用作渲染缓存键。
+ */
+enum ColorScheme
+{
+    ColorSchemeNormal = 0,            // 原始颜色
+    ColorSchemeDark = 1,              // 深色背景、浅色文字，适合暗环境
+    ColorSchemeHighContrast = 2,      // 黑底白字，填充转为描边
+    ColorSchemeCount
+};
+
+// 方案名称，用于界面提示
+QString colorSchemeName(ColorScheme eScheme);
+
+// 页面背景色，ARGB 格式，供 FPDFBitmap_FillRect 使用
+FPDF_DWORD colorSchemeBackground(ColorScheme eScheme);
+
+// 占位画面与周围区域的颜色
+QColor colorSchemeBackgroundColor(ColorScheme eScheme);
+QColor colorSchemeForegroundColor(ColorScheme eScheme);
+
+// 取得 PDFium 颜色方案；原始颜色方案返回 false，应使用普通渲染
+bool colorSchemeFor(ColorScheme eScheme, FPDF_COLORSCHEME* pColorScheme);
+
+// 方案附加的渲染标志
+int colorSchemeRenderFlags(ColorScheme eScheme);
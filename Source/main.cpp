@@ -56,16 +56,47 @@
 
 #include <QApplication>
 #include "CustomTreeWidget.h"
+#include "DocumentWorkspace.h"
+#include "memory_governor.h"
+#include "page_assembly_command.h"
+#include "pdfium_executor.h"
+#include "pdfium_runtime.h"
+#include "startup_profiler.h"
 
 int main(int argc, char* argv[])
 {
+    // 页面装配命令（merge、split、extract、nup、tile）以及装配工作进程不创建窗口
+    if (isPageAssemblyCommand(argc, argv))
+    {
+        return runPageAssemblyCommand(argc, argv);
+    }
+
+    StartupProfiler::instance().mark(StartupProfiler::ProcessStart);
     QApplication app(argc, argv);
+    StartupProfiler::instance().mark(StartupProfiler::QtInitialized);
+
+    int result = 0;
+    {
+        CAMainWindow mainWindow;
+        mainWindow.setWindowTitle("Two-Layer Example with DragBar and BlueLayer Rectangle");
+        mainWindow.resize(800, 600);
+        mainWindow.show();
+
+        // 命令行参数中的文件各自在一个标签页中打开；没有文档时窗口首帧即为启动完成
+        const QStringList lstPaths = QApplication::arguments().mid(1);
+        StartupProfiler::instance().setReportPhase(lstPaths.isEmpty() ? StartupProfiler::WindowShown
+            : StartupProfiler::FirstPagePainted);
+        mainWindow.workspace()->openDocuments(lstPaths);
+
+        // 按系统内存压力与容器内存上限约束各缓存的总占用
+        MemoryGovernor::instance().startMonitoring();
 
-    CAMainWindow mainWindow;
-    mainWindow.setWindowTitle("Two-Layer Example with DragBar and BlueLayer Rectangle");
-    mainWindow.resize(800, 600);
-    mainWindow.show();
+        result = QApplication::exec();
+    }
 
-    return QApplication::exec();
+    // 窗口销毁后文档在执行线程上依次关闭，最后一个文档关闭时销毁 PDFium 库
+    PdfiumRuntime::instance().shutdown();
+    PdfiumExecutor::instance().shutdown();
+    return result;
 }
 
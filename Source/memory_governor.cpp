@@ -0,0 +1,294 @@
+﻿/*!
+ * @brief 进程级内存预算与内存压力下的缓存淘汰的实现。
+ *
+ * @author LiuYe
+ * @date 2026-10-19
+ * @copyright (c) 2013-2026 Honghu Yuntu Corporation
+ */
+
+#include "memory_governor.h"
+
+#include <QFile>
+#include <QTimerEvent>
+
+#include <algorithm>
+
+namespace
+{
+    // 默认总预算
+    const qint64 kDefaultBudget = 1024LL * 1024 * 1024;
+
+    // 压力下预算的最小值，保证至少能容纳一两页位图
+    const qint64 kMinimumBudget = 64LL * 1024 * 1024;
+
+    // 压力检测间隔
+    const int kMonitorIntervalMs = 1000;
+
+    // PSI 10 秒平均停顿比例（百分比）的阈值：some 为部分任务等待内存，full 为全部任务等待内存
+    const double kModerateSomeAvg10 = 10.0;
+    const double kCriticalFullAvg10 = 5.0;
+
+    // 读取一个小的 proc/sysfs 文件；这些文件大小报告为 0，只能读到结束
+    QByteArray readSmallFile(const QString& strPath)
+    {
+        QFile file(strPath);
+        return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+    }
+
+    // 在 "key value" 或 "key a=1 b=2" 形式的文本中取字段值
+    QByteArray fieldValue(const QByteArray& text, const QByteArray& line, const QByteArray& key)
+    {
+        const QList<QByteArray> lstLines = text.split('\n');
+        for (int i = 0; i < lstLines.size(); ++i)
+        {
+            const QList<QByteArray> lstFields = lstLines[i].simplified().split(' ');
+            if (lstFields.isEmpty() || lstFields[0] != line)
+            {
+                continue;
+            }
+            if (key.isEmpty())
+            {
+                return lstFields.value(1);
+            }
+            for (int j = 1; j < lstFields.size(); ++j)
+            {
+                if (lstFields[j].startsWith(key + '='))
+                {
+                    return lstFields[j].mid(key.size() + 1);
+                }
+            }
+        }
+        return QByteArray();
+    }
+
+    // cgroup v2 下本进程所在 cgroup 的目录，"0::/路径" 一行给出相对路径
+    QString cgroupDirectory()
+    {
+        const QList<QByteArray> lstLines = readSmallFile("/proc/self/cgroup").split('\n');
+        for (int i = 0; i < lstLines.size(); ++i)
+        {
+            if (lstLines[i].startsWith("0::"))
+            {
+                return "/sys/fs/cgroup" + QString::fromLocal8Bit(lstLines[i].mid(3)).trimmed();
+            }
+        }
+        return QString();
+    }
+}
+
+MemoryGovernor& MemoryGovernor::instance()
+{
+    static MemoryGovernor* pGovernor = new MemoryGovernor;
+    return *pGovernor;
+}
+
+MemoryGovernor::MemoryGovernor(QObject* pParent)
+    : QObject(pParent), m_nNextId(1), m_nBudget(kDefaultBudget), m_nPressureLimit(kDefaultBudget),
+    m_ePressure(MemoryPressureNone), m_bEnforcePending(false), m_nCgroupHigh(0), m_nCgroupMax(0),
+    m_bCgroupEvent(false)
+{
+}
+
+int MemoryGovernor::registerConsumer(const QString& strName, const MemoryPriority ePriority,
+    const UsageFunction& fnUsage, const TrimFunction& fnTrim, const UsageFunction& fnWorkingSet)
+{
+    Consumer consumer;
+    consumer.nId = m_nNextId++;
+    consumer.strName = strName;
+    consumer.ePriority = ePriority;
+    consumer.fnUsage = fnUsage;
+    consumer.fnTrim = fnTrim;
+    consumer.fnWorkingSet = fnWorkingSet;
+    // 按优先级保持有序，同优先级先登记的先缩减
+    const std::vector<Consumer>::iterator it = std::upper_bound(m_vecConsumers.begin(), m_vecConsumers.end(),
+        consumer, [](const Consumer& left, const Consumer& right) { return left.ePriority < right.ePriority; });
+    m_vecConsumers.insert(it, consumer);
+    return consumer.nId;
+}
+
+void MemoryGovernor::unregisterConsumer(const int nId)
+{
+    m_vecConsumers.erase(std::remove_if(m_vecConsumers.begin(), m_vecConsumers.end(),
+        [nId](const Consumer& consumer) { return consumer.nId == nId; }), m_vecConsumers.end());
+}
+
+void MemoryGovernor::setBudget(const qint64 nBytes)
+{
+    m_nBudget = nBytes;
+    m_nPressureLimit = std::min(m_nPressureLimit, nBytes);
+    enforce();
+}
+
+// 压力下的预算不低于下限，否则当前页的位图刚渲染完就被淘汰，随即重新渲染
+qint64 MemoryGovernor::effectiveBudget() const
+{
+    return std::min(m_nBudget, std::max(m_nPressureLimit, minimumBudget()));
+}
+
+qint64 MemoryGovernor::minimumBudget() const
+{
+    qint64 nWorkingSet = 0;
+    for (size_t i = 0; i < m_vecConsumers.size(); ++i)
+    {
+        if (m_vecConsumers[i].fnWorkingSet)
+        {
+            nWorkingSet += m_vecConsumers[i].fnWorkingSet();
+        }
+    }
+    return std::max(kMinimumBudget, nWorkingSet);
+}
+
+qint64 MemoryGovernor::usedBytes() const
+{
+    qint64 nUsed = 0;
+    for (size_t i = 0; i < m_vecConsumers.size(); ++i)
+    {
+        nUsed += m_vecConsumers[i].fnUsage();
+    }
+    return nUsed;
+}
+
+void MemoryGovernor::requestEnforce()
+{
+    if (!m_bEnforcePending)
+    {
+        m_bEnforcePending = true;
+        m_oEnforceTimer.start(0, this);
+    }
+}
+
+/*!
+ * @brief 超出有效预算时从最低优先级的缓存开始缩减，直到总占用不超出预算。
+ */
+void MemoryGovernor::enforce()
+{
+    m_bEnforcePending = false;
+    m_oEnforceTimer.stop();
+    qint64 nExcess = usedBytes() - effectiveBudget();
+    for (size_t i = 0; i < m_vecConsumers.size() && nExcess > 0; ++i)
+    {
+        const Consumer& consumer = m_vecConsumers[i];
+        const qint64 nBefore = consumer.fnUsage();
+        if (nBefore <= 0)
+        {
+            continue;
+        }
+        consumer.fnTrim(std::max<qint64>(0, nBefore - nExcess));
+        nExcess -= nBefore - consumer.fnUsage();
+    }
+}
+
+/*!
+ * @brief 开始监视内存压力。
+ *
+ * 所在 cgroup 设有 memory.max 时同时把总预算限制在上限的一半。
+ */
+void MemoryGovernor::startMonitoring()
+{
+#ifdef Q_OS_LINUX
+    const QString strCgroup = cgroupDirectory();
+    if (!strCgroup.isEmpty())
+    {
+        bool bOk = false;
+        const qint64 nLimit = readSmallFile(strCgroup + "/memory.max").trimmed().toLongLong(&bOk);
+        if (bOk && nLimit > 0)
+        {
+            setBudget(std::min(m_nBudget, nLimit / 2));
+        }
+        if (QFile::exists(strCgroup + "/memory.events"))
+        {
+            m_strCgroupEvents = strCgroup + "/memory.events";
+        }
+    }
+    // 以当前计数为基线，启动前发生的事件不算压力
+    readPressure();
+    m_oMonitorTimer.start(kMonitorIntervalMs, this);
+#endif
+}
+
+void MemoryGovernor::timerEvent(QTimerEvent* pEvent)
+{
+    if (pEvent->timerId() == m_oEnforceTimer.timerId())
+    {
+        enforce();
+    }
+    else if (pEvent->timerId() == m_oMonitorTimer.timerId())
+    {
+        onPressure(readPressure());
+    }
+    else
+    {
+        QObject::timerEvent(pEvent);
+    }
+}
+
+MemoryPressure MemoryGovernor::readPressure()
+{
+    MemoryPressure ePressure = MemoryPressureNone;
+    m_bCgroupEvent = false;
+
+    // 内核未启用 PSI 时文件不存在，只依据 cgroup 事件
+    const QByteArray psi = readSmallFile("/proc/pressure/memory");
+    if (!psi.isEmpty())
+    {
+        if (fieldValue(psi, "full", "avg10").toDouble() >= kCriticalFullAvg10)
+        {
+            ePressure = MemoryPressureCritical;
+        }
+        else if (fieldValue(psi, "some", "avg10").toDouble() >= kModerateSomeAvg10)
+        {
+            ePressure = MemoryPressureModerate;
+        }
+    }
+
+    if (!m_strCgroupEvents.isEmpty())
+    {
+        const QByteArray events = readSmallFile(m_strCgroupEvents);
+        const qint64 nHigh = fieldValue(events, "high", QByteArray()).toLongLong();
+        const qint64 nMax = fieldValue(events, "max", QByteArray()).toLongLong()
+            + fieldValue(events, "oom", QByteArray()).toLongLong();
+        if (nMax > m_nCgroupMax)
+        {
+            ePressure = MemoryPressureCritical;
+        }
+        else if (nHigh > m_nCgroupHigh)
+        {
+            ePressure = std::max(ePressure, MemoryPressureModerate);
+        }
+        m_bCgroupEvent = nMax > m_nCgroupMax || nHigh > m_nCgroupHigh;
+        m_nCgroupHigh = nHigh;
+        m_nCgroupMax = nMax;
+    }
+    return ePressure;
+}
+
+/*!
+ * @brief 按压力等级调整有效预算。
+ *
+ * 压力升级或 cgroup 出现新的越限事件时在当前占用的基础上缩减，预算不低于 minimumBudget()；
+ * 同级压力持续时（PSI 的平均值会在数十秒内保持在阈值以上）维持已降低的预算，不再逐次减半。
+ * 压力消退后预算逐步恢复，避免刚释放的内存立即被重新渲染的位图占满而再次触发回收。
+ */
+void MemoryGovernor::onPressure(const MemoryPressure ePressure)
+{
+    if (ePressure != MemoryPressureNone)
+    {
+        if (ePressure > m_ePressure || m_bCgroupEvent)
+        {
+            const qint64 nUsed = usedBytes();
+            const qint64 nTarget = ePressure == MemoryPressureCritical ? nUsed / 2 : nUsed * 3 / 4;
+            m_nPressureLimit = std::max(minimumBudget(), std::min(m_nPressureLimit, nTarget));
+        }
+        enforce();
+    }
+    else if (m_nPressureLimit < m_nBudget)
+    {
+        m_nPressureLimit = std::min(m_nBudget, m_nPressureLimit + m_nBudget / 10);
+    }
+
+    if (ePressure != m_ePressure)
+    {
+        m_ePressure = ePressure;
+        emit pressureChanged(ePressure);
+    }
+}
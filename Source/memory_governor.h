@@ -0,0 +1,138 @@
+﻿/*!
+ * @brief 进程级内存预算与内存压力下的缓存淘汰。
+ *
+ * `MemoryGovernor` 维护一个进程级总预算，缓存登记自己的占用查询与淘汰回调以及优先级。目前登记的只有
+ * `RenderCache`：后台文档的低分辨率位图（MemoryLow）和当前文档的位图（MemoryNormal）；页面句柄、
+ * 注释几何等其他数据不在总预算之内。预算的执行方式：
+ * - 缓存增长后调用 `requestEnforce()`，下一轮事件循环汇总占用，超出总预算时按优先级从低到高
+ *   依次要求缓存缩减，低优先级缓存全部缩减后仍超出才轮到高优先级缓存；
+ * - Linux 上每秒读取一次 PSI（/proc/pressure/memory）与所在 cgroup 的 memory.events。
+ *   内存紧张（PSI 停顿比例上升或 cgroup 越过 memory.high）时把有效预算降到当前占用的四分之三，
+ *   接近上限（PSI full 停顿或 cgroup 触及 memory.max、发生 OOM）时降到一半；只有压力升级或 cgroup
+ *   出现新的越限事件时才再次缩减，且不低于可见内容所需的下限；压力消退后每秒恢复总预算的十分之一；
+ * - 所在 cgroup 设有 memory.max 时，总预算不超过该上限的一半，其余留给 PDFium 的文档对象与界面。
+ *
+ * 因此在容器内存上限下打开大型图纸集时，查看器先丢弃可重新渲染的位图，而不是被 OOM 终止。
+ *
+ * @author LiuYe
+ * @date 2026-10-19
+ * @copyright (c) 2013-2026 Honghu Yuntu Corporation
+ */
+
+#pragma once
+
+#include <QBasicTimer>
+#include <QObject>
+#include <QString>
+
+#include <functional>
+#include <vector>
+
+/*!
+ * @brief 缓存的淘汰优先级，数值越小越先被缩减。
+ */
+enum MemoryPriority
+{
+    MemoryLow = 0,                    // 后台文档的位图等可随时重建的内容
+    MemoryNormal = 1,                 // 当前文档的位图
+    MemoryHigh = 2                    // 重建代价高、影响交互的内容
+};
+
+/*!
+ * @brief 内存压力等级。
+ */
+enum MemoryPressure
+{
+    MemoryPressureNone = 0,
+    MemoryPressureModerate,           // 出现内存回收停顿，缩减到当前占用的四分之三
+    MemoryPressureCritical            // 接近上限，缩减到当前占用的一半
+};
+
+/*!
+ * @brief 进程级内存预算，只在 GUI 线程使用。
+ *
+ * @date 2026.10.19
+ */
+class MemoryGovernor : public QObject
+{
+    Q_OBJECT
+
+public:
+    // 返回当前占用的字节数
+    typedef std::function<qint64()> UsageFunction;
+
+    // 把占用缩减到不超过给定字节数
+    typedef std::function<void(qint64)> TrimFunction;
+
+    static MemoryGovernor& instance();
+
+    // 登记一个缓存，返回用于注销的编号；fnWorkingSet 返回其中当前可见内容的字节数，压力下的预算不低于各缓存之和
+    int registerConsumer(const QString& strName, MemoryPriority ePriority, const UsageFunction& fnUsage,
+        const TrimFunction& fnTrim, const UsageFunction& fnWorkingSet = UsageFunction());
+    void unregisterConsumer(int nId);
+
+    void setBudget(qint64 nBytes);
+    qint64 budget() const
+    {
+        return m_nBudget;
+    }
+
+    // 考虑内存压力后的预算
+    qint64 effectiveBudget() const;
+
+    // 压力下预算的下限：固定的最小值与各缓存可见内容之和中的较大者
+    qint64 minimumBudget() const;
+
+    // 已登记缓存的占用之和
+    qint64 usedBytes() const;
+
+    MemoryPressure pressure() const
+    {
+        return m_ePressure;
+    }
+
+    // 缓存增长后调用；同一轮事件循环中的多次调用合并为一次检查
+    void requestEnforce();
+
+    // 立即检查，超出有效预算时按优先级缩减
+    void enforce();
+
+    // 开始监视系统内存压力；非 Linux 平台只按预算淘汰
+    void startMonitoring();
+
+signals:
+    void pressureChanged(MemoryPressure ePressure);
+
+protected:
+    void timerEvent(QTimerEvent* pEvent) override;
+
+private:
+    struct Consumer
+    {
+        int nId;
+        QString strName;
+        MemoryPriority ePriority;
+        UsageFunction fnUsage;
+        TrimFunction fnTrim;
+        UsageFunction fnWorkingSet;   // 可为空
+    };
+
+    explicit MemoryGovernor(QObject* pParent = nullptr);
+
+    // 读取 PSI 与 cgroup 事件，返回本次检测到的压力等级
+    MemoryPressure readPressure();
+    void onPressure(MemoryPressure ePressure);
+
+    std::vector<Consumer> m_vecConsumers;
+    int m_nNextId;
+    qint64 m_nBudget;
+    qint64 m_nPressureLimit;          // 压力下的预算上限，无压力时逐步恢复到 m_nBudget
+    MemoryPressure m_ePressure;
+    bool m_bEnforcePending;
+    QBasicTimer m_oEnforceTimer;
+    QBasicTimer m_oMonitorTimer;
+    QString m_strCgroupEvents;        // 所在 cgroup 的 memory.events，为空表示不可用
+    qint64 m_nCgroupHigh;             // memory.events 中上一次读到的计数
+    qint64 m_nCgroupMax;
+    bool m_bCgroupEvent;              // 最近一次检测时 cgroup 计数有增加
+};
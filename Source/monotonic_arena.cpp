@@ -0,0 +1,96 @@
+﻿/*!
+ * @brief 单调递增的 arena 分配器的实现。
+ *
+ * @author LiuYe
+ * @date 2026-10-19
+ * @copyright (c) 2013-2026 Honghu Yuntu Corporation
+ */
+
+#include "monotonic_arena.h"
+
+#include "perf_counters.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+namespace
+{
+    const size_t kInitialChunkBytes = 16 * 1024;
+    const size_t kMaxChunkBytes = 256 * 1024;
+
+    char* alignUp(char* pPointer, const size_t nAlign)
+    {
+        const uintptr_t nAddress = reinterpret_cast<uintptr_t>(pPointer);
+        return pPointer + ((nAlign - nAddress % nAlign) % nAlign);
+    }
+}
+
+MonotonicArena::MonotonicArena(const bool bPassthrough)
+    : m_pChunks(nullptr), m_pCursor(nullptr), m_pEnd(nullptr), m_nNextChunkBytes(kInitialChunkBytes),
+    m_nAllocations(0), m_nChunks(0), m_bPassthrough(bPassthrough)
+{
+}
+
+MonotonicArena::~MonotonicArena()
+{
+    release();
+}
+
+void* MonotonicArena::allocate(const size_t nBytes, const size_t nAlign)
+{
+    ++m_nAllocations;
+    char* pStart = m_pCursor ? alignUp(m_pCursor, nAlign) : nullptr;
+    if (pStart && nBytes <= static_cast<size_t>(m_pEnd - pStart))
+    {
+        m_pCursor = pStart + nBytes;
+        return pStart;
+    }
+    return allocateChunk(nBytes, nAlign);
+}
+
+/*!
+ * @brief 申请新块并从中分配。
+ *
+ * 大请求与直通模式下的请求单独成块并挂在链表中，当前块的剩余空间继续使用。
+ */
+void* MonotonicArena::allocateChunk(const size_t nBytes, const size_t nAlign)
+{
+    const bool bDedicated = m_bPassthrough || nBytes > m_nNextChunkBytes / 2;
+    const size_t nChunkBytes = bDedicated ? sizeof(Chunk) + nAlign + nBytes : m_nNextChunkBytes;
+    Chunk* pChunk = static_cast<Chunk*>(::operator new(nChunkBytes));
+    pChunk->pNext = m_pChunks;
+    pChunk->nBytes = nChunkBytes;
+    m_pChunks = pChunk;
+    ++m_nChunks;
+
+    char* pBegin = reinterpret_cast<char*>(pChunk + 1);
+    char* pStart = alignUp(pBegin, nAlign);
+    if (!bDedicated)
+    {
+        m_pCursor = pStart + nBytes;
+        m_pEnd = reinterpret_cast<char*>(pChunk) + nChunkBytes;
+        m_nNextChunkBytes = std::min(m_nNextChunkBytes * 2, kMaxChunkBytes);
+    }
+    return pStart;
+}
+
+void MonotonicArena::release()
+{
+    if (m_nAllocations > 0 && !m_bPassthrough)
+    {
+        PerfCounters::add(PerfArenaAllocations, static_cast<long long>(m_nAllocations));
+        PerfCounters::add(PerfArenaChunks, static_cast<long long>(m_nChunks));
+    }
+    while (m_pChunks)
+    {
+        Chunk* pNext = m_pChunks->pNext;
+        ::operator delete(m_pChunks);
+        m_pChunks = pNext;
+    }
+    m_pCursor = nullptr;
+    m_pEnd = nullptr;
+    m_nNextChunkBytes = kInitialChunkBytes;
+    m_nAllocations = 0;
+    m_nChunks = 0;
+}
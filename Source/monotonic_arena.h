@@ -0,0 +1,129 @@
+﻿/*!
+ * @brief 单调递增的 arena 分配器，用于单页分析过程中的临时数据。
+ *
+ * 读取注释几何、识别正文网址等单页分析会产生大量短命的小对象（顶点数组、字符串缓冲区等），
+ * 逐个向堆申请和释放在执行线程与 GUI 线程之间争用分配器的锁，并留下碎片。`MonotonicArena`
+ * 以大块内存顺序切分，分配只移动指针，单个对象不释放，分析结束时整块一次归还。
+ *
+ * `ArenaAllocator` 把 arena 接入标准容器，`ArenaVector<T>` 为常用的别名。从 arena 分配的
+ * 对象不得在 arena 销毁后使用；需要保留的结果（注释路径、链接地址等）仍复制到普通容器中。
+ *
+ * 每个 arena 销毁或 `release()` 时把服务的分配次数与实际向堆申请的块数计入 `PerfCounters`，
+ * 性能面板据此显示改用 arena 前后的堆分配次数。以直通模式构造的 arena 每次分配都单独向堆申请，
+ * 行为与不用 arena 相同，供 kpdf-arenabench 对比两种方式下整页分析的实际堆分配次数。
+ *
+ * @author LiuYe
+ * @date 2026-10-19
+ * @copyright (c) 2013-2026 Honghu Yuntu Corporation
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+/*!
+ * @brief 只分配不单独释放的内存池，不可跨线程共享。
+ *
+ * 第一次分配时才向堆申请第一块（16 KB），之后每块的大小翻倍直到 256 KB；超过块大小一半的请求单独申请一块。
+ * bPassthrough 为真时每个请求都单独申请一块，且不计入 `PerfCounters`。
+ *
+ * @date 2026.10.19
+ */
+class MonotonicArena
+{
+public:
+    explicit MonotonicArena(bool bPassthrough = false);
+    ~MonotonicArena();
+
+    // 分配 nBytes 字节，按 nAlign 对齐（nAlign 须为 2 的幂）
+    void* allocate(size_t nBytes, size_t nAlign);
+
+    // 一次释放全部内存，之前分配的对象全部失效
+    void release();
+
+    // 自上次 release() 以来服务的分配次数
+    size_t allocationCount() const
+    {
+        return m_nAllocations;
+    }
+
+    // 自上次 release() 以来向堆申请的块数
+    size_t chunkCount() const
+    {
+        return m_nChunks;
+    }
+
+    MonotonicArena(const MonotonicArena&) = delete;
+    MonotonicArena& operator=(const MonotonicArena&) = delete;
+
+private:
+    struct Chunk
+    {
+        Chunk* pNext;
+        size_t nBytes;
+    };
+
+    void* allocateChunk(size_t nBytes, size_t nAlign);
+
+    Chunk* m_pChunks;                 // 最近申请的块在前
+    char* m_pCursor;                  // 当前块的空闲起点
+    char* m_pEnd;
+    size_t m_nNextChunkBytes;
+    size_t m_nAllocations;
+    size_t m_nChunks;
+    bool m_bPassthrough;              // 每个请求单独向堆申请，用于对比
+};
+
+/*!
+ * @brief 从 `MonotonicArena` 分配的标准分配器，deallocate 不做任何事。
+ */
+template <typename T>
+class ArenaAllocator
+{
+public:
+    typedef T value_type;
+
+    explicit ArenaAllocator(MonotonicArena& arena)
+        : m_pArena(&arena)
+    {
+    }
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other)
+        : m_pArena(other.arena())
+    {
+    }
+
+    T* allocate(const size_t nCount)
+    {
+        return static_cast<T*>(m_pArena->allocate(nCount * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T*, size_t)
+    {
+    }
+
+    MonotonicArena* arena() const
+    {
+        return m_pArena;
+    }
+
+private:
+    MonotonicArena* m_pArena;
+};
+
+template <typename T, typename U>
+bool operator==(const ArenaAllocator<T>& left, const ArenaAllocator<U>& right)
+{
+    return left.arena() == right.arena();
+}
+
+template <typename T, typename U>
+bool operator!=(const ArenaAllocator<T>& left, const ArenaAllocator<U>& right)
+{
+    return left.arena() != right.arena();
+}
+
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
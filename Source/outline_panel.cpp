@@ -0,0 +1,104 @@
+﻿/*!
+ * @brief 书签（大纲）面板的实现。
+ *
+ * @author LiuYe
+ * @date 2026-10-19
+ * @copyright (c) 2013-2026 Honghu Yuntu Corporation
+ */
+
+#include "outline_panel.h"
+
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QLineEdit>
+#include <QTreeView>
+#include <QVBoxLayout>
+
+#include "pdf_outline.h"
+#include "pdf_viewer.h"
+
+OutlinePanel::OutlinePanel(QWidget* pParent)
+    : QWidget(pParent), m_pSearchEdit(new QLineEdit(this)), m_pStatusLabel(new QLabel(this)),
+    m_pTreeView(new QTreeView(this)), m_pModel(new PdfOutlineModel(this))
+{
+    m_pSearchEdit->setPlaceholderText("Find bookmark title");
+    m_pSearchEdit->setClearButtonEnabled(true);
+
+    // 书签数量很大时统一行高让视图不必逐行计算高度
+    m_pTreeView->setModel(m_pModel);
+    m_pTreeView->setHeaderHidden(true);
+    m_pTreeView->setUniformRowHeights(true);
+    m_pTreeView->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_pTreeView->header()->setSectionResizeMode(QHeaderView::Stretch);
+
+    QHBoxLayout* pSearchLayout = new QHBoxLayout;
+    pSearchLayout->setContentsMargins(0, 0, 0, 0);
+    pSearchLayout->addWidget(m_pSearchEdit, 1);
+    pSearchLayout->addWidget(m_pStatusLabel);
+
+    QVBoxLayout* pLayout = new QVBoxLayout(this);
+    pLayout->setContentsMargins(0, 0, 0, 0);
+    pLayout->setSpacing(0);
+    pLayout->addLayout(pSearchLayout);
+    pLayout->addWidget(m_pTreeView, 1);
+
+    connect(m_pTreeView, &QTreeView::activated, this, &OutlinePanel::onActivated);
+    connect(m_pTreeView, &QTreeView::clicked, this, &OutlinePanel::onActivated);
+    connect(m_pModel, &PdfOutlineModel::pageActivated, this, &OutlinePanel::onPageActivated);
+    connect(m_pModel, &PdfOutlineModel::found, this, &OutlinePanel::onFound);
+    connect(m_pSearchEdit, &QLineEdit::returnPressed, this, &OutlinePanel::onSearch);
+}
+
+void OutlinePanel::setViewer(PDFViewer* pViewer)
+{
+    disconnect(m_oLoadedConnection);
+    m_pViewer = pViewer;
+    m_pStatusLabel->clear();
+    m_pModel->setDocument(pViewer ? pViewer->loader()->document() : PdfDocumentPtr());
+    if (pViewer && !pViewer->loader()->document())
+    {
+        m_oLoadedConnection = connect(pViewer->loader(), &PdfDocumentLoader::xrefParsed, this, [this]()
+            {
+                if (m_pViewer)
+                {
+                    m_pModel->setDocument(m_pViewer->loader()->document());
+                }
+            });
+    }
+}
+
+void OutlinePanel::onActivated(const QModelIndex& index)
+{
+    m_pModel->activate(index);
+}
+
+void OutlinePanel::onPageActivated(const int nPage)
+{
+    if (m_pViewer && m_pViewer->document() == m_pModel->document())
+    {
+        // 查看器在页码越界、用户保留未保存的编辑或保存未完成时不跳转
+        if (!m_pViewer->showPage(nPage))
+        {
+            m_pStatusLabel->setText(QStringLiteral("Did not go to page %1").arg(nPage + 1));
+        }
+    }
+}
+
+void OutlinePanel::onFound(const QModelIndex& index)
+{
+    if (!index.isValid())
+    {
+        m_pStatusLabel->setText("Not found");
+        return;
+    }
+    m_pStatusLabel->clear();
+    m_pTreeView->setCurrentIndex(index);
+    m_pTreeView->scrollTo(index);
+}
+
+void OutlinePanel::onSearch()
+{
+    m_pStatusLabel->setText("Searching...");
+    m_pModel->find(m_pSearchEdit->text().trimmed());
+}
@@ -0,0 +1,52 @@
+﻿/*!
+ * @brief 书签（大纲）面板。
+ *
+ * 面板显示当前标签页文档的书签树，点击书签跳转到目标页，输入标题后回车查找书签。
+ * 书签按需分批加载（见 `PdfOutlineModel`），打开文档和切换标签页都不会遍历大纲。
+ *
+ * @author LiuYe
+ * @date 2026-10-19
+ * @copyright (c) 2013-2026 Honghu Yuntu Corporation
+ */
+
+#pragma once
+
+#include <QPointer>
+#include <QWidget>
+
+class QLabel;
+class QLineEdit;
+class QTreeView;
+class PDFViewer;
+class PdfOutlineModel;
+
+/*!
+ * @brief 书签面板，跟随当前标签页切换文档。
+ *
+ * @param pParent 父窗口对象，默认为 nullptr
+ * @date 2026.10.19
+ */
+class OutlinePanel : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit OutlinePanel(QWidget* pParent = nullptr);
+
+    // 显示该查看器的文档的书签；文档仍在加载时在交叉引用表解析完成后显示
+    void setViewer(PDFViewer* pViewer);
+
+private slots:
+    void onActivated(const QModelIndex& index);
+    void onPageActivated(int nPage);
+    void onFound(const QModelIndex& index);
+    void onSearch();
+
+private:
+    QLineEdit* m_pSearchEdit;
+    QLabel* m_pStatusLabel;
+    QTreeView* m_pTreeView;
+    PdfOutlineModel* m_pModel;
+    QPointer<PDFViewer> m_pViewer;
+    QMetaObject::Connection m_oLoadedConnection; // 等待文档解析完成的连接
+};
@@ -0,0 +1,733 @@
+﻿/*!
+ * @brief 文档合并、拆分与页面提取的实现。
+ *
+ * @author LiuYe
+ * @date 2026-10-19
+ * @copyright (c) 2013-2026 Honghu Yuntu Corporation
+ */
+
+#include "page_assembly.h"
+
+#include "fpdf_edit.h"
+#include "fpdf_ppo.h"
+#include "fpdf_save.h"
+#include "pdf_document.h"
+#include "pdfium_runtime.h"
+
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QFileInfo>
+#include <QProcess>
+#include <QSaveFile>
+#include <QThread>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+    // 工作进程输入中表示全部页、不拼版的占位符，避免传递空字段
+    const char* const kAllPages = "-";
+    const char* const kSequential = "-";
+
+    // 平铺时容许的尺寸误差（点），页面恰好等于纸张大小时不多出一列空白
+    const double kTileTolerance = 0.5;
+
+    struct NamedSheet
+    {
+        const char* pName;
+        double dWidth;
+        double dHeight;
+    };
+
+    const NamedSheet kNamedSheets[] = {
+        { "a0", 2384, 3370 },
+        { "a1", 1684, 2384 },
+        { "a2", 1191, 1684 },
+        { "a3", 842, 1191 },
+        { "a4", 595, 842 },
+        { "letter", 612, 792 },
+        { "tabloid", 792, 1224 }
+    };
+
+    // N-up 的网格，常用页数取横向排列较多的网格，配合横向纸张
+    void nUpGrid(const int nPagesPerSheet, int& nColumns, int& nRows)
+    {
+        switch (nPagesPerSheet)
+        {
+        case 2:
+            nColumns = 2;
+            nRows = 1;
+            return;
+        case 6:
+            nColumns = 3;
+            nRows = 2;
+            return;
+        case 8:
+            nColumns = 4;
+            nRows = 2;
+            return;
+        default:
+            nColumns = std::max(1, static_cast<int>(std::ceil(std::sqrt(static_cast<double>(nPagesPerSheet)))));
+            nRows = std::max(1, (nPagesPerSheet + nColumns - 1) / nColumns);
+            return;
+        }
+    }
+
+    // 解析 "1,3,5-7"（从 1 开始）为页下标，范围超出页数时返回 false
+    bool parsePageRange(const QString& strPages, const int nPageCount, std::vector<int>& vecPages)
+    {
+        if (strPages.isEmpty())
+        {
+            for (int i = 0; i < nPageCount; ++i)
+            {
+                vecPages.push_back(i);
+            }
+            return nPageCount > 0;
+        }
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+        const QStringList lstParts = strPages.split(',', Qt::SkipEmptyParts);
+#else
+        const QStringList lstParts = strPages.split(',', QString::SkipEmptyParts);
+#endif
+        for (int i = 0; i < lstParts.size(); ++i)
+        {
+            const QStringList lstBounds = lstParts[i].split('-');
+            bool bFirstOk = false;
+            bool bLastOk = false;
+            const int nFirst = lstBounds[0].trimmed().toInt(&bFirstOk);
+            const int nLast = lstBounds.size() == 2 ? lstBounds[1].trimmed().toInt(&bLastOk) : nFirst;
+            if (!bFirstOk || (lstBounds.size() == 2 && !bLastOk) || lstBounds.size() > 2 || nFirst < 1
+                || nLast < nFirst || nLast > nPageCount)
+            {
+                return false;
+            }
+            for (int nPage = nFirst; nPage <= nLast; ++nPage)
+            {
+                vecPages.push_back(nPage - 1);
+            }
+        }
+        return !vecPages.empty();
+    }
+
+    /*!
+     * @brief 源页面的放置变换。
+     *
+     * 先把裁剪框按页面的 /Rotate 摆正并移到原点，再缩放 dScale、平移到 (dX, dY)。
+     * 表单 XObject 保留页面未旋转的坐标，旋转需要在放置时补上。
+     */
+    FS_MATRIX placementMatrix(const FS_RECTF& crop, const int nRotation, const double dScale, const double dX,
+        const double dY)
+    {
+        double a = 1.0;
+        double b = 0.0;
+        double c = 0.0;
+        double d = 1.0;
+        double e = -crop.left;
+        double f = -crop.bottom;
+        switch (nRotation)
+        {
+        case 1:
+            a = 0.0;
+            b = -1.0;
+            c = 1.0;
+            d = 0.0;
+            e = -crop.bottom;
+            f = crop.right;
+            break;
+        case 2:
+            a = -1.0;
+            d = -1.0;
+            e = crop.right;
+            f = crop.top;
+            break;
+        case 3:
+            a = 0.0;
+            b = 1.0;
+            c = -1.0;
+            d = 0.0;
+            e = crop.top;
+            f = -crop.left;
+            break;
+        default:
+            break;
+        }
+
+        FS_MATRIX matrix;
+        matrix.a = static_cast<float>(a * dScale);
+        matrix.b = static_cast<float>(b * dScale);
+        matrix.c = static_cast<float>(c * dScale);
+        matrix.d = static_cast<float>(d * dScale);
+        matrix.e = static_cast<float>(e * dScale + dX);
+        matrix.f = static_cast<float>(f * dScale + dY);
+        return matrix;
+    }
+
+    /*!
+     * @brief 把一个源页面按原大小分块平铺到若干张纸上。
+     *
+     * 每块是一张纸大小的新页面，放置同一个表单 XObject 并平移到该块的位置，块以外的内容由页面边界裁掉。
+     * 块按从上到下、从左到右的顺序输出。
+     */
+    bool tilePage(const FPDF_DOCUMENT pOutput, const FPDF_DOCUMENT pSource, const int nPage, const QSizeF& oSheet)
+    {
+        const FPDF_PAGE page = FPDF_LoadPage(pSource, nPage);
+        if (!page)
+        {
+            return false;
+        }
+        FS_RECTF crop;
+        if (!FPDF_GetPageBoundingBox(page, &crop))
+        {
+            crop.left = 0.0f;
+            crop.bottom = 0.0f;
+            crop.right = FPDF_GetPageWidthF(page);
+            crop.top = FPDF_GetPageHeightF(page);
+        }
+        const int nRotation = FPDFPage_GetRotation(page);
+        FPDF_ClosePage(page);
+
+        const bool bSwap = nRotation % 2 == 1;
+        const double dWidth = bSwap ? crop.top - crop.bottom : crop.right - crop.left;
+        const double dHeight = bSwap ? crop.right - crop.left : crop.top - crop.bottom;
+        const int nColumns = std::max(1, static_cast<int>(std::ceil((dWidth - kTileTolerance) / oSheet.width())));
+        const int nRows = std::max(1, static_cast<int>(std::ceil((dHeight - kTileTolerance) / oSheet.height())));
+
+        const FPDF_XOBJECT xobject = FPDF_NewXObjectFromPage(pOutput, pSource, nPage);
+        if (!xobject)
+        {
+            return false;
+        }
+        bool bSucceeded = true;
+        for (int nRow = 0; nRow < nRows && bSucceeded; ++nRow)
+        {
+            for (int nColumn = 0; nColumn < nColumns && bSucceeded; ++nColumn)
+            {
+                const FPDF_PAGE sheet = FPDFPage_New(pOutput, FPDF_GetPageCount(pOutput), oSheet.width(),
+                    oSheet.height());
+                const FPDF_PAGEOBJECT form = sheet ? FPDF_NewFormObjectFromXObject(xobject) : nullptr;
+                if (form)
+                {
+                    // 第 nRow 行（自上而下）对应页面 y 区间 [dHeight - (nRow + 1) * 纸高, dHeight - nRow * 纸高]
+                    const FS_MATRIX matrix = placementMatrix(crop, nRotation, 1.0, -nColumn * oSheet.width(),
+                        (nRow + 1) * oSheet.height() - dHeight);
+                    FPDFPageObj_TransformF(form, &matrix);
+                    FPDFPage_InsertObject(sheet, form);
+                }
+                bSucceeded = form && FPDFPage_GenerateContent(sheet);
+                if (sheet)
+                {
+                    FPDF_ClosePage(sheet);
+                }
+            }
+        }
+        FPDF_CloseXObject(xobject);
+        return bSucceeded;
+    }
+
+    /*!
+     * @brief 按 N-up 拼版生成临时文档。
+     *
+     * 只导入部分页时先把这些页导入一个临时文档。纸张大小未指定时取第一页大小，网格列数多于行数时
+     * 用横向纸张。
+     */
+    FPDF_DOCUMENT nUpDocument(FPDF_DOCUMENT pSource, const QByteArray& pages, const PageImposition& imposition)
+    {
+        FPDF_DOCUMENT pSelected = nullptr;
+        if (!pages.isEmpty())
+        {
+            pSelected = FPDF_CreateNewDocument();
+            if (!pSelected || !FPDF_ImportPages(pSelected, pSource, pages.constData(), 0))
+            {
+                if (pSelected)
+                {
+                    FPDF_CloseDocument(pSelected);
+                }
+                return nullptr;
+            }
+            pSource = pSelected;
+        }
+
+        QSizeF oSheet = imposition.oSheetSize;
+        FS_SIZEF size;
+        if (oSheet.isEmpty() && FPDF_GetPageSizeByIndexF(pSource, 0, &size))
+        {
+            const double dLong = std::max(size.width, size.height);
+            const double dShort = std::min(size.width, size.height);
+            oSheet = imposition.columns() > imposition.rows() ? QSizeF(dLong, dShort) : QSizeF(dShort, dLong);
+        }
+        const FPDF_DOCUMENT pNUp = oSheet.isEmpty() ? nullptr
+            : FPDF_ImportNPagesToOne(pSource, static_cast<float>(oSheet.width()), static_cast<float>(oSheet.height()),
+                static_cast<size_t>(imposition.columns()), static_cast<size_t>(imposition.rows()));
+        if (pSelected)
+        {
+            FPDF_CloseDocument(pSelected);
+        }
+        return pNUp;
+    }
+
+    // 按拼版方式把一个源文档的页面追加到输出文档
+    bool importSource(const FPDF_DOCUMENT pOutput, const FPDF_DOCUMENT pSource, const QString& strPages,
+        const PageImposition& imposition)
+    {
+        const QByteArray pages = strPages.toLatin1();
+        switch (imposition.eLayout)
+        {
+        case PageImposition::NUp:
+        {
+            const FPDF_DOCUMENT pNUp = nUpDocument(pSource, pages, imposition);
+            const bool bSucceeded = pNUp && FPDF_ImportPages(pOutput, pNUp, nullptr, FPDF_GetPageCount(pOutput));
+            if (pNUp)
+            {
+                FPDF_CloseDocument(pNUp);
+            }
+            return bSucceeded;
+        }
+        case PageImposition::Tiles:
+        {
+            std::vector<int> vecPages;
+            if (!parsePageRange(strPages, FPDF_GetPageCount(pSource), vecPages))
+            {
+                return false;
+            }
+            for (size_t i = 0; i < vecPages.size(); ++i)
+            {
+                if (!tilePage(pOutput, pSource, vecPages[i], imposition.oSheetSize))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+        default:
+            return FPDF_ImportPages(pOutput, pSource, pages.isEmpty() ? nullptr : pages.constData(),
+                FPDF_GetPageCount(pOutput)) != 0;
+        }
+    }
+
+    /*!
+     * @brief FPDF_SaveAsCopy 的输出端，写入 QSaveFile，提交前不会覆盖已有文件。
+     */
+    struct FileWriter : public FPDF_FILEWRITE
+    {
+        QSaveFile* pFile;
+    };
+
+    int writeBlock(FPDF_FILEWRITE* pThis, const void* pData, unsigned long nSize)
+    {
+        QSaveFile* pFile = static_cast<FileWriter*>(pThis)->pFile;
+        return pFile->write(static_cast<const char*>(pData), static_cast<qint64>(nSize)) == static_cast<qint64>(nSize)
+            ? 1 : 0;
+    }
+
+    bool saveDocument(const FPDF_DOCUMENT pDocument, const QString& strPath, QString& strError)
+    {
+        QSaveFile file(strPath);
+        if (!file.open(QIODevice::WriteOnly))
+        {
+            strError = file.errorString();
+            return false;
+        }
+
+        FileWriter writer;
+        writer.version = 1;
+        writer.WriteBlock = writeBlock;
+        writer.pFile = &file;
+        if (!FPDF_SaveAsCopy(pDocument, &writer, FPDF_NO_INCREMENTAL) || !file.commit())
+        {
+            strError = file.errorString().isEmpty() ? QStringLiteral("Failed to write the document")
+                : file.errorString();
+            return false;
+        }
+        return true;
+    }
+
+    // out.pdf 的第 n 个拆分文件为 out_n.pdf
+    QString numberedPath(const QString& strOutput, const int nNumber)
+    {
+        const QFileInfo info(strOutput);
+        const QString strSuffix = info.suffix().isEmpty() ? QString() : "." + info.suffix();
+        return info.path() + "/" + info.completeBaseName() + QStringLiteral("_%1").arg(nNumber) + strSuffix;
+    }
+}
+
+PageAssemblySource::PageAssemblySource()
+{
+}
+
+PageAssemblySource::PageAssemblySource(const QString& strSourcePath, const QString& strPageRange)
+    : strPath(strSourcePath), strPages(strPageRange)
+{
+}
+
+PageImposition::PageImposition()
+    : eLayout(Sequential), nPagesPerSheet(1)
+{
+}
+
+QString PageImposition::toString() const
+{
+    const QString strSheet = oSheetSize.isEmpty() ? QString()
+        : QStringLiteral("%1x%2").arg(oSheetSize.width()).arg(oSheetSize.height());
+    switch (eLayout)
+    {
+    case NUp:
+        return QStringLiteral("nup:%1").arg(nPagesPerSheet) + (strSheet.isEmpty() ? QString() : ":" + strSheet);
+    case Tiles:
+        return "tile:" + strSheet;
+    default:
+        return QString::fromLatin1(kSequential);
+    }
+}
+
+bool PageImposition::fromString(const QString& strText, PageImposition& imposition)
+{
+    imposition = PageImposition();
+    if (strText == kSequential)
+    {
+        return true;
+    }
+
+    const QStringList lstParts = strText.split(':');
+    if (lstParts[0] == "nup" && (lstParts.size() == 2 || lstParts.size() == 3))
+    {
+        imposition.eLayout = NUp;
+        imposition.nPagesPerSheet = lstParts[1].toInt();
+        return imposition.nPagesPerSheet > 0
+            && (lstParts.size() == 2 || parseSheetSize(lstParts[2], imposition.oSheetSize));
+    }
+    if (lstParts[0] == "tile" && lstParts.size() == 2)
+    {
+        imposition.eLayout = Tiles;
+        return parseSheetSize(lstParts[1], imposition.oSheetSize);
+    }
+    return false;
+}
+
+int PageImposition::columns() const
+{
+    int nColumns = 1;
+    int nRows = 1;
+    nUpGrid(nPagesPerSheet, nColumns, nRows);
+    return nColumns;
+}
+
+int PageImposition::rows() const
+{
+    int nColumns = 1;
+    int nRows = 1;
+    nUpGrid(nPagesPerSheet, nColumns, nRows);
+    return nRows;
+}
+
+bool parseSheetSize(const QString& strText, QSizeF& oSize)
+{
+    const QString strName = strText.trimmed().toLower();
+    for (size_t i = 0; i < sizeof(kNamedSheets) / sizeof(kNamedSheets[0]); ++i)
+    {
+        if (strName == kNamedSheets[i].pName)
+        {
+            oSize = QSizeF(kNamedSheets[i].dWidth, kNamedSheets[i].dHeight);
+            return true;
+        }
+    }
+
+    const QStringList lstParts = strName.split('x');
+    bool bWidthOk = false;
+    bool bHeightOk = false;
+    if (lstParts.size() == 2)
+    {
+        oSize = QSizeF(lstParts[0].toDouble(&bWidthOk), lstParts[1].toDouble(&bHeightOk));
+    }
+    return bWidthOk && bHeightOk && !oSize.isEmpty();
+}
+
+// 字段依次为输出文件、拼版方式、各源文件路径与页码范围，以 QDataStream 编码后转为 Base64，
+// 工作进程在 Windows 上以文本模式读取标准输入，Base64 不含会被换行转换改写的字节
+QByteArray PageAssemblyJob::toWorkerInput() const
+{
+    QStringList lstFields;
+    lstFields << strOutput << oImposition.toString();
+    for (int i = 0; i < vecSources.size(); ++i)
+    {
+        lstFields << vecSources[i].strPath
+                  << (vecSources[i].strPages.isEmpty() ? QString::fromLatin1(kAllPages) : vecSources[i].strPages);
+    }
+
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_6);
+    stream << lstFields;
+    return data.toBase64();
+}
+
+bool PageAssemblyJob::fromWorkerInput(const QByteArray& input, PageAssemblyJob& job)
+{
+    QStringList lstFields;
+    QDataStream stream(QByteArray::fromBase64(input.trimmed()));
+    stream.setVersion(QDataStream::Qt_5_6);
+    stream >> lstFields;
+    if (stream.status() != QDataStream::Ok || lstFields.size() < 4 || lstFields.size() % 2 == 1
+        || !PageImposition::fromString(lstFields[1], job.oImposition))
+    {
+        return false;
+    }
+    job.strOutput = lstFields[0];
+    job.vecSources.clear();
+    for (int i = 2; i + 1 < lstFields.size(); i += 2)
+    {
+        const QString& strPages = lstFields[i + 1];
+        job.vecSources.append(PageAssemblySource(lstFields[i], strPages == kAllPages ? QString() : strPages));
+    }
+    return true;
+}
+
+PageAssemblyResult::PageAssemblyResult()
+    : bSucceeded(false), nPages(0)
+{
+}
+
+PageAssemblyReport::PageAssemblyReport()
+    : nFiles(0), nFailed(0), nPages(0), nMilliseconds(0), bCanceled(false)
+{
+}
+
+double PageAssemblyReport::pagesPerSecond() const
+{
+    return nMilliseconds > 0 ? nPages * 1000.0 / nMilliseconds : 0.0;
+}
+
+QVector<PageAssemblyJob> planMerge(const QStringList& lstSources, const QString& strOutput)
+{
+    PageAssemblyJob job;
+    job.strOutput = strOutput;
+    for (int i = 0; i < lstSources.size(); ++i)
+    {
+        job.vecSources.append(PageAssemblySource(lstSources[i], QString()));
+    }
+    return QVector<PageAssemblyJob>() << job;
+}
+
+QVector<PageAssemblyJob> planSplit(const QString& strSource, const QStringList& lstRanges, const QString& strOutput)
+{
+    QVector<PageAssemblyJob> vecJobs;
+    for (int i = 0; i < lstRanges.size(); ++i)
+    {
+        PageAssemblyJob job;
+        job.strOutput = numberedPath(strOutput, i + 1);
+        job.vecSources.append(PageAssemblySource(strSource, lstRanges[i].trimmed()));
+        vecJobs.append(job);
+    }
+    return vecJobs;
+}
+
+QVector<PageAssemblyJob> planSplitEvery(const QString& strSource, const int nPageCount, const int nPagesPerFile,
+    const QString& strOutput)
+{
+    QStringList lstRanges;
+    const int nStep = std::max(1, nPagesPerFile);
+    for (int nFirst = 1; nFirst <= nPageCount; nFirst += nStep)
+    {
+        const int nLast = std::min(nPageCount, nFirst + nStep - 1);
+        lstRanges << (nFirst == nLast ? QString::number(nFirst) : QStringLiteral("%1-%2").arg(nFirst).arg(nLast));
+    }
+    return planSplit(strSource, lstRanges, strOutput);
+}
+
+QVector<PageAssemblyJob> planImpose(const QStringList& lstSources, const PageImposition& imposition,
+    const QString& strOutput)
+{
+    QVector<PageAssemblyJob> vecJobs = planMerge(lstSources, strOutput);
+    vecJobs[0].oImposition = imposition;
+    return vecJobs;
+}
+
+QVector<PageAssemblyJob> planExtract(const QString& strSource, const QString& strPages, const QString& strOutput)
+{
+    PageAssemblyJob job;
+    job.strOutput = strOutput;
+    job.vecSources.append(PageAssemblySource(strSource, strPages.trimmed()));
+    return QVector<PageAssemblyJob>() << job;
+}
+
+/*!
+ * @brief 生成一个输出文件。
+ *
+ * 导入的页面对象以及拼版用的表单 XObject 都被复制到输出文档，源文档在导入后即可关闭，
+ * 因此源文档逐个打开、逐个关闭。
+ */
+PageAssemblyResult assemblePages(const PageAssemblyJob& job)
+{
+    PdfiumRuntimeRef runtime;
+    PageAssemblyResult result;
+    result.strOutput = job.strOutput;
+
+    const FPDF_DOCUMENT pOutput = FPDF_CreateNewDocument();
+    if (!pOutput)
+    {
+        result.strError = QStringLiteral("Failed to create the output document");
+        return result;
+    }
+
+    for (int i = 0; i < job.vecSources.size() && result.strError.isEmpty(); ++i)
+    {
+        const PageAssemblySource& source = job.vecSources[i];
+        PdfDocumentPtr pSource = PdfDocument::create();
+        QString strError;
+        if (!pSource->map(source.strPath, strError) || !pSource->load(QByteArray(), strError))
+        {
+            result.strError = source.strPath + ": " + strError;
+            break;
+        }
+
+        if (!importSource(pOutput, pSource->handle(), source.strPages, job.oImposition))
+        {
+            // 页码范围有误是最常见的原因，一并给出
+            result.strError = source.strPath + ": " + QStringLiteral("failed to import pages")
+                + (source.strPages.isEmpty() ? QString() : " \"" + source.strPages + "\"");
+            break;
+        }
+        if (i == 0)
+        {
+            FPDF_CopyViewerPreferences(pOutput, pSource->handle());
+        }
+    }
+
+    result.nPages = FPDF_GetPageCount(pOutput);
+    if (result.strError.isEmpty())
+    {
+        QString strError;
+        result.bSucceeded = saveDocument(pOutput, job.strOutput, strError);
+        if (!result.bSucceeded)
+        {
+            result.strError = job.strOutput + ": " + strError;
+        }
+    }
+    FPDF_CloseDocument(pOutput);
+    return result;
+}
+
+PageAssemblyRunner::PageAssemblyRunner(QObject* pParent)
+    : QObject(pParent), m_nNextJob(0), m_nRunning(0), m_nFinished(0),
+    m_nMaxWorkers(std::max(1, QThread::idealThreadCount()))
+{
+}
+
+PageAssemblyRunner::~PageAssemblyRunner()
+{
+    cancel();
+}
+
+void PageAssemblyRunner::setMaxWorkers(const int nMaxWorkers)
+{
+    m_nMaxWorkers = std::max(1, nMaxWorkers);
+}
+
+bool PageAssemblyRunner::start(const QVector<PageAssemblyJob>& vecJobs)
+{
+    if (isRunning())
+    {
+        return false;
+    }
+
+    m_vecJobs = vecJobs;
+    m_nNextJob = 0;
+    m_nFinished = 0;
+    m_oReport = PageAssemblyReport();
+    m_oTimer.start();
+    if (m_vecJobs.isEmpty())
+    {
+        emit finished(m_oReport);
+        return true;
+    }
+    while (m_nRunning < m_nMaxWorkers && m_nNextJob < m_vecJobs.size())
+    {
+        launchNext();
+    }
+    return true;
+}
+
+void PageAssemblyRunner::cancel()
+{
+    if (!isRunning())
+    {
+        return;
+    }
+    m_nNextJob = m_vecJobs.size();
+    m_oReport.bCanceled = true;
+    const QList<QProcess*> lstWorkers = m_lstWorkers;
+    for (int i = 0; i < lstWorkers.size(); ++i)
+    {
+        lstWorkers[i]->kill();
+    }
+}
+
+void PageAssemblyRunner::launchNext()
+{
+    const int nJob = m_nNextJob++;
+    QProcess* pProcess = new QProcess(this);
+    m_lstWorkers.append(pProcess);
+    ++m_nRunning;
+
+    connect(pProcess, static_cast<void (QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished), this,
+        [this, pProcess, nJob]()
+        {
+            onWorkerFinished(pProcess, nJob, true);
+        });
+    connect(pProcess, &QProcess::errorOccurred, this, [this, pProcess, nJob](const QProcess::ProcessError eError)
+        {
+            // 启动失败时不会再收到 finished
+            if (eError == QProcess::FailedToStart)
+            {
+                onWorkerFinished(pProcess, nJob, false);
+            }
+        });
+    // 任务写入标准输入，进程启动后送出，写完即关闭使工作进程读到结束
+    pProcess->start(QCoreApplication::applicationFilePath(), QStringList() << QStringLiteral("--assemble-worker"));
+    pProcess->write(m_vecJobs[nJob].toWorkerInput());
+    pProcess->closeWriteChannel();
+}
+
+void PageAssemblyRunner::onWorkerFinished(QProcess* pProcess, const int nJob, const bool bStarted)
+{
+    m_lstWorkers.removeOne(pProcess);
+    --m_nRunning;
+    ++m_nFinished;
+
+    PageAssemblyResult result;
+    result.strOutput = m_vecJobs[nJob].strOutput;
+    const QByteArray output = bStarted ? pProcess->readAllStandardOutput().trimmed() : QByteArray();
+    if (bStarted && pProcess->exitStatus() == QProcess::NormalExit && pProcess->exitCode() == 0
+        && output.startsWith("pages "))
+    {
+        result.bSucceeded = true;
+        result.nPages = output.mid(6).toInt();
+        ++m_oReport.nFiles;
+        m_oReport.nPages += result.nPages;
+    }
+    else
+    {
+        result.strError = bStarted ? QString::fromLocal8Bit(pProcess->readAllStandardError().trimmed())
+            : pProcess->errorString();
+        if (result.strError.isEmpty())
+        {
+            result.strError = result.strOutput + ": " + QStringLiteral("worker process exited abnormally");
+        }
+        ++m_oReport.nFailed;
+    }
+    pProcess->deleteLater();
+
+    emit jobFinished(result);
+    emit progress(m_nFinished, m_vecJobs.size());
+    if (m_nNextJob < m_vecJobs.size())
+    {
+        launchNext();
+    }
+    else if (m_nRunning == 0)
+    {
+        m_oReport.nMilliseconds = m_oTimer.elapsed();
+        emit finished(m_oReport);
+    }
+}
@@ -0,0 +1,185 @@
+﻿/*!
+ * @brief 文档合并、拆分与页面提取。
+ *
+ * 一个输出文件对应一个 `PageAssemblyJob`：按顺序从若干源文档导入页面（`FPDF_ImportPages`），
+ * 并从第一个源文档复制阅读器偏好（`FPDF_CopyViewerPreferences`）。源文档逐个打开、导入后立即关闭，
+ * 合并数百个图纸文件时同一时刻只有一个源文档处于打开状态。
+ *
+ * 审图打印时可把多页拼到一张纸上（N-up，`FPDF_ImportNPagesToOne`），或把大幅面图纸按纸张大小分块
+ * 平铺到多张纸上（`FPDF_NewXObjectFromPage` / `FPDF_NewFormObjectFromXObject`）。两种拼版都把源页面
+ * 作为表单 XObject 引用，输出仍是矢量内容，不做光栅化；平铺时同一源页面的各块共用一个 XObject。
+ *
+ * PDFium 不能在同一进程内并行使用，互不相关的输出文件交给 `PageAssemblyRunner` 在多个工作进程中
+ * 并行生成，每个工作进程同样只打开一个源文档，同时打开的文档数量不超过工作进程数的两倍。
+ * 界面与命令行（见 page_assembly_command.h）共用同一套任务划分与工作进程调度。
+ *
+ * @author LiuYe
+ * @date 2026-10-19
+ * @copyright (c) 2013-2026 Honghu Yuntu Corporation
+ */
+
+#pragma once
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QList>
+#include <QObject>
+#include <QSizeF>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+class QProcess;
+
+/*!
+ * @brief 一个源文档及要导入的页码。
+ */
+struct PageAssemblySource
+{
+    QString strPath;
+    QString strPages;                 // FPDF_ImportPages 的页码范围，如 "1,3,5-7"（从 1 开始），空表示全部页
+
+    PageAssemblySource();
+    PageAssemblySource(const QString& strSourcePath, const QString& strPageRange);
+};
+
+/*!
+ * @brief 输出页面的拼版方式。
+ */
+struct PageImposition
+{
+    enum Layout
+    {
+        Sequential,                   // 源页面原样依次输出
+        NUp,                          // 每张纸按网格排列 nPagesPerSheet 个源页面，等比缩放
+        Tiles                         // 每个源页面按原大小分块平铺到若干张纸上
+    };
+
+    Layout eLayout;
+    int nPagesPerSheet;               // NUp 每张纸的页数，如 2、4、8
+    QSizeF oSheetSize;                // 纸张大小（点）；NUp 为空时取源文档第一页大小，方向随网格
+
+    PageImposition();
+
+    // 与工作进程命令行之间的转换，如 "-"、"nup:4"、"nup:8:1191x842"、"tile:842x1191"
+    QString toString() const;
+    static bool fromString(const QString& strText, PageImposition& imposition);
+
+    // 每张纸的列数与行数
+    int columns() const;
+    int rows() const;
+};
+
+// 解析纸张大小：a0-a4、letter、tabloid（纵向）或 "宽x高"（点）
+bool parseSheetSize(const QString& strText, QSizeF& oSize);
+
+/*!
+ * @brief 生成一个输出文件的任务。
+ */
+struct PageAssemblyJob
+{
+    QString strOutput;
+    QVector<PageAssemblySource> vecSources;
+    PageImposition oImposition;
+
+    // 与工作进程标准输入之间的转换。任务不经命令行传递，源文件再多也不受 Windows 命令行 32K 字符的限制
+    QByteArray toWorkerInput() const;
+    static bool fromWorkerInput(const QByteArray& input, PageAssemblyJob& job);
+};
+
+/*!
+ * @brief 一个任务的执行结果。
+ */
+struct PageAssemblyResult
+{
+    QString strOutput;
+    bool bSucceeded;
+    int nPages;                       // 输出文件的页数
+    QString strError;
+
+    PageAssemblyResult();
+};
+
+/*!
+ * @brief 一批任务的汇总。
+ */
+struct PageAssemblyReport
+{
+    int nFiles;                       // 成功生成的文件数
+    int nFailed;
+    int nPages;                       // 成功生成的文件的总页数
+    qint64 nMilliseconds;             // 从启动第一个工作进程到最后一个结束
+    bool bCanceled;
+
+    PageAssemblyReport();
+
+    double pagesPerSecond() const;
+};
+
+// 合并：全部源文档的全部页面依次写入一个文件
+QVector<PageAssemblyJob> planMerge(const QStringList& lstSources, const QString& strOutput);
+
+// 拆分：每个页码范围生成一个文件，文件名为 strOutput 加序号，如 out_1.pdf
+QVector<PageAssemblyJob> planSplit(const QString& strSource, const QStringList& lstRanges, const QString& strOutput);
+
+// 按固定页数拆分，最后一个文件可能不足 nPagesPerFile 页
+QVector<PageAssemblyJob> planSplitEvery(const QString& strSource, int nPageCount, int nPagesPerFile,
+    const QString& strOutput);
+
+// 拼版：全部源文档的页面按 N-up 或平铺方式写入一个文件；源文档之间另起一张纸
+QVector<PageAssemblyJob> planImpose(const QStringList& lstSources, const PageImposition& imposition,
+    const QString& strOutput);
+
+// 提取：把指定页码范围写入一个文件
+QVector<PageAssemblyJob> planExtract(const QString& strSource, const QString& strPages, const QString& strOutput);
+
+// 生成一个输出文件，只能在 PDFium 执行线程上调用
+PageAssemblyResult assemblePages(const PageAssemblyJob& job);
+
+/*!
+ * @brief 在工作进程中并行执行一批任务。
+ *
+ * 工作进程即本程序以 `--assemble-worker` 参数启动，每个进程从标准输入读取一个任务，成功时在标准输出写出
+ * 输出文件的页数，失败时在标准错误写出原因。同时运行的进程数默认等于处理器核数。
+ *
+ * @date 2026.10.19
+ */
+class PageAssemblyRunner : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PageAssemblyRunner(QObject* pParent = nullptr);
+    ~PageAssemblyRunner() override;
+
+    void setMaxWorkers(int nMaxWorkers);
+
+    // 启动一批任务；已有任务在执行时返回 false
+    bool start(const QVector<PageAssemblyJob>& vecJobs);
+
+    // 结束全部工作进程，尚未开始的任务不再执行
+    void cancel();
+
+    bool isRunning() const
+    {
+        return m_nRunning > 0;
+    }
+
+signals:
+    void jobFinished(const PageAssemblyResult& result);
+    void progress(int nFinished, int nTotal);
+    void finished(const PageAssemblyReport& report);
+
+private:
+    void launchNext();
+    void onWorkerFinished(QProcess* pProcess, int nJob, bool bStarted);
+
+    QVector<PageAssemblyJob> m_vecJobs;
+    QList<QProcess*> m_lstWorkers;    // 正在运行的工作进程
+    int m_nNextJob;                   // 下一个要启动的任务
+    int m_nRunning;
+    int m_nFinished;
+    int m_nMaxWorkers;
+    PageAssemblyReport m_oReport;
+    QElapsedTimer m_oTimer;
+};
@@ -0,0 +1,252 @@
+﻿/*!
+ * @brief 页面装配命令行入口的实现。
+ *
+ * @author LiuYe
+ * @date 2026-10-19
+ * @copyright (c) 2013-2026 Honghu Yuntu Corporation
+ */
+
+#include "page_assembly_command.h"
+
+#include "page_assembly.h"
+#include "pdf_document.h"
+#include "pdfium_executor.h"
+#include "pdfium_runtime.h"
+
+#include <QCoreApplication>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+#include <string>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#endif
+
+namespace
+{
+    const char* const kWorkerFlag = "--assemble-worker";
+
+    int usage()
+    {
+        std::cerr << "usage: KnowingPDF merge [--jobs N] -o OUT.pdf IN.pdf...\n"
+                     "       KnowingPDF split [--jobs N] IN.pdf -o OUT.pdf (--every N | PAGES...)\n"
+                     "       KnowingPDF extract IN.pdf PAGES -o OUT.pdf\n"
+                     "       KnowingPDF nup [--per-sheet N] [--sheet SIZE] -o OUT.pdf IN.pdf...\n"
+                     "       KnowingPDF tile --sheet SIZE -o OUT.pdf IN.pdf...\n"
+                     "PAGES uses 1-based ranges such as 1,3,5-7\n"
+                     "SIZE is a0-a4, letter, tabloid or WIDTHxHEIGHT in points\n";
+        return 2;
+    }
+
+    // 主程序以窗口子系统链接，命令行模式把标准输出接到启动它的控制台
+    void attachConsole()
+    {
+#ifdef Q_OS_WIN
+        if (AttachConsole(ATTACH_PARENT_PROCESS))
+        {
+            std::freopen("CONOUT$", "w", stdout);
+            std::freopen("CONOUT$", "w", stderr);
+        }
+#endif
+    }
+
+    // 任务从标准输入读取，见 PageAssemblyJob::toWorkerInput
+    int runWorker()
+    {
+        const std::string strInput((std::istreambuf_iterator<char>(std::cin)), std::istreambuf_iterator<char>());
+        PageAssemblyJob job;
+        if (!PageAssemblyJob::fromWorkerInput(QByteArray(strInput.data(), static_cast<int>(strInput.size())), job))
+        {
+            std::cerr << "invalid worker input\n";
+            return 2;
+        }
+        const PageAssemblyResult result = PdfiumExecutor::instance().run<PageAssemblyResult>(
+            [job](QFutureInterface<PageAssemblyResult>&)
+            {
+                return assemblePages(job);
+            }).result();
+        if (!result.bSucceeded)
+        {
+            std::cerr << result.strError.toLocal8Bit().constData() << '\n';
+            return 1;
+        }
+        std::cout << "pages " << result.nPages << '\n';
+        return 0;
+    }
+
+    // 按固定页数拆分前读取页数
+    int pageCount(const QString& strPath, QString& strError)
+    {
+        return PdfiumExecutor::instance().run<int>([strPath, &strError](QFutureInterface<int>&)
+            {
+                PdfDocumentPtr pDocument = PdfDocument::create();
+                if (!pDocument->map(strPath, strError) || !pDocument->load(QByteArray(), strError))
+                {
+                    return -1;
+                }
+                return FPDF_GetPageCount(pDocument->handle());
+            }).result();
+    }
+
+    // 解析 merge / split / extract 的参数并划分任务，参数有误时返回 false
+    bool planJobs(const QStringList& lstArgs, QVector<PageAssemblyJob>& vecJobs, int& nMaxWorkers)
+    {
+        QString strOutput;
+        int nEvery = 0;
+        PageImposition imposition;
+        imposition.nPagesPerSheet = 4;
+        bool bSheetOk = true;
+        QStringList lstPositional;
+        for (int i = 1; i < lstArgs.size(); ++i)
+        {
+            const bool bHasValue = i + 1 < lstArgs.size();
+            if (lstArgs[i] == "-o" && bHasValue)
+            {
+                strOutput = lstArgs[++i];
+            }
+            else if (lstArgs[i] == "--jobs" && bHasValue)
+            {
+                nMaxWorkers = std::max(1, lstArgs[++i].toInt());
+            }
+            else if (lstArgs[i] == "--every" && bHasValue)
+            {
+                nEvery = lstArgs[++i].toInt();
+            }
+            else if (lstArgs[i] == "--per-sheet" && bHasValue)
+            {
+                imposition.nPagesPerSheet = std::max(1, lstArgs[++i].toInt());
+            }
+            else if (lstArgs[i] == "--sheet" && bHasValue)
+            {
+                bSheetOk = parseSheetSize(lstArgs[++i], imposition.oSheetSize);
+            }
+            else if (lstArgs[i].startsWith("--"))
+            {
+                return false;
+            }
+            else
+            {
+                lstPositional << lstArgs[i];
+            }
+        }
+        if (strOutput.isEmpty() || lstPositional.isEmpty() || !bSheetOk)
+        {
+            return false;
+        }
+
+        const QString& strCommand = lstArgs[0];
+        if (strCommand == "merge")
+        {
+            vecJobs = planMerge(lstPositional, strOutput);
+        }
+        else if (strCommand == "nup")
+        {
+            imposition.eLayout = PageImposition::NUp;
+            vecJobs = planImpose(lstPositional, imposition, strOutput);
+        }
+        else if (strCommand == "tile" && !imposition.oSheetSize.isEmpty())
+        {
+            imposition.eLayout = PageImposition::Tiles;
+            vecJobs = planImpose(lstPositional, imposition, strOutput);
+        }
+        else if (strCommand == "extract" && lstPositional.size() == 2)
+        {
+            vecJobs = planExtract(lstPositional[0], lstPositional[1], strOutput);
+        }
+        else if (strCommand == "split" && nEvery > 0 && lstPositional.size() == 1)
+        {
+            QString strError;
+            const int nPages = pageCount(lstPositional[0], strError);
+            if (nPages < 0)
+            {
+                std::cerr << lstPositional[0].toLocal8Bit().constData() << ": " << strError.toLocal8Bit().constData()
+                          << '\n';
+                return false;
+            }
+            vecJobs = planSplitEvery(lstPositional[0], nPages, nEvery, strOutput);
+        }
+        else if (strCommand == "split" && nEvery == 0 && lstPositional.size() > 1)
+        {
+            vecJobs = planSplit(lstPositional[0], lstPositional.mid(1), strOutput);
+        }
+        else
+        {
+            return false;
+        }
+        return true;
+    }
+
+    int runCommand(const QStringList& lstArgs)
+    {
+        QVector<PageAssemblyJob> vecJobs;
+        int nMaxWorkers = 0;
+        if (!planJobs(lstArgs, vecJobs, nMaxWorkers))
+        {
+            return usage();
+        }
+
+        PageAssemblyRunner runner;
+        if (nMaxWorkers > 0)
+        {
+            runner.setMaxWorkers(nMaxWorkers);
+        }
+        QObject::connect(&runner, &PageAssemblyRunner::jobFinished, [](const PageAssemblyResult& result)
+            {
+                if (result.bSucceeded)
+                {
+                    std::cout << result.strOutput.toLocal8Bit().constData() << ": " << result.nPages << " pages\n";
+                }
+                else
+                {
+                    std::cerr << result.strError.toLocal8Bit().constData() << '\n';
+                }
+            });
+        int nResult = 0;
+        QObject::connect(&runner, &PageAssemblyRunner::finished, [&nResult](const PageAssemblyReport& report)
+            {
+                std::cout << report.nFiles << " files, " << report.nPages << " pages in "
+                          << report.nMilliseconds / 1000.0 << " s (" << report.pagesPerSecond() << " pages/s)";
+                if (report.nFailed > 0)
+                {
+                    std::cout << ", " << report.nFailed << " failed";
+                }
+                std::cout << '\n';
+                nResult = report.nFailed > 0 ? 1 : 0;
+                QCoreApplication::exit(nResult);
+            });
+
+        runner.start(vecJobs);
+        return runner.isRunning() ? QCoreApplication::exec() : nResult;
+    }
+}
+
+bool isPageAssemblyCommand(const int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        return false;
+    }
+    const char* const pCommand = argv[1];
+    return std::strcmp(pCommand, kWorkerFlag) == 0 || std::strcmp(pCommand, "merge") == 0
+        || std::strcmp(pCommand, "split") == 0 || std::strcmp(pCommand, "extract") == 0
+        || std::strcmp(pCommand, "nup") == 0 || std::strcmp(pCommand, "tile") == 0;
+}
+
+int runPageAssemblyCommand(int argc, char* argv[])
+{
+    attachConsole();
+    int nResult = 0;
+    {
+        QCoreApplication app(argc, argv);
+        const QStringList lstArgs = QCoreApplication::arguments().mid(1);
+        nResult = lstArgs[0] == kWorkerFlag ? runWorker() : runCommand(lstArgs);
+    }
+
+    PdfiumRuntime::instance().shutdown();
+    PdfiumExecutor::instance().shutdown();
+    return nResult;
+}
@@ -0,0 +1,27 @@
+﻿/*!
+ * @brief 页面装配的命令行入口。
+ *
+ * 用法：
+ *     KnowingPDF merge [--jobs N] -o 输出.pdf 输入.pdf...
+ *     KnowingPDF split [--jobs N] 输入.pdf -o 输出.pdf (--every 页数 | 页码范围...)
+ *     KnowingPDF extract 输入.pdf 页码范围 -o 输出.pdf
+ *     KnowingPDF nup [--per-sheet 2|4|8...] [--sheet 纸张] -o 输出.pdf 输入.pdf...
+ *     KnowingPDF tile --sheet 纸张 -o 输出.pdf 输入.pdf...
+ *
+ * 纸张为 a0-a4、letter、tabloid 或 "宽x高"（点）。
+ * 页码从 1 开始，范围写法与 FPDF_ImportPages 相同，如 "1,3,5-7"。拆分的输出文件为输出文件名加序号。
+ * 结束时输出每个文件的页数以及总吞吐量（页/秒）。以 `--assemble-worker` 开头时作为
+ * `PageAssemblyRunner` 的工作进程，从标准输入读取一个任务并执行。命令行模式不创建窗口。
+ *
+ * @author LiuYe
+ * @date 2026-10-19
+ * @copyright (c) 2013-2026 Honghu Yuntu Corporation
+ */
+
+#pragma once
+
+// 第一个参数是否为页面装配命令或工作进程标志
+bool isPageAssemblyCommand(int argc, char* argv[]);
+
+// 执行页面装配命令，返回进程退出码
+int runPageAssemblyCommand(int argc, char* argv[]);
@@ -0,0 +1,135 @@
+﻿/*!
+ * @brief 内存映射的 PDF 文档句柄的实现。
+ *
+ * @author LiuYe
+ * @date 2026-10-19
+ * @copyright (c) 2013-2026 Honghu Yuntu Corporation
+ */
+
+#include "pdf_document.h"
+
+#include "pdf_form.h"
+#include "pdfium_executor.h"
+
+#include <atomic>
+
+namespace
+{
+    QString pdfiumErrorString(const unsigned long nError)
+    {
+        switch (nError)
+        {
+        case FPDF_ERR_FILE:
+            return QStringLiteral("File not found or could not be opened");
+        case FPDF_ERR_FORMAT:
+            return QStringLiteral("File is not a PDF or is damaged");
+        case FPDF_ERR_PASSWORD:
+            return QStringLiteral("Password required or incorrect");
+        case FPDF_ERR_SECURITY:
+            return QStringLiteral("Unsupported security scheme");
+        default:
+            return QStringLiteral("Unknown error");
+        }
+    }
+
+    // 最后一个引用可能在任意线程释放，关闭文档统一投递到执行线程
+    void destroyOnExecutor(PdfDocument* pDocument)
+    {
+        PdfiumExecutor& executor = PdfiumExecutor::instance();
+        if (executor.isExecutorThread())
+        {
+            delete pDocument;
+            return;
+        }
+        executor.post([pDocument]() { delete pDocument; });
+    }
+}
+
+PdfDocument::PdfDocument()
+    : m_nId(0), m_pData(nullptr), m_nFileSize(0), m_pDocument(nullptr), m_bFormsChecked(false),
+    m_pAnnotationEditor(nullptr)
+{
+    static std::atomic<quint64> s_nNextId(1);
+    m_nId = s_nNextId++;
+}
+
+PdfDocument::~PdfDocument()
+{
+    m_pForms.reset();
+    if (m_pDocument)
+    {
+        FPDF_CloseDocument(m_pDocument);
+    }
+    if (m_pData)
+    {
+        m_oFile.unmap(m_pData);
+    }
+}
+
+PdfDocumentPtr PdfDocument::create()
+{
+    return PdfDocumentPtr(new PdfDocument, destroyOnExecutor);
+}
+
+bool PdfDocument::map(const QString& strPath, QString& strError)
+{
+    m_strFilePath = strPath;
+    m_oFile.setFileName(strPath);
+    if (!m_oFile.open(QIODevice::ReadOnly))
+    {
+        strError = m_oFile.errorString();
+        return false;
+    }
+
+    m_nFileSize = m_oFile.size();
+    m_pData = m_nFileSize > 0 ? m_oFile.map(0, m_nFileSize) : nullptr;
+    if (!m_pData)
+    {
+        strError = m_nFileSize > 0 ? m_oFile.errorString() : pdfiumErrorString(FPDF_ERR_FORMAT);
+        return false;
+    }
+    return true;
+}
+
+bool PdfDocument::load(const QByteArray& password, QString& strError)
+{
+    m_pDocument = FPDF_LoadMemDocument64(m_pData, static_cast<size_t>(m_nFileSize),
+        password.isEmpty() ? nullptr : password.constData());
+    if (!m_pDocument)
+    {
+        strError = pdfiumErrorString(FPDF_GetLastError());
+        return false;
+    }
+    return true;
+}
+
+PdfFormEnvironment* PdfDocument::forms()
+{
+    if (!m_bFormsChecked && m_pDocument)
+    {
+        m_bFormsChecked = true;
+        if (FPDF_GetFormType(m_pDocument) != FORMTYPE_NONE)
+        {
+            m_pForms.reset(new PdfFormEnvironment(m_pDocument));
+        }
+    }
+    return m_pForms.get();
+}
+
+bool PdfDocument::claimAnnotationEditor(const void* pEditor)
+{
+    if (m_pAnnotationEditor && m_pAnnotationEditor != pEditor)
+    {
+        return false;
+    }
+    m_pAnnotationEditor = pEditor;
+    return true;
+}
+
+void PdfDocument::releaseAnnotationEditor(const void* pEditor)
+{
+    if (m_pAnnotationEditor == pEditor)
+    {
+        m_pAnnotationEditor = nullptr;
+    }
+}
@@ -0,0 +1,98 @@
+﻿/*!
+ * @brief 内存映射的 PDF 文档句柄。
+ *
+ * `PdfDocument` 持有文件的只读内存映射以及在该映射上打开的 FPDF_DOCUMENT。PDFium 直接从映射
+ * 读取文件内容，不再自行读取文件，映射在文档关闭后才解除。文档必须在 PDFium 执行线程上打开和
+ * 关闭，因此只通过 `PdfDocumentPtr` 共享，最后一个引用释放时关闭操作被投递到执行线程。
+ *
+ * @author LiuYe
+ * @date 2026-10-19
+ * @copyright (c) 2013-2026 Honghu Yuntu Corporation
+ */
+
+#pragma once
+
+#include <QFile>
+#include <QMetaType>
+#include <QString>
+
+#include <memory>
+
+#include "fpdfview.h"
+#include "pdfium_runtime.h"
+
+class PdfDocument;
+class PdfFormEnvironment;
+typedef std::shared_ptr<PdfDocument> PdfDocumentPtr;
+
+/*!
+ * @brief 一个已打开的 PDF 文档。
+ *
+ * 除访问器与注释编辑权外，全部函数只能在 PDFium 执行线程上调用。
+ *
+ * @date 2026.10.19
+ */
+class PdfDocument
+{
+public:
+    ~PdfDocument();
+
+    // 映射文件，失败时返回 false 并填写 strError
+    bool map(const QString& strPath, QString& strError);
+
+    // 在映射上解析交叉引用表并打开文档
+    bool load(const QByteArray& password, QString& strError);
+
+    FPDF_DOCUMENT handle() const
+    {
+        return m_pDocument;
+    }
+
+    const QString& filePath() const
+    {
+        return m_strFilePath;
+    }
+
+    // 映射时的文件大小，也是原位增量保存的追加起点
+    qint64 fileSize() const
+    {
+        return m_nFileSize;
+    }
+
+    // 进程内唯一的文档编号，不随地址复用而重复，用作渲染缓存的键
+    quint64 id() const
+    {
+        return m_nId;
+    }
+
+    // 表单填写环境，首次调用时创建；文档不含表单时返回 nullptr
+    PdfFormEnvironment* forms();
+
+    // 注释编辑权，只在 GUI 线程调用。同一文件的多个标签页共享文档，保存时的删除会改变 PDFium
+    // 注释下标，其他标签页缓存的下标随之失效，因此同一时刻只允许一个编辑者持有未保存的注释编辑。
+    // 已由其他编辑者持有时 claim 返回 false；release 只释放自己持有的编辑权
+    bool claimAnnotationEditor(const void* pEditor);
+    void releaseAnnotationEditor(const void* pEditor);
+
+    // 创建空文档对象，释放时在执行线程上关闭
+    static PdfDocumentPtr create();
+
+    PdfDocument(const PdfDocument&) = delete;
+    PdfDocument& operator=(const PdfDocument&) = delete;
+
+private:
+    PdfDocument();
+
+    PdfiumRuntimeRef m_oRuntime;      // 文档存活期间库保持初始化
+    quint64 m_nId;
+    QString m_strFilePath;
+    QFile m_oFile;
+    uchar* m_pData;                   // 文件映射，文档关闭前一直有效
+    qint64 m_nFileSize;
+    FPDF_DOCUMENT m_pDocument;
+    std::unique_ptr<PdfFormEnvironment> m_pForms; // 须先于文档关闭
+    bool m_bFormsChecked;
+    const void* m_pAnnotationEditor;  // 持有注释编辑权的查看器，仅在 GUI 线程访问
+};
+
+Q_DECLARE_METATYPE(PdfDocumentPtr)
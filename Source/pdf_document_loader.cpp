@@ -0,0 +1,176 @@
+﻿/*!
+ * @brief 异步打开 PDF 文档的实现。
+ *
+ * @author LiuYe
+ * @date 2026-10-19
+ * @copyright (c) 2013-2026 Honghu Yuntu Corporation
+ */
+
+#include "pdf_document_loader.h"
+
+#include "pdf_document_registry.h"
+#include "pdf_document_saver.h"
+#include "pdf_form.h"
+#include "pdfium_executor.h"
+#include "pdfium_utils.h"
+#include "perf_counters.h"
+
+namespace
+{
+    void reportFailure(QFutureInterface<PdfLoadEvent>& future, const QString& strError)
+    {
+        PdfLoadEvent event;
+        event.eStage = PdfLoadEvent::Failed;
+        event.strError = strError;
+        future.reportResult(event);
+    }
+
+    /*!
+     * @brief 在执行线程上依次完成各阶段，每个阶段结束后汇报一个事件。
+     *
+     * 取消后 reportResult 不再生效，因此只需在耗时步骤之前检查取消标志。
+     */
+    void loadDocument(QFutureInterface<PdfLoadEvent>& future, const QString& strPath, const int nFirstPage,
+        const ColorScheme eColorScheme, const bool bGrayscale)
+    {
+        // 同一文件已经打开时直接共享，映射和解析两个阶段立即完成
+        PdfDocumentRegistry& registry = PdfDocumentRegistry::instance();
+        PdfDocumentPtr pDocument = registry.find(strPath);
+        PdfLoadEvent event;
+        event.eStage = PdfLoadEvent::FileMapped;
+        if (pDocument)
+        {
+            event.nValue = pDocument->fileSize();
+            future.reportResult(event);
+        }
+        else
+        {
+            // 上次原位保存中断时遗留的日志先提交或丢弃，保证映射到的是完整文件
+            PdfDocumentSaver::recoverJournal(strPath);
+
+            QString strError;
+            pDocument = PdfDocument::create();
+            if (!pDocument->map(strPath, strError))
+            {
+                reportFailure(future, strError);
+                return;
+            }
+            event.nValue = pDocument->fileSize();
+            future.reportResult(event);
+            if (future.isCanceled())
+            {
+                return;
+            }
+
+            if (!pDocument->load(QByteArray(), strError))
+            {
+                reportFailure(future, strError);
+                return;
+            }
+            pDocument = registry.insert(pDocument);
+        }
+        if (future.isCanceled())
+        {
+            return;
+        }
+
+        event = PdfLoadEvent();
+        event.eStage = PdfLoadEvent::XrefParsed;
+        event.pDocument = pDocument;
+        future.reportResult(event);
+        if (future.isCanceled())
+        {
+            return;
+        }
+
+        event = PdfLoadEvent();
+        event.eStage = PdfLoadEvent::PageCountKnown;
+        event.nValue = FPDF_GetPageCount(pDocument->handle());
+        future.reportResult(event);
+        if (future.isCanceled() || nFirstPage >= event.nValue)
+        {
+            return;
+        }
+
+        const FPDF_PAGE page = FPDF_LoadPage(pDocument->handle(), nFirstPage);
+        if (!page)
+        {
+            reportFailure(future, QStringLiteral("Failed to load page %1").arg(nFirstPage + 1));
+            return;
+        }
+        PerfCounters::add(PerfOpenPages);
+        event = PdfLoadEvent();
+        event.eStage = PdfLoadEvent::FirstPageRendered;
+        const PdfFormEnvironment* pForms = pDocument->forms();
+        event.oImage = renderPdfPageToImage(page, 0, 1.0, pForms ? pForms->handle() : nullptr, eColorScheme,
+            bGrayscale);
+        event.oPageToDevice = pageToDeviceTransform(page, 0, 0, event.oImage.width(), event.oImage.height(), 0);
+        FPDF_ClosePage(page);
+        PerfCounters::add(PerfOpenPages, -1);
+        future.reportResult(event);
+    }
+}
+
+PdfLoadEvent::PdfLoadEvent()
+    : eStage(Failed), nValue(0)
+{
+}
+
+PdfDocumentLoader::PdfDocumentLoader(QObject* pParent)
+    : QObject(pParent)
+{
+    connect(&m_oWatcher, &QFutureWatcher<PdfLoadEvent>::resultReadyAt, this, &PdfDocumentLoader::onEventReady);
+}
+
+PdfDocumentLoader::~PdfDocumentLoader()
+{
+    cancel();
+}
+
+void PdfDocumentLoader::open(const QString& strPath, const int nFirstPage, const ColorScheme eColorScheme,
+    const bool bGrayscale)
+{
+    cancel();
+    m_pDocument.reset();
+    m_oWatcher.setFuture(PdfiumExecutor::instance().runWithResults<PdfLoadEvent>(
+        [strPath, nFirstPage, eColorScheme, bGrayscale](QFutureInterface<PdfLoadEvent>& future)
+        {
+            loadDocument(future, strPath, nFirstPage, eColorScheme, bGrayscale);
+        }));
+}
+
+void PdfDocumentLoader::cancel()
+{
+    // 替换 future 后旧请求的结果不会再送达本对象
+    m_oWatcher.cancel();
+    m_oWatcher.setFuture(QFuture<PdfLoadEvent>());
+}
+
+bool PdfDocumentLoader::isLoading() const
+{
+    return m_oWatcher.isRunning();
+}
+
+void PdfDocumentLoader::onEventReady(const int nIndex)
+{
+    const PdfLoadEvent event = m_oWatcher.resultAt(nIndex);
+    switch (event.eStage)
+    {
+    case PdfLoadEvent::FileMapped:
+        emit fileMapped(event.nValue);
+        break;
+    case PdfLoadEvent::XrefParsed:
+        m_pDocument = event.pDocument;
+        emit xrefParsed();
+        break;
+    case PdfLoadEvent::PageCountKnown:
+        emit pageCountKnown(static_cast<int>(event.nValue));
+        break;
+    case PdfLoadEvent::FirstPageRendered:
+        emit firstPageRendered(event.oImage, event.oPageToDevice);
+        break;
+    case PdfLoadEvent::Failed:
+        emit failed(event.strError);
+        break;
+    }
+}
@@ -0,0 +1,86 @@
+﻿/*!
+ * @brief 异步打开 PDF 文档。
+ *
+ * `PdfDocumentLoader` 把打开文档拆成映射文件、解析交叉引用表、统计页数、渲染首页四个阶段，
+ * 全部在 PDFium 执行线程上完成，每完成一个阶段就通过信号通知 GUI 线程。打开新文件或调用
+ * `cancel()` 会取消进行中的请求：执行线程在阶段之间检查取消标志，已取消请求的后续通知不再送达，
+ * 已打开的文档随最后一个引用释放而关闭。
+ *
+ * @author LiuYe
+ * @date 2026-10-19
+ * @copyright (c) 2013-2026 Honghu Yuntu Corporation
+ */
+
+#pragma once
+
+#include <QFutureWatcher>
+#include <QImage>
+#include <QObject>
+#include <QTransform>
+
+#include "color_scheme.h"
+#include "pdf_document.h"
+
+/*!
+ * @brief 打开过程中的一个阶段事件。
+ */
+struct PdfLoadEvent
+{
+    enum Stage
+    {
+        FileMapped,                   // nValue 为文件大小
+        XrefParsed,                   // pDocument 可用
+        PageCountKnown,               // nValue 为页数
+        FirstPageRendered,            // oImage、oPageToDevice 可用
+        Failed                        // strError 为原因
+    };
+
+    Stage eStage;
+    qint64 nValue;
+    PdfDocumentPtr pDocument;
+    QImage oImage;
+    QTransform oPageToDevice;         // 首页页面坐标到 oImage 像素坐标的变换
+    QString strError;
+
+    PdfLoadEvent();
+};
+
+/*!
+ * @brief 分阶段异步打开文档，同一时刻只处理一个请求。
+ *
+ * @date 2026.10.19
+ */
+class PdfDocumentLoader : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PdfDocumentLoader(QObject* pParent = nullptr);
+    ~PdfDocumentLoader() override;
+
+    // 打开文档，进行中的请求被取消；首页以 eColorScheme 渲染，bGrayscale 为真时渲染为 8 位灰度
+    void open(const QString& strPath, int nFirstPage = 0, ColorScheme eColorScheme = ColorSchemeNormal,
+        bool bGrayscale = false);
+    void cancel();
+    bool isLoading() const;
+
+    // 最近一次请求打开的文档，交叉引用表解析完成前为空
+    PdfDocumentPtr document() const
+    {
+        return m_pDocument;
+    }
+
+signals:
+    void fileMapped(qint64 fileSize);
+    void xrefParsed();
+    void pageCountKnown(int pageCount);
+    void firstPageRendered(const QImage& image, const QTransform& pageToDevice);
+    void failed(const QString& error);
+
+private slots:
+    void onEventReady(int nIndex);
+
+private:
+    QFutureWatcher<PdfLoadEvent> m_oWatcher;
+    PdfDocumentPtr m_pDocument;
+};
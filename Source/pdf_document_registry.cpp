@@ -0,0 +1,93 @@
+﻿/*!
+ * @brief 已打开文档登记表的实现。
+ *
+ * @author LiuYe
+ * @date 2026-10-19
+ * @copyright (c) 2013-2026 Honghu Yuntu Corporation
+ */
+
+#include "pdf_document_registry.h"
+
+#include <QFileInfo>
+
+PdfDocumentRegistry& PdfDocumentRegistry::instance()
+{
+    static PdfDocumentRegistry registry;
+    return registry;
+}
+
+PdfDocumentRegistry::PdfDocumentRegistry()
+{
+}
+
+/*!
+ * @brief 规范化路径：解析符号链接和相对路径，Windows 上忽略大小写。
+ *
+ * 文件不存在时 canonicalFilePath 为空，退回绝对路径。
+ */
+QString PdfDocumentRegistry::canonicalPath(const QString& strPath)
+{
+    const QFileInfo info(strPath);
+    QString strCanonical = info.canonicalFilePath();
+    if (strCanonical.isEmpty())
+    {
+        strCanonical = info.absoluteFilePath();
+    }
+#ifdef Q_OS_WIN
+    strCanonical = strCanonical.toLower();
+#endif
+    return strCanonical;
+}
+
+PdfDocumentPtr PdfDocumentRegistry::find(const QString& strPath)
+{
+    const QHash<QString, std::weak_ptr<PdfDocument>>::iterator it = m_hashDocuments.find(canonicalPath(strPath));
+    if (it == m_hashDocuments.end())
+    {
+        return PdfDocumentPtr();
+    }
+
+    const PdfDocumentPtr pDocument = it->lock();
+    if (!pDocument)
+    {
+        m_hashDocuments.erase(it);
+    }
+    return pDocument;
+}
+
+PdfDocumentPtr PdfDocumentRegistry::insert(const PdfDocumentPtr& pDocument)
+{
+    const QString strKey = canonicalPath(pDocument->filePath());
+    const PdfDocumentPtr pExisting = m_hashDocuments.value(strKey).lock();
+    if (pExisting)
+    {
+        return pExisting;
+    }
+
+    purge();
+    m_hashDocuments.insert(strKey, pDocument);
+    return pDocument;
+}
+
+int PdfDocumentRegistry::openCount()
+{
+    purge();
+    return m_hashDocuments.size();
+}
+
+// 清除已关闭文档的条目
+void PdfDocumentRegistry::purge()
+{
+    QHash<QString, std::weak_ptr<PdfDocument>>::iterator it = m_hashDocuments.begin();
+    while (it != m_hashDocuments.end())
+    {
+        if (it->expired())
+        {
+            it = m_hashDocuments.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
@@ -0,0 +1,50 @@
+﻿/*!
+ * @brief 已打开文档的登记表。
+ *
+ * 同一文件被多次打开时共享同一个 `PdfDocument`（同一份文件映射和 FPDF_DOCUMENT），以规范化路径
+ * 为键。登记表只保存弱引用，最后一个使用者释放后文档照常关闭，下一次打开重新加载。
+ *
+ * @author LiuYe
+ * @date 2026-10-19
+ * @copyright (c) 2013-2026 Honghu Yuntu Corporation
+ */
+
+#pragma once
+
+#include <QHash>
+#include <QString>
+
+#include <memory>
+
+#include "pdf_document.h"
+
+/*!
+ * @brief 规范化路径到共享文档的登记表。
+ *
+ * 只能在 PDFium 执行线程上使用，因此不需要加锁。
+ *
+ * @date 2026.10.19
+ */
+class PdfDocumentRegistry
+{
+public:
+    static PdfDocumentRegistry& instance();
+
+    // 返回已打开的同一文件的文档，没有则返回空
+    PdfDocumentPtr find(const QString& strPath);
+
+    // 登记新打开的文档；同一文件已有存活的文档时返回已有文档
+    PdfDocumentPtr insert(const PdfDocumentPtr& pDocument);
+
+    // 当前存活的文档数
+    int openCount();
+
+    static QString canonicalPath(const QString& strPath);
+
+private:
+    PdfDocumentRegistry();
+
+    void purge();
+
+    QHash<QString, std::weak_ptr<PdfDocument>> m_hashDocuments;
+};
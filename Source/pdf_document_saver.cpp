@@ -0,0 +1,491 @@
+﻿/*!
+ * @brief 注释编辑增量保存的实现。
+ *
+ * 被移动或改色的注释会清除其外观流（AP），由阅读器按 /Rect、/C、/QuadPoints、/InkList
+ * 重新生成；PDFium 只能为部分注释类型生成外观，其余类型若已带外观流则跳过该编辑。
+ * 直线、折线、多边形的顶点没有公开的写接口，移动它们同样被跳过。
+ *
+ * @author LiuYe
+ * @date 2026-10-19
+ * @copyright (c) 2013-2026 Honghu Yuntu Corporation
+ */
+
+#include "pdf_document_saver.h"
+
+#include "fpdf_annot.h"
+#include "fpdf_save.h"
+
+#include <QDataStream>
+#include <QFile>
+#include <QSaveFile>
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    // 日志文件头：魔数、原文件加载时大小、增量长度（写完前为 -1）
+    const quint32 kJournalMagic = 0x4B504A31;
+    const qint64 kJournalHeaderSize = 4 + 8 + 8;
+    const qint64 kCopyChunkSize = 64 * 1024;
+
+    /*!
+     * @brief FPDF_SaveAsCopy 的输出端。
+     *
+     * 输出的前 nPrefixSize 字节只与 pPrefix 比对、不写入设备；pPrefix 为空时全部写入设备。
+     * 回调返回 0 会使 PDFium 中止保存，用于响应取消、写入失败和前缀不一致。
+     */
+    struct StreamWriter : public FPDF_FILEWRITE
+    {
+        QIODevice* pDevice;
+        const uchar* pPrefix;
+        qint64 nPrefixSize;
+        qint64 nOffset;               // PDFium 已输出的总字节数
+        qint64 nWritten;              // 写入设备的字节数
+        bool bPrefixMismatch;
+        bool bWriteFailed;
+        const QFutureInterfaceBase* pFuture;
+    };
+
+    int writeBlock(FPDF_FILEWRITE* pThis, const void* pData, unsigned long nSize)
+    {
+        StreamWriter* pWriter = static_cast<StreamWriter*>(pThis);
+        if (pWriter->pFuture->isCanceled())
+        {
+            return 0;
+        }
+
+        const char* pBytes = static_cast<const char*>(pData);
+        qint64 nRemaining = static_cast<qint64>(nSize);
+        if (pWriter->nOffset < pWriter->nPrefixSize)
+        {
+            const qint64 nCompare = std::min(nRemaining, pWriter->nPrefixSize - pWriter->nOffset);
+            if (std::memcmp(pWriter->pPrefix + pWriter->nOffset, pBytes, static_cast<size_t>(nCompare)) != 0)
+            {
+                pWriter->bPrefixMismatch = true;
+                return 0;
+            }
+            pWriter->nOffset += nCompare;
+            pBytes += nCompare;
+            nRemaining -= nCompare;
+        }
+
+        if (nRemaining > 0)
+        {
+            if (pWriter->pDevice->write(pBytes, nRemaining) != nRemaining)
+            {
+                pWriter->bWriteFailed = true;
+                return 0;
+            }
+            pWriter->nOffset += nRemaining;
+            pWriter->nWritten += nRemaining;
+        }
+        return 1;
+    }
+
+    StreamWriter makeWriter(QIODevice* pDevice, const uchar* pPrefix, const qint64 nPrefixSize,
+        const QFutureInterfaceBase& future)
+    {
+        StreamWriter writer;
+        writer.version = 1;
+        writer.WriteBlock = writeBlock;
+        writer.pDevice = pDevice;
+        writer.pPrefix = pPrefix;
+        writer.nPrefixSize = pPrefix ? nPrefixSize : 0;
+        writer.nOffset = 0;
+        writer.nWritten = 0;
+        writer.bPrefixMismatch = false;
+        writer.bWriteFailed = false;
+        writer.pFuture = &future;
+        return writer;
+    }
+
+    // PDFium 能够按注释字典重新生成外观流的类型
+    bool canRegenerateAppearance(const int nSubtype)
+    {
+        switch (nSubtype)
+        {
+        case FPDF_ANNOT_TEXT:
+        case FPDF_ANNOT_SQUARE:
+        case FPDF_ANNOT_CIRCLE:
+        case FPDF_ANNOT_HIGHLIGHT:
+        case FPDF_ANNOT_UNDERLINE:
+        case FPDF_ANNOT_SQUIGGLY:
+        case FPDF_ANNOT_STRIKEOUT:
+        case FPDF_ANNOT_INK:
+        case FPDF_ANNOT_POPUP:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    // 清除正常外观流，使新的矩形和颜色生效；无法重新生成外观的类型返回 false
+    bool dropAppearance(FPDF_ANNOTATION annot, const int nSubtype)
+    {
+        // 空外观返回 2 字节（UTF-16 结束符）
+        if (FPDFAnnot_GetAP(annot, FPDF_ANNOT_APPEARANCEMODE_NORMAL, nullptr, 0) <= 2)
+        {
+            return true;
+        }
+        return canRegenerateAppearance(nSubtype)
+            && FPDFAnnot_SetAP(annot, FPDF_ANNOT_APPEARANCEMODE_NORMAL, nullptr);
+    }
+
+    FS_QUADPOINTSF toQuad(const AnnotationPath& path)
+    {
+        // 四边形顶点按 1-2-4-3 存放
+        FS_QUADPOINTSF quad;
+        quad.x1 = static_cast<float>(path[0].x());
+        quad.y1 = static_cast<float>(path[0].y());
+        quad.x2 = static_cast<float>(path[1].x());
+        quad.y2 = static_cast<float>(path[1].y());
+        quad.x4 = static_cast<float>(path[2].x());
+        quad.y4 = static_cast<float>(path[2].y());
+        quad.x3 = static_cast<float>(path[3].x());
+        quad.y3 = static_cast<float>(path[3].y());
+        return quad;
+    }
+
+    /*!
+     * @brief 写入注释矩形和顶点。
+     *
+     * @param bCreated 注释是否刚创建，刚创建的注释追加顶点，已有注释替换顶点
+     * @return 几何是否完整写入
+     */
+    bool writeGeometry(FPDF_ANNOTATION annot, const AnnotationGeometry& geometry, const bool bCreated)
+    {
+        FS_RECTF rect;
+        rect.left = static_cast<float>(geometry.oBounds.left());
+        rect.top = static_cast<float>(geometry.oBounds.bottom());
+        rect.right = static_cast<float>(geometry.oBounds.right());
+        rect.bottom = static_cast<float>(geometry.oBounds.top());
+        if (!FPDFAnnot_SetRect(annot, &rect))
+        {
+            return false;
+        }
+
+        switch (geometry.nSubtype)
+        {
+        case FPDF_ANNOT_LINE:
+        case FPDF_ANNOT_POLYLINE:
+        case FPDF_ANNOT_POLYGON:
+            return geometry.vecPaths.empty();
+        case FPDF_ANNOT_INK:
+            if (!bCreated)
+            {
+                FPDFAnnot_RemoveInkList(annot);
+            }
+            for (size_t i = 0; i < geometry.vecPaths.size(); ++i)
+            {
+                std::vector<FS_POINTF> vecPoints(geometry.vecPaths[i].size());
+                for (size_t j = 0; j < vecPoints.size(); ++j)
+                {
+                    vecPoints[j].x = static_cast<float>(geometry.vecPaths[i][j].x());
+                    vecPoints[j].y = static_cast<float>(geometry.vecPaths[i][j].y());
+                }
+                if (FPDFAnnot_AddInkStroke(annot, vecPoints.data(), vecPoints.size()) < 0)
+                {
+                    return false;
+                }
+            }
+            return true;
+        default:
+            for (size_t i = 0; i < geometry.vecPaths.size(); ++i)
+            {
+                if (geometry.vecPaths[i].size() != 4)
+                {
+                    continue;
+                }
+                const FS_QUADPOINTSF quad = toQuad(geometry.vecPaths[i]);
+                const FPDF_BOOL bWritten = bCreated ? FPDFAnnot_AppendAttachmentPoints(annot, &quad)
+                    : FPDFAnnot_SetAttachmentPoints(annot, i, &quad);
+                if (!bWritten)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+    }
+
+    bool writeColor(FPDF_ANNOTATION annot, const FPDFANNOT_COLORTYPE type, const QColor& color)
+    {
+        return FPDFAnnot_SetColor(annot, type, color.red(), color.green(), color.blue(), color.alpha());
+    }
+
+    // 创建新注释并写入全部属性
+    bool createAnnotation(FPDF_PAGE page, const AnnotationGeometry& geometry)
+    {
+        FPDF_ANNOTATION annot = FPDFPage_CreateAnnot(page, geometry.nSubtype);
+        if (!annot)
+        {
+            return false;
+        }
+
+        bool bComplete = writeGeometry(annot, geometry, true);
+        bComplete = writeColor(annot, FPDFANNOT_COLORTYPE_Color, geometry.oColor) && bComplete;
+        if (geometry.oInteriorColor.isValid())
+        {
+            bComplete = writeColor(annot, FPDFANNOT_COLORTYPE_InteriorColor, geometry.oInteriorColor) && bComplete;
+        }
+        FPDFAnnot_SetBorder(annot, 0.0f, 0.0f, geometry.fBorderWidth);
+        FPDFAnnot_SetFlags(annot, FPDF_ANNOT_FLAG_PRINT | (geometry.bHidden ? FPDF_ANNOT_FLAG_HIDDEN : 0));
+        if (!geometry.strContents.isEmpty())
+        {
+            FPDFAnnot_SetStringValue(annot, "Contents", reinterpret_cast<FPDF_WIDESTRING>(geometry.strContents.utf16()));
+        }
+        FPDFPage_CloseAnnot(annot);
+        return bComplete;
+    }
+
+    struct JournalHeader
+    {
+        qint64 nBaseSize;
+        qint64 nDeltaSize;
+    };
+
+    // 读取并校验日志头，增量长度与文件大小不符视为不完整
+    bool readJournalHeader(QFile& journal, JournalHeader& header)
+    {
+        QDataStream stream(&journal);
+        quint32 nMagic = 0;
+        stream >> nMagic >> header.nBaseSize >> header.nDeltaSize;
+        return stream.status() == QDataStream::Ok && nMagic == kJournalMagic && header.nBaseSize > 0
+            && header.nDeltaSize >= 0 && journal.size() == kJournalHeaderSize + header.nDeltaSize;
+    }
+
+    /*!
+     * @brief 把完整的日志提交到原文件：从加载时大小处写入增量并截去多余的尾部，成功后删除日志。
+     *
+     * 增量是相对加载时文件的全部修改，因此重复保存时总是从加载时大小处覆盖上一次追加的内容。
+     * 先写后截断，截断位置不低于加载时大小，文档仍以内存映射打开时同样可以提交。
+     */
+    bool commitJournal(const QString& strPath, QString& strError)
+    {
+        QFile journal(PdfDocumentSaver::journalPath(strPath));
+        JournalHeader header;
+        if (!journal.open(QIODevice::ReadOnly) || !readJournalHeader(journal, header))
+        {
+            strError = QStringLiteral("Incomplete save journal");
+            return false;
+        }
+
+        QFile original(strPath);
+        if (!original.open(QIODevice::ReadWrite) || original.size() < header.nBaseSize
+            || !original.seek(header.nBaseSize))
+        {
+            strError = original.errorString();
+            return false;
+        }
+
+        QByteArray chunk;
+        qint64 nRemaining = header.nDeltaSize;
+        while (nRemaining > 0)
+        {
+            chunk = journal.read(std::min(nRemaining, kCopyChunkSize));
+            if (chunk.isEmpty() || original.write(chunk) != chunk.size())
+            {
+                strError = original.errorString();
+                return false;
+            }
+            nRemaining -= chunk.size();
+        }
+        if (!original.flush() || !original.resize(header.nBaseSize + header.nDeltaSize))
+        {
+            strError = original.errorString();
+            return false;
+        }
+        original.close();
+        journal.close();
+        journal.remove();
+        return true;
+    }
+}
+
+PdfSaveResult::PdfSaveResult()
+    : bSucceeded(false), bIncremental(false), nBytesWritten(0), nSkippedEdits(0)
+{
+}
+
+/*!
+ * @brief 把注释编辑写回 PDFium 页面。
+ *
+ * 先按发生顺序删除，再修改已有注释（此时 nAnnotIndex 与删除后的注释数组一致），
+ * 最后按绘制顺序追加新增注释。
+ *
+ * @return 未能写回的编辑数
+ */
+int PdfDocumentSaver::applyAnnotationEdits(FPDF_PAGE page, const AnnotationEdits& edits)
+{
+    int nSkipped = 0;
+    for (size_t i = 0; i < edits.vecRemovedIndices.size(); ++i)
+    {
+        if (!FPDFPage_RemoveAnnot(page, edits.vecRemovedIndices[i]))
+        {
+            ++nSkipped;
+        }
+    }
+
+    for (size_t i = 0; i < edits.vecModified.size(); ++i)
+    {
+        const AnnotationEdit& edit = edits.vecModified[i];
+        FPDF_ANNOTATION annot = FPDFPage_GetAnnot(page, edit.geometry.nAnnotIndex);
+        if (!annot)
+        {
+            ++nSkipped;
+            continue;
+        }
+
+        bool bWritten = dropAppearance(annot, edit.geometry.nSubtype);
+        if (bWritten && (edit.nFlags & AnnotationEdit::Moved) != 0)
+        {
+            bWritten = writeGeometry(annot, edit.geometry, false);
+        }
+        if (bWritten && (edit.nFlags & AnnotationEdit::Recolored) != 0)
+        {
+            bWritten = writeColor(annot, FPDFANNOT_COLORTYPE_Color, edit.geometry.oColor);
+        }
+        if (!bWritten)
+        {
+            ++nSkipped;
+        }
+        FPDFPage_CloseAnnot(annot);
+    }
+
+    for (size_t i = 0; i < edits.vecAdded.size(); ++i)
+    {
+        if (!createAnnotation(page, edits.vecAdded[i]))
+        {
+            ++nSkipped;
+        }
+    }
+    return nSkipped;
+}
+
+/*!
+ * @brief 原位增量保存。
+ *
+ * 增量输出的前 nBaseSize 字节与原文件逐字节比对（通过内存映射，不产生写入），之后的增量
+ * 写入日志，再由日志追加到原文件。前缀不一致（例如文件已被其他程序修改）时退回到完整另存。
+ */
+PdfSaveResult PdfDocumentSaver::saveInPlace(FPDF_DOCUMENT document, const QString& strPath, const qint64 nBaseSize,
+    QFutureInterface<PdfSaveResult>& future)
+{
+    QFile original(strPath);
+    uchar* pPrefix = nullptr;
+    if (nBaseSize > 0 && original.open(QIODevice::ReadOnly) && original.size() >= nBaseSize)
+    {
+        pPrefix = original.map(0, nBaseSize);
+    }
+    if (!pPrefix)
+    {
+        return saveAs(document, strPath, future);
+    }
+
+    PdfSaveResult result;
+    QFile journal(journalPath(strPath));
+    if (!journal.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        result.strError = journal.errorString();
+        return result;
+    }
+    QDataStream header(&journal);
+    header << kJournalMagic << nBaseSize << static_cast<qint64>(-1);
+
+    StreamWriter writer = makeWriter(&journal, pPrefix, nBaseSize, future);
+    const bool bSaved = FPDF_SaveAsCopy(document, &writer, FPDF_INCREMENTAL) && writer.nOffset >= nBaseSize;
+    original.unmap(pPrefix);
+    original.close();
+
+    if (!bSaved || writer.bPrefixMismatch || writer.bWriteFailed || future.isCanceled())
+    {
+        journal.close();
+        journal.remove();
+        if (writer.bPrefixMismatch)
+        {
+            return saveAs(document, strPath, future);
+        }
+        result.strError = future.isCanceled() ? QStringLiteral("Save canceled") : journal.errorString();
+        return result;
+    }
+
+    // 回填增量长度，日志至此完整
+    if (!journal.seek(4 + 8))
+    {
+        result.strError = journal.errorString();
+        return result;
+    }
+    header << writer.nWritten;
+    if (!journal.flush())
+    {
+        result.strError = journal.errorString();
+        return result;
+    }
+    journal.close();
+
+    // 提交失败时保留日志，下次打开文件前由 recoverJournal 重放
+    if (!commitJournal(strPath, result.strError))
+    {
+        return result;
+    }
+    result.bSucceeded = true;
+    result.bIncremental = true;
+    result.nBytesWritten = writer.nWritten;
+    return result;
+}
+
+PdfSaveResult PdfDocumentSaver::saveAs(FPDF_DOCUMENT document, const QString& strPath,
+    QFutureInterface<PdfSaveResult>& future)
+{
+    PdfSaveResult result;
+    QSaveFile file(strPath);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        result.strError = file.errorString();
+        return result;
+    }
+
+    StreamWriter writer = makeWriter(&file, nullptr, 0, future);
+    if (!FPDF_SaveAsCopy(document, &writer, FPDF_INCREMENTAL) || writer.bWriteFailed || future.isCanceled())
+    {
+        file.cancelWriting();
+        result.strError = future.isCanceled() ? QStringLiteral("Save canceled") : file.errorString();
+        return result;
+    }
+    if (!file.commit())
+    {
+        result.strError = file.errorString();
+        return result;
+    }
+    result.bSucceeded = true;
+    result.nBytesWritten = writer.nWritten;
+    return result;
+}
+
+QString PdfDocumentSaver::journalPath(const QString& strPath)
+{
+    return strPath + QStringLiteral(".kpdf-journal");
+}
+
+bool PdfDocumentSaver::recoverJournal(const QString& strPath)
+{
+    QFile journal(journalPath(strPath));
+    if (!journal.exists())
+    {
+        return false;
+    }
+
+    // 日志不完整说明崩溃发生在写日志期间，此时原文件尚未改动，直接丢弃
+    JournalHeader header;
+    const bool bComplete = journal.open(QIODevice::ReadOnly) && readJournalHeader(journal, header);
+    journal.close();
+    if (!bComplete)
+    {
+        journal.remove();
+        return false;
+    }
+
+    QString strError;
+    return commitJournal(strPath, strError);
+}
@@ -0,0 +1,65 @@
+﻿/*!
+ * @brief 注释编辑的增量保存。
+ *
+ * 保存分两步在 `PdfiumExecutor` 上完成：先把 `AnnotationEdits` 写回 PDFium 文档，再以
+ * FPDF_INCREMENTAL 方式流式输出。增量输出的前缀与原文件逐字节相同，因此原位保存只把前缀之后的
+ * 增量部分追加到原文件末尾，写入量与编辑规模成正比，而不是与文档大小成正比；另存为则写入
+ * 临时文件后原子替换目标文件。
+ *
+ * 原位追加先把增量写入 `<文件名>.kpdf-journal` 日志，再从原文件加载时的大小处写入增量，
+ * 中途崩溃时下次打开文件前由 `recoverJournal()` 重放或丢弃日志，原文件不会处于半写状态。
+ *
+ * @author LiuYe
+ * @date 2026-10-19
+ * @copyright (c) 2013-2026 Honghu Yuntu Corporation
+ */
+
+#pragma once
+
+#include <QFutureInterface>
+#include <QString>
+
+#include "fpdfview.h"
+#include "annotation_overlay.h"
+
+/*!
+ * @brief 一次保存的结果。
+ */
+struct PdfSaveResult
+{
+    bool bSucceeded;                  // 是否成功
+    bool bIncremental;                // 是否以追加方式写入原文件
+    qint64 nBytesWritten;             // 实际写入磁盘的字节数
+    int nSkippedEdits;                // 无法写回 PDFium 而未保存的编辑数
+    QString strError;                 // 失败原因
+
+    PdfSaveResult();
+};
+
+/*!
+ * @brief 注释编辑的写回与文档保存。
+ *
+ * 除 `journalPath()` 与 `recoverJournal()` 外，全部函数只能在 PDFium 执行线程上调用。
+ *
+ * @date 2026.10.19
+ */
+class PdfDocumentSaver
+{
+public:
+    // 把编辑写回页面，返回未能写回的编辑数
+    static int applyAnnotationEdits(FPDF_PAGE page, const AnnotationEdits& edits);
+
+    // 原位保存：nBaseSize 为 PDFium 加载文档时的文件大小
+    static PdfSaveResult saveInPlace(FPDF_DOCUMENT document, const QString& strPath, qint64 nBaseSize,
+        QFutureInterface<PdfSaveResult>& future);
+
+    // 另存为：完整写出到临时文件后原子替换目标文件
+    static PdfSaveResult saveAs(FPDF_DOCUMENT document, const QString& strPath,
+        QFutureInterface<PdfSaveResult>& future);
+
+    // 原位保存使用的日志文件路径
+    static QString journalPath(const QString& strPath);
+
+    // 处理上次原位保存遗留的日志：完整的日志被重放，不完整的日志被丢弃。返回是否重放了日志
+    static bool recoverJournal(const QString& strPath);
+};
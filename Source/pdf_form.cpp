@@ -0,0 +1,260 @@
+﻿/*!
+ * @brief 交互式表单填写的实现。
+ *
+ * @author LiuYe
+ * @date 2026-10-19
+ * @copyright (c) 2013-2026 Honghu Yuntu Corporation
+ */
+
+#include "pdf_form.h"
+
+#include "fpdf_annot.h"
+#include "pdfium_utils.h"
+#include "perf_counters.h"
+
+namespace
+{
+    // 表单域高亮颜色（0xRRGGBB）与透明度，与常见阅读器一致
+    const unsigned long kFieldHighlightColor = 0xE4DDFF;
+    const unsigned char kFieldHighlightAlpha = 100;
+
+    // 脏区域外扩的像素，覆盖抗锯齿边缘与光标
+    const int kPatchMargin = 2;
+
+    /*!
+     * @brief 合并相交的矩形，减少小块渲染的次数。
+     */
+    QVector<QRect> mergeRects(QVector<QRect> vecRects)
+    {
+        bool bMerged = true;
+        while (bMerged)
+        {
+            bMerged = false;
+            for (int i = 0; i < vecRects.size() && !bMerged; ++i)
+            {
+                for (int j = i + 1; j < vecRects.size(); ++j)
+                {
+                    if (vecRects[i].intersects(vecRects[j]))
+                    {
+                        vecRects[i] = vecRects[i].united(vecRects[j]);
+                        vecRects.remove(j);
+                        bMerged = true;
+                        break;
+                    }
+                }
+            }
+        }
+        return vecRects;
+    }
+}
+
+/*!
+ * @brief 交给 PDFium 的回调表，附带所属环境的指针。
+ */
+struct PdfFormEnvironment::FormFillInfo : public FPDF_FORMFILLINFO
+{
+    PdfFormEnvironment* pOwner;
+
+    FormFillInfo()
+        : FPDF_FORMFILLINFO(), pOwner(nullptr)
+    {
+    }
+};
+
+PdfFormEvent::PdfFormEvent()
+    : eType(MouseMove), nKey(0), nModifiers(0)
+{
+}
+
+PdfFormUpdate::PdfFormUpdate()
+    : nPage(-1), eColorScheme(ColorSchemeNormal), bGrayscale(false), bFocused(false)
+{
+}
+
+PdfFormEnvironment::PdfFormEnvironment(const FPDF_DOCUMENT pDocument)
+    : m_pDocument(pDocument), m_pForm(nullptr), m_pInfo(new FormFillInfo), m_pPage(nullptr), m_nPage(-1),
+    m_bModified(false)
+{
+    // 只实现稳定接口；未提供的回调 PDFium 不会调用
+    m_pInfo->version = 1;
+    m_pInfo->FFI_Invalidate = onInvalidate;
+    m_pInfo->FFI_OnChange = onChange;
+    m_pInfo->pOwner = this;
+
+    m_pForm = FPDFDOC_InitFormFillEnvironment(m_pDocument, m_pInfo);
+    if (m_pForm)
+    {
+        FPDF_SetFormFieldHighlightColor(m_pForm, FPDF_FORMFIELD_UNKNOWN, kFieldHighlightColor);
+        FPDF_SetFormFieldHighlightAlpha(m_pForm, kFieldHighlightAlpha);
+    }
+}
+
+PdfFormEnvironment::~PdfFormEnvironment()
+{
+    closePage();
+    if (m_pForm)
+    {
+        FPDFDOC_ExitFormFillEnvironment(m_pForm);
+    }
+    delete m_pInfo;
+}
+
+void PdfFormEnvironment::onInvalidate(FPDF_FORMFILLINFO* pThis, const FPDF_PAGE pPage, const double dLeft,
+    const double dTop, const double dRight, const double dBottom)
+{
+    PdfFormEnvironment* pOwner = static_cast<FormFillInfo*>(pThis)->pOwner;
+    if (pPage && pPage == pOwner->m_pPage)
+    {
+        pOwner->m_vecDirty.append(QRectF(QPointF(dLeft, dTop), QPointF(dRight, dBottom)).normalized());
+    }
+}
+
+void PdfFormEnvironment::onChange(FPDF_FORMFILLINFO* pThis)
+{
+    static_cast<FormFillInfo*>(pThis)->pOwner->m_bModified = true;
+}
+
+FPDF_PAGE PdfFormEnvironment::loadPage(const int nPage)
+{
+    if (m_pPage && m_nPage == nPage)
+    {
+        return m_pPage;
+    }
+
+    closePage();
+    m_pPage = FPDF_LoadPage(m_pDocument, nPage);
+    if (m_pPage)
+    {
+        PerfCounters::add(PerfOpenPages);
+        m_nPage = nPage;
+        FORM_OnAfterLoadPage(m_pPage, m_pForm);
+    }
+    return m_pPage;
+}
+
+void PdfFormEnvironment::closePage()
+{
+    if (!m_pPage)
+    {
+        return;
+    }
+    FORM_ForceToKillFocus(m_pForm);
+    FORM_OnBeforeClosePage(m_pPage, m_pForm);
+    FPDF_ClosePage(m_pPage);
+    PerfCounters::add(PerfOpenPages, -1);
+    m_pPage = nullptr;
+    m_nPage = -1;
+    m_vecDirty.clear();
+}
+
+/*!
+ * @brief 处理一批输入并渲染脏区域。
+ *
+ * 同一批事件产生的脏矩形先合并再渲染，连续输入时 GUI 线程积压的按键只触发一次小块渲染。
+ * 每块位图与整页位图使用相同的显示区域参数，只是把原点平移到小块左上角，PDFium 只光栅化
+ * 落在小块内的内容。
+ */
+PdfFormUpdate PdfFormEnvironment::handleEvents(const int nPage, const QVector<PdfFormEvent>& vecEvents,
+    const QTransform& oPageToDevice, const QSize& oImageSize, const ColorScheme eColorScheme, const bool bGrayscale)
+{
+    PdfFormUpdate update;
+    update.nPage = nPage;
+    update.eColorScheme = eColorScheme;
+    update.bGrayscale = bGrayscale;
+    const FPDF_PAGE page = m_pForm ? loadPage(nPage) : nullptr;
+    if (!page)
+    {
+        return update;
+    }
+
+    for (int i = 0; i < vecEvents.size(); ++i)
+    {
+        const PdfFormEvent& event = vecEvents[i];
+        const double dX = event.oPagePoint.x();
+        const double dY = event.oPagePoint.y();
+        switch (event.eType)
+        {
+        case PdfFormEvent::MouseDown:
+            FORM_OnLButtonDown(m_pForm, page, event.nModifiers, dX, dY);
+            break;
+        case PdfFormEvent::MouseUp:
+            FORM_OnLButtonUp(m_pForm, page, event.nModifiers, dX, dY);
+            break;
+        case PdfFormEvent::MouseMove:
+            FORM_OnMouseMove(m_pForm, page, event.nModifiers, dX, dY);
+            break;
+        case PdfFormEvent::KeyDown:
+            FORM_OnKeyDown(m_pForm, page, event.nKey, event.nModifiers);
+            break;
+        case PdfFormEvent::Char:
+            FORM_OnChar(m_pForm, page, event.nKey, event.nModifiers);
+            break;
+        case PdfFormEvent::KillFocus:
+            FORM_ForceToKillFocus(m_pForm);
+            break;
+        }
+    }
+
+    int nFocusedPage = -1;
+    FPDF_ANNOTATION focused = nullptr;
+    if (FORM_GetFocusedAnnot(m_pForm, &nFocusedPage, &focused) && focused)
+    {
+        update.bFocused = true;
+        FPDFPage_CloseAnnot(focused);
+    }
+
+    const QRect imageRect(QPoint(0, 0), oImageSize);
+    QVector<QRect> vecDeviceRects;
+    for (int i = 0; i < m_vecDirty.size(); ++i)
+    {
+        const QRect rect = oPageToDevice.mapRect(m_vecDirty[i]).toAlignedRect()
+            .adjusted(-kPatchMargin, -kPatchMargin, kPatchMargin, kPatchMargin) & imageRect;
+        if (!rect.isEmpty())
+        {
+            vecDeviceRects.append(rect);
+        }
+    }
+    m_vecDirty.clear();
+
+    vecDeviceRects = mergeRects(vecDeviceRects);
+    for (int i = 0; i < vecDeviceRects.size(); ++i)
+    {
+        const QRect& rect = vecDeviceRects[i];
+        const FPDF_BITMAP bitmap = createPdfiumBitmap(rect.width(), rect.height(), bGrayscale);
+        if (!bitmap)
+        {
+            continue;
+        }
+        renderPdfPageToBitmap(bitmap, page, -rect.x(), -rect.y(), oImageSize.width(), oImageSize.height(), 0,
+            eColorScheme);
+        FPDF_FFLDraw(m_pForm, bitmap, page, -rect.x(), -rect.y(), oImageSize.width(), oImageSize.height(), 0,
+            bGrayscale ? FPDF_GRAYSCALE : 0);
+
+        PdfFormPatch patch;
+        patch.oDeviceRect = rect;
+        patch.oImage = pdfiumBitmapToQImage(bitmap);
+        FPDFBitmap_Destroy(bitmap);
+        update.vecPatches.append(patch);
+    }
+    return update;
+}
+
+void PdfFormEnvironment::drawFields(const FPDF_BITMAP pBitmap, const FPDF_PAGE pPage, const int nPage,
+    const int nStartX, const int nStartY, const int nSizeX, const int nSizeY, const int nFlags)
+{
+    if (!m_pForm)
+    {
+        return;
+    }
+    // 交互页上正在编辑的表单域只有通过交互页的句柄才能画出未提交的内容
+    const FPDF_PAGE page = m_pPage && m_nPage == nPage ? m_pPage : pPage;
+    FPDF_FFLDraw(m_pForm, pBitmap, page, nStartX, nStartY, nSizeX, nSizeY, 0, nFlags);
+}
+
+void PdfFormEnvironment::commit()
+{
+    if (m_pForm)
+    {
+        FORM_ForceToKillFocus(m_pForm);
+    }
+}
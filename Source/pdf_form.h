@@ -0,0 +1,143 @@
+﻿/*!
+ * @brief 交互式表单填写。
+ *
+ * `PdfFormEnvironment` 封装一个文档的 PDFium 表单填写环境（FPDFDOC_InitFormFillEnvironment）。
+ * 鼠标、键盘输入在 GUI 线程收集成 `PdfFormEvent`，成批交给执行线程送入 PDFium。PDFium 通过
+ * FFI_Invalidate 回调报告需要重绘的页面区域，`handleEvents()` 收集这些脏矩形，只把脏矩形内的
+ * 页面内容与表单域（FPDF_FFLDraw）渲染成小块位图返回，GUI 线程把小块贴回缓存中的页面位图。
+ * 因此在内容密集的页面上输入一个字符只需渲染文本框所在的一小块区域，而不是整页。
+ *
+ * 整页渲染（首页、渲染调度器）在页面位图之上调用 `drawFields()` 绘制表单域，与小块渲染的结果一致。
+ *
+ * @author LiuYe
+ * @date 2026-10-19
+ * @copyright (c) 2013-2026 Honghu Yuntu Corporation
+ */
+
+#pragma once
+
+#include <QImage>
+#include <QPointF>
+#include <QRect>
+#include <QSize>
+#include <QString>
+#include <QTransform>
+#include <QVector>
+
+#include "color_scheme.h"
+#include "fpdf_formfill.h"
+
+/*!
+ * @brief 一个送往表单的输入事件，坐标为页面坐标。
+ */
+struct PdfFormEvent
+{
+    enum Type
+    {
+        MouseDown,
+        MouseUp,
+        MouseMove,
+        KeyDown,
+        Char,
+        KillFocus                     // 提交焦点所在表单域的输入并取消焦点
+    };
+
+    Type eType;
+    QPointF oPagePoint;               // 鼠标事件的位置
+    int nKey;                         // KeyDown 为 FWL_VKEY_*，Char 为 UTF-16 码元
+    int nModifiers;                   // FWL_EVENTFLAG_* 组合
+
+    PdfFormEvent();
+};
+
+/*!
+ * @brief 重绘后的一块页面区域。
+ */
+struct PdfFormPatch
+{
+    QRect oDeviceRect;                // 在页面位图中的位置
+    QImage oImage;
+};
+
+/*!
+ * @brief 一批输入事件的处理结果。
+ */
+struct PdfFormUpdate
+{
+    int nPage;
+    QVector<PdfFormPatch> vecPatches;
+    ColorScheme eColorScheme;         // 小块渲染使用的颜色方案
+    bool bGrayscale;                  // 小块是否以 8 位灰度渲染
+    bool bFocused;                    // 处理后是否有表单域持有焦点，持有焦点时键盘输入送往表单
+
+    PdfFormUpdate();
+};
+
+/*!
+ * @brief 一个文档的表单填写环境，由 `PdfDocument` 持有。
+ *
+ * 全部函数只能在 PDFium 执行线程上调用。同一时刻只有一页处于交互状态，该页保持加载，
+ * 切换到其他页时先提交焦点所在表单域的输入。
+ *
+ * @date 2026.10.19
+ */
+class PdfFormEnvironment
+{
+public:
+    explicit PdfFormEnvironment(FPDF_DOCUMENT pDocument);
+    ~PdfFormEnvironment();
+
+    FPDF_FORMHANDLE handle() const
+    {
+        return m_pForm;
+    }
+
+    // 输入后是否有表单域的值被修改
+    bool isModified() const
+    {
+        return m_bModified;
+    }
+
+    /*!
+     * @brief 处理一批输入并渲染脏区域。
+     *
+     * @param nPage 事件所在页
+     * @param vecEvents 输入事件，按发生顺序
+     * @param oPageToDevice 页面坐标到页面位图像素坐标的变换
+     * @param oImageSize 页面位图的大小
+     * @param eColorScheme 页面位图的颜色方案
+     * @param bGrayscale 页面位图是否以灰度渲染
+     */
+    PdfFormUpdate handleEvents(int nPage, const QVector<PdfFormEvent>& vecEvents, const QTransform& oPageToDevice,
+        const QSize& oImageSize, ColorScheme eColorScheme, bool bGrayscale);
+
+    // 在整页渲染的位图上绘制表单域；nPage 为交互页时使用交互页的句柄，以显示正在输入的内容
+    // nFlags 与页面渲染的标志一致，灰度位图须带 FPDF_GRAYSCALE，与小块渲染的结果相同
+    void drawFields(FPDF_BITMAP pBitmap, FPDF_PAGE pPage, int nPage, int nStartX, int nStartY, int nSizeX,
+        int nSizeY, int nFlags);
+
+    // 提交焦点所在表单域的输入，保存前调用
+    void commit();
+
+    PdfFormEnvironment(const PdfFormEnvironment&) = delete;
+    PdfFormEnvironment& operator=(const PdfFormEnvironment&) = delete;
+
+private:
+    struct FormFillInfo;
+
+    static void onInvalidate(FPDF_FORMFILLINFO* pThis, FPDF_PAGE pPage, double dLeft, double dTop, double dRight,
+        double dBottom);
+    static void onChange(FPDF_FORMFILLINFO* pThis);
+
+    // 加载交互页，必要时关闭前一页
+    FPDF_PAGE loadPage(int nPage);
+    void closePage();
+
+    FPDF_DOCUMENT m_pDocument;
+    FPDF_FORMHANDLE m_pForm;
+    FormFillInfo* m_pInfo;            // PDFium 在环境存活期间持有该结构的指针
+    FPDF_PAGE m_pPage;                // 交互页
+    int m_nPage;
+    QVector<QRectF> m_vecDirty;       // 交互页上待重绘的页面区域
+    bool m_bModified;
+};
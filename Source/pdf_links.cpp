@@ -0,0 +1,223 @@
+﻿/*!
+ * @brief 页面链接预先索引的实现。
+ *
+ * @author LiuYe
+ * @date 2026-10-19
+ * @copyright (c) 2013-2026 Honghu Yuntu Corporation
+ */
+
+#include "pdf_links.h"
+
+#include "fpdf_doc.h"
+#include "fpdf_text.h"
+#include "monotonic_arena.h"
+
+#include <algorithm>
+
+namespace
+{
+    // 读取 URI 动作的地址，PDFium 返回以 NUL 结尾的 7 位 ASCII 字符串
+    QString actionUri(const FPDF_DOCUMENT pDocument, const FPDF_ACTION pAction, MonotonicArena& scratch)
+    {
+        const unsigned long nBytes = FPDFAction_GetURIPath(pDocument, pAction, nullptr, 0);
+        if (nBytes <= 1)
+        {
+            return QString();
+        }
+        ArenaVector<char> vecBuffer(nBytes, 0, ArenaAllocator<char>(scratch));
+        FPDFAction_GetURIPath(pDocument, pAction, vecBuffer.data(), nBytes);
+        return QString::fromLatin1(vecBuffer.data(), static_cast<int>(nBytes) - 1);
+    }
+
+    /*!
+     * @brief 解析链接目标。
+     *
+     * 目标直接写在 Dest 中，或者写在 GoTo / URI 动作中；其他动作（打开其他文件、运行程序等）不支持，
+     * 返回 false。
+     */
+    bool resolveTarget(const FPDF_DOCUMENT pDocument, const FPDF_LINK pLink, PdfLink& link, MonotonicArena& scratch)
+    {
+        FPDF_DEST dest = FPDFLink_GetDest(pDocument, pLink);
+        const FPDF_ACTION action = dest ? nullptr : FPDFLink_GetAction(pLink);
+        if (action)
+        {
+            switch (FPDFAction_GetType(action))
+            {
+            case PDFACTION_GOTO:
+                dest = FPDFAction_GetDest(pDocument, action);
+                break;
+            case PDFACTION_URI:
+                link.eType = PdfLink::OpenUri;
+                link.strUri = actionUri(pDocument, action, scratch);
+                return !link.strUri.isEmpty();
+            default:
+                break;
+            }
+        }
+        if (!dest)
+        {
+            return false;
+        }
+        link.eType = PdfLink::GoToPage;
+        link.nTargetPage = FPDFDest_GetDestPageIndex(pDocument, dest);
+        return link.nTargetPage >= 0;
+    }
+}
+
+PdfLink::PdfLink()
+    : eType(GoToPage), nTargetPage(-1)
+{
+}
+
+PdfLinkIndex::PdfLinkIndex()
+{
+}
+
+void PdfLinkIndex::load(const FPDF_DOCUMENT pDocument, const FPDF_PAGE pPage, MonotonicArena* pScratch)
+{
+    clear();
+    if (!pDocument || !pPage)
+    {
+        return;
+    }
+    MonotonicArena localScratch;
+    MonotonicArena& scratch = pScratch ? *pScratch : localScratch;
+    // 正文网址先加入，与链接注释重叠时链接注释优先
+    loadWebLinks(pPage, scratch);
+    loadAnnotationLinks(pDocument, pPage, scratch);
+    rebuildIndex();
+}
+
+void PdfLinkIndex::clear()
+{
+    m_vecLinks.clear();
+    m_vecRectOwners.clear();
+    m_oIndex.clear();
+}
+
+void PdfLinkIndex::loadAnnotationLinks(const FPDF_DOCUMENT pDocument, const FPDF_PAGE pPage,
+    MonotonicArena& scratch)
+{
+    int nPosition = 0;
+    FPDF_LINK pLink = nullptr;
+    while (FPDFLink_Enumerate(pPage, &nPosition, &pLink))
+    {
+        PdfLink link;
+        if (!pLink || !resolveTarget(pDocument, pLink, link, scratch))
+        {
+            continue;
+        }
+
+        // 跨行的链接用多个四边形描述，只取注释矩形会覆盖行间的无关文字
+        const int nQuads = FPDFLink_CountQuadPoints(pLink);
+        for (int i = 0; i < nQuads; ++i)
+        {
+            FS_QUADPOINTSF quad;
+            if (FPDFLink_GetQuadPoints(pLink, i, &quad))
+            {
+                const float fMinX = std::min(std::min(quad.x1, quad.x2), std::min(quad.x3, quad.x4));
+                const float fMaxX = std::max(std::max(quad.x1, quad.x2), std::max(quad.x3, quad.x4));
+                const float fMinY = std::min(std::min(quad.y1, quad.y2), std::min(quad.y3, quad.y4));
+                const float fMaxY = std::max(std::max(quad.y1, quad.y2), std::max(quad.y3, quad.y4));
+                link.vecRects.push_back(QRectF(fMinX, fMinY, fMaxX - fMinX, fMaxY - fMinY));
+            }
+        }
+        FS_RECTF rect;
+        if (link.vecRects.empty() && FPDFLink_GetAnnotRect(pLink, &rect))
+        {
+            link.vecRects.push_back(
+                QRectF(QPointF(rect.left, rect.bottom), QPointF(rect.right, rect.top)).normalized());
+        }
+        if (!link.vecRects.empty())
+        {
+            m_vecLinks.push_back(link);
+        }
+    }
+}
+
+void PdfLinkIndex::loadWebLinks(const FPDF_PAGE pPage, MonotonicArena& scratch)
+{
+    const FPDF_TEXTPAGE textPage = FPDFText_LoadPage(pPage);
+    if (!textPage)
+    {
+        return;
+    }
+    const FPDF_PAGELINK webLinks = FPDFLink_LoadWebLinks(textPage);
+    if (webLinks)
+    {
+        const int nCount = FPDFLink_CountWebLinks(webLinks);
+        for (int i = 0; i < nCount; ++i)
+        {
+            // 返回的长度以 UTF-16 码元计，包含结尾的 NUL
+            const int nChars = FPDFLink_GetURL(webLinks, i, nullptr, 0);
+            if (nChars <= 1)
+            {
+                continue;
+            }
+            ArenaVector<unsigned short> vecBuffer(static_cast<size_t>(nChars), 0,
+                ArenaAllocator<unsigned short>(scratch));
+            FPDFLink_GetURL(webLinks, i, vecBuffer.data(), nChars);
+
+            PdfLink link;
+            link.eType = PdfLink::OpenUri;
+            link.strUri = QString::fromUtf16(vecBuffer.data(), nChars - 1);
+            const int nRects = FPDFLink_CountRects(webLinks, i);
+            for (int j = 0; j < nRects; ++j)
+            {
+                double dLeft = 0.0;
+                double dTop = 0.0;
+                double dRight = 0.0;
+                double dBottom = 0.0;
+                if (FPDFLink_GetRect(webLinks, i, j, &dLeft, &dTop, &dRight, &dBottom))
+                {
+                    link.vecRects.push_back(QRectF(QPointF(dLeft, dBottom), QPointF(dRight, dTop)).normalized());
+                }
+            }
+            if (!link.vecRects.empty())
+            {
+                m_vecLinks.push_back(link);
+            }
+        }
+        FPDFLink_CloseWebLinks(webLinks);
+    }
+    FPDFText_ClosePage(textPage);
+}
+
+void PdfLinkIndex::rebuildIndex()
+{
+    std::vector<std::pair<int, QRectF>> vecEntries;
+    for (size_t i = 0; i < m_vecLinks.size(); ++i)
+    {
+        const std::vector<QRectF>& vecRects = m_vecLinks[i].vecRects;
+        for (size_t j = 0; j < vecRects.size(); ++j)
+        {
+            vecEntries.push_back(std::make_pair(static_cast<int>(m_vecRectOwners.size()), vecRects[j]));
+            m_vecRectOwners.push_back(static_cast<int>(i));
+        }
+    }
+    m_oIndex.build(vecEntries);
+}
+
+int PdfLinkIndex::hitTest(const QPointF& oPoint, const double dTolerance) const
+{
+    if (m_vecLinks.empty())
+    {
+        return -1;
+    }
+
+    // 链接区域都是轴对齐矩形，空间索引的包围盒测试即为精确测试
+    std::vector<int> vecIds;
+    m_oIndex.queryPoint(oPoint, dTolerance, vecIds);
+    int nHit = -1;
+    for (size_t i = 0; i < vecIds.size(); ++i)
+    {
+        nHit = std::max(nHit, m_vecRectOwners[static_cast<size_t>(vecIds[i])]);
+    }
+    return nHit;
+}
+
+const PdfLink* PdfLinkIndex::link(const int nLink) const
+{
+    return nLink >= 0 && static_cast<size_t>(nLink) < m_vecLinks.size() ? &m_vecLinks[static_cast<size_t>(nLink)]
+        : nullptr;
+}
@@ -0,0 +1,82 @@
+﻿/*!
+ * @brief 页面链接的预先索引。
+ *
+ * `PdfLinkIndex` 在读取页面注释几何的同一个执行线程任务中收集一页的全部链接：链接注释经
+ * `FPDFLink_Enumerate` 枚举，区域取 QuadPoints（缺省时取注释矩形）；正文中未做成注释的网址经
+ * `FPDFLink_LoadWebLinks` 识别。链接的目标在收集时一并解析，页内跳转得到目标页下标，外部链接得到 URI。
+ * 全部区域放入 `SpatialIndex`，鼠标移动时的命中测试、光标与提示文字的更新都不再访问 PDFium。
+ *
+ * @author LiuYe
+ * @date 2026-10-19
+ * @copyright (c) 2013-2026 Honghu Yuntu Corporation
+ */
+
+#pragma once
+
+#include <QPointF>
+#include <QRectF>
+#include <QString>
+
+#include <vector>
+
+#include "fpdfview.h"
+#include "spatial_index.h"
+
+class MonotonicArena;
+
+/*!
+ * @brief 一个已解析目标的链接。
+ */
+struct PdfLink
+{
+    enum Type
+    {
+        GoToPage,                     // 跳转到本文档的另一页
+        OpenUri                       // 打开外部 URI
+    };
+
+    Type eType;
+    int nTargetPage;                  // GoToPage 的目标页下标
+    QString strUri;                   // OpenUri 的地址
+    std::vector<QRectF> vecRects;     // 链接区域，页面坐标，top() 为最小 y
+
+    PdfLink();
+};
+
+/*!
+ * @brief 一页链接的缓存及空间索引。
+ *
+ * `load()` 只能在 PDFium 执行线程上调用，之后的查询只访问缓存，可在 GUI 线程上进行。
+ * 区域重叠时链接注释优先于正文识别出的网址，同类中后绘制的优先。
+ *
+ * @date 2026.10.19
+ */
+class PdfLinkIndex
+{
+public:
+    PdfLinkIndex();
+
+    // 读取页面上的全部链接并解析目标，已有内容全部丢弃；地址的临时缓冲区从 pScratch 分配，为空时使用局部 arena
+    void load(FPDF_DOCUMENT pDocument, FPDF_PAGE pPage, MonotonicArena* pScratch = nullptr);
+    void clear();
+
+    bool isEmpty() const
+    {
+        return m_vecLinks.empty();
+    }
+
+    // 查找包含该点（允许 dTolerance 误差）的链接，没有时返回 -1
+    int hitTest(const QPointF& oPoint, double dTolerance) const;
+
+    // 按 hitTest 返回的下标取链接，下标无效时返回 nullptr
+    const PdfLink* link(int nLink) const;
+
+private:
+    void loadAnnotationLinks(FPDF_DOCUMENT pDocument, FPDF_PAGE pPage, MonotonicArena& scratch);
+    void loadWebLinks(FPDF_PAGE pPage, MonotonicArena& scratch);
+    void rebuildIndex();
+
+    std::vector<PdfLink> m_vecLinks;  // 正文网址在前，链接注释在后，下标越大优先级越高
+    std::vector<int> m_vecRectOwners; // 空间索引中每个区域所属的链接下标
+    SpatialIndex m_oIndex;
+};
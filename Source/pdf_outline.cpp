@@ -0,0 +1,394 @@
+﻿/*!
+ * @brief 文档书签（大纲）的延迟加载模型的实现。
+ *
+ * @author LiuYe
+ * @date 2026-10-19
+ * @copyright (c) 2013-2026 Honghu Yuntu Corporation
+ */
+
+#include "pdf_outline.h"
+
+#include <QSet>
+
+#include "pdfium_executor.h"
+
+namespace
+{
+    // 目标页尚未解析
+    const int kPageUnresolved = -2;
+
+    // 查找路径时的最大深度，防止损坏文档中父子循环导致无限递归
+    const int kMaxDepth = 256;
+
+    PdfOutlineEntry readEntry(const FPDF_DOCUMENT pDocument, const FPDF_BOOKMARK pBookmark)
+    {
+        PdfOutlineEntry entry;
+        entry.pBookmark = pBookmark;
+        entry.bHasChildren = FPDFBookmark_GetFirstChild(pDocument, pBookmark) != nullptr;
+        const unsigned long nBytes = FPDFBookmark_GetTitle(pBookmark, nullptr, 0);
+        if (nBytes > sizeof(FPDF_WCHAR))
+        {
+            std::vector<FPDF_WCHAR> vecBuffer(nBytes / sizeof(FPDF_WCHAR));
+            FPDFBookmark_GetTitle(pBookmark, vecBuffer.data(), nBytes);
+            entry.strTitle = QString::fromUtf16(vecBuffer.data(), static_cast<int>(vecBuffer.size()) - 1);
+        }
+        return entry;
+    }
+
+    PdfOutlineBatch readBatch(const FPDF_DOCUMENT pDocument, FPDF_BOOKMARK pBookmark)
+    {
+        PdfOutlineBatch batch;
+        while (pBookmark && batch.vecEntries.size() < static_cast<size_t>(PdfOutlineModel::kBatchSize))
+        {
+            batch.vecEntries.push_back(readEntry(pDocument, pBookmark));
+            pBookmark = FPDFBookmark_GetNextSibling(pDocument, pBookmark);
+        }
+        batch.pNext = pBookmark;
+        return batch;
+    }
+
+    /*!
+     * @brief 深度优先查找 pTarget，找到时从内向外填写路径。
+     *
+     * 遍历时只记录句柄，只有路径上各层的书签才读取标题。
+     */
+    bool findPath(const FPDF_DOCUMENT pDocument, const FPDF_BOOKMARK pParent, const FPDF_BOOKMARK pTarget,
+        QSet<FPDF_BOOKMARK>& setVisited, const int nDepth, PdfOutlinePath& path)
+    {
+        if (nDepth > kMaxDepth)
+        {
+            return false;
+        }
+        std::vector<FPDF_BOOKMARK> vecSiblings;
+        for (FPDF_BOOKMARK pBookmark = FPDFBookmark_GetFirstChild(pDocument, pParent);
+            pBookmark && !setVisited.contains(pBookmark); pBookmark = FPDFBookmark_GetNextSibling(pDocument, pBookmark))
+        {
+            setVisited.insert(pBookmark);
+            vecSiblings.push_back(pBookmark);
+            if (pBookmark == pTarget || findPath(pDocument, pBookmark, pTarget, setVisited, nDepth + 1, path))
+            {
+                std::vector<PdfOutlineEntry> vecLevel;
+                vecLevel.reserve(vecSiblings.size());
+                for (size_t i = 0; i < vecSiblings.size(); ++i)
+                {
+                    vecLevel.push_back(readEntry(pDocument, vecSiblings[i]));
+                }
+                path.vecLevels.insert(path.vecLevels.begin(), vecLevel);
+                path.vecNext.insert(path.vecNext.begin(), FPDFBookmark_GetNextSibling(pDocument, pBookmark));
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
+/*!
+ * @brief 模型中的一个书签节点，根节点代表大纲本身。
+ */
+struct PdfOutlineModel::Node
+{
+    Node* pParent;
+    int nRow;
+    PdfOutlineEntry entry;
+    int nPage;                        // 目标页，kPageUnresolved 为未解析，-1 为没有目标页
+    std::vector<std::unique_ptr<Node>> vecChildren;
+    QSet<FPDF_BOOKMARK> setChildren;  // 已加载的子书签，用于发现兄弟循环
+    FPDF_BOOKMARK pNext;              // 下一批子书签的起点
+    bool bStarted;                    // 是否已请求过第一批子书签
+    bool bFetching;
+
+    Node()
+        : pParent(nullptr), nRow(0), nPage(kPageUnresolved), pNext(nullptr), bStarted(false), bFetching(false)
+    {
+    }
+};
+
+PdfOutlineEntry::PdfOutlineEntry()
+    : pBookmark(nullptr), bHasChildren(false)
+{
+}
+
+PdfOutlineBatch::PdfOutlineBatch()
+    : pNext(nullptr)
+{
+}
+
+PdfOutlineModel::PdfOutlineModel(QObject* pParent)
+    : QAbstractItemModel(pParent), m_pRoot(new Node), m_nGeneration(0)
+{
+    connect(&m_oFindWatcher, &QFutureWatcher<PdfOutlinePath>::finished, this, &PdfOutlineModel::onFindFinished);
+}
+
+PdfOutlineModel::~PdfOutlineModel()
+{
+    m_oFindWatcher.setFuture(QFuture<PdfOutlinePath>());
+}
+
+/*!
+ * @brief 换用另一个文档。
+ *
+ * 只重置模型，不读取任何书签；顶层书签在视图第一次请求时才分批读取。
+ */
+void PdfOutlineModel::setDocument(const PdfDocumentPtr& pDocument)
+{
+    if (pDocument == m_pDocument)
+    {
+        return;
+    }
+    beginResetModel();
+    ++m_nGeneration;
+    m_oFindWatcher.setFuture(QFuture<PdfOutlinePath>());
+    m_pDocument = pDocument;
+    m_pRoot.reset(new Node);
+    m_pRoot->entry.bHasChildren = static_cast<bool>(pDocument);
+    endResetModel();
+}
+
+void PdfOutlineModel::activate(const QModelIndex& index)
+{
+    Node* pNode = nodeFor(index);
+    if (!pNode || pNode == m_pRoot.get() || !m_pDocument)
+    {
+        return;
+    }
+    if (pNode->nPage != kPageUnresolved)
+    {
+        if (pNode->nPage >= 0)
+        {
+            emit pageActivated(pNode->nPage);
+        }
+        return;
+    }
+
+    const PdfDocumentPtr document = m_pDocument;
+    const FPDF_BOOKMARK bookmark = pNode->entry.pBookmark;
+    const quint64 nGeneration = m_nGeneration;
+    QFutureWatcher<int>* pWatcher = new QFutureWatcher<int>(this);
+    connect(pWatcher, &QFutureWatcher<int>::finished, this, [this, pWatcher, pNode, nGeneration]()
+        {
+            pWatcher->deleteLater();
+            if (nGeneration != m_nGeneration || pWatcher->future().resultCount() == 0)
+            {
+                return;
+            }
+            pNode->nPage = pWatcher->future().result();
+            if (pNode->nPage >= 0)
+            {
+                emit pageActivated(pNode->nPage);
+            }
+        });
+    pWatcher->setFuture(PdfiumExecutor::instance().run<int>(
+        [document, bookmark](QFutureInterface<int>&)
+        {
+            const FPDF_DOCUMENT pDocument = document->handle();
+            FPDF_DEST dest = FPDFBookmark_GetDest(pDocument, bookmark);
+            if (!dest)
+            {
+                // 没有 /Dest 的书签常用 GoTo 动作指定目标
+                const FPDF_ACTION action = FPDFBookmark_GetAction(bookmark);
+                if (action && FPDFAction_GetType(action) == PDFACTION_GOTO)
+                {
+                    dest = FPDFAction_GetDest(pDocument, action);
+                }
+            }
+            return dest ? FPDFDest_GetDestPageIndex(pDocument, dest) : -1;
+        }));
+}
+
+void PdfOutlineModel::find(const QString& strTitle)
+{
+    if (!m_pDocument || strTitle.isEmpty())
+    {
+        emit found(QModelIndex());
+        return;
+    }
+    const PdfDocumentPtr document = m_pDocument;
+    m_oFindWatcher.setFuture(PdfiumExecutor::instance().run<PdfOutlinePath>(
+        [document, strTitle](QFutureInterface<PdfOutlinePath>& future)
+        {
+            PdfOutlinePath path;
+            const FPDF_DOCUMENT pDocument = document->handle();
+            const FPDF_BOOKMARK pTarget = FPDFBookmark_Find(pDocument,
+                reinterpret_cast<FPDF_WIDESTRING>(strTitle.utf16()));
+            if (pTarget && !future.isCanceled())
+            {
+                QSet<FPDF_BOOKMARK> setVisited;
+                findPath(pDocument, nullptr, pTarget, setVisited, 0, path);
+            }
+            return path;
+        }));
+}
+
+/*!
+ * @brief 补齐路径上各层尚未加载的书签，发出目标书签的索引。
+ */
+void PdfOutlineModel::onFindFinished()
+{
+    const QFuture<PdfOutlinePath> future = m_oFindWatcher.future();
+    if (future.resultCount() == 0)
+    {
+        return;
+    }
+    const PdfOutlinePath path = future.result();
+    Node* pNode = m_pRoot.get();
+    for (size_t i = 0; i < path.vecLevels.size() && pNode; ++i)
+    {
+        const std::vector<PdfOutlineEntry>& vecLevel = path.vecLevels[i];
+        if (pNode->vecChildren.size() < vecLevel.size())
+        {
+            // 进行中的分批读取在结果到达时发现起点已变化，会被丢弃
+            pNode->bStarted = true;
+            appendEntries(pNode, vecLevel, pNode->vecChildren.size(), path.vecNext[i]);
+        }
+        pNode = pNode->vecChildren.size() >= vecLevel.size() ? pNode->vecChildren[vecLevel.size() - 1].get()
+            : nullptr;
+    }
+    emit found(pNode && pNode != m_pRoot.get() ? indexFor(pNode) : QModelIndex());
+}
+
+QModelIndex PdfOutlineModel::index(const int nRow, const int nColumn, const QModelIndex& parent) const
+{
+    const Node* pParent = nodeFor(parent);
+    if (!pParent || nColumn != 0 || nRow < 0 || nRow >= static_cast<int>(pParent->vecChildren.size()))
+    {
+        return QModelIndex();
+    }
+    return createIndex(nRow, nColumn, pParent->vecChildren[nRow].get());
+}
+
+QModelIndex PdfOutlineModel::parent(const QModelIndex& index) const
+{
+    const Node* pNode = nodeFor(index);
+    if (!pNode || !pNode->pParent || pNode->pParent == m_pRoot.get())
+    {
+        return QModelIndex();
+    }
+    return indexFor(pNode->pParent);
+}
+
+int PdfOutlineModel::rowCount(const QModelIndex& parent) const
+{
+    const Node* pNode = nodeFor(parent);
+    return pNode ? static_cast<int>(pNode->vecChildren.size()) : 0;
+}
+
+int PdfOutlineModel::columnCount(const QModelIndex&) const
+{
+    return 1;
+}
+
+bool PdfOutlineModel::hasChildren(const QModelIndex& parent) const
+{
+    const Node* pNode = nodeFor(parent);
+    return pNode && (!pNode->vecChildren.empty() || pNode->entry.bHasChildren);
+}
+
+QVariant PdfOutlineModel::data(const QModelIndex& index, const int nRole) const
+{
+    const Node* pNode = nodeFor(index);
+    if (!pNode || pNode == m_pRoot.get())
+    {
+        return QVariant();
+    }
+    if (nRole == Qt::DisplayRole || nRole == Qt::ToolTipRole)
+    {
+        return pNode->entry.strTitle;
+    }
+    return QVariant();
+}
+
+bool PdfOutlineModel::canFetchMore(const QModelIndex& parent) const
+{
+    const Node* pNode = nodeFor(parent);
+    return m_pDocument && pNode && pNode->entry.bHasChildren && !pNode->bFetching
+        && (!pNode->bStarted || pNode->pNext);
+}
+
+/*!
+ * @brief 在执行线程上读取下一批子书签。
+ *
+ * 结果到达时已加载的子书签数必须与请求时相同，否则说明期间查找结果已补齐了这一层，丢弃本批。
+ */
+void PdfOutlineModel::fetchMore(const QModelIndex& parent)
+{
+    Node* pNode = nodeFor(parent);
+    if (!canFetchMore(parent))
+    {
+        return;
+    }
+    const PdfDocumentPtr document = m_pDocument;
+    const bool bFirst = !pNode->bStarted;
+    const FPDF_BOOKMARK bookmark = bFirst ? pNode->entry.pBookmark : pNode->pNext;
+    const size_t nFirstRow = pNode->vecChildren.size();
+    const quint64 nGeneration = m_nGeneration;
+    pNode->bStarted = true;
+    pNode->bFetching = true;
+
+    QFutureWatcher<PdfOutlineBatch>* pWatcher = new QFutureWatcher<PdfOutlineBatch>(this);
+    connect(pWatcher, &QFutureWatcher<PdfOutlineBatch>::finished, this,
+        [this, pWatcher, pNode, nFirstRow, nGeneration]()
+        {
+            pWatcher->deleteLater();
+            if (nGeneration != m_nGeneration)
+            {
+                return;
+            }
+            pNode->bFetching = false;
+            if (pWatcher->future().resultCount() > 0 && pNode->vecChildren.size() == nFirstRow)
+            {
+                const PdfOutlineBatch batch = pWatcher->future().result();
+                appendEntries(pNode, batch.vecEntries, 0, batch.pNext);
+            }
+        });
+    pWatcher->setFuture(PdfiumExecutor::instance().run<PdfOutlineBatch>(
+        [document, bFirst, bookmark](QFutureInterface<PdfOutlineBatch>&)
+        {
+            const FPDF_DOCUMENT pDocument = document->handle();
+            return readBatch(pDocument, bFirst ? FPDFBookmark_GetFirstChild(pDocument, bookmark) : bookmark);
+        }));
+}
+
+PdfOutlineModel::Node* PdfOutlineModel::nodeFor(const QModelIndex& index) const
+{
+    return index.isValid() ? static_cast<Node*>(index.internalPointer()) : m_pRoot.get();
+}
+
+QModelIndex PdfOutlineModel::indexFor(const Node* pNode) const
+{
+    return pNode == m_pRoot.get() ? QModelIndex() : createIndex(pNode->nRow, 0, const_cast<Node*>(pNode));
+}
+
+void PdfOutlineModel::appendEntries(Node* pNode, const std::vector<PdfOutlineEntry>& vecEntries, const size_t nFirst,
+    FPDF_BOOKMARK pNext)
+{
+    size_t nEnd = nFirst;
+    QSet<FPDF_BOOKMARK> setNew;
+    while (nEnd < vecEntries.size() && !pNode->setChildren.contains(vecEntries[nEnd].pBookmark)
+        && !setNew.contains(vecEntries[nEnd].pBookmark))
+    {
+        setNew.insert(vecEntries[nEnd].pBookmark);
+        ++nEnd;
+    }
+    if (nEnd < vecEntries.size() || (pNext && (pNode->setChildren.contains(pNext) || setNew.contains(pNext))))
+    {
+        pNext = nullptr;
+    }
+    pNode->pNext = pNext;
+    if (nEnd == nFirst)
+    {
+        return;
+    }
+
+    const int nRow = static_cast<int>(pNode->vecChildren.size());
+    beginInsertRows(indexFor(pNode), nRow, nRow + static_cast<int>(nEnd - nFirst) - 1);
+    for (size_t i = nFirst; i < nEnd; ++i)
+    {
+        std::unique_ptr<Node> pChild(new Node);
+        pChild->pParent = pNode;
+        pChild->nRow = static_cast<int>(pNode->vecChildren.size());
+        pChild->entry = vecEntries[i];
+        pNode->setChildren.insert(vecEntries[i].pBookmark);
+        pNode->vecChildren.push_back(std::move(pChild));
+    }
+    endInsertRows();
+}
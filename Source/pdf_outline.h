@@ -0,0 +1,122 @@
+﻿/*!
+ * @brief 文档书签（大纲）的延迟加载模型。
+ *
+ * 标准类文档的大纲可达数万条，打开文档时不遍历大纲。`PdfOutlineModel` 只在视图需要时读取子书签：
+ * 节点展开或滚动到已加载部分的末尾时，执行线程通过 `FPDFBookmark_GetFirstChild` /
+ * `FPDFBookmark_GetNextSibling` 读取下一批（每批至多 kBatchSize 条）的标题，GUI 线程追加到模型。
+ * 书签的目标页在激活时才经 `FPDFBookmark_GetDest` 解析并缓存。按标题查找使用 `FPDFBookmark_Find`，
+ * 在执行线程上找到书签后求出它从顶层开始的路径，只补齐路径上各层尚未加载的书签。
+ *
+ * 书签句柄属于文档，只在执行线程上使用；异步任务持有文档引用，句柄在任务期间保持有效。
+ *
+ * @author LiuYe
+ * @date 2026-10-19
+ * @copyright (c) 2013-2026 Honghu Yuntu Corporation
+ */
+
+#pragma once
+
+#include <QAbstractItemModel>
+#include <QFutureWatcher>
+#include <QString>
+
+#include <memory>
+#include <vector>
+
+#include "fpdf_doc.h"
+#include "pdf_document.h"
+
+/*!
+ * @brief 一个书签的句柄与标题，在执行线程上读取。
+ */
+struct PdfOutlineEntry
+{
+    FPDF_BOOKMARK pBookmark;
+    QString strTitle;
+    bool bHasChildren;
+
+    PdfOutlineEntry();
+};
+
+/*!
+ * @brief 一批相邻的兄弟书签。
+ */
+struct PdfOutlineBatch
+{
+    std::vector<PdfOutlineEntry> vecEntries;
+    FPDF_BOOKMARK pNext;              // 下一批的第一个书签，nullptr 表示本层已读完
+
+    PdfOutlineBatch();
+};
+
+/*!
+ * @brief 查找结果：从顶层到目标书签的每一层，从第一个兄弟截止到路径上的书签。
+ *
+ * 未找到时 vecLevels 为空。
+ */
+struct PdfOutlinePath
+{
+    std::vector<std::vector<PdfOutlineEntry>> vecLevels;
+    std::vector<FPDF_BOOKMARK> vecNext;   // 每层路径书签之后的兄弟
+};
+
+/*!
+ * @brief 单列的书签树模型，只在 GUI 线程使用。
+ *
+ * @date 2026.10.19
+ */
+class PdfOutlineModel : public QAbstractItemModel
+{
+    Q_OBJECT
+
+public:
+    // 每批读取的书签数
+    static const int kBatchSize = 200;
+
+    explicit PdfOutlineModel(QObject* pParent = nullptr);
+    ~PdfOutlineModel() override;
+
+    // 换用另一个文档，之前的异步结果全部丢弃
+    void setDocument(const PdfDocumentPtr& pDocument);
+    PdfDocumentPtr document() const
+    {
+        return m_pDocument;
+    }
+
+    // 激活书签：目标页已解析时立即发出 pageActivated，否则在执行线程上解析后发出
+    void activate(const QModelIndex& index);
+
+    // 按标题查找第一个匹配的书签，完成后发出 found
+    void find(const QString& strTitle);
+
+    QModelIndex index(int nRow, int nColumn, const QModelIndex& parent = QModelIndex()) const override;
+    QModelIndex parent(const QModelIndex& index) const override;
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    bool hasChildren(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int nRole = Qt::DisplayRole) const override;
+    bool canFetchMore(const QModelIndex& parent) const override;
+    void fetchMore(const QModelIndex& parent) override;
+
+signals:
+    void pageActivated(int nPage);
+    void found(const QModelIndex& index); // 未找到时为无效索引
+
+private slots:
+    void onFindFinished();
+
+private:
+    struct Node;
+
+    Node* nodeFor(const QModelIndex& index) const;
+    QModelIndex indexFor(const Node* pNode) const;
+
+    // 在 pNode 的已加载子书签之后追加，遇到已加载过的书签（损坏文档中的循环）时停止
+    void appendEntries(Node* pNode, const std::vector<PdfOutlineEntry>& vecEntries, size_t nFirst,
+        FPDF_BOOKMARK pNext);
+
+    PdfDocumentPtr m_pDocument;
+    std::unique_ptr<Node> m_pRoot;
+    quint64 m_nGeneration;            // 每次换文档递增，用于丢弃旧文档的异步结果
+    QFutureWatcher<PdfOutlinePath> m_oFindWatcher;
+};
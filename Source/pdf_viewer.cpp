@@ -1,46 +1,1196 @@
 #include "pdf_viewer.h"
 #include "pdfium_utils.h"
+#include "pdfium_executor.h"
+#include "monotonic_arena.h"
+#include "perf_counters.h"
+#include "render_scheduler.h"
+#include "startup_profiler.h"
+#include "fpdf_annot.h"
+#include "fpdf_fwlevent.h"
+#include <QDesktopServices>
 #include <QPainter>
 #include <QFileDialog>
+#include <QFileInfo>
+#include <QKeyEvent>
+#include <QMessageBox>
+#include <QMouseEvent>
+#include <QShortcut>
+#include <QToolTip>
+#include <QUrl>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <iostream>
 
-PDFViewer::PDFViewer(const QString& pdfFilePath, QWidget* parent)
-    : QWidget(parent), m_pPDFDoc(nullptr)
+namespace
 {
-    const QByteArray filePathBytes = pdfFilePath.toLocal8Bit();
-    m_pPDFDoc = FPDF_LoadDocument(filePathBytes.constData(), nullptr);
-    if (!m_pPDFDoc)
+    // ݲλΪ
+    const double kHitTolerancePixels = 3.0;
+
+    // ҳǰռλĴСȡ US Letter ҳ 72 DPI µĳߴ
+    const QSize kPlaceholderSize(612, 792);
+
+    // Ⱦޣʾͬһڱ仯ʱλͼȾ
+    const int kZoomBucketPercent = 5;
+    const int kMaxZoomPercent = 400;
+
+    // ڴСֹͣ仯úµȾȾ
+    const int kResizeSettleMs = 150;
+
+    // ַıֻЩЭ飻file:UNC ·ȿس
+    bool isSafeLinkScheme(const QUrl& url)
+    {
+        const QString scheme = url.scheme().toLower();
+        return scheme == QLatin1String("http") || scheme == QLatin1String("https")
+            || scheme == QLatin1String("mailto");
+    }
+
+    /*!
+     * @brief ѱСҳλͼ
+     *
+     * ҶҳλͼиƻҶС飻СɫʱȰҳλͼת 32 λ
+     */
+    void pastePatch(QImage& image, const PdfFormPatch& patch)
     {
-        std::cerr << "Failed to open PDF file: " << pdfFilePath.toStdString() << '\n';
+        const QRect& rect = patch.oDeviceRect;
+        if (image.format() == QImage::Format_Grayscale8 && !patch.oImage.allGray())
+        {
+            image = image.convertToFormat(QImage::Format_RGB32);
+        }
+        if (image.format() != QImage::Format_Grayscale8)
+        {
+            QPainter painter(&image);
+            painter.drawImage(rect.topLeft(), patch.oImage);
+            return;
+        }
+
+        const QImage gray = patch.oImage.convertToFormat(QImage::Format_Grayscale8);
+        const QRect target = rect & image.rect();
+        for (int y = target.top(); y <= target.bottom(); ++y)
+        {
+            const uchar* pSource = gray.constScanLine(y - rect.top()) + (target.left() - rect.left());
+            memcpy(image.scanLine(y) + target.left(), pSource, static_cast<size_t>(target.width()));
+        }
     }
 
-    if (m_pPDFDoc)
+    int fwlModifiers(const Qt::KeyboardModifiers modifiers)
     {
-        const FPDF_PAGE page = FPDF_LoadPage(m_pPDFDoc, 0); // صһҳ
-        if (page)
+        int flags = 0;
+        if (modifiers & Qt::ShiftModifier)
+        {
+            flags |= FWL_EVENTFLAG_ShiftKey;
+        }
+        if (modifiers & Qt::ControlModifier)
+        {
+            flags |= FWL_EVENTFLAG_ControlKey;
+        }
+        if (modifiers & Qt::AltModifier)
         {
-            m_oPDFImage = renderPdfPageToImage(page); // Ⱦһҳ
-            FPDF_ClosePage(page);
+            flags |= FWL_EVENTFLAG_AltKey;
         }
+        return flags;
     }
 
-    setFixedSize(m_oPDFImage.size());
+    // Qt  FWL_VKEY_*ĸֵıͬ޶Ӧʱ 0
+    int fwlKeyCode(const int key)
+    {
+        switch (key)
+        {
+        case Qt::Key_Backspace:
+            return FWL_VKEY_Back;
+        case Qt::Key_Tab:
+            return FWL_VKEY_Tab;
+        case Qt::Key_Return:
+        case Qt::Key_Enter:
+            return FWL_VKEY_Return;
+        case Qt::Key_Escape:
+            return FWL_VKEY_Escape;
+        case Qt::Key_PageUp:
+            return FWL_VKEY_Prior;
+        case Qt::Key_PageDown:
+            return FWL_VKEY_Next;
+        case Qt::Key_End:
+            return FWL_VKEY_End;
+        case Qt::Key_Home:
+            return FWL_VKEY_Home;
+        case Qt::Key_Left:
+            return FWL_VKEY_Left;
+        case Qt::Key_Up:
+            return FWL_VKEY_Up;
+        case Qt::Key_Right:
+            return FWL_VKEY_Right;
+        case Qt::Key_Down:
+            return FWL_VKEY_Down;
+        case Qt::Key_Delete:
+            return FWL_VKEY_Delete;
+        default:
+            break;
+        }
+        if ((key >= Qt::Key_A && key <= Qt::Key_Z) || (key >= Qt::Key_0 && key <= Qt::Key_9))
+        {
+            return key;
+        }
+        return 0;
+    }
+}
+
+PDFViewer::PDFViewer(const QString& pdfFilePath, QWidget* parent)
+    : QWidget(parent), m_nPageIndex(0), m_nPageCount(0), m_nImageScalePercent(100), m_nZoomPercent(100), m_nFitWidth(0),
+    m_bResizing(false), m_eColorScheme(ColorSchemeNormal),
+    m_eImageColorScheme(ColorSchemeNormal), m_bGrayscale(false), m_bImageGrayscale(false), m_bImageStale(false),
+    m_bActive(true),
+    m_dHitTolerance(kHitTolerancePixels), m_nHoveredAnnotation(-1), m_nSelectedAnnotation(-1),
+    m_bDraggingAnnotation(false), m_nHoveredLink(-1), m_nPressedLink(-1), m_bFormFocused(false), m_bFormPressed(false)
+{
+    setFixedSize(kPlaceholderSize);
+    setMouseTracking(true);
+    setFocusPolicy(Qt::ClickFocus);
+
+    connect(&m_oLoader, &PdfDocumentLoader::fileMapped, this, [this]()
+        {
+            m_strStatus = "Parsing document...";
+            update();
+        });
+    connect(&m_oLoader, &PdfDocumentLoader::xrefParsed, this, [this]()
+        {
+            m_pDocument = m_oLoader.document();
+        });
+    connect(&m_oLoader, &PdfDocumentLoader::pageCountKnown, this, [this](const int pageCount)
+        {
+            m_nPageCount = pageCount;
+            m_strStatus = "Rendering first page...";
+            update();
+        });
+    connect(&m_oLoader, &PdfDocumentLoader::firstPageRendered, this, &PDFViewer::onFirstPageRendered);
+    connect(&m_oLoader, &PdfDocumentLoader::failed, this, &PDFViewer::onLoadFailed);
+    connect(&m_oGeometryWatcher, &QFutureWatcher<PdfPageGeometry>::finished, this, &PDFViewer::onPageGeometryLoaded);
+    connect(&m_oSaveWatcher, &QFutureWatcher<PdfSaveResult>::finished, this, &PDFViewer::onSaveFinished);
+    connect(&m_oFormWatcher, &QFutureWatcher<PdfFormUpdate>::finished, this, &PDFViewer::onFormUpdated);
+    connect(&RenderScheduler::instance(), &RenderScheduler::pageRendered, this, &PDFViewer::onPageRendered);
+
+    QShortcut* saveShortcut = new QShortcut(QKeySequence::Save, this);
+    connect(saveShortcut, &QShortcut::activated, this, [this]() { saveAnnotations(); });
+    QShortcut* saveAsShortcut = new QShortcut(QKeySequence::SaveAs, this);
+    connect(saveAsShortcut, &QShortcut::activated, this, [this]()
+        {
+            const QString path = QFileDialog::getSaveFileName(this, "Save PDF As", m_strFilePath, "PDF Files (*.pdf)");
+            if (!path.isEmpty())
+            {
+                saveAnnotations(path);
+            }
+        });
+
+    if (!pdfFilePath.isEmpty())
+    {
+        openDocument(pdfFilePath);
+    }
 }
 
 PDFViewer::~PDFViewer()
 {
-    if (m_pPDFDoc)
+    // ĵڽеͬУһͷʱִ߳Ϲرգ
+    // PDFium  PdfiumRuntime 鿴
+    m_oLoader.cancel();
+    m_oGeometryWatcher.setFuture(QFuture<PdfPageGeometry>());
+    m_oFormWatcher.setFuture(QFuture<PdfFormUpdate>());
+    if (m_pDocument)
+    {
+        m_pDocument->releaseAnnotationEditor(this);
+    }
+    m_pDocument.reset();
+}
+
+/*!
+ * @brief ĵ
+ *
+ * յǰҳ沢ʾռλ棬ĵӳ䡢ҳȾִ߳ϽС
+ */
+void PDFViewer::openDocument(const QString& pdfFilePath)
+{
+    m_oGeometryWatcher.cancel();
+    m_oGeometryWatcher.setFuture(QFuture<PdfPageGeometry>());
+    m_oFormWatcher.setFuture(QFuture<PdfFormUpdate>());
+    m_vecFormEvents.clear();
+    m_bFormFocused = false;
+    m_bFormPressed = false;
+    if (m_pDocument)
+    {
+        // δı༭ĵһ
+        m_pDocument->releaseAnnotationEditor(this);
+    }
+    m_pDocument.reset();
+    m_nPageCount = 0;
+    m_oPDFImage = QImage();
+    m_bImageStale = false;
+    m_oOverlay.clear();
+    m_oPageToImage.reset();
+    m_oPageSize = QSize();
+    m_nZoomPercent = 100;
+    m_oPageToDevice.reset();
+    m_oDeviceToPage.reset();
+    m_nHoveredAnnotation = -1;
+    m_nSelectedAnnotation = -1;
+    m_bDraggingAnnotation = false;
+    m_oLinks.clear();
+    m_nHoveredLink = -1;
+    m_nPressedLink = -1;
+    setCursor(Qt::ArrowCursor);
+    setToolTip(QString());
+
+    m_strFilePath = pdfFilePath;
+    m_strStatus = "Opening " + QFileInfo(pdfFilePath).fileName() + "...";
+    setFixedSize(kPlaceholderSize);
+    update();
+    m_eImageColorScheme = m_eColorScheme;
+    m_bImageGrayscale = m_bGrayscale;
+    m_oLoader.open(pdfFilePath, m_nPageIndex, m_eColorScheme, m_bGrayscale);
+}
+
+void PDFViewer::onFirstPageRendered(const QImage& image, const QTransform& pageToDevice)
+{
+    // ҳ 100% ȾӦʱʾʾٰȾȾ
+    m_oPDFImage = image;
+    m_nImageScalePercent = 100;
+    setPageGeometry(pageToDevice, image.size());
+    update();
+
+    if (m_pDocument)
+    {
+        RenderCache::instance().insert(pageKey(true), image);
+        if (!m_bActive)
+        {
+            setActive(false);
+        }
+        else if (m_eImageColorScheme != m_eColorScheme || m_bImageGrayscale != m_bGrayscale
+            || m_nImageScalePercent != m_nZoomPercent)
+        {
+            // 򿪹лɫҶãӦȵȾ 100%
+            refreshPage();
+        }
+    }
+
+    // עͼִ߳϶ȡǰҳȲעʾ
+    loadPageGeometry();
+}
+
+bool PDFViewer::setPageGeometry(const QTransform& pageToImage, const QSize& pageSize)
+{
+    m_oPageToImage = pageToImage;
+    m_oPageSize = pageSize;
+    return applyZoom();
+}
+
+/*!
+ * @brief Ӧȵø´ڴС任Ⱦ
+ *
+ *  100% λͼ갴ʾСŵõλͼͬı쵽ڣʼһ¡
+ * ȾıʱȡɼȾɵ÷ʱ¼Ⱦ
+ *
+ * @return ȾǷı
+ */
+bool PDFViewer::applyZoom()
+{
+    if (!m_oPageSize.isValid())
+    {
+        return false;
+    }
+    const double zoom = m_nFitWidth > 0 ? static_cast<double>(m_nFitWidth) / m_oPageSize.width() : 1.0;
+    const QSize displaySize(std::max(1, qRound(m_oPageSize.width() * zoom)),
+        std::max(1, qRound(m_oPageSize.height() * zoom)));
+    setFixedSize(displaySize);
+    m_oPageToDevice = m_oPageToImage * QTransform::fromScale(
+        static_cast<double>(displaySize.width()) / m_oPageSize.width(),
+        static_cast<double>(displaySize.height()) / m_oPageSize.height());
+    m_oDeviceToPage = m_oPageToDevice.inverted();
+    const double pixelsPerPoint = std::sqrt(std::abs(m_oPageToDevice.determinant()));
+    if (pixelsPerPoint > 0.0)
     {
-        FPDF_CloseDocument(m_pPDFDoc);
+        m_dHitTolerance = kHitTolerancePixels / pixelsPerPoint;
     }
-    FPDF_DestroyLibrary();
+
+    const int zoomPercent = std::min(kMaxZoomPercent,
+        std::max(kZoomBucketPercent, qRound(zoom * 100.0 / kZoomBucketPercent) * kZoomBucketPercent));
+    if (zoomPercent == m_nZoomPercent)
+    {
+        return false;
+    }
+    if (m_pDocument)
+    {
+        RenderScheduler::instance().cancel(pageKey(false));
+    }
+    m_nZoomPercent = zoomPercent;
+    return true;
+}
+
+/*!
+ * @brief ӦȵĿȡ
+ *
+ * ڴС仯ʱÿֻʾλͼƽֵȾı仯ƳٵСȶ
+ * kResizeSettleMs ֮󣻼δʱȾֱûеλͼ
+ */
+void PDFViewer::setFitWidth(const int width)
+{
+    if (width == m_nFitWidth)
+    {
+        return;
+    }
+    m_nFitWidth = std::max(0, width);
+    if (!m_oPageSize.isValid())
+    {
+        return;
+    }
+    applyZoom();
+    m_bResizing = true;
+    m_oResizeTimer.start(kResizeSettleMs, this);
+    update();
+}
+
+void PDFViewer::timerEvent(QTimerEvent* event)
+{
+    if (event->timerId() != m_oResizeTimer.timerId())
+    {
+        QWidget::timerEvent(event);
+        return;
+    }
+    m_oResizeTimer.stop();
+    m_bResizing = false;
+    if (m_pDocument && m_bActive && !m_oLoader.isLoading() && m_nImageScalePercent != m_nZoomPercent)
+    {
+        refreshPage();
+    }
+    update();
+}
+
+void PDFViewer::loadPageGeometry()
+{
+    const PdfDocumentPtr document = m_pDocument;
+    if (!document)
+    {
+        return;
+    }
+    const int pageIndex = m_nPageIndex;
+    m_oGeometryWatcher.setFuture(PdfiumExecutor::instance().run<PdfPageGeometry>(
+        [document, pageIndex](QFutureInterface<PdfPageGeometry>&)
+        {
+            PdfPageGeometry geometry;
+            geometry.nPage = pageIndex;
+            const FPDF_PAGE page = FPDF_LoadPage(document->handle(), pageIndex);
+            if (page)
+            {
+                PerfCounters::add(PerfOpenPages);
+                // עͼӲռע͵ĻơвԼӵͣתٷ PDFium
+                // еʱͬһ arena 䣬ʱһͷ
+                MonotonicArena scratch;
+                geometry.oOverlay.load(page, &scratch);
+                geometry.oLinks.load(document->handle(), page, &scratch);
+                geometry.oImageSize = QSize(std::max(1, static_cast<int>(FPDF_GetPageWidth(page))),
+                    std::max(1, static_cast<int>(FPDF_GetPageHeight(page))));
+                geometry.oPageToDevice = pageToDeviceTransform(page, 0, 0, geometry.oImageSize.width(),
+                    geometry.oImageSize.height(), 0);
+                FPDF_ClosePage(page);
+                PerfCounters::add(PerfOpenPages, -1);
+            }
+            return geometry;
+        }));
+}
+
+void PDFViewer::onPageGeometryLoaded()
+{
+    const QFuture<PdfPageGeometry> future = m_oGeometryWatcher.future();
+    if (future.resultCount() == 0 || future.result().nPage != m_nPageIndex)
+    {
+        return;
+    }
+    const PdfPageGeometry geometry = future.result();
+    if (!m_oOverlay.hasUnsavedEdits())
+    {
+        // ȡڼı༭ԱصӲΪ׼
+        const AnnotationOverlay previous = m_oOverlay;
+        m_oOverlay = geometry.oOverlay;
+        m_oOverlay.copySubtypeVisibility(previous);
+        if (!m_oOverlay.annotations().find(m_nHoveredAnnotation))
+        {
+            m_nHoveredAnnotation = -1;
+        }
+        if (!m_oOverlay.annotations().find(m_nSelectedAnnotation))
+        {
+            m_nSelectedAnnotation = -1;
+            m_bDraggingAnnotation = false;
+        }
+    }
+    m_oLinks = geometry.oLinks;
+    m_nHoveredLink = -1;
+    m_nPressedLink = -1;
+    if (geometry.oImageSize.isValid())
+    {
+        // лҳڴ˵õҳĴС任ҳͬ
+        // ӦʱҳȲͬıȾ𣬰¼
+        if (setPageGeometry(geometry.oPageToDevice, geometry.oImageSize) && m_bActive)
+        {
+            refreshPage();
+        }
+    }
+    update();
+}
+
+/*!
+ * @brief лһҳ
+ *
+ * ʾиҳλͼͷֱʱŴʾûлʱʾռλ棬
+ * ͬʱȫֱȾִ߳϶ȡҳע任
+ *
+ * @param pageIndex Ŀҳ±
+ * @return ʾĿҳڸҳʱ trueδлʱ false
+ */
+bool PDFViewer::showPage(const int pageIndex)
+{
+    if (!m_pDocument || m_oLoader.isLoading() || pageIndex < 0 || pageIndex >= m_nPageCount)
+    {
+        return false;
+    }
+    if (pageIndex == m_nPageIndex)
+    {
+        return true;
+    }
+    if (isSaving())
+    {
+        // ɺҪǰҳ¶ȡעͣڼڱҳ
+        QMessageBox::information(this, "Go to Page",
+            QStringLiteral("Page %1 cannot be shown until the annotations have been saved.").arg(pageIndex + 1));
+        return false;
+    }
+    // ༭ֻڵǰҳĵӲУ뿪ҳʧ
+    if (m_oOverlay.hasUnsavedEdits()
+        && QMessageBox::question(this, "Go to Page",
+            QStringLiteral("The annotation edits on page %1 have not been saved. Discard them and go to page %2?")
+                .arg(m_nPageIndex + 1).arg(pageIndex + 1),
+            QMessageBox::Discard | QMessageBox::Cancel, QMessageBox::Cancel) != QMessageBox::Discard)
+    {
+        return false;
+    }
+
+    RenderScheduler::instance().cancel(pageKey(false));
+    // δͳıھҳлҳʱύڱ
+    m_vecFormEvents.clear();
+    m_bFormFocused = false;
+    m_bFormPressed = false;
+    m_oOverlay.clear();
+    releaseAnnotationEditing();
+    m_nHoveredAnnotation = -1;
+    m_nSelectedAnnotation = -1;
+    m_bDraggingAnnotation = false;
+    m_oLinks.clear();
+    m_nHoveredLink = -1;
+    m_nPressedLink = -1;
+    setCursor(Qt::ArrowCursor);
+    setToolTip(QString());
+
+    m_nPageIndex = pageIndex;
+    m_oPDFImage = QImage();
+    m_bImageStale = false;
+    m_nImageScalePercent = 100;
+    m_strStatus = QStringLiteral("Rendering page %1...").arg(pageIndex + 1);
+    loadPageGeometry();
+    if (m_bActive)
+    {
+        refreshPage();
+    }
+    update();
+    return true;
+}
+
+quint64 PDFViewer::documentId() const
+{
+    return m_pDocument ? m_pDocument->id() : 0;
+}
+
+void PDFViewer::setActive(const bool active)
+{
+    m_bActive = active;
+    if (!m_pDocument)
+    {
+        return;
+    }
+
+    RenderCache& cache = RenderCache::instance();
+    if (!active)
+    {
+        // е̨ҳ治ҪȫֱȾδɵȡ
+        RenderScheduler::instance().cancel(pageKey(false));
+        // ȫֱλͼãֻͷֱʸ
+        cache.demoteDocument(m_pDocument->id());
+        int scalePercent = 0;
+        const QImage image = cache.findBest(m_pDocument->id(), m_nPageIndex, m_eColorScheme, m_bGrayscale,
+            &scalePercent);
+        if (!image.isNull())
+        {
+            m_oPDFImage = image;
+            m_nImageScalePercent = scalePercent;
+            m_eImageColorScheme = m_eColorScheme;
+            m_bImageGrayscale = m_bGrayscale;
+        }
+        return;
+    }
+
+    cache.setActiveDocument(m_pDocument->id());
+    refreshPage();
+}
+
+void PDFViewer::setColorScheme(const ColorScheme colorScheme)
+{
+    setRenderMode(colorScheme, m_bGrayscale);
+}
+
+void PDFViewer::setGrayscale(const bool grayscale)
+{
+    setRenderMode(m_eColorScheme, grayscale);
+}
+
+void PDFViewer::setRenderMode(const ColorScheme colorScheme, const bool grayscale)
+{
+    if (colorScheme == m_eColorScheme && grayscale == m_bGrayscale)
+    {
+        return;
+    }
+    if (m_pDocument)
+    {
+        RenderScheduler::instance().cancel(pageKey(false));
+    }
+    m_eColorScheme = colorScheme;
+    m_bGrayscale = grayscale;
+    if (!m_pDocument || m_oLoader.isLoading())
+    {
+        // ҳδҳ·Ⱦ
+        update();
+        return;
+    }
+    if (m_bActive)
+    {
+        refreshPage();
+    }
+    else
+    {
+        setActive(false);
+    }
+}
+
+void PDFViewer::refreshPage()
+{
+    // ȡǰȾλͼûʱȡλͼʾһȡͼֻһлδ
+    RenderCache& cache = RenderCache::instance();
+    int scalePercent = m_nZoomPercent;
+    const QImage image = cache.contains(pageKey(false)) ? cache.find(pageKey(false))
+        : cache.findBest(m_pDocument->id(), m_nPageIndex, m_eColorScheme, m_bGrayscale, &scalePercent);
+    if (!image.isNull())
+    {
+        // reloadPage ոҳĻ棬ʱеλͼĵ޸֮Ⱦ
+        m_oPDFImage = image;
+        m_nImageScalePercent = scalePercent;
+        m_eImageColorScheme = m_eColorScheme;
+        m_bImageGrayscale = m_bGrayscale;
+        m_bImageStale = false;
+        update();
+    }
+    if (m_nImageScalePercent != m_nZoomPercent || m_oPDFImage.isNull() || m_eImageColorScheme != m_eColorScheme
+        || m_bImageGrayscale != m_bGrayscale || m_bImageStale)
+    {
+        RenderRequest request;
+        request.pDocument = m_pDocument;
+        request.nPage = m_nPageIndex;
+        request.nScalePercent = m_nZoomPercent;
+        request.eColorScheme = m_eColorScheme;
+        request.bGrayscale = m_bGrayscale;
+        request.ePriority = RenderVisible;
+        RenderScheduler::instance().request(request);
+    }
+}
+
+RenderKey PDFViewer::pageKey(const bool image) const
+{
+    return image ? RenderKey(documentId(), m_nPageIndex, m_nImageScalePercent, m_eImageColorScheme, m_bImageGrayscale)
+        : RenderKey(documentId(), m_nPageIndex, m_nZoomPercent, m_eColorScheme, m_bGrayscale);
+}
+
+void PDFViewer::onPageRendered(const RenderKey& key, const QImage& image)
+{
+    if (m_bActive && m_pDocument && key == pageKey(false))
+    {
+        m_oPDFImage = image;
+        m_nImageScalePercent = m_nZoomPercent;
+        m_eImageColorScheme = m_eColorScheme;
+        m_bImageGrayscale = m_bGrayscale;
+        m_bImageStale = false;
+        update();
+    }
+}
+
+void PDFViewer::onLoadFailed(const QString& error)
+{
+    std::cerr << "Failed to open PDF file: " << m_strFilePath.toStdString() << ": " << error.toStdString() << '\n';
+    m_strStatus = "Failed to open " + QFileInfo(m_strFilePath).fileName() + ": " + error;
+    update();
 }
 
 void PDFViewer::paintEvent(QPaintEvent* event)
 {
+    // ƺʱ֡ʱ
+    PerfCounters::add(PerfFrames);
+    const PerfScopedTimer frameTimer(PerfFrameNanoseconds);
     QPainter painter(this);
-    if (!m_oPDFImage.isNull())
+    if (m_oPDFImage.isNull())
+    {
+        // ռλ
+        painter.fillRect(rect(), colorSchemeBackgroundColor(m_eColorScheme));
+        painter.setPen(colorSchemeForegroundColor(m_eColorScheme));
+        painter.drawText(rect().adjusted(16, 16, -16, -16), Qt::AlignCenter | Qt::TextWordWrap, m_strStatus);
+        return;
+    }
+    // ֻ¼ڵһλҳ棬֮ĻƲٽʱ
+    static bool s_bFirstPagePainted = false;
+    if (!s_bFirstPagePainted)
     {
-        painter.drawImage(0, 0, m_oPDFImage);
+        s_bFirstPagePainted = true;
+        StartupProfiler::instance().mark(StartupProfiler::FirstPagePainted);
+    }
+    if (m_oPDFImage.size() == size())
+    {
+        painter.drawImage(event->rect(), m_oPDFImage, event->rect());
+    }
+    else
+    {
+        // ͷֱʻλͼŴʾֱȫֱȾɣӦʱλͼʾš
+        // Сڼ䲻ƽֵҳҲܸÿһ֡
+        const double scaleX = static_cast<double>(m_oPDFImage.width()) / width();
+        const double scaleY = static_cast<double>(m_oPDFImage.height()) / height();
+        const QRectF source(event->rect().x() * scaleX, event->rect().y() * scaleY,
+            event->rect().width() * scaleX, event->rect().height() * scaleY);
+        painter.setRenderHint(QPainter::SmoothPixmapTransform, !m_bResizing);
+        painter.drawImage(QRectF(event->rect()), m_oPDFImage, source);
+    }
+
+    // ע͵Ӳ㣬ֻƱ¶ڵע
+    m_oOverlay.paint(painter, m_oPageToDevice, event->rect());
+
+    // ͣѡע͵
+    const int annotationIds[] = { m_nHoveredAnnotation, m_nSelectedAnnotation };
+    for (int i = 0; i < 2; ++i)
+    {
+        const AnnotationGeometry* geometry = m_oOverlay.annotations().find(annotationIds[i]);
+        if (!geometry)
+        {
+            continue;
+        }
+        const bool selected = annotationIds[i] == m_nSelectedAnnotation;
+        QPen pen(selected ? QColor(46, 80, 132) : QColor(62, 62, 62), selected ? 2 : 1,
+            selected ? Qt::SolidLine : Qt::DashLine);
+        painter.setPen(pen);
+        painter.setBrush(Qt::NoBrush);
+        painter.drawRect(m_oPageToDevice.mapRect(geometry->oBounds));
+    }
+}
+
+void PDFViewer::mouseMoveEvent(QMouseEvent* event)
+{
+    const QPointF pagePoint = m_oDeviceToPage.map(QPointF(event->pos()));
+    if (m_bDraggingAnnotation)
+    {
+        moveAnnotation(m_nSelectedAnnotation, pagePoint - m_oDragPagePosition);
+        m_oDragPagePosition = pagePoint;
+    }
+    else if (m_bFormPressed)
+    {
+        // ڱ϶ѡı
+        postFormEvent(PdfFormEvent::MouseMove, pagePoint, 0, fwlModifiers(event->modifiers()));
+    }
+    else
+    {
+        int annotationId = m_oOverlay.annotations().hitTest(pagePoint, m_dHitTolerance);
+        const int link = linkAt(pagePoint, annotationId);
+        if (link >= 0)
+        {
+            annotationId = -1;
+        }
+        setHoveredAnnotation(annotationId);
+        setHoveredLink(link);
+    }
+    QWidget::mouseMoveEvent(event);
+}
+
+void PDFViewer::mousePressEvent(QMouseEvent* event)
+{
+    if (event->button() == Qt::LeftButton)
+    {
+        const QPointF pagePoint = m_oDeviceToPage.map(QPointF(event->pos()));
+        int annotationId = m_oOverlay.annotations().hitTest(pagePoint, m_dHitTolerance);
+
+        // 򲻲ѡк϶нʱλҲȡ
+        const AnnotationGeometry* geometry = m_oOverlay.annotations().find(annotationId);
+        const bool formField = geometry && geometry->nSubtype == FPDF_ANNOT_WIDGET;
+        if (formField)
+        {
+            annotationId = -1;
+        }
+        if (formField || m_bFormFocused)
+        {
+            m_bFormPressed = true;
+            postFormEvent(PdfFormEvent::MouseDown, pagePoint, 0, fwlModifiers(event->modifiers()));
+        }
+
+        // Ӳѡк϶ɿʱת
+        m_nPressedLink = formField ? -1 : linkAt(pagePoint, annotationId);
+        if (m_nPressedLink >= 0)
+        {
+            annotationId = -1;
+        }
+
+        if (annotationId != m_nSelectedAnnotation)
+        {
+            const QRect dirty = annotationDeviceRect(m_nSelectedAnnotation).united(annotationDeviceRect(annotationId));
+            m_nSelectedAnnotation = annotationId;
+            update(dirty);
+        }
+
+        // סѡеעͼ϶ǩҳб༭Ȩʱֻѡв϶
+        // עͻҳλͼ϶ʱλͼ棬ֻѡв϶
+        m_bDraggingAnnotation = annotationId >= 0 && geometry && isOverlayAnnotationSubtype(geometry->nSubtype)
+            && claimAnnotationEditing();
+        m_oDragPagePosition = pagePoint;
+    }
+    QWidget::mousePressEvent(event);
+}
+
+void PDFViewer::mouseReleaseEvent(QMouseEvent* event)
+{
+    if (event->button() == Qt::LeftButton)
+    {
+        m_bDraggingAnnotation = false;
+        // ֻǵѡû϶ʱ༭Ȩ
+        releaseAnnotationEditing();
+        if (m_bFormPressed)
+        {
+            m_bFormPressed = false;
+            postFormEvent(PdfFormEvent::MouseUp, m_oDeviceToPage.map(QPointF(event->pos())), 0,
+                fwlModifiers(event->modifiers()));
+        }
+
+        const int pressedLink = m_nPressedLink;
+        m_nPressedLink = -1;
+        if (pressedLink >= 0
+            && m_oLinks.hitTest(m_oDeviceToPage.map(QPointF(event->pos())), m_dHitTolerance) == pressedLink)
+        {
+            activateLink(pressedLink);
+        }
+    }
+    QWidget::mouseReleaseEvent(event);
+}
+
+void PDFViewer::leaveEvent(QEvent* event)
+{
+    setHoveredAnnotation(-1);
+    setHoveredLink(-1);
+    QWidget::leaveEvent(event);
+}
+
+void PDFViewer::keyPressEvent(QKeyEvent* event)
+{
+    if (!m_bFormFocused)
+    {
+        QWidget::keyPressEvent(event);
+        return;
+    }
+
+    const int modifiers = fwlModifiers(event->modifiers());
+    const int key = fwlKeyCode(event->key());
+    if (key != 0)
+    {
+        postFormEvent(PdfFormEvent::KeyDown, QPointF(), key, modifiers);
+    }
+    // ַԼ˸񡢻سȿַ FORM_OnChar 
+    const QString text = event->text();
+    for (int i = 0; i < text.size(); ++i)
+    {
+        postFormEvent(PdfFormEvent::Char, QPointF(), text.at(i).unicode(), modifiers);
+    }
+    event->accept();
+}
+
+QRect PDFViewer::annotationDeviceRect(const int annotationId) const
+{
+    const AnnotationGeometry* geometry = m_oOverlay.annotations().find(annotationId);
+    if (!geometry)
+    {
+        return QRect();
+    }
+    return m_oPageToDevice.mapRect(m_oOverlay.paintBounds(annotationId)).toAlignedRect().adjusted(-3, -3, 3, 3);
+}
+
+void PDFViewer::updatePageRect(const QRectF& pageRect)
+{
+    if (!pageRect.isNull())
+    {
+        update(m_oPageToDevice.mapRect(pageRect).toAlignedRect().adjusted(-3, -3, 3, 3));
+    }
+}
+
+int PDFViewer::addAnnotation(const AnnotationGeometry& geometry)
+{
+    int annotationId = -1;
+    if (claimAnnotationEditing())
+    {
+        updatePageRect(m_oOverlay.addAnnotation(geometry, &annotationId));
+    }
+    return annotationId;
+}
+
+void PDFViewer::moveAnnotation(const int annotationId, const QPointF& pageOffset)
+{
+    if (claimAnnotationEditing())
+    {
+        updatePageRect(m_oOverlay.moveAnnotation(annotationId, pageOffset));
+    }
+}
+
+void PDFViewer::setAnnotationColor(const int annotationId, const QColor& color)
+{
+    if (claimAnnotationEditing())
+    {
+        updatePageRect(m_oOverlay.setAnnotationColor(annotationId, color));
+    }
+}
+
+void PDFViewer::removeAnnotation(const int annotationId)
+{
+    if (!claimAnnotationEditing())
+    {
+        return;
+    }
+    const QRect dirty = annotationDeviceRect(annotationId);
+    m_oOverlay.removeAnnotation(annotationId);
+    if (annotationId == m_nHoveredAnnotation)
+    {
+        setHoveredAnnotation(-1);
+    }
+    if (annotationId == m_nSelectedAnnotation)
+    {
+        m_nSelectedAnnotation = -1;
+        m_bDraggingAnnotation = false;
+    }
+    update(dirty);
+}
+
+/*!
+ * @brief ȡעͱ༭Ȩ
+ *
+ * ͬһļǩҳδı༭ڱʱǩҳı༭ڼʧЧ PDFium
+ * ע±꣬˾ܾ༭ʾûǸǩҳ档
+ */
+bool PDFViewer::claimAnnotationEditing()
+{
+    if (m_pDocument && m_pDocument->claimAnnotationEditor(this))
+    {
+        return true;
+    }
+    QToolTip::showText(QCursor::pos(), "Annotations of this file have unsaved edits in another tab. "
+        "Save them there first.", this);
+    return false;
+}
+
+void PDFViewer::releaseAnnotationEditing()
+{
+    if (m_pDocument && !m_oOverlay.hasUnsavedEdits() && !isSaving())
+    {
+        m_pDocument->releaseAnnotationEditor(this);
+    }
+}
+
+void PDFViewer::reloadPage()
+{
+    if (!m_pDocument || m_oLoader.isLoading())
+    {
+        return;
+    }
+    // ǰύȾѶȡ˾ɵעͣһȡ
+    RenderScheduler::instance().cancel(pageKey(false));
+    RenderCache::instance().removePage(m_pDocument->id(), m_nPageIndex);
+    m_bImageStale = !m_oPDFImage.isNull();
+    if (m_bActive)
+    {
+        refreshPage();
+    }
+}
+
+void PDFViewer::reloadAnnotations()
+{
+    if (m_pDocument && !m_oLoader.isLoading() && !m_oOverlay.hasUnsavedEdits())
+    {
+        loadPageGeometry();
+    }
+}
+
+void PDFViewer::setAnnotationTypeVisible(const int subtype, const bool visible)
+{
+    updatePageRect(m_oOverlay.setSubtypeVisible(subtype, visible));
+}
+
+void PDFViewer::postFormEvent(const PdfFormEvent::Type type, const QPointF& pagePoint, const int key,
+    const int modifiers)
+{
+    // ѹƶֻһλ
+    if (type == PdfFormEvent::MouseMove && !m_vecFormEvents.isEmpty()
+        && m_vecFormEvents.last().eType == PdfFormEvent::MouseMove)
+    {
+        m_vecFormEvents.last().oPagePoint = pagePoint;
+        return;
+    }
+
+    PdfFormEvent formEvent;
+    formEvent.eType = type;
+    formEvent.oPagePoint = pagePoint;
+    formEvent.nKey = key;
+    formEvent.nModifiers = modifiers;
+    m_vecFormEvents.append(formEvent);
+    flushFormEvents();
+}
+
+/*!
+ * @brief Ŷӵıִ̡߳
+ *
+ * ͬһʱֻһִУִڼ䵽ŶӣɺϲΪһ
+ * ˿ʱȾζǰ
+ */
+void PDFViewer::flushFormEvents()
+{
+    if (m_vecFormEvents.isEmpty() || m_oFormWatcher.isRunning() || !m_pDocument)
+    {
+        return;
+    }
+
+    const PdfDocumentPtr document = m_pDocument;
+    const int pageIndex = m_nPageIndex;
+    const QVector<PdfFormEvent> events = m_vecFormEvents;
+    // С鰴ǰλͼķֱȾλͼǵǰȾʱ
+    const QSize imageSize = m_oPDFImage.isNull() || !m_oPageSize.isValid() ? size() : m_oPDFImage.size();
+    const QTransform pageToDevice = m_oPageSize.isValid()
+        ? m_oPageToImage * QTransform::fromScale(static_cast<double>(imageSize.width()) / m_oPageSize.width(),
+            static_cast<double>(imageSize.height()) / m_oPageSize.height())
+        : m_oPageToDevice;
+    const ColorScheme colorScheme = m_eImageColorScheme;
+    const bool grayscale = m_bImageGrayscale;
+    m_vecFormEvents.clear();
+
+    m_oFormWatcher.setFuture(PdfiumExecutor::instance().run<PdfFormUpdate>(
+        [document, pageIndex, events, pageToDevice, imageSize, colorScheme, grayscale](
+            QFutureInterface<PdfFormUpdate>&)
+        {
+            PdfFormEnvironment* forms = document->forms();
+            return forms ? forms->handleEvents(pageIndex, events, pageToDevice, imageSize, colorScheme, grayscale)
+                : PdfFormUpdate();
+        }));
+}
+
+/*!
+ * @brief ػСҳλͼͻ棬ֻػЩ
+ *
+ * ʾǵͷֱλͼʱͼȴеȫֱȾѰ״̬
+ */
+void PDFViewer::onFormUpdated()
+{
+    const QFuture<PdfFormUpdate> future = m_oFormWatcher.future();
+    if (future.resultCount() > 0 && m_pDocument)
+    {
+        const PdfFormUpdate formUpdate = future.result();
+        m_bFormFocused = formUpdate.bFocused;
+        if (formUpdate.nPage == m_nPageIndex && m_nImageScalePercent == m_nZoomPercent && !m_oPDFImage.isNull()
+            && formUpdate.eColorScheme == m_eImageColorScheme && formUpdate.bGrayscale == m_bImageGrayscale
+            && !formUpdate.vecPatches.isEmpty())
+        {
+            for (int i = 0; i < formUpdate.vecPatches.size(); ++i)
+            {
+                pastePatch(m_oPDFImage, formUpdate.vecPatches[i]);
+            }
+            RenderCache::instance().insert(pageKey(true), m_oPDFImage);
+            const QTransform imageToDevice = QTransform::fromScale(static_cast<double>(width()) / m_oPDFImage.width(),
+                static_cast<double>(height()) / m_oPDFImage.height());
+            for (int i = 0; i < formUpdate.vecPatches.size(); ++i)
+            {
+                update(imageToDevice.mapRect(QRectF(formUpdate.vecPatches[i].oDeviceRect)).toAlignedRect());
+            }
+        }
+    }
+    flushFormEvents();
+}
+
+/*!
+ * @brief עͱ༭
+ *
+ * ༭¼ GUI ߳ȡ󽻸ִ߳д PDFium ʽGUI ̲߳ȴд롣
+ * ԭλֻ׷֣д༭ģȣΪдʱļԭ滻
+ */
+bool PDFViewer::saveAnnotations(const QString& targetPath)
+{
+    if (!m_pDocument || isSaving())
+    {
+        return false;
+    }
+
+    const PdfDocumentPtr document = m_pDocument;
+    const int pageIndex = m_nPageIndex;
+    const AnnotationEdits edits = m_oOverlay.takeEdits();
+    if (m_bFormFocused)
+    {
+        // ύڵıػñȥ
+        postFormEvent(PdfFormEvent::KillFocus);
+    }
+    const bool inPlace = targetPath.isEmpty() || QFileInfo(targetPath) == QFileInfo(document->filePath());
+    const QString path = inPlace ? document->filePath() : targetPath;
+    const qint64 baseSize = document->fileSize();
+
+    m_oSaveWatcher.setFuture(PdfiumExecutor::instance().run<PdfSaveResult>(
+        [document, pageIndex, edits, inPlace, path, baseSize](QFutureInterface<PdfSaveResult>& future)
+        {
+            // ıύֵŻдĵ
+            if (PdfFormEnvironment* forms = document->forms())
+            {
+                forms->commit();
+            }
+
+            int skipped = 0;
+            if (!edits.isEmpty())
+            {
+                const FPDF_PAGE page = FPDF_LoadPage(document->handle(), pageIndex);
+                PerfCounters::add(PerfOpenPages, page ? 1 : 0);
+                skipped = page ? PdfDocumentSaver::applyAnnotationEdits(page, edits) : 1;
+                if (page)
+                {
+                    FPDF_ClosePage(page);
+                    PerfCounters::add(PerfOpenPages, -1);
+                }
+            }
+
+            PdfSaveResult result = inPlace ? PdfDocumentSaver::saveInPlace(document->handle(), path, baseSize, future)
+                : PdfDocumentSaver::saveAs(document->handle(), path, future);
+            result.nSkippedEdits = skipped;
+            return result;
+        }));
+    return true;
+}
+
+bool PDFViewer::isSaving() const
+{
+    return m_oSaveWatcher.isRunning();
+}
+
+void PDFViewer::onSaveFinished()
+{
+    const QFuture<PdfSaveResult> future = m_oSaveWatcher.future();
+    if (future.resultCount() == 0)
+    {
+        releaseAnnotationEditing();
+        emit saveFinished(false, 0, "Save canceled");
+        return;
+    }
+
+    // ༭дĵû±༭ʱ༭Ȩǩҳ¶ȡעͼɱ༭
+    releaseAnnotationEditing();
+    const PdfSaveResult result = future.result();
+    emit saveFinished(result.bSucceeded, result.nSkippedEdits, result.strError);
+}
+
+// лͣעֻͣػ¾ע
+void PDFViewer::setHoveredAnnotation(const int annotationId)
+{
+    if (annotationId == m_nHoveredAnnotation)
+    {
+        return;
+    }
+
+    const QRect dirty = annotationDeviceRect(m_nHoveredAnnotation).united(annotationDeviceRect(annotationId));
+    m_nHoveredAnnotation = annotationId;
+    setCursor(annotationId >= 0 ? Qt::PointingHandCursor : Qt::ArrowCursor);
+
+    const AnnotationGeometry* geometry = m_oOverlay.annotations().find(annotationId);
+    setToolTip(geometry ? geometry->strContents : QString());
+    update(dirty);
+}
+
+int PDFViewer::linkAt(const QPointF& pagePoint, const int annotationId) const
+{
+    const AnnotationGeometry* geometry = m_oOverlay.annotations().find(annotationId);
+    if (geometry && geometry->nSubtype != FPDF_ANNOT_LINK)
+    {
+        return -1;
+    }
+    return m_oLinks.hitTest(pagePoint, m_dHitTolerance);
+}
+
+/*!
+ * @brief лͣӡ
+ *
+ * ʾԤȽĿꡣҳתĿҳԤȡȼǰȾ
+ * ʱ `showPage()` ֱӴӻȡȫֱλͼ
+ */
+void PDFViewer::setHoveredLink(const int link)
+{
+    if (link == m_nHoveredLink)
+    {
+        return;
+    }
+    m_nHoveredLink = link;
+
+    const PdfLink* target = m_oLinks.link(link);
+    if (!target)
+    {
+        // 뿪ʱעϣʾע;
+        if (m_nHoveredAnnotation < 0)
+        {
+            setCursor(Qt::ArrowCursor);
+            setToolTip(QString());
+        }
+        return;
+    }
+
+    setCursor(Qt::PointingHandCursor);
+    if (target->eType == PdfLink::OpenUri)
+    {
+        setToolTip(target->strUri);
+        return;
+    }
+    setToolTip(QStringLiteral("Go to page %1").arg(target->nTargetPage + 1));
+    if (m_pDocument && target->nTargetPage != m_nPageIndex)
+    {
+        RenderRequest request;
+        request.pDocument = m_pDocument;
+        request.nPage = target->nTargetPage;
+        request.nScalePercent = m_nZoomPercent;
+        request.eColorScheme = m_eColorScheme;
+        request.bGrayscale = m_bGrayscale;
+        request.ePriority = RenderPrefetch;
+        RenderScheduler::instance().request(request);
+    }
+}
+
+void PDFViewer::activateLink(const int link)
+{
+    const PdfLink* target = m_oLinks.link(link);
+    if (!target)
+    {
+        return;
+    }
+    if (target->eType == PdfLink::OpenUri)
+    {
+        // ĵṩַţֻҳʼӣЭԲ֪û
+        const QUrl url(target->strUri, QUrl::TolerantMode);
+        if (url.isValid() && isSafeLinkScheme(url))
+        {
+            QDesktopServices::openUrl(url);
+        }
+        else
+        {
+            QMessageBox::warning(this, "Link", "This link was not opened because only http, https and mailto "
+                "links are allowed:\n" + target->strUri);
+        }
+        return;
     }
+    // Ŀҳ± FPDFDest_GetDestPageIndex ĵҳΧ
+    showPage(target->nTargetPage);
 }
@@ -2,26 +2,227 @@
 #define PDF_VIEWER_H
 
 #include <QWidget>
+#include <QBasicTimer>
 #include <QImage>
+#include <QTransform>
+#include <QFutureWatcher>
 #include "fpdfview.h"
+#include "annotation_overlay.h"
+#include "pdf_document_loader.h"
+#include "pdf_document_saver.h"
+#include "pdf_form.h"
+#include "pdf_links.h"
+#include "render_cache.h"
+
+// ִ߳϶ȡһҳע͡任
+struct PdfPageGeometry
+{
+    int nPage;
+    AnnotationOverlay oOverlay;
+    PdfLinkIndex oLinks;              // ѽĿ
+    QTransform oPageToDevice;         // ȫֱλͼҳ굽λͼ
+    QSize oImageSize;                 // ȫֱλͼĴС
+
+    PdfPageGeometry() : nPage(-1) {}
+};
 
 // PDFViewer ࣬ʾ PDF ļ
 class PDFViewer : public QWidget {
+    Q_OBJECT
+
 public:
-    explicit PDFViewer(const QString& pdfFilePath, QWidget* parent = nullptr);
+    // أĵ PDFium ִ߳첽򿪣ҳǰʾռλ
+    explicit PDFViewer(const QString& pdfFilePath = QString(), QWidget* parent = nullptr);
     ~PDFViewer() override;
 
+    // һĵеĴȡ
+    void openDocument(const QString& pdfFilePath);
+
+    PdfDocumentLoader* loader()
+    {
+        return &m_oLoader;
+    }
+
+    const QString& filePath() const
+    {
+        return m_strFilePath;
+    }
+
+    // ĵţĵδʱΪ 0
+    quint64 documentId() const;
+
+    // ñɺã֮ǰΪ
+    PdfDocumentPtr document() const
+    {
+        return m_pDocument;
+    }
+
+    int pageIndex() const
+    {
+        return m_nPageIndex;
+    }
+
+    // ĵҳҳδʱΪ 0
+    int pageCount() const
+    {
+        return m_nPageCount;
+    }
+
+    // лһҳиҳʱʾȾע任ִ߳϶ȡ
+    // ǰҳδı༭ʱѯǷڱʱʾȴڸҳʱκ² true
+    // ҳδҳԽ硢ڱ༭ȡδлʱ false
+    bool showPage(int pageIndex);
+
+    // ǩҳлʱãǰ̨ʾλͼȫֱȾ
+    // ֻ̨ͷֱλͼ黹ڴ
+    void setActive(bool active);
+    bool isActive() const
+    {
+        return m_bActive;
+    }
+
+    // лɫ÷λͼڻʱʾʾǰλͼֱ·Ⱦ
+    void setColorScheme(ColorScheme colorScheme);
+    ColorScheme colorScheme() const
+    {
+        return m_eColorScheme;
+    }
+
+    //  8 λҶȾҳ棬λͼڴΪɫķ֮һлɫͬ
+    void setGrayscale(bool grayscale);
+    bool isGrayscale() const
+    {
+        return m_bGrayscale;
+    }
+
+    // Ӧȣҳŵʾ0 ʾ 100% ʾã϶ڱԵʱ
+    // λͼֹͣȾ仯˲Ⱦ
+    void setFitWidth(int width);
+    int fitWidth() const
+    {
+        return m_nFitWidth;
+    }
+
     PDFViewer(const PDFViewer&) = delete;
     PDFViewer& operator=(const PDFViewer&) = delete;
     PDFViewer(PDFViewer&&) = delete;
     PDFViewer&& operator=(PDFViewer&&) = delete;
 
+    // עͱ༭ֻػӰ򣬲Ⱦҳ
+    int addAnnotation(const AnnotationGeometry& geometry);
+    void moveAnnotation(int annotationId, const QPointF& pageOffset);
+    void setAnnotationColor(int annotationId, const QColor& color);
+    void removeAnnotation(int annotationId);
+    void setAnnotationTypeVisible(int subtype, bool visible);
+
+    //  PDFium ִ߳ϱעͱ༭targetPath Ϊʱԭλ棬Ϊ
+    // бʱ falseɺ󷢳 saveFinished
+    bool saveAnnotations(const QString& targetPath = QString());
+    bool isSaving() const;
+    // ǰҳǷδעͱ༭
+    bool hasUnsavedEdits() const
+    {
+        return m_oOverlay.hasUnsavedEdits();
+    }
+
+    // ¶ȡǰҳעͬ͡һĵıǩҳ PDFium ע±仯ɹã
+    // δı༭ʱ¶ȡʱ鿴б༭Ȩ±Լά
+    void reloadAnnotations();
+
+    // ǰҳȫżĻλͼȾλͼǰʾλͼ
+    // עдĵɹãɾͼ¡עͻҳλͼ
+    void reloadPage();
+
+signals:
+    // skippedEdits Ϊδдĵעͱ༭ȡʧʱ succeeded Ϊ falseerror Ϊԭ
+    void saveFinished(bool succeeded, int skippedEdits, const QString& error);
+
 protected:
     void paintEvent(QPaintEvent* event) override;
+    void mouseMoveEvent(QMouseEvent* event) override;
+    void mousePressEvent(QMouseEvent* event) override;
+    void mouseReleaseEvent(QMouseEvent* event) override;
+    void leaveEvent(QEvent* event) override;
+    void keyPressEvent(QKeyEvent* event) override;
+    void timerEvent(QTimerEvent* event) override;
+
+private slots:
+    void onSaveFinished();
+    void onFirstPageRendered(const QImage& image, const QTransform& pageToDevice);
+    void onPageGeometryLoaded();
+    void onLoadFailed(const QString& error);
+    void onPageRendered(const RenderKey& key, const QImage& image);
+    void onFormUpdated();
 
 private:
-    FPDF_DOCUMENT m_pPDFDoc;
+    // עڴе򣬰ߵ
+    QRect annotationDeviceRect(int annotationId) const;
+    void setHoveredAnnotation(int annotationId);
+    // µӣûлעסʱ -1עͱӴ
+    int linkAt(const QPointF& pagePoint, int annotationId) const;
+    // лͣӣͬʱԤȡҳתĿҳ
+    void setHoveredLink(int link);
+    void activateLink(int link);
+    void updatePageRect(const QRectF& pageRect); // ػҳ
+
+    // ʾеǰɫҶλͼȫֱʱȾ
+    void refreshPage();
+    void loadPageGeometry();          // ִ߳϶ȡǰҳע͡任
+    bool claimAnnotationEditing();    // ȡùĵעͱ༭Ȩʧʱڹ괦ʾ
+    void releaseAnnotationEditing();  // ûδı༭Ҳڱʱ༭Ȩ
+    // õǰҳ 100% λͼ任Сʾ´ڣȾǷı
+    bool setPageGeometry(const QTransform& pageToImage, const QSize& pageSize);
+    bool applyZoom();
+    void setRenderMode(ColorScheme colorScheme, bool grayscale);
+
+    // ǰҳȫֱλͼĻimage Ϊʱȡ m_oPDFImage ȾȡҪȾ
+    RenderKey pageKey(bool image) const;
+
+    //  GUI ߳Ŷӣһɺִ߳
+    void postFormEvent(PdfFormEvent::Type type, const QPointF& pagePoint = QPointF(), int key = 0,
+        int modifiers = 0);
+    void flushFormEvents();
+
+    PdfDocumentLoader m_oLoader;
+    PdfDocumentPtr m_pDocument;       // ҳ
     QImage m_oPDFImage;
+    QString m_strFilePath;            // ĵ·
+    QString m_strStatus;              // ռλʾ״̬
+    int m_nPageIndex;                 // ǰҳ±
+    int m_nPageCount;                 // ĵҳҳδ֪ʱΪ 0
+    int m_nImageScalePercent;         // m_oPDFImage Ⱦ m_nZoomPercent ͬʱʾ
+    int m_nZoomPercent;               // Ⱦʾ 5% ȡ𲻱ʱȾ
+    int m_nFitWidth;                  // ӦȵĿȣ0 ʾ 100% ʾ
+    bool m_bResizing;                 // ʾСʾʱƽֵ
+    QBasicTimer m_oResizeTimer;       // ֹٰͣµȾȾ
+    ColorScheme m_eColorScheme;       // Ҫɫ
+    ColorScheme m_eImageColorScheme;  // m_oPDFImage ɫ m_eColorScheme ͬʱȴȾ
+    bool m_bGrayscale;                // ҪԻҶȾ
+    bool m_bImageGrayscale;           // m_oPDFImage ǷԻҶȾ
+    bool m_bImageStale;               // m_oPDFImage Ⱦĵ޸֮ǰȴȾ
+    bool m_bActive;                   // ǷΪǰǩҳ
+    QFutureWatcher<PdfSaveResult> m_oSaveWatcher;
+    QFutureWatcher<PdfPageGeometry> m_oGeometryWatcher;
+
+    AnnotationOverlay m_oOverlay;     // ǰҳעʸӲ
+    QTransform m_oPageToImage;        // ҳ굽 100% λͼ
+    QSize m_oPageSize;                // ǰҳ 100% λͼĴСҳǰЧ
+    QTransform m_oPageToDevice;       // ҳ굽
+    QTransform m_oDeviceToPage;       // 굽ҳ
+    double m_dHitTolerance;           // ݲλΪ PDF 
+    int m_nHoveredAnnotation;         // ͣע idΪ -1
+    int m_nSelectedAnnotation;        // ѡеע idΪ -1
+    bool m_bDraggingAnnotation;       // Ƿ϶ѡеע
+    QPointF m_oDragPagePosition;      // һ϶λãҳ
+
+    PdfLinkIndex m_oLinks;            // ǰҳӣֻͣѯ
+    int m_nHoveredLink;               // ͣ±꣬Ϊ -1
+    int m_nPressedLink;               // ʱڵ±꣬ͬһɿʱת
+
+    QFutureWatcher<PdfFormUpdate> m_oFormWatcher;
+    QVector<PdfFormEvent> m_vecFormEvents; // ȴ̵ִ߳ı
+    bool m_bFormFocused;              // Ƿбн㣬ʱ
+    bool m_bFormPressed;              // Ƿڱϰ£ڼƶ
 };
 
 #endif // PDF_VIEWER_H
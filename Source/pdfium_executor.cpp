@@ -0,0 +1,79 @@
+﻿/*!
+ * @brief PDFium 专用执行线程的实现。
+ *
+ * @author LiuYe
+ * @date 2026-10-19
+ * @copyright (c) 2013-2026 Honghu Yuntu Corporation
+ */
+
+#include "pdfium_executor.h"
+
+#include "perf_counters.h"
+
+PdfiumExecutor& PdfiumExecutor::instance()
+{
+    static PdfiumExecutor executor;
+    return executor;
+}
+
+PdfiumExecutor::PdfiumExecutor()
+    : m_bStopping(false)
+{
+    m_oThread = std::thread(&PdfiumExecutor::threadMain, this);
+}
+
+PdfiumExecutor::~PdfiumExecutor()
+{
+    shutdown();
+}
+
+void PdfiumExecutor::post(const std::function<void()>& task)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_oMutex);
+        if (m_bStopping)
+        {
+            return;
+        }
+        m_queTasks.push_back(task);
+    }
+    m_oCondition.notify_one();
+}
+
+bool PdfiumExecutor::isExecutorThread() const
+{
+    return std::this_thread::get_id() == m_oThread.get_id();
+}
+
+void PdfiumExecutor::shutdown()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_oMutex);
+        m_bStopping = true;
+    }
+    m_oCondition.notify_all();
+    if (m_oThread.joinable() && !isExecutorThread())
+    {
+        m_oThread.join();
+    }
+}
+
+void PdfiumExecutor::threadMain()
+{
+    for (;;)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_oMutex);
+            m_oCondition.wait(lock, [this]() { return m_bStopping || !m_queTasks.empty(); });
+            if (m_queTasks.empty())
+            {
+                return;
+            }
+            task = m_queTasks.front();
+            m_queTasks.pop_front();
+        }
+        PerfScopedTimer busy(PerfPdfiumBusyNanoseconds);
+        task();
+    }
+}
@@ -0,0 +1,106 @@
+﻿/*!
+ * @brief PDFium 专用执行线程。
+ *
+ * PDFium 不是线程安全的，所有对同一库实例的调用必须串行执行。`PdfiumExecutor` 提供一个进程内
+ * 唯一的后台线程，按提交顺序执行 PDFium 相关任务；任务结果以 QFuture 返回，GUI 线程通过
+ * QFutureWatcher 接收完成通知、进度和取消，不会被 PDFium 调用阻塞。
+ *
+ * @author LiuYe
+ * @date 2026-10-19
+ * @copyright (c) 2013-2026 Honghu Yuntu Corporation
+ */
+
+#pragma once
+
+#include <QFuture>
+#include <QFutureInterface>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+/*!
+ * @brief 串行执行 PDFium 调用的单线程执行器。
+ *
+ * `post()` 提交无返回值的任务；`run<T>()` 提交带 QFutureInterface 的任务并返回 QFuture，
+ * 任务内部可以报告进度，并通过 `isCanceled()` 响应调用方的取消请求。
+ *
+ * @date 2026.10.19
+ */
+class PdfiumExecutor
+{
+public:
+    static PdfiumExecutor& instance();
+
+    // 提交任务，按提交顺序执行
+    void post(const std::function<void()>& task);
+
+    // 提交任务并返回 QFuture；任务签名为 T(QFutureInterface<T>&)
+    template <typename T, typename Task>
+    QFuture<T> run(Task task);
+
+    // 提交分阶段汇报结果的任务；任务签名为 void(QFutureInterface<T>&)，自行调用 reportResult，
+    // 调用方通过 QFutureWatcher::resultReadyAt 逐个接收
+    template <typename T, typename Task>
+    QFuture<T> runWithResults(Task task);
+
+    // 当前线程是否为执行线程
+    bool isExecutorThread() const;
+
+    // 执行完已提交的任务后停止执行线程，此后提交的任务被丢弃；应在 QApplication 析构前调用
+    void shutdown();
+
+    PdfiumExecutor(const PdfiumExecutor&) = delete;
+    PdfiumExecutor& operator=(const PdfiumExecutor&) = delete;
+
+private:
+    PdfiumExecutor();
+    ~PdfiumExecutor();
+
+    void threadMain();
+
+    std::thread m_oThread;
+    std::mutex m_oMutex;
+    std::condition_variable m_oCondition;
+    std::deque<std::function<void()>> m_queTasks;
+    bool m_bStopping;
+};
+
+template <typename T, typename Task>
+QFuture<T> PdfiumExecutor::run(Task task)
+{
+    QFutureInterface<T> futureInterface;
+    futureInterface.reportStarted();
+    const QFuture<T> future = futureInterface.future();
+
+    post([futureInterface, task]() mutable
+        {
+            if (!futureInterface.isCanceled())
+            {
+                const T result = task(futureInterface);
+                futureInterface.reportResult(result);
+            }
+            futureInterface.reportFinished();
+        });
+    return future;
+}
+
+template <typename T, typename Task>
+QFuture<T> PdfiumExecutor::runWithResults(Task task)
+{
+    QFutureInterface<T> futureInterface;
+    futureInterface.reportStarted();
+    const QFuture<T> future = futureInterface.future();
+
+    post([futureInterface, task]() mutable
+        {
+            if (!futureInterface.isCanceled())
+            {
+                task(futureInterface);
+            }
+            futureInterface.reportFinished();
+        });
+    return future;
+}
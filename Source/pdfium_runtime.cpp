@@ -0,0 +1,90 @@
+﻿/*!
+ * @brief 进程级 PDFium 运行时的实现。
+ *
+ * @author LiuYe
+ * @date 2026-10-19
+ * @copyright (c) 2013-2026 Honghu Yuntu Corporation
+ */
+
+#include "pdfium_runtime.h"
+
+#include "pdfium_executor.h"
+#include "pdfium_utils.h"
+
+namespace
+{
+    // 在执行线程上调用；已在执行线程上时直接调用，保证先于随后投递的任务执行
+    void runOnExecutor(void (*pFunction)())
+    {
+        PdfiumExecutor& executor = PdfiumExecutor::instance();
+        if (executor.isExecutorThread())
+        {
+            pFunction();
+            return;
+        }
+        executor.post(pFunction);
+    }
+
+    void destroyPdfium()
+    {
+        FPDF_DestroyLibrary();
+    }
+}
+
+PdfiumRuntime& PdfiumRuntime::instance()
+{
+    static PdfiumRuntime runtime;
+    return runtime;
+}
+
+PdfiumRuntime::PdfiumRuntime()
+    : m_nRefCount(0), m_bInitialized(false), m_bShutdownRequested(false)
+{
+}
+
+void PdfiumRuntime::acquire()
+{
+    std::lock_guard<std::mutex> lock(m_oMutex);
+    ++m_nRefCount;
+    if (!m_bInitialized && !m_bShutdownRequested)
+    {
+        m_bInitialized = true;
+        runOnExecutor(initializePdFium);
+    }
+}
+
+void PdfiumRuntime::release()
+{
+    std::lock_guard<std::mutex> lock(m_oMutex);
+    if (--m_nRefCount == 0 && m_bShutdownRequested)
+    {
+        destroyLibrary();
+    }
+}
+
+void PdfiumRuntime::shutdown()
+{
+    std::lock_guard<std::mutex> lock(m_oMutex);
+    m_bShutdownRequested = true;
+    if (m_nRefCount == 0)
+    {
+        destroyLibrary();
+    }
+}
+
+int PdfiumRuntime::refCount() const
+{
+    std::lock_guard<std::mutex> lock(m_oMutex);
+    return m_nRefCount;
+}
+
+// 调用方持有 m_oMutex
+void PdfiumRuntime::destroyLibrary()
+{
+    if (!m_bInitialized)
+    {
+        return;
+    }
+    m_bInitialized = false;
+    runOnExecutor(destroyPdfium);
+}
@@ -0,0 +1,69 @@
+﻿/*!
+ * @brief 进程级 PDFium 运行时。
+ *
+ * PDFium 库在整个进程中只初始化一次：第一个使用者登记时在执行线程上调用 `initializePdFium()`，
+ * 之后即使所有文档都已关闭也不销毁，打开新文档无需重新初始化，字体与编解码缓存得以保留。
+ * 进程退出前调用 `shutdown()`，待最后一个使用者释放后在执行线程上调用 `FPDF_DestroyLibrary()`。
+ *
+ * @author LiuYe
+ * @date 2026-10-19
+ * @copyright (c) 2013-2026 Honghu Yuntu Corporation
+ */
+
+#pragma once
+
+#include <mutex>
+
+/*!
+ * @brief 引用计数的 PDFium 库生命周期管理。
+ *
+ * 使用者通过 `PdfiumRuntimeRef` 登记，登记期间保证库已初始化且不会被销毁。
+ *
+ * @date 2026.10.19
+ */
+class PdfiumRuntime
+{
+public:
+    static PdfiumRuntime& instance();
+
+    void acquire();
+    void release();
+
+    // 请求销毁库；仍有使用者时推迟到最后一个使用者释放
+    void shutdown();
+
+    int refCount() const;
+
+    PdfiumRuntime(const PdfiumRuntime&) = delete;
+    PdfiumRuntime& operator=(const PdfiumRuntime&) = delete;
+
+private:
+    PdfiumRuntime();
+
+    void destroyLibrary();
+
+    mutable std::mutex m_oMutex;
+    int m_nRefCount;
+    bool m_bInitialized;
+    bool m_bShutdownRequested;
+};
+
+/*!
+ * @brief 在作用域内持有一次 PdfiumRuntime 登记。
+ */
+class PdfiumRuntimeRef
+{
+public:
+    PdfiumRuntimeRef()
+    {
+        PdfiumRuntime::instance().acquire();
+    }
+
+    ~PdfiumRuntimeRef()
+    {
+        PdfiumRuntime::instance().release();
+    }
+
+    PdfiumRuntimeRef(const PdfiumRuntimeRef&) = delete;
+    PdfiumRuntimeRef& operator=(const PdfiumRuntimeRef&) = delete;
+};
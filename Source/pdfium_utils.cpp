@@ -1,4 +1,26 @@
 #include "pdfium_utils.h"
+#include "fpdf_annot.h"
+#include "fpdf_progressive.h"
+#include "scanned_page.h"
+#include "startup_profiler.h"
+#include "system_font_index.h"
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    FPDF_BOOL neverPause(IFSDK_PAUSE*)
+    {
+        return false;
+    }
+
+    // Ҫ PDFium עͣ FPDF_FFLDraw ƣ뵯ڲʾ
+    bool isAppearanceAnnotationSubtype(const int subtype)
+    {
+        return !isOverlayAnnotationSubtype(subtype) && subtype != FPDF_ANNOT_WIDGET && subtype != FPDF_ANNOT_LINK
+            && subtype != FPDF_ANNOT_POPUP;
+    }
+}
 
 // ʼ PDFium
 void initializePdFium()
@@ -9,28 +31,162 @@ void initializePdFium()
     config.m_pIsolate = nullptr;
     config.m_v8EmbedderSlot = 0;
     FPDF_InitLibraryWithConfig(&config);
+
+#ifndef Q_OS_WIN
+    // Ԥ PDFium ÿɨĿ¼ʱĬϲ
+    SystemFontIndex& fontIndex = SystemFontIndex::instance();
+    if (fontIndex.open())
+    {
+        FPDF_SetSystemFontInfo(fontIndex.fontInfo());
+    }
+#endif
+    StartupProfiler::instance().mark(StartupProfiler::PdfiumInitialized);
 }
 
 //  PDFium λͼתΪ QImage
-QImage pdfiumBitmapToQImage(const FPDF_BITMAP bitmap)
+QImage pdfiumBitmapToQImage(const FPDF_BITMAP bitmap, const bool detectGray)
 {
     const int width = FPDFBitmap_GetWidth(bitmap);
     const int height = FPDFBitmap_GetHeight(bitmap);
+    const int stride = FPDFBitmap_GetStride(bitmap);
     void* buffer = FPDFBitmap_GetBuffer(bitmap);
 
-    const QImage image(static_cast<uchar*>(buffer), width, height, QImage::Format_RGB32);
-    return image.rgbSwapped();
+    if (FPDFBitmap_GetFormat(bitmap) == FPDFBitmap_Gray)
+    {
+        const QImage image(static_cast<uchar*>(buffer), width, height, stride, QImage::Format_Grayscale8);
+        return image.copy();
+    }
+
+    // PDFium  BGRx λͼ Format_RGB32 ڴֽ˳ֱͬӸƣͨ
+    // ɨҳ JPEG ·Ҳ Format_RGB32·ɫһ
+    const QImage image(static_cast<uchar*>(buffer), width, height, stride, QImage::Format_RGB32);
+    // һɫؼֹͣ
+    if (detectGray && image.allGray())
+    {
+        return image.convertToFormat(QImage::Format_Grayscale8);
+    }
+    return image.copy();
+}
+
+// Ⱦõλͼ
+FPDF_BITMAP createPdfiumBitmap(const int width, const int height, const bool grayscale)
+{
+    if (grayscale)
+    {
+        return FPDFBitmap_CreateEx(width, height, FPDFBitmap_Gray, nullptr, 0);
+    }
+    return FPDFBitmap_Create(width, height, 1);
+}
+
+// ӲʵƵע
+bool isOverlayAnnotationSubtype(const int subtype)
+{
+    switch (subtype)
+    {
+    case FPDF_ANNOT_HIGHLIGHT:
+    case FPDF_ANNOT_UNDERLINE:
+    case FPDF_ANNOT_SQUIGGLY:
+    case FPDF_ANNOT_STRIKEOUT:
+    case FPDF_ANNOT_LINE:
+    case FPDF_ANNOT_POLYLINE:
+    case FPDF_ANNOT_POLYGON:
+    case FPDF_ANNOT_INK:
+    case FPDF_ANNOT_SQUARE:
+    case FPDF_ANNOT_CIRCLE:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// ֻ࣬޸κα־ûעʱ±
+AppearanceAnnotationScope::AppearanceAnnotationScope(const FPDF_PAGE page)
+    : m_pPage(page), m_bPresent(false), m_bHidden(false)
+{
+    if (!page)
+    {
+        return;
+    }
+
+    const int count = FPDFPage_GetAnnotCount(page);
+    for (int i = 0; i < count; ++i)
+    {
+        const FPDF_ANNOTATION annot = FPDFPage_GetAnnot(page, i);
+        if (!annot)
+        {
+            continue;
+        }
+        const int flags = FPDFAnnot_GetFlags(annot);
+        if (!(flags & FPDF_ANNOT_FLAG_HIDDEN))
+        {
+            if (isAppearanceAnnotationSubtype(FPDFAnnot_GetSubtype(annot)))
+            {
+                m_bPresent = true;
+            }
+            else
+            {
+                m_vecOthers.push_back(std::make_pair(i, flags));
+            }
+        }
+        FPDFPage_CloseAnnot(annot);
+    }
+
+    if (!m_bPresent)
+    {
+        m_vecOthers.clear();
+    }
+}
+
+AppearanceAnnotationScope::~AppearanceAnnotationScope()
+{
+    if (!m_bHidden)
+    {
+        return;
+    }
+    for (size_t i = 0; i < m_vecOthers.size(); ++i)
+    {
+        const FPDF_ANNOTATION annot = FPDFPage_GetAnnot(m_pPage, m_vecOthers[i].first);
+        FPDFAnnot_SetFlags(annot, m_vecOthers[i].second);
+        FPDFPage_CloseAnnot(annot);
+    }
+}
+
+int AppearanceAnnotationScope::hide()
+{
+    if (!m_bPresent)
+    {
+        return 0;
+    }
+    if (!m_bHidden)
+    {
+        m_bHidden = true;
+        for (size_t i = 0; i < m_vecOthers.size(); ++i)
+        {
+            const FPDF_ANNOTATION annot = FPDFPage_GetAnnot(m_pPage, m_vecOthers[i].first);
+            FPDFAnnot_SetFlags(annot, m_vecOthers[i].second | FPDF_ANNOT_FLAG_HIDDEN);
+            FPDFPage_CloseAnnot(annot);
+        }
+    }
+    return FPDF_ANNOT;
 }
 
 // Ⱦ PDF ҳ浽 QImage
-QImage renderPdfPageToImage(const FPDF_PAGE page)
+QImage renderPdfPageToImage(const FPDF_PAGE page, const int flags, const double scale, const FPDF_FORMHANDLE form,
+    const ColorScheme colorScheme, const bool grayscale)
 {
-    const int width = static_cast<int>(FPDF_GetPageWidth(page));
-    const int height = static_cast<int>(FPDF_GetPageHeight(page));
+    const int width = std::max(1, static_cast<int>(FPDF_GetPageWidth(page) * scale));
+    const int height = std::max(1, static_cast<int>(FPDF_GetPageHeight(page) * scale));
 
-    const FPDF_BITMAP bitmap = FPDFBitmap_Create(width, height, 1);
-    FPDFBitmap_FillRect(bitmap, 0, 0, width, height, 0xFFFFFFFF); // ɫ
-    FPDF_RenderPageBitmap(bitmap, page, 0, 0, width, height, 0, FPDF_ANNOT);
+    const FPDF_BITMAP bitmap = createPdfiumBitmap(width, height, grayscale);
+    if (!bitmap)
+    {
+        return QImage();
+    }
+    renderPdfPageToBitmap(bitmap, page, 0, 0, width, height, flags, colorScheme);
+    if (form)
+    {
+        FPDF_FFLDraw(form, bitmap, page, 0, 0, width, height, 0, grayscale ? flags | FPDF_GRAYSCALE : flags);
+    }
 
     QImage image = pdfiumBitmapToQImage(bitmap);
 
@@ -38,3 +194,92 @@ QImage renderPdfPageToImage(const FPDF_PAGE page)
 
     return image;
 }
+
+// ɫȾҳ浽λͼ
+// ɫֻнʽӿڣӲͣ IFSDK_PAUSE һȾ
+void renderPdfPageToBitmap(const FPDF_BITMAP bitmap, const FPDF_PAGE page, const int startX, const int startY,
+    const int sizeX, const int sizeY, const int flags, const ColorScheme colorScheme)
+{
+    FPDFBitmap_FillRect(bitmap, 0, 0, FPDFBitmap_GetWidth(bitmap), FPDFBitmap_GetHeight(bitmap),
+        colorSchemeBackground(colorScheme));
+    // ÷Ҫ決ȫעʱκעͣȾڱɣ뿪ǰָעͱ־
+    AppearanceAnnotationScope annotations((flags & FPDF_ANNOT) ? nullptr : page);
+    const int annotFlags = flags | annotations.hide();
+    const int renderFlags =
+        FPDFBitmap_GetFormat(bitmap) == FPDFBitmap_Gray ? annotFlags | FPDF_GRAYSCALE : annotFlags;
+
+    FPDF_COLORSCHEME scheme;
+    if (!colorSchemeFor(colorScheme, &scheme))
+    {
+        FPDF_RenderPageBitmap(bitmap, page, startX, startY, sizeX, sizeY, 0, renderFlags);
+        return;
+    }
+
+    IFSDK_PAUSE pause;
+    pause.version = 1;
+    pause.NeedToPauseNow = neverPause;
+    pause.user = nullptr;
+    int status = FPDF_RenderPageBitmapWithColorScheme_Start(bitmap, page, startX, startY, sizeX, sizeY, 0,
+        renderFlags | colorSchemeRenderFlags(colorScheme), &scheme, &pause);
+    while (status == FPDF_RENDER_TOBECONTINUED)
+    {
+        status = FPDF_RenderPage_Continue(page, &pause);
+    }
+    FPDF_RenderPage_Close(page);
+}
+
+// Ⱦ PDF ҳ浽ⲿ
+// СȾɨҳʱֱСǶ JPEGFormat_RGB32 ڴеֽ˳Ϊ BGRxи
+bool renderPdfPageToBuffer(const FPDF_PAGE page, void* buffer, const int width, const int height, const int stride,
+    const int flags)
+{
+    const bool drawsAnnotations = (flags & FPDF_ANNOT) && FPDFPage_GetAnnotCount(page) > 0;
+    if (!drawsAnnotations && !(flags & FPDF_GRAYSCALE))
+    {
+        const QImage image = decodeScannedPage(page, width, height).convertToFormat(QImage::Format_RGB32);
+        if (!image.isNull())
+        {
+            for (int y = 0; y < height; ++y)
+            {
+                memcpy(static_cast<uchar*>(buffer) + static_cast<size_t>(y) * stride, image.constScanLine(y),
+                    static_cast<size_t>(width) * 4);
+            }
+            return true;
+        }
+    }
+
+    const FPDF_BITMAP bitmap = FPDFBitmap_CreateEx(width, height, FPDFBitmap_BGRx, buffer, stride);
+    if (!bitmap)
+    {
+        return false;
+    }
+    FPDFBitmap_FillRect(bitmap, 0, 0, width, height, 0xFFFFFFFF); // ɫ
+    FPDF_RenderPageBitmap(bitmap, page, 0, 0, width, height, 0, flags);
+    FPDFBitmap_Destroy(bitmap); // ⲿλͼͷ
+    return true;
+}
+
+// ҳ굽豸ı任
+//  FPDF_DeviceToPage ʾǵõ豸ҳķ任棬
+// ֮껻㲻Ҫҳ
+QTransform pageToDeviceTransform(const FPDF_PAGE page, const int startX, const int startY, const int sizeX,
+    const int sizeY, const int rotate)
+{
+    if (!page || sizeX <= 0 || sizeY <= 0)
+    {
+        return QTransform();
+    }
+
+    double x0 = 0.0, y0 = 0.0, x1 = 0.0, y1 = 0.0, x2 = 0.0, y2 = 0.0;
+    FPDF_DeviceToPage(page, startX, startY, sizeX, sizeY, rotate, startX, startY, &x0, &y0);
+    FPDF_DeviceToPage(page, startX, startY, sizeX, sizeY, rotate, startX + sizeX, startY, &x1, &y1);
+    FPDF_DeviceToPage(page, startX, startY, sizeX, sizeY, rotate, startX, startY + sizeY, &x2, &y2);
+
+    const double m11 = (x1 - x0) / sizeX;
+    const double m12 = (y1 - y0) / sizeX;
+    const double m21 = (x2 - x0) / sizeY;
+    const double m22 = (y2 - y0) / sizeY;
+    const QTransform deviceToPage(m11, m12, m21, m22,
+        x0 - m11 * startX - m21 * startY, y0 - m12 * startX - m22 * startY);
+    return deviceToPage.inverted();
+}
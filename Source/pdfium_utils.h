@@ -2,15 +2,75 @@
 #define PDFIUM_UTILS_H
 
 #include <QImage>
+#include <QTransform>
+#include <vector>
 #include "fpdfview.h"
+#include "fpdf_formfill.h"
+#include "color_scheme.h"
 
 // ʼ PDFium
 void initializePdFium();
 
 //  PDFium λͼתΪ QImage
-QImage pdfiumBitmapToQImage(FPDF_BITMAP bitmap);
+// ҶλͼתΪ Format_Grayscale8BGRx λͼתΪ Format_RGB32
+// detectGray Ϊʱ BGRx λͼأȫΪɫɨ߸壩ʱתΪ Format_Grayscale8ڴֻķ֮һ
+// ҪɨλͼֻͼȵͷֱȾʾҳ治
+QImage pdfiumBitmapToQImage(FPDF_BITMAP bitmap, bool detectGray = false);
+
+// Ⱦõλͼgrayscale Ϊʱÿ 1 ֽڣFPDFBitmap_GrayΪ BGRx
+FPDF_BITMAP createPdfiumBitmap(int width, int height, bool grayscale);
+
+// עǷ AnnotationOverlay ʵƣıǡߡΡīΡԲ
+// ͣͼ¡ͼꡢֿ򡢸ȣֻУ PDFium ҳλͼ
+bool isOverlayAnnotationSubtype(int subtype);
+
+// ҳעͰƷʽķࡣʱһעͣ޸ĵ
+// hide() ѵӲƵע͡뵯ʱΪأʹ FPDF_ANNOT Ⱦֻעͣ
+// ʱָԭб־PDFium ڿʼȾʱFPDF_RenderPageBitmap 򽥽ʽӿڵ _Startȡעͱ־
+// ʾб֮ FPDF_RenderPage_Continue ٶȡֻڿʼȾǰء
+// ־ڹĵϣhide()ʼȾͬһִ߳ɣڹرҳ棬
+// ̴ִִ߳ǩҳȾ桢ֻῴԭб־
+class AppearanceAnnotationScope
+{
+public:
+    explicit AppearanceAnnotationScope(FPDF_PAGE page);
+    ~AppearanceAnnotationScope();
+
+    // ҳǷҪ PDFium Ŀɼע
+    bool hasAppearanceAnnotations() const
+    {
+        return m_bPresent;
+    }
+
+    // עͲӦȾ־ FPDF_ANNOTûעʱ޸ĵ 0
+    int hide();
+
+    AppearanceAnnotationScope(const AppearanceAnnotationScope&) = delete;
+    AppearanceAnnotationScope& operator=(const AppearanceAnnotationScope&) = delete;
+
+private:
+    FPDF_PAGE m_pPage;
+    bool m_bPresent;
+    bool m_bHidden;
+    std::vector<std::pair<int, int> > m_vecOthers;  // ɼע͵±ԭб־
+};
 
 // Ⱦ PDF ҳ浽 QImage
-QImage renderPdfPageToImage(FPDF_PAGE page);
+// ӲƵעͲλͼ AnnotationOverlay λͼ֮ʸʽƣע PDFium ƣ
+// Ҫ決ȫעʱ FPDF_ANNOT
+// scale ΪÿӦform Ϊʱҳ֮ϻƱgrayscale ΪʱֱȾΪ 8 λҶ
+QImage renderPdfPageToImage(FPDF_PAGE page, int flags = 0, double scale = 1.0, FPDF_FORMHANDLE form = nullptr,
+    ColorScheme colorScheme = ColorSchemeNormal, bool grayscale = false);
+
+// Էıɫλͼٰ FPDF_RenderPageBitmap ʾȾҳ
+// ҶλͼԶ FPDF_GRAYSCALE
+void renderPdfPageToBitmap(FPDF_BITMAP bitmap, FPDF_PAGE page, int startX, int startY, int sizeX, int sizeY,
+    int flags = 0, ColorScheme colorScheme = ColorSchemeNormal);
+
+// Ⱦ PDF ҳ浽÷ṩ BGRx Ϊ stride * height ֽڣ QImage 
+bool renderPdfPageToBuffer(FPDF_PAGE page, void* buffer, int width, int height, int stride, int flags = 0);
+
+// ҳ굽豸ı任 FPDF_RenderPageBitmap ʾһ
+QTransform pageToDeviceTransform(FPDF_PAGE page, int startX, int startY, int sizeX, int sizeY, int rotate);
 
 #endif // PDFIUM_UTILS_H
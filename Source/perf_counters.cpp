@@ -0,0 +1,60 @@
+﻿/*!
+ * @brief 低开销性能计数器的实现。
+ *
+ * @author LiuYe
+ * @date 2026-10-19
+ * @copyright (c) 2013-2026 Honghu Yuntu Corporation
+ */
+
+#include "perf_counters.h"
+
+PerfCounters::ThreadSlot::ThreadSlot()
+{
+    for (int i = 0; i < PerfCounterCount; ++i)
+    {
+        arrValues[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+PerfCounters& PerfCounters::instance()
+{
+    static PerfCounters counters;
+    return counters;
+}
+
+PerfCounters::PerfCounters()
+{
+}
+
+void PerfCounters::add(const PerfCounter eCounter, const long long nValue)
+{
+    // 槽只由本线程写入，采样线程只读
+    static thread_local ThreadSlot* s_pSlot = nullptr;
+    if (!s_pSlot)
+    {
+        s_pSlot = instance().registerThread();
+    }
+    s_pSlot->arrValues[eCounter].fetch_add(nValue, std::memory_order_relaxed);
+}
+
+PerfSample PerfCounters::sample() const
+{
+    PerfSample values;
+    values.fill(0);
+    std::lock_guard<std::mutex> lock(m_oMutex);
+    for (size_t i = 0; i < m_vecSlots.size(); ++i)
+    {
+        for (int j = 0; j < PerfCounterCount; ++j)
+        {
+            values[j] += m_vecSlots[i]->arrValues[j].load(std::memory_order_relaxed);
+        }
+    }
+    return values;
+}
+
+PerfCounters::ThreadSlot* PerfCounters::registerThread()
+{
+    std::lock_guard<std::mutex> lock(m_oMutex);
+    m_vecSlots.push_back(std::unique_ptr<ThreadSlot>(new ThreadSlot));
+    return m_vecSlots.back().get();
+}
@@ -0,0 +1,99 @@
+﻿/*!
+ * @brief 进程内的低开销性能计数器。
+ *
+ * 每个线程第一次计数时登记一个计数槽，之后的计数只对本线程的槽做一次 relaxed 原子加法，不加锁、
+ * 不与其他线程争用缓存行。`sample()` 汇总全部线程的计数，由性能面板以较低频率调用；面板隐藏时
+ * 不采样，计数本身的开销可以忽略。
+ *
+ * 计数只增不清零，速率类指标（帧时间、命中率、忙碌比例）由采样方对两次采样求差得到。
+ * 打开的页面句柄数以 +1 / -1 计入，各线程的和即当前值。
+ *
+ * @author LiuYe
+ * @date 2026-10-19
+ * @copyright (c) 2013-2026 Honghu Yuntu Corporation
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+enum PerfCounter
+{
+    PerfFrames = 0,                   // 页面绘制次数
+    PerfFrameNanoseconds,             // 页面绘制耗时
+    PerfCacheHits,                    // 渲染缓存命中次数
+    PerfCacheMisses,                  // 渲染缓存未命中次数
+    PerfOpenPages,                    // 打开的 FPDF_PAGE 句柄数
+    PerfPdfiumBusyNanoseconds,        // PDFium 执行线程执行任务的时间
+    PerfArenaAllocations,             // 由 arena 服务的分配次数，即不用 arena 时的堆分配次数
+    PerfArenaChunks,                  // arena 向堆申请的块数
+    PerfCounterCount
+};
+
+typedef std::array<long long, PerfCounterCount> PerfSample;
+
+/*!
+ * @brief 按线程分槽累加的计数器。
+ *
+ * @date 2026.10.19
+ */
+class PerfCounters
+{
+public:
+    static PerfCounters& instance();
+
+    // 累加到当前线程的计数槽
+    static void add(PerfCounter eCounter, long long nValue = 1);
+
+    // 汇总全部线程的计数，各槽分别读取，结果不是严格的同一时刻快照
+    PerfSample sample() const;
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+private:
+    struct ThreadSlot
+    {
+        std::atomic<long long> arrValues[PerfCounterCount];
+        char arrPadding[64];          // 与相邻线程的槽隔开，避免伪共享
+
+        ThreadSlot();
+    };
+
+    PerfCounters();
+
+    ThreadSlot* registerThread();
+
+    mutable std::mutex m_oMutex;      // 只在登记线程和采样时使用
+    std::vector<std::unique_ptr<ThreadSlot>> m_vecSlots; // 线程退出后保留，累计值不丢失
+};
+
+/*!
+ * @brief 在作用域结束时把经过的时间（纳秒）计入计数器。
+ */
+class PerfScopedTimer
+{
+public:
+    explicit PerfScopedTimer(const PerfCounter eCounter)
+        : m_eCounter(eCounter), m_oStart(std::chrono::steady_clock::now())
+    {
+    }
+
+    ~PerfScopedTimer()
+    {
+        const std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - m_oStart;
+        PerfCounters::add(m_eCounter, static_cast<long long>(elapsed.count()));
+    }
+
+    PerfScopedTimer(const PerfScopedTimer&) = delete;
+    PerfScopedTimer& operator=(const PerfScopedTimer&) = delete;
+
+private:
+    PerfCounter m_eCounter;
+    std::chrono::steady_clock::time_point m_oStart;
+};
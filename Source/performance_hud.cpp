@@ -0,0 +1,138 @@
+﻿/*!
+ * @brief 底部面板中的实时性能面板的实现。
+ *
+ * @author LiuYe
+ * @date 2026-10-19
+ * @copyright (c) 2013-2026 Honghu Yuntu Corporation
+ */
+
+#include "performance_hud.h"
+
+#include <QFormLayout>
+#include <QLabel>
+#include <QStringList>
+#include <QTimerEvent>
+
+#include <algorithm>
+
+#include "memory_governor.h"
+#include "render_cache.h"
+#include "render_scheduler.h"
+
+namespace
+{
+    const int kSampleIntervalMs = 500;
+
+    // 列出的最慢渲染数
+    const int kSlowestRenderCount = 5;
+
+    QString megabytes(const qint64 nBytes)
+    {
+        return QString::number(nBytes / (1024.0 * 1024.0), 'f', 1) + " MB";
+    }
+}
+
+PerformanceHud::PerformanceHud(QWidget* pParent)
+    : QWidget(pParent), m_pFrameLabel(new QLabel(this)), m_pQueueLabel(new QLabel(this)),
+    m_pCacheLabel(new QLabel(this)), m_pMemoryLabel(new QLabel(this)), m_pBudgetLabel(new QLabel(this)),
+    m_pPagesLabel(new QLabel(this)), m_pPdfiumLabel(new QLabel(this)), m_pArenaLabel(new QLabel(this)),
+    m_pSlowestLabel(new QLabel(this))
+{
+    m_oLastSample.fill(0);
+    m_pSlowestLabel->setTextInteractionFlags(Qt::TextSelectableByMouse);
+
+    QFormLayout* pLayout = new QFormLayout(this);
+    pLayout->setContentsMargins(6, 4, 6, 4);
+    pLayout->addRow("Frame time:", m_pFrameLabel);
+    pLayout->addRow("Render queue:", m_pQueueLabel);
+    pLayout->addRow("Cache hit rate:", m_pCacheLabel);
+    pLayout->addRow("Cached bitmaps:", m_pMemoryLabel);
+    pLayout->addRow("Memory budget:", m_pBudgetLabel);
+    pLayout->addRow("Open pages:", m_pPagesLabel);
+    pLayout->addRow("PDFium busy:", m_pPdfiumLabel);
+    pLayout->addRow("Page analysis:", m_pArenaLabel);
+    pLayout->addRow("Slowest renders:", m_pSlowestLabel);
+}
+
+void PerformanceHud::showEvent(QShowEvent* pEvent)
+{
+    QWidget::showEvent(pEvent);
+    // 以当前计数为基线，隐藏期间的累计不计入第一次的速率
+    m_oLastSample = PerfCounters::instance().sample();
+    m_oSampleClock.start();
+    m_oTimer.start(kSampleIntervalMs, this);
+}
+
+void PerformanceHud::hideEvent(QHideEvent* pEvent)
+{
+    m_oTimer.stop();
+    QWidget::hideEvent(pEvent);
+}
+
+void PerformanceHud::timerEvent(QTimerEvent* pEvent)
+{
+    if (pEvent->timerId() != m_oTimer.timerId())
+    {
+        QWidget::timerEvent(pEvent);
+        return;
+    }
+    // 被窗口遮挡或面板高度拖为 0 时不刷新
+    if (!visibleRegion().isEmpty())
+    {
+        refresh();
+    }
+}
+
+void PerformanceHud::refresh()
+{
+    const PerfSample sample = PerfCounters::instance().sample();
+    const qint64 nElapsedNs = std::max<qint64>(1, m_oSampleClock.nsecsElapsed());
+    m_oSampleClock.start();
+    PerfSample delta;
+    for (int i = 0; i < PerfCounterCount; ++i)
+    {
+        delta[i] = sample[i] - m_oLastSample[i];
+    }
+    m_oLastSample = sample;
+
+    const long long nFrames = delta[PerfFrames];
+    m_pFrameLabel->setText(nFrames > 0
+        ? QString("%1 ms avg, %2 frames/s")
+            .arg(delta[PerfFrameNanoseconds] / 1e6 / nFrames, 0, 'f', 2)
+            .arg(nFrames * 1e9 / nElapsedNs, 0, 'f', 1)
+        : QString("idle"));
+
+    m_pQueueLabel->setText(QString::number(RenderScheduler::instance().pendingCount()) + " pending");
+
+    const long long nLookups = delta[PerfCacheHits] + delta[PerfCacheMisses];
+    m_pCacheLabel->setText(nLookups > 0
+        ? QString("%1% of %2 lookups").arg(100.0 * delta[PerfCacheHits] / nLookups, 0, 'f', 1).arg(nLookups)
+        : QString("no lookups"));
+
+    const RenderCache& cache = RenderCache::instance();
+    m_pMemoryLabel->setText(megabytes(cache.usedBytes()) + " / " + megabytes(cache.budget()));
+    const MemoryGovernor& governor = MemoryGovernor::instance();
+    static const char* const s_arrPressure[] = { "", ", moderate pressure", ", critical pressure" };
+    m_pBudgetLabel->setText(megabytes(governor.usedBytes()) + " / " + megabytes(governor.effectiveBudget())
+        + s_arrPressure[governor.pressure()]);
+    m_pPagesLabel->setText(QString::number(sample[PerfOpenPages]));
+    m_pPdfiumLabel->setText(QString::number(
+        std::min(100.0, 100.0 * delta[PerfPdfiumBusyNanoseconds] / nElapsedNs), 'f', 1) + "%");
+
+    // 不使用 arena 时每次分配都是一次堆分配，使用后只有块的申请访问堆
+    m_pArenaLabel->setText(delta[PerfArenaAllocations] > 0
+        ? QString("%1 allocations served from %2 heap blocks").arg(delta[PerfArenaAllocations])
+            .arg(delta[PerfArenaChunks])
+        : QString("idle"));
+
+    const std::vector<RenderTiming> vecSlowest = RenderScheduler::instance().slowestRecentRenders(kSlowestRenderCount);
+    QStringList lstSlowest;
+    for (size_t i = 0; i < vecSlowest.size(); ++i)
+    {
+        lstSlowest.append(QString("page %1 at %2%: %3 ms")
+            .arg(vecSlowest[i].key.nPage + 1)
+            .arg(vecSlowest[i].key.nScalePercent)
+            .arg(vecSlowest[i].nNanoseconds / 1e6, 0, 'f', 1));
+    }
+    m_pSlowestLabel->setText(lstSlowest.isEmpty() ? QString("none yet") : lstSlowest.join('\n'));
+}
@@ -0,0 +1,58 @@
+﻿/*!
+ * @brief 底部面板中的实时性能面板。
+ *
+ * 面板每 500 毫秒对 `PerfCounters` 采样一次，与上一次采样求差得到帧时间、缓存命中率、PDFium
+ * 执行线程忙碌比例等速率指标，并显示渲染队列长度、缓存占用、打开的页面句柄数、单页分析由 arena
+ * 代替的堆分配以及最近最慢的渲染。
+ * 定时器只在面板可见时运行，面板隐藏或所在标签页未选中时不采样。
+ *
+ * @author LiuYe
+ * @date 2026-10-19
+ * @copyright (c) 2013-2026 Honghu Yuntu Corporation
+ */
+
+#pragma once
+
+#include <QBasicTimer>
+#include <QElapsedTimer>
+#include <QWidget>
+
+#include "perf_counters.h"
+
+class QLabel;
+
+/*!
+ * @brief 性能面板，显示计数器的实时值。
+ *
+ * @param pParent 父窗口对象，默认为 nullptr
+ * @date 2026.10.19
+ */
+class PerformanceHud : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit PerformanceHud(QWidget* pParent = nullptr);
+
+protected:
+    void showEvent(QShowEvent* pEvent) override;
+    void hideEvent(QHideEvent* pEvent) override;
+    void timerEvent(QTimerEvent* pEvent) override;
+
+private:
+    // 采样一次并刷新显示
+    void refresh();
+
+    QLabel* m_pFrameLabel;
+    QLabel* m_pQueueLabel;
+    QLabel* m_pCacheLabel;
+    QLabel* m_pMemoryLabel;
+    QLabel* m_pBudgetLabel;
+    QLabel* m_pPagesLabel;
+    QLabel* m_pPdfiumLabel;
+    QLabel* m_pArenaLabel;
+    QLabel* m_pSlowestLabel;
+    QBasicTimer m_oTimer;
+    QElapsedTimer m_oSampleClock;     // 距上一次采样的时间
+    PerfSample m_oLastSample;
+};
@@ -0,0 +1,286 @@
+﻿/*!
+ * @brief 全部文档共享的页面位图缓存的实现。
+ *
+ * @author LiuYe
+ * @date 2026-10-19
+ * @copyright (c) 2013-2026 Honghu Yuntu Corporation
+ */
+
+#include "render_cache.h"
+
+#include "memory_governor.h"
+#include "perf_counters.h"
+
+#include <vector>
+
+namespace
+{
+    // 默认内存预算
+    const qint64 kDefaultBudget = 512LL * 1024 * 1024;
+}
+
+RenderKey::RenderKey()
+    : nDocumentId(0), nPage(-1), nScalePercent(0), nColorScheme(ColorSchemeNormal), bGrayscale(false)
+{
+}
+
+RenderKey::RenderKey(const quint64 nDocument, const int nPageIndex, const int nScale, const ColorScheme eColorScheme,
+    const bool bGray)
+    : nDocumentId(nDocument), nPage(nPageIndex), nScalePercent(nScale), nColorScheme(eColorScheme),
+    bGrayscale(bGray)
+{
+}
+
+bool RenderKey::operator==(const RenderKey& other) const
+{
+    return nDocumentId == other.nDocumentId && nPage == other.nPage && nScalePercent == other.nScalePercent
+        && nColorScheme == other.nColorScheme && bGrayscale == other.bGrayscale;
+}
+
+uint qHash(const RenderKey& key, const uint nSeed)
+{
+    return qHash(key.nDocumentId, nSeed) ^ qHash(key.nPage, nSeed + 1) ^ qHash(key.nScalePercent, nSeed + 2)
+        ^ qHash(key.nColorScheme, nSeed + 3) ^ qHash(key.bGrayscale, nSeed + 4);
+}
+
+RenderCache& RenderCache::instance()
+{
+    static RenderCache cache;
+    return cache;
+}
+
+RenderCache::RenderCache()
+    : m_nBudget(kDefaultBudget), m_nUsedBytes(0), m_nActiveBytes(0), m_nActiveDocumentId(0)
+{
+    // 后台文档的位图切回标签页时可从低分辨率副本重新渲染，先于当前文档的位图缩减
+    MemoryGovernor& governor = MemoryGovernor::instance();
+    governor.registerConsumer("background page bitmaps", MemoryLow,
+        [this]() { return m_nUsedBytes - m_nActiveBytes; },
+        [this](const qint64 nBytes) { evict(false, nBytes); });
+    governor.registerConsumer("page bitmaps", MemoryNormal,
+        [this]() { return m_nActiveBytes; },
+        [this](const qint64 nBytes) { evict(true, nBytes); },
+        [this]() { return visibleBytes(); });
+}
+
+// 当前文档最近使用的位图即正在显示的页面，淘汰时最后才轮到它
+qint64 RenderCache::visibleBytes() const
+{
+    for (std::list<RenderKey>::const_iterator it = m_lstLru.begin(); it != m_lstLru.end(); ++it)
+    {
+        if (it->nDocumentId == m_nActiveDocumentId)
+        {
+            return m_hashEntries.find(*it)->nBytes;
+        }
+    }
+    return 0;
+}
+
+void RenderCache::setBudget(const qint64 nBytes)
+{
+    m_nBudget = nBytes;
+    trim();
+}
+
+QImage RenderCache::find(const RenderKey& key)
+{
+    const QHash<RenderKey, Entry>::iterator it = m_hashEntries.find(key);
+    if (it == m_hashEntries.end())
+    {
+        PerfCounters::add(PerfCacheMisses);
+        return QImage();
+    }
+    PerfCounters::add(PerfCacheHits);
+    m_lstLru.splice(m_lstLru.begin(), m_lstLru, it->itLru);
+    return it->image;
+}
+
+QImage RenderCache::findBest(const quint64 nDocumentId, const int nPage, const ColorScheme eColorScheme,
+    const bool bGrayscale, int* pScalePercent)
+{
+    const RenderKey* pBest = nullptr;
+    for (QHash<RenderKey, Entry>::const_iterator it = m_hashEntries.constBegin(); it != m_hashEntries.constEnd(); ++it)
+    {
+        if (it.key().nDocumentId == nDocumentId && it.key().nPage == nPage && it.key().nColorScheme == eColorScheme
+            && it.key().bGrayscale == bGrayscale && (!pBest || it.key().nScalePercent > pBest->nScalePercent))
+        {
+            pBest = &it.key();
+        }
+    }
+    if (!pBest)
+    {
+        PerfCounters::add(PerfCacheMisses);
+        return QImage();
+    }
+    if (pScalePercent)
+    {
+        *pScalePercent = pBest->nScalePercent;
+    }
+    return find(*pBest);
+}
+
+void RenderCache::insert(const RenderKey& key, const QImage& image)
+{
+    erase(key);
+    if (image.isNull())
+    {
+        return;
+    }
+
+    m_lstLru.push_front(key);
+    Entry entry;
+    entry.image = image;
+    entry.nBytes = image.byteCount();
+    entry.itLru = m_lstLru.begin();
+    m_hashEntries.insert(key, entry);
+    m_nUsedBytes += entry.nBytes;
+    if (key.nDocumentId == m_nActiveDocumentId)
+    {
+        m_nActiveBytes += entry.nBytes;
+    }
+    trim();
+    MemoryGovernor::instance().requestEnforce();
+}
+
+void RenderCache::setActiveDocument(const quint64 nDocumentId)
+{
+    m_nActiveDocumentId = nDocumentId;
+    m_nActiveBytes = 0;
+    for (QHash<RenderKey, Entry>::const_iterator it = m_hashEntries.constBegin(); it != m_hashEntries.constEnd(); ++it)
+    {
+        if (it.key().nDocumentId == nDocumentId)
+        {
+            m_nActiveBytes += it->nBytes;
+        }
+    }
+}
+
+/*!
+ * @brief 把文档降为后台文档：每页保留一份低分辨率副本，其余位图全部释放。
+ *
+ * 平滑缩放总是输出 32 位图像，灰度位图的副本缩放后转回 Format_Grayscale8，保持四分之一的占用；
+ * 彩色位图的副本较小，全部像素为灰色（扫描件、线稿）时也转为 Format_Grayscale8。
+ */
+void RenderCache::demoteDocument(const quint64 nDocumentId)
+{
+    std::vector<RenderKey> vecKeys;
+    for (QHash<RenderKey, Entry>::const_iterator it = m_hashEntries.constBegin(); it != m_hashEntries.constEnd(); ++it)
+    {
+        if (it.key().nDocumentId == nDocumentId && it.key().nScalePercent > kBackgroundScalePercent)
+        {
+            vecKeys.push_back(it.key());
+        }
+    }
+
+    for (size_t i = 0; i < vecKeys.size(); ++i)
+    {
+        const RenderKey lowKey(nDocumentId, vecKeys[i].nPage, kBackgroundScalePercent,
+            static_cast<ColorScheme>(vecKeys[i].nColorScheme), vecKeys[i].bGrayscale);
+        if (!m_hashEntries.contains(lowKey))
+        {
+            const QImage image = m_hashEntries.value(vecKeys[i]).image;
+            const double dFactor = static_cast<double>(kBackgroundScalePercent) / vecKeys[i].nScalePercent;
+            QImage lowImage = image.scaled(qMax(1, qRound(image.width() * dFactor)),
+                qMax(1, qRound(image.height() * dFactor)), Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+            if (lowImage.format() != QImage::Format_Grayscale8
+                && (image.format() == QImage::Format_Grayscale8 || lowImage.allGray()))
+            {
+                lowImage = lowImage.convertToFormat(QImage::Format_Grayscale8);
+            }
+            insert(lowKey, lowImage);
+        }
+        erase(vecKeys[i]);
+    }
+}
+
+void RenderCache::removeDocument(const quint64 nDocumentId)
+{
+    std::vector<RenderKey> vecKeys;
+    for (QHash<RenderKey, Entry>::const_iterator it = m_hashEntries.constBegin(); it != m_hashEntries.constEnd(); ++it)
+    {
+        if (it.key().nDocumentId == nDocumentId)
+        {
+            vecKeys.push_back(it.key());
+        }
+    }
+    for (size_t i = 0; i < vecKeys.size(); ++i)
+    {
+        erase(vecKeys[i]);
+    }
+}
+
+void RenderCache::removePage(const quint64 nDocumentId, const int nPage)
+{
+    std::vector<RenderKey> vecKeys;
+    for (QHash<RenderKey, Entry>::const_iterator it = m_hashEntries.constBegin(); it != m_hashEntries.constEnd(); ++it)
+    {
+        if (it.key().nDocumentId == nDocumentId && it.key().nPage == nPage)
+        {
+            vecKeys.push_back(it.key());
+        }
+    }
+    for (size_t i = 0; i < vecKeys.size(); ++i)
+    {
+        erase(vecKeys[i]);
+    }
+}
+
+void RenderCache::erase(const RenderKey& key)
+{
+    const QHash<RenderKey, Entry>::iterator it = m_hashEntries.find(key);
+    if (it == m_hashEntries.end())
+    {
+        return;
+    }
+    m_nUsedBytes -= it->nBytes;
+    if (key.nDocumentId == m_nActiveDocumentId)
+    {
+        m_nActiveBytes -= it->nBytes;
+    }
+    m_lstLru.erase(it->itLru);
+    m_hashEntries.erase(it);
+}
+
+/*!
+ * @brief 淘汰位图直到不超出预算：先从最久未用的一端淘汰后台文档的位图，仍超出时再淘汰当前文档的。
+ */
+void RenderCache::trim()
+{
+    for (int nPass = 0; nPass < 2 && m_nUsedBytes > m_nBudget; ++nPass)
+    {
+        std::list<RenderKey>::iterator it = m_lstLru.end();
+        while (it != m_lstLru.begin() && m_nUsedBytes > m_nBudget)
+        {
+            --it;
+            if (nPass == 0 && it->nDocumentId == m_nActiveDocumentId)
+            {
+                continue;
+            }
+            const RenderKey key = *it;
+            it = m_lstLru.erase(it);
+            const QHash<RenderKey, Entry>::iterator itEntry = m_hashEntries.find(key);
+            m_nUsedBytes -= itEntry->nBytes;
+            if (key.nDocumentId == m_nActiveDocumentId)
+            {
+                m_nActiveBytes -= itEntry->nBytes;
+            }
+            m_hashEntries.erase(itEntry);
+        }
+    }
+}
+
+void RenderCache::evict(const bool bActive, const qint64 nBytes)
+{
+    std::list<RenderKey>::iterator it = m_lstLru.end();
+    while (it != m_lstLru.begin() && (bActive ? m_nActiveBytes : m_nUsedBytes - m_nActiveBytes) > nBytes)
+    {
+        --it;
+        if ((it->nDocumentId == m_nActiveDocumentId) != bActive)
+        {
+            continue;
+        }
+        const RenderKey key = *it;
+        ++it;
+        erase(key);
+    }
+}
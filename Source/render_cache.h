@@ -0,0 +1,120 @@
+﻿/*!
+ * @brief 全部文档共享的页面位图缓存。
+ *
+ * 所有标签页的渲染结果放在同一个 `RenderCache` 中，受同一个内存预算约束。当前文档保留全分辨率
+ * 位图；切到后台的文档只保留低分辨率副本，超出预算时优先淘汰后台文档的位图，再按最近最少
+ * 使用顺序淘汰其余位图。切回标签页时可以立即用缓存中最清晰的位图显示，同时重新渲染全分辨率。
+ *
+ * @author LiuYe
+ * @date 2026-10-19
+ * @copyright (c) 2013-2026 Honghu Yuntu Corporation
+ */
+
+#pragma once
+
+#include <QHash>
+#include <QImage>
+
+#include <list>
+
+#include "color_scheme.h"
+
+/*!
+ * @brief 缓存键：文档、页码、缩放百分比、颜色方案、是否灰度渲染。
+ */
+struct RenderKey
+{
+    quint64 nDocumentId;              // PdfDocument::id()
+    int nPage;
+    int nScalePercent;                // 渲染缩放比例，100 为 1 像素/点
+    int nColorScheme;                 // ColorScheme
+    bool bGrayscale;                  // 按用户偏好以 8 位灰度渲染，色彩信息已丢弃
+
+    RenderKey();
+    RenderKey(quint64 nDocument, int nPageIndex, int nScale, ColorScheme eColorScheme = ColorSchemeNormal,
+        bool bGray = false);
+
+    bool operator==(const RenderKey& other) const;
+};
+
+uint qHash(const RenderKey& key, uint nSeed = 0);
+
+/*!
+ * @brief 带内存预算的 LRU 位图缓存，只在 GUI 线程使用。
+ *
+ * @date 2026.10.19
+ */
+class RenderCache
+{
+public:
+    static RenderCache& instance();
+
+    // 后台文档保留的分辨率
+    static const int kBackgroundScalePercent = 25;
+
+    void setBudget(qint64 nBytes);
+    qint64 budget() const
+    {
+        return m_nBudget;
+    }
+    qint64 usedBytes() const
+    {
+        return m_nUsedBytes;
+    }
+
+    // 精确查找，命中时更新最近使用顺序，计入命中率统计
+    QImage find(const RenderKey& key);
+
+    // 是否缓存了该位图，不更新最近使用顺序也不计入命中率统计，供调度等内部判断使用
+    bool contains(const RenderKey& key) const
+    {
+        return m_hashEntries.contains(key);
+    }
+
+    // 查找该页在指定颜色方案与灰度设置下缩放比例最大的位图，未命中返回空图像，pScalePercent 接收其缩放比例
+    QImage findBest(quint64 nDocumentId, int nPage, ColorScheme eColorScheme, bool bGrayscale,
+        int* pScalePercent = nullptr);
+
+    void insert(const RenderKey& key, const QImage& image);
+
+    // 设为当前文档，其余文档视为后台文档
+    void setActiveDocument(quint64 nDocumentId);
+    quint64 activeDocument() const
+    {
+        return m_nActiveDocumentId;
+    }
+
+    // 把文档的全部位图降为低分辨率副本，归还内存
+    void demoteDocument(quint64 nDocumentId);
+
+    void removeDocument(quint64 nDocumentId);
+
+    // 删除该页全部缩放级别、颜色方案的位图，页面内容（如注释）改变后调用
+    void removePage(quint64 nDocumentId, int nPage);
+
+private:
+    struct Entry
+    {
+        QImage image;
+        qint64 nBytes;
+        std::list<RenderKey>::iterator itLru;
+    };
+
+    RenderCache();
+
+    void erase(const RenderKey& key);
+    void trim();
+
+    // 当前文档正在显示的位图占用，作为内存压力下预算的下限
+    qint64 visibleBytes() const;
+
+    // 从最久未用的一端淘汰当前文档（bActive）或后台文档的位图，直到该部分不超过 nBytes
+    void evict(bool bActive, qint64 nBytes);
+
+    QHash<RenderKey, Entry> m_hashEntries;
+    std::list<RenderKey> m_lstLru;    // 表头为最近使用
+    qint64 m_nBudget;
+    qint64 m_nUsedBytes;
+    qint64 m_nActiveBytes;            // 当前文档的位图占用，其余为后台文档
+    quint64 m_nActiveDocumentId;
+};
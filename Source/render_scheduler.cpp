@@ -0,0 +1,494 @@
+﻿/*!
+ * @brief 全部文档共享的页面渲染调度器的实现。
+ *
+ * @author LiuYe
+ * @date 2026-10-19
+ * @copyright (c) 2013-2026 Honghu Yuntu Corporation
+ */
+
+#include "render_scheduler.h"
+
+#include "fpdf_progressive.h"
+#include "pdf_form.h"
+#include "pdfium_executor.h"
+#include "pdfium_utils.h"
+#include "perf_counters.h"
+#include "scanned_page.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+
+/*!
+ * @brief 一个渲染任务，在 GUI 线程与执行线程之间共享。
+ *
+ * bPreempt 与 bCanceled 由 GUI 线程设置、执行线程在暂停检查中读取；bHoldsPage 与 oPausedAt 只在 GUI 线程访问；
+ * 其余渲染状态只在执行线程上访问。暂停期间页面与位图保持打开，继续渲染时沿用，被释放后从头渲染。
+ */
+struct RenderJob
+{
+    RenderRequest request;
+    quint64 nSubmitSerial;            // 提交顺序，同一文档内先提交先执行
+    std::atomic<bool> bPreempt;
+    std::atomic<bool> bCanceled;
+
+    FPDF_PAGE page;
+    FPDF_BITMAP bitmap;
+    int nWidth;
+    int nHeight;
+    qint64 nNanoseconds;              // 各步骤在执行线程上累计的耗时
+
+    bool bHoldsPage;                  // 已暂停且页面与位图尚未释放
+    std::chrono::steady_clock::time_point oPausedAt;
+
+    RenderJob()
+        : nSubmitSerial(0), bPreempt(false), bCanceled(false), page(nullptr), bitmap(nullptr), nWidth(0), nHeight(0),
+        nNanoseconds(0), bHoldsPage(false)
+    {
+    }
+
+    // 关闭渐进式渲染的页面和位图，只能在执行线程上调用
+    void release()
+    {
+        if (page)
+        {
+            FPDF_RenderPage_Close(page);
+            FPDF_ClosePage(page);
+            PerfCounters::add(PerfOpenPages, -1);
+            page = nullptr;
+        }
+        if (bitmap)
+        {
+            FPDFBitmap_Destroy(bitmap);
+            bitmap = nullptr;
+        }
+    }
+};
+
+namespace
+{
+    // 保留耗时记录的最近渲染数
+    const size_t kRecentRenderCount = 64;
+
+    // 同时保留页面与位图的暂停任务数，超出时先释放优先级低、暂停早的任务
+    const size_t kMaxPausedJobs = 4;
+
+    // 暂停超过该时长的任务释放页面与位图
+    const std::chrono::milliseconds kPausedHoldTime(2000);
+
+    // 渐进式渲染的暂停检查：被抢占或取消时让 PDFium 暂停
+    struct JobPause : public IFSDK_PAUSE
+    {
+        RenderJob* pJob;
+    };
+
+    FPDF_BOOL needToPauseNow(IFSDK_PAUSE* pThis)
+    {
+        const RenderJob* pJob = static_cast<JobPause*>(pThis)->pJob;
+        return pJob->bPreempt.load() || pJob->bCanceled.load();
+    }
+
+    /*!
+     * @brief 在执行线程上推进一个渲染任务，直到完成、暂停或失败。
+     */
+    RenderStepResult renderStep(RenderJob& job)
+    {
+        RenderStepResult result;
+        if (job.bCanceled)
+        {
+            job.release();
+            result.eStatus = RenderStepResult::Canceled;
+            return result;
+        }
+
+        JobPause pause;
+        pause.version = 1;
+        pause.NeedToPauseNow = needToPauseNow;
+        pause.user = nullptr;
+        pause.pJob = &job;
+
+        int nStatus = FPDF_RENDER_FAILED;
+        if (!job.page)
+        {
+            job.page = FPDF_LoadPage(job.request.pDocument->handle(), job.request.nPage);
+            if (!job.page)
+            {
+                result.eStatus = RenderStepResult::Failed;
+                return result;
+            }
+            PerfCounters::add(PerfOpenPages);
+            const double dScale = job.request.nScalePercent / 100.0;
+            job.nWidth = std::max(1, static_cast<int>(FPDF_GetPageWidth(job.page) * dScale));
+            job.nHeight = std::max(1, static_cast<int>(FPDF_GetPageHeight(job.page) * dScale));
+
+            // 注释只在加载页面的这一步分类，渐进式渲染的后续步骤不再遍历注释
+            AppearanceAnnotationScope annotations(job.page);
+
+            // 缩小显示的扫描页直接缩小解码内嵌的 JPEG，颜色方案不影响图像；
+            // 表单域与依赖外观流的注释需要绘制在位图上，有表单的文档和有这类注释的页面不走此路径
+            if (!job.request.pDocument->forms() && !annotations.hasAppearanceAnnotations())
+            {
+                const QImage image = decodeScannedPage(job.page, job.nWidth, job.nHeight);
+                if (!image.isNull())
+                {
+                    job.release();
+                    result.eStatus = RenderStepResult::Done;
+                    result.oImage = job.request.bGrayscale ? image.convertToFormat(QImage::Format_Grayscale8) : image;
+                    return result;
+                }
+            }
+
+            job.bitmap = createPdfiumBitmap(job.nWidth, job.nHeight, job.request.bGrayscale);
+            if (!job.bitmap)
+            {
+                job.release();
+                result.eStatus = RenderStepResult::Failed;
+                return result;
+            }
+            FPDFBitmap_FillRect(job.bitmap, 0, 0, job.nWidth, job.nHeight,
+                colorSchemeBackground(job.request.eColorScheme));
+            // PDFium 在 _Start 中按注释标志生成显示列表，隐藏只需覆盖 _Start；离开本块时恢复标志，
+            // 早于本步结束，之后的任务看到的始终是原有标志
+            const int nFlags = (job.request.bGrayscale ? FPDF_GRAYSCALE : 0) | annotations.hide();
+
+            // 颜色方案由 PDFium 在光栅化时应用，图像不受影响，也不需要渲染后再处理像素
+            FPDF_COLORSCHEME scheme;
+            if (colorSchemeFor(job.request.eColorScheme, &scheme))
+            {
+                nStatus = FPDF_RenderPageBitmapWithColorScheme_Start(job.bitmap, job.page, 0, 0, job.nWidth,
+                    job.nHeight, 0, nFlags | colorSchemeRenderFlags(job.request.eColorScheme), &scheme, &pause);
+            }
+            else
+            {
+                nStatus = FPDF_RenderPageBitmap_Start(job.bitmap, job.page, 0, 0, job.nWidth, job.nHeight, 0, nFlags,
+                    &pause);
+            }
+        }
+        else
+        {
+            nStatus = FPDF_RenderPage_Continue(job.page, &pause);
+        }
+
+        if (nStatus == FPDF_RENDER_TOBECONTINUED)
+        {
+            if (job.bCanceled)
+            {
+                job.release();
+                result.eStatus = RenderStepResult::Canceled;
+            }
+            else
+            {
+                result.eStatus = RenderStepResult::Paused;
+            }
+            return result;
+        }
+
+        if (nStatus == FPDF_RENDER_DONE)
+        {
+            result.eStatus = RenderStepResult::Done;
+            if (PdfFormEnvironment* pForms = job.request.pDocument->forms())
+            {
+                pForms->drawFields(job.bitmap, job.page, job.request.nPage, 0, 0, job.nWidth, job.nHeight,
+                    job.request.bGrayscale ? FPDF_GRAYSCALE : 0);
+            }
+            // 只有低分辨率的缩略图检查是否全为灰色，正常显示的页面不扫描整幅位图
+            result.oImage = pdfiumBitmapToQImage(job.bitmap, job.request.ePriority == RenderThumbnail);
+        }
+        else
+        {
+            result.eStatus = RenderStepResult::Failed;
+        }
+        job.release();
+        return result;
+    }
+}
+
+RenderRequest::RenderRequest()
+    : nPage(-1), nScalePercent(100), eColorScheme(ColorSchemeNormal), bGrayscale(false), ePriority(RenderVisible)
+{
+}
+
+RenderKey RenderRequest::key() const
+{
+    return RenderKey(pDocument ? pDocument->id() : 0, nPage, nScalePercent, eColorScheme, bGrayscale);
+}
+
+RenderStepResult::RenderStepResult()
+    : eStatus(Failed)
+{
+}
+
+RenderScheduler& RenderScheduler::instance()
+{
+    static RenderScheduler* pScheduler = new RenderScheduler;
+    return *pScheduler;
+}
+
+RenderScheduler::RenderScheduler(QObject* pParent)
+    : QObject(pParent), m_nServeSerial(0), m_nSubmitSerial(0), m_nPreemptions(0)
+{
+    connect(&m_oWatcher, &QFutureWatcher<RenderStepResult>::finished, this, &RenderScheduler::onStepFinished);
+}
+
+/*!
+ * @brief 提交渲染请求。
+ *
+ * 与排队中或执行中的请求相同时只提升其优先级；优先级高于正在执行的任务时请求其暂停让出。
+ *
+ * @return 是否已排队（缓存命中时为 false）
+ */
+bool RenderScheduler::request(const RenderRequest& request)
+{
+    const RenderKey key = request.key();
+    if (!request.pDocument || RenderCache::instance().contains(key))
+    {
+        return false;
+    }
+
+    if (m_pRunning && m_pRunning->request.key() == key && !m_pRunning->bCanceled)
+    {
+        m_pRunning->request.ePriority = std::min(m_pRunning->request.ePriority, request.ePriority);
+        return true;
+    }
+
+    bool bCoalesced = false;
+    for (size_t i = 0; i < m_vecPending.size() && !bCoalesced; ++i)
+    {
+        if (m_vecPending[i]->request.key() == key)
+        {
+            m_vecPending[i]->request.ePriority = std::min(m_vecPending[i]->request.ePriority, request.ePriority);
+            bCoalesced = true;
+        }
+    }
+
+    if (!bCoalesced)
+    {
+        const RenderJobPtr pJob = std::make_shared<RenderJob>();
+        pJob->request = request;
+        pJob->nSubmitSerial = ++m_nSubmitSerial;
+        m_vecPending.push_back(pJob);
+    }
+
+    if (m_pRunning && request.ePriority < m_pRunning->request.ePriority)
+    {
+        m_pRunning->bPreempt = true;
+    }
+    pump();
+    return true;
+}
+
+void RenderScheduler::cancel(const RenderKey& key)
+{
+    if (m_pRunning && m_pRunning->request.key() == key)
+    {
+        m_pRunning->bCanceled = true;
+    }
+    for (size_t i = m_vecPending.size(); i-- > 0;)
+    {
+        if (m_vecPending[i]->request.key() == key)
+        {
+            discard(m_vecPending[i]);
+            m_vecPending.erase(m_vecPending.begin() + i);
+        }
+    }
+}
+
+void RenderScheduler::cancelDocument(const quint64 nDocumentId)
+{
+    if (m_pRunning && m_pRunning->request.key().nDocumentId == nDocumentId)
+    {
+        m_pRunning->bCanceled = true;
+    }
+    for (size_t i = m_vecPending.size(); i-- > 0;)
+    {
+        if (m_vecPending[i]->request.key().nDocumentId == nDocumentId)
+        {
+            discard(m_vecPending[i]);
+            m_vecPending.erase(m_vecPending.begin() + i);
+        }
+    }
+    m_hashLastServed.remove(nDocumentId);
+}
+
+// 已暂停的任务仍持有页面和位图，在执行线程上释放
+void RenderScheduler::discard(const RenderJobPtr& pJob)
+{
+    pJob->bCanceled = true;
+    pJob->bHoldsPage = false;
+    const RenderJobPtr pReleased = pJob;
+    PdfiumExecutor::instance().post([pReleased]() { pReleased->release(); });
+}
+
+// 执行线程按提交顺序执行，释放总是先于该任务之后的渲染步骤，下一步看到页面为空时从头渲染
+void RenderScheduler::suspend(const RenderJobPtr& pJob)
+{
+    pJob->bHoldsPage = false;
+    const RenderJobPtr pReleased = pJob;
+    PdfiumExecutor::instance().post([pReleased]() { pReleased->release(); });
+}
+
+/*!
+ * @brief 限制暂停任务占用的页面与位图。
+ *
+ * 暂停超过 kPausedHoldTime 或所在文档已不在前台的任务立即释放；其余超过 kMaxPausedJobs 时，
+ * 按优先级从低到高、暂停时间从早到晚释放。
+ */
+void RenderScheduler::trimPaused()
+{
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    const quint64 nActiveDocument = RenderCache::instance().activeDocument();
+    std::vector<RenderJobPtr> vecHeld;
+    for (size_t i = 0; i < m_vecPending.size(); ++i)
+    {
+        const RenderJobPtr& pJob = m_vecPending[i];
+        if (!pJob->bHoldsPage)
+        {
+            continue;
+        }
+        if (now - pJob->oPausedAt > kPausedHoldTime || pJob->request.key().nDocumentId != nActiveDocument)
+        {
+            suspend(pJob);
+        }
+        else
+        {
+            vecHeld.push_back(pJob);
+        }
+    }
+
+    if (vecHeld.size() <= kMaxPausedJobs)
+    {
+        return;
+    }
+    std::sort(vecHeld.begin(), vecHeld.end(),
+        [](const RenderJobPtr& left, const RenderJobPtr& right)
+        {
+            if (left->request.ePriority != right->request.ePriority)
+            {
+                return left->request.ePriority > right->request.ePriority;
+            }
+            return left->oPausedAt < right->oPausedAt;
+        });
+    for (size_t i = 0; i < vecHeld.size() - kMaxPausedJobs; ++i)
+    {
+        suspend(vecHeld[i]);
+    }
+}
+
+/*!
+ * @brief 选出下一个任务：优先级最高；同优先级中最久未被服务的文档；同文档中最早提交的请求。
+ */
+size_t RenderScheduler::pickNext() const
+{
+    size_t nBest = 0;
+    for (size_t i = 1; i < m_vecPending.size(); ++i)
+    {
+        const RenderJob& candidate = *m_vecPending[i];
+        const RenderJob& best = *m_vecPending[nBest];
+        if (candidate.request.ePriority != best.request.ePriority)
+        {
+            if (candidate.request.ePriority < best.request.ePriority)
+            {
+                nBest = i;
+            }
+            continue;
+        }
+
+        const quint64 nCandidateServed = m_hashLastServed.value(candidate.request.key().nDocumentId);
+        const quint64 nBestServed = m_hashLastServed.value(best.request.key().nDocumentId);
+        if (nCandidateServed < nBestServed
+            || (nCandidateServed == nBestServed && candidate.nSubmitSerial < best.nSubmitSerial))
+        {
+            nBest = i;
+        }
+    }
+    return nBest;
+}
+
+void RenderScheduler::pump()
+{
+    if (m_pRunning || m_vecPending.empty())
+    {
+        return;
+    }
+
+    const size_t nNext = pickNext();
+    m_pRunning = m_vecPending[nNext];
+    m_vecPending.erase(m_vecPending.begin() + nNext);
+    m_pRunning->bPreempt = false;
+    m_pRunning->bHoldsPage = false;
+    m_hashLastServed.insert(m_pRunning->request.key().nDocumentId, ++m_nServeSerial);
+
+    const RenderJobPtr pJob = m_pRunning;
+    m_oWatcher.setFuture(PdfiumExecutor::instance().run<RenderStepResult>(
+        [pJob](QFutureInterface<RenderStepResult>&)
+        {
+            const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            const RenderStepResult result = renderStep(*pJob);
+            pJob->nNanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count();
+            return result;
+        }));
+}
+
+void RenderScheduler::onStepFinished()
+{
+    const RenderJobPtr pJob = m_pRunning;
+    m_pRunning.reset();
+    const QFuture<RenderStepResult> future = m_oWatcher.future();
+    const RenderStepResult result = future.resultCount() > 0 ? future.result() : RenderStepResult();
+
+    if (pJob)
+    {
+        switch (result.eStatus)
+        {
+        case RenderStepResult::Done:
+        {
+            RenderTiming timing;
+            timing.key = pJob->request.key();
+            timing.nNanoseconds = pJob->nNanoseconds;
+            m_dequeRecent.push_back(timing);
+            if (m_dequeRecent.size() > kRecentRenderCount)
+            {
+                m_dequeRecent.pop_front();
+            }
+            RenderCache::instance().insert(pJob->request.key(), result.oImage);
+            emit pageRendered(pJob->request.key(), result.oImage);
+            break;
+        }
+        case RenderStepResult::Paused:
+            // 放回队列，之后从暂停处继续
+            ++m_nPreemptions;
+            if (pJob->bCanceled)
+            {
+                discard(pJob);
+            }
+            else
+            {
+                pJob->bHoldsPage = true;
+                pJob->oPausedAt = std::chrono::steady_clock::now();
+                m_vecPending.push_back(pJob);
+            }
+            break;
+        case RenderStepResult::Canceled:
+        case RenderStepResult::Failed:
+            break;
+        }
+    }
+    trimPaused();
+    pump();
+}
+
+std::vector<RenderTiming> RenderScheduler::slowestRecentRenders(const int nCount) const
+{
+    std::vector<RenderTiming> vecTimings(m_dequeRecent.begin(), m_dequeRecent.end());
+    std::sort(vecTimings.begin(), vecTimings.end(),
+        [](const RenderTiming& left, const RenderTiming& right)
+        {
+            return left.nNanoseconds > right.nNanoseconds;
+        });
+    if (vecTimings.size() > static_cast<size_t>(std::max(0, nCount)))
+    {
+        vecTimings.resize(static_cast<size_t>(std::max(0, nCount)));
+    }
+    return vecTimings;
+}
@@ -0,0 +1,154 @@
+﻿/*!
+ * @brief 全部文档共享的页面渲染调度器。
+ *
+ * 各标签页的渲染请求统一交给 `RenderScheduler`，由它按优先级依次投递到 PDFium 执行线程。
+ * 调度规则：
+ * - 优先级分为可见、预取、缩略图、搜索高亮、导出五类，高优先级总是先执行；
+ * - 同一优先级内按文档轮转，最久未被服务的文档先执行，避免某个文档的大量请求饿死其他文档；
+ * - 相同的请求（文档、页码、缩放、颜色方案、灰度设置都相同）合并为一个，优先级取较高者；
+ * - 渲染使用 PDFium 的渐进式接口，新到的请求优先级更高时，正在执行的渲染经 `IFSDK_PAUSE`
+ *   暂停并让出执行线程，之后从暂停处继续；
+ * - 已提交的请求可以取消，例如页面滚出可见区域时，正在执行的渲染会在下一次暂停检查时终止；
+ * - 暂停的渲染持有页面与位图，暂停过久、所在文档退到后台或暂停数超过上限时释放，之后从头渲染。
+ *
+ * 因此即使后台正在导出整份文档，可见页面的等待时间也只有一次暂停检查的间隔。
+ *
+ * @author LiuYe
+ * @date 2026-10-19
+ * @copyright (c) 2013-2026 Honghu Yuntu Corporation
+ */
+
+#pragma once
+
+#include <QFutureWatcher>
+#include <QHash>
+#include <QImage>
+#include <QObject>
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "pdf_document.h"
+#include "render_cache.h"
+
+/*!
+ * @brief 渲染优先级，数值越小越优先。
+ */
+enum RenderPriority
+{
+    RenderVisible = 0,                // 当前标签页的可见页面
+    RenderPrefetch = 1,               // 即将滚入可见区域的页面
+    RenderThumbnail = 2,              // 缩略图、后台标签页的低分辨率页面
+    RenderSearch = 3,                 // 搜索结果高亮所在页面
+    RenderExport = 4                  // 导出、打印等整份文档的渲染
+};
+
+/*!
+ * @brief 一个页面渲染请求。
+ */
+struct RenderRequest
+{
+    PdfDocumentPtr pDocument;
+    int nPage;
+    int nScalePercent;
+    ColorScheme eColorScheme;
+    bool bGrayscale;                  // 渲染为 8 位灰度位图
+    RenderPriority ePriority;
+
+    RenderRequest();
+
+    RenderKey key() const;
+};
+
+/*!
+ * @brief 一次完成的渲染在执行线程上花费的时间，包括被抢占前的各个步骤。
+ */
+struct RenderTiming
+{
+    RenderKey key;
+    qint64 nNanoseconds;
+};
+
+struct RenderJob;
+typedef std::shared_ptr<RenderJob> RenderJobPtr;
+
+/*!
+ * @brief 一次执行线程上渲染步骤的结果。
+ */
+struct RenderStepResult
+{
+    enum Status
+    {
+        Done,                         // 渲染完成，oImage 可用
+        Paused,                       // 被更高优先级的请求抢占，可继续
+        Canceled,
+        Failed
+    };
+
+    Status eStatus;
+    QImage oImage;
+
+    RenderStepResult();
+};
+
+/*!
+ * @brief 按优先级调度页面渲染，只在 GUI 线程使用。
+ *
+ * @date 2026.10.19
+ */
+class RenderScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    static RenderScheduler& instance();
+
+    // 提交请求；缓存已命中时不提交，直接返回 false
+    bool request(const RenderRequest& request);
+
+    // 取消请求；正在执行的渲染在下一次暂停检查时终止
+    void cancel(const RenderKey& key);
+    void cancelDocument(quint64 nDocumentId);
+
+    int pendingCount() const
+    {
+        return static_cast<int>(m_vecPending.size());
+    }
+
+    // 统计：被抢占暂停的次数
+    quint64 preemptionCount() const
+    {
+        return m_nPreemptions;
+    }
+
+    // 最近完成的渲染中耗时最长的 nCount 个，按耗时降序
+    std::vector<RenderTiming> slowestRecentRenders(int nCount) const;
+
+signals:
+    void pageRendered(const RenderKey& key, const QImage& image);
+
+private slots:
+    void onStepFinished();
+
+private:
+    explicit RenderScheduler(QObject* pParent = nullptr);
+
+    void pump();
+    size_t pickNext() const;
+    void discard(const RenderJobPtr& pJob);
+    // 释放暂停任务的页面与位图，任务留在队列中
+    void suspend(const RenderJobPtr& pJob);
+    void trimPaused();
+
+    std::vector<RenderJobPtr> m_vecPending;       // 等待执行或已暂停的任务
+    RenderJobPtr m_pRunning;                      // 正在执行线程上的任务
+    QHash<quint64, quint64> m_hashLastServed;     // 文档 -> 最近一次被服务的序号
+    quint64 m_nServeSerial;
+    quint64 m_nSubmitSerial;
+    quint64 m_nPreemptions;
+    std::deque<RenderTiming> m_dequeRecent;       // 最近完成的渲染耗时，按完成顺序
+    QFutureWatcher<RenderStepResult> m_oWatcher;
+};
+
+Q_DECLARE_METATYPE(RenderKey)
@@ -0,0 +1,110 @@
+﻿/*!
+ * @brief 扫描页的快速缩小解码的实现。
+ *
+ * @author LiuYe
+ * @date 2026-10-19
+ * @copyright (c) 2013-2026 Honghu Yuntu Corporation
+ */
+
+#include "scanned_page.h"
+
+#include <QBuffer>
+#include <QByteArray>
+#include <QImageReader>
+
+#include "fpdf_edit.h"
+
+namespace
+{
+    // 图像边界与页面可见区域允许的误差，单位为点
+    const float kCoverTolerance = 1.0f;
+
+    // 图像是否只经过 DCTDecode 一个滤镜，即原始数据就是完整的 JPEG 文件
+    bool isJpegImage(const FPDF_PAGEOBJECT pImage)
+    {
+        if (FPDFImageObj_GetImageFilterCount(pImage) != 1)
+        {
+            return false;
+        }
+        char szFilter[16] = {};
+        const unsigned long nLength = FPDFImageObj_GetImageFilter(pImage, 0, szFilter, sizeof(szFilter));
+        return nLength > 0 && nLength <= sizeof(szFilter) && qstrcmp(szFilter, "DCTDecode") == 0;
+    }
+
+    // 图像是否正立且边界与页面可见区域重合
+    bool coversPage(const FPDF_PAGE pPage, const FPDF_PAGEOBJECT pImage)
+    {
+        FS_MATRIX matrix;
+        if (!FPDFPageObj_GetMatrix(pImage, &matrix) || matrix.b != 0.0f || matrix.c != 0.0f || matrix.a <= 0.0f
+            || matrix.d <= 0.0f)
+        {
+            return false;
+        }
+
+        FS_RECTF box;
+        float fLeft = 0.0f, fBottom = 0.0f, fRight = 0.0f, fTop = 0.0f;
+        if (!FPDF_GetPageBoundingBox(pPage, &box) || !FPDFPageObj_GetBounds(pImage, &fLeft, &fBottom, &fRight, &fTop))
+        {
+            return false;
+        }
+        return qAbs(fLeft - box.left) <= kCoverTolerance && qAbs(fRight - box.right) <= kCoverTolerance
+            && qAbs(fBottom - box.bottom) <= kCoverTolerance && qAbs(fTop - box.top) <= kCoverTolerance;
+    }
+}
+
+/*!
+ * @brief 缩小解码扫描页。
+ *
+ * 只接受 DeviceGray 与 DeviceRGB 的 8 位 JPEG；CMYK JPEG 常带有 Adobe 反相约定，交给 PDFium 处理。
+ * 解码器收到目标尺寸后选择不超过目标的最大 DCT 缩小比例，余下的缩放在解码结果上完成。
+ */
+QImage decodeScannedPage(const FPDF_PAGE pPage, const int nWidth, const int nHeight)
+{
+    if (!pPage || nWidth <= 0 || nHeight <= 0 || FPDFPage_GetRotation(pPage) != 0
+        || FPDFPage_CountObjects(pPage) != 1)
+    {
+        return QImage();
+    }
+    const FPDF_PAGEOBJECT pImage = FPDFPage_GetObject(pPage, 0);
+    if (FPDFPageObj_GetType(pImage) != FPDF_PAGEOBJ_IMAGE || !isJpegImage(pImage) || !coversPage(pPage, pImage))
+    {
+        return QImage();
+    }
+
+    FPDF_IMAGEOBJ_METADATA metadata;
+    if (!FPDFImageObj_GetImageMetadata(pImage, pPage, &metadata)
+        || (metadata.colorspace != FPDF_COLORSPACE_DEVICEGRAY && metadata.colorspace != FPDF_COLORSPACE_DEVICERGB)
+        || metadata.bits_per_pixel % 8 != 0)
+    {
+        return QImage();
+    }
+    // 至少缩小一半才能用上 DCT 域缩小
+    if (static_cast<unsigned int>(nWidth) * 2 > metadata.width
+        || static_cast<unsigned int>(nHeight) * 2 > metadata.height)
+    {
+        return QImage();
+    }
+
+    const unsigned long nLength = FPDFImageObj_GetImageDataRaw(pImage, nullptr, 0);
+    if (nLength == 0)
+    {
+        return QImage();
+    }
+    QByteArray data(static_cast<int>(nLength), Qt::Uninitialized);
+    if (FPDFImageObj_GetImageDataRaw(pImage, data.data(), nLength) != nLength)
+    {
+        return QImage();
+    }
+
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::ReadOnly);
+    QImageReader reader(&buffer, "jpeg");
+    reader.setAutoTransform(false); // PDF 不使用 EXIF 方向
+    reader.setScaledSize(QSize(nWidth, nHeight));
+    const QImage image = reader.read();
+    if (image.isNull())
+    {
+        return QImage();
+    }
+    return image.convertToFormat(image.allGray() ? QImage::Format_Grayscale8 : QImage::Format_RGB32);
+}
@@ -0,0 +1,26 @@
+﻿/*!
+ * @brief 扫描页的快速缩小解码。
+ *
+ * 扫描得到的 PDF 每页通常只有一幅覆盖整页的 JPEG 图像。缩小显示这类页面时（缩略图、后台文档、
+ * 缩小的视图），不经过 PDFium 光栅化，而是用 `FPDFImageObj_GetImageDataRaw` 取出原始 JPEG 数据，
+ * 由 JPEG 解码器在 DCT 域按 1/2、1/4、1/8 缩小解码，只需解码全部系数的一小部分，速度快很多倍。
+ * 目标尺寸超过图像原始分辨率的一半时 DCT 缩小不再带来收益，仍走完整渲染。
+ *
+ * @author LiuYe
+ * @date 2026-10-19
+ * @copyright (c) 2013-2026 Honghu Yuntu Corporation
+ */
+
+#pragma once
+
+#include <QImage>
+
+#include "fpdfview.h"
+
+/*!
+ * @brief 页面只由一幅正立、恰好覆盖可见区域的 JPEG 图像组成时，把图像缩小解码为 nWidth x nHeight。
+ *
+ * 缩小解码后的图像全部像素为灰色时返回 Format_Grayscale8，否则返回 Format_RGB32。
+ * 页面不符合条件或目标尺寸不够小时返回空图像，调用方应改用完整渲染。
+ */
+QImage decodeScannedPage(FPDF_PAGE pPage, int nWidth, int nHeight);
@@ -0,0 +1,286 @@
+﻿/*!
+ * @brief 紧凑 R 树空间索引的实现。
+ *
+ * @author LiuYe
+ * @date 2026-10-19
+ * @copyright (c) 2013-2026 Honghu Yuntu Corporation
+ */
+
+#include "spatial_index.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+    // 每个节点的子项数量
+    const size_t kNodeSize = 16;
+
+    // 增量修改少于该数量时不重建
+    const size_t kMinRebuildThreshold = 64;
+
+    // 计算 16 位网格坐标在 Hilbert 曲线上的序号
+    quint64 hilbertIndex(quint32 x, quint32 y)
+    {
+        const quint32 n = 1u << 16;
+        quint64 d = 0;
+        for (quint32 s = n / 2; s > 0; s /= 2)
+        {
+            const quint32 rx = (x & s) > 0 ? 1u : 0u;
+            const quint32 ry = (y & s) > 0 ? 1u : 0u;
+            d += static_cast<quint64>(s) * s * ((3 * rx) ^ ry);
+            if (ry == 0)
+            {
+                if (rx == 1)
+                {
+                    x = n - 1 - x;
+                    y = n - 1 - y;
+                }
+                std::swap(x, y);
+            }
+        }
+        return d;
+    }
+}
+
+SpatialIndex::SpatialIndex()
+    : m_nLeafCount(0)
+{
+}
+
+SpatialIndex::Box SpatialIndex::toBox(const QRectF& oRect)
+{
+    const QRectF oNormalized = oRect.normalized();
+    Box box;
+    box.fMinX = static_cast<float>(oNormalized.left());
+    box.fMinY = static_cast<float>(oNormalized.top());
+    box.fMaxX = static_cast<float>(oNormalized.right());
+    box.fMaxY = static_cast<float>(oNormalized.bottom());
+    return box;
+}
+
+/*!
+ * @brief 以一批对象批量构建索引。
+ *
+ * @param vecEntries 对象 id 与包围盒，id 重复时以后出现的为准
+ */
+void SpatialIndex::build(const std::vector<std::pair<int, QRectF>>& vecEntries)
+{
+    m_mapLive.clear();
+    m_mapLive.reserve(vecEntries.size());
+    for (size_t i = 0; i < vecEntries.size(); ++i)
+    {
+        m_mapLive[vecEntries[i].first] = toBox(vecEntries[i].second);
+    }
+    rebuild();
+}
+
+void SpatialIndex::clear()
+{
+    m_vecBoxes.clear();
+    m_vecRefs.clear();
+    m_vecLevelEnds.clear();
+    m_nLeafCount = 0;
+    m_mapLive.clear();
+    m_setPacked.clear();
+    m_setStale.clear();
+    m_vecPending.clear();
+}
+
+/*!
+ * @brief 插入对象；id 已存在时更新其包围盒。
+ */
+void SpatialIndex::insert(const int nId, const QRectF& oBounds)
+{
+    remove(nId);
+    m_mapLive[nId] = toBox(oBounds);
+    m_vecPending.push_back(nId);
+    rebuildIfNeeded();
+}
+
+/*!
+ * @brief 删除对象，不存在时忽略。
+ */
+void SpatialIndex::remove(const int nId)
+{
+    if (m_mapLive.erase(nId) == 0)
+    {
+        return;
+    }
+
+    if (m_setPacked.count(nId) != 0)
+    {
+        m_setStale.insert(nId);
+    }
+
+    const std::vector<int>::iterator it = std::find(m_vecPending.begin(), m_vecPending.end(), nId);
+    if (it != m_vecPending.end())
+    {
+        m_vecPending.erase(it);
+    }
+}
+
+bool SpatialIndex::contains(const int nId) const
+{
+    return m_mapLive.count(nId) != 0;
+}
+
+size_t SpatialIndex::size() const
+{
+    return m_mapLive.size();
+}
+
+void SpatialIndex::queryRect(const QRectF& oRect, std::vector<int>& vecIds) const
+{
+    query(toBox(oRect), vecIds);
+}
+
+void SpatialIndex::queryPoint(const QPointF& oPoint, const double dTolerance, std::vector<int>& vecIds) const
+{
+    Box box;
+    box.fMinX = static_cast<float>(oPoint.x() - dTolerance);
+    box.fMinY = static_cast<float>(oPoint.y() - dTolerance);
+    box.fMaxX = static_cast<float>(oPoint.x() + dTolerance);
+    box.fMaxY = static_cast<float>(oPoint.y() + dTolerance);
+    query(box, vecIds);
+}
+
+/*!
+ * @brief 自根节点向下遍历打包的树，再线性扫描待合并项。
+ */
+void SpatialIndex::query(const Box& oBox, std::vector<int>& vecIds) const
+{
+    if (!m_vecBoxes.empty())
+    {
+        // 深度不超过 log16(n)，固定大小的栈足够
+        size_t stack[256];
+        size_t nTop = 0;
+        stack[nTop++] = m_vecBoxes.size() - 1;
+
+        while (nTop > 0)
+        {
+            const size_t nNode = stack[--nTop];
+            if (!m_vecBoxes[nNode].intersects(oBox))
+            {
+                continue;
+            }
+
+            if (nNode < m_nLeafCount)
+            {
+                const int nId = m_vecRefs[nNode];
+                if (m_setStale.empty() || m_setStale.count(nId) == 0)
+                {
+                    vecIds.push_back(nId);
+                }
+                continue;
+            }
+
+            const size_t nFirst = static_cast<size_t>(m_vecRefs[nNode]);
+            const size_t nLevelEnd = *std::upper_bound(m_vecLevelEnds.begin(), m_vecLevelEnds.end(), nFirst);
+            const size_t nLast = std::min(nFirst + kNodeSize, nLevelEnd);
+            for (size_t nChild = nFirst; nChild < nLast && nTop < sizeof(stack) / sizeof(stack[0]); ++nChild)
+            {
+                stack[nTop++] = nChild;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < m_vecPending.size(); ++i)
+    {
+        const std::unordered_map<int, Box>::const_iterator it = m_mapLive.find(m_vecPending[i]);
+        if (it != m_mapLive.end() && it->second.intersects(oBox))
+        {
+            vecIds.push_back(it->first);
+        }
+    }
+}
+
+void SpatialIndex::rebuildIfNeeded()
+{
+    const size_t nDirty = m_vecPending.size() + m_setStale.size();
+    if (nDirty > std::max(kMinRebuildThreshold, m_nLeafCount / 32))
+    {
+        rebuild();
+    }
+}
+
+/*!
+ * @brief 以全部有效对象重新打包整棵树。
+ */
+void SpatialIndex::rebuild()
+{
+    m_vecBoxes.clear();
+    m_vecRefs.clear();
+    m_vecLevelEnds.clear();
+    m_setPacked.clear();
+    m_setStale.clear();
+    m_vecPending.clear();
+    m_nLeafCount = m_mapLive.size();
+    if (m_nLeafCount == 0)
+    {
+        return;
+    }
+
+    // 整体范围，用于把中心点量化到 Hilbert 网格
+    Box extent;
+    extent.fMinX = std::numeric_limits<float>::max();
+    extent.fMinY = std::numeric_limits<float>::max();
+    extent.fMaxX = -std::numeric_limits<float>::max();
+    extent.fMaxY = -std::numeric_limits<float>::max();
+    for (std::unordered_map<int, Box>::const_iterator it = m_mapLive.begin(); it != m_mapLive.end(); ++it)
+    {
+        extent.fMinX = std::min(extent.fMinX, it->second.fMinX);
+        extent.fMinY = std::min(extent.fMinY, it->second.fMinY);
+        extent.fMaxX = std::max(extent.fMaxX, it->second.fMaxX);
+        extent.fMaxY = std::max(extent.fMaxY, it->second.fMaxY);
+    }
+    const double dScaleX = extent.fMaxX > extent.fMinX ? 65535.0 / (extent.fMaxX - extent.fMinX) : 0.0;
+    const double dScaleY = extent.fMaxY > extent.fMinY ? 65535.0 / (extent.fMaxY - extent.fMinY) : 0.0;
+
+    std::vector<std::pair<quint64, int>> vecOrder;
+    vecOrder.reserve(m_nLeafCount);
+    for (std::unordered_map<int, Box>::const_iterator it = m_mapLive.begin(); it != m_mapLive.end(); ++it)
+    {
+        const Box& box = it->second;
+        const double dCenterX = (box.fMinX + box.fMaxX) * 0.5 - extent.fMinX;
+        const double dCenterY = (box.fMinY + box.fMaxY) * 0.5 - extent.fMinY;
+        vecOrder.push_back(std::make_pair(hilbertIndex(static_cast<quint32>(dCenterX * dScaleX),
+            static_cast<quint32>(dCenterY * dScaleY)), it->first));
+    }
+    std::sort(vecOrder.begin(), vecOrder.end());
+
+    m_vecBoxes.reserve(m_nLeafCount + m_nLeafCount / (kNodeSize - 1) + 1);
+    m_vecRefs.reserve(m_vecBoxes.capacity());
+    for (size_t i = 0; i < vecOrder.size(); ++i)
+    {
+        m_vecBoxes.push_back(m_mapLive[vecOrder[i].second]);
+        m_vecRefs.push_back(vecOrder[i].second);
+        m_setPacked.insert(vecOrder[i].second);
+    }
+    m_vecLevelEnds.push_back(m_nLeafCount);
+
+    // 逐层把相邻的 kNodeSize 个节点合并为上一层的一个节点，直到只剩根节点
+    size_t nLevelBegin = 0;
+    size_t nLevelEnd = m_nLeafCount;
+    while (nLevelEnd - nLevelBegin > 1)
+    {
+        for (size_t nFirst = nLevelBegin; nFirst < nLevelEnd; nFirst += kNodeSize)
+        {
+            Box node = m_vecBoxes[nFirst];
+            const size_t nLast = std::min(nFirst + kNodeSize, nLevelEnd);
+            for (size_t nChild = nFirst + 1; nChild < nLast; ++nChild)
+            {
+                const Box& child = m_vecBoxes[nChild];
+                node.fMinX = std::min(node.fMinX, child.fMinX);
+                node.fMinY = std::min(node.fMinY, child.fMinY);
+                node.fMaxX = std::max(node.fMaxX, child.fMaxX);
+                node.fMaxY = std::max(node.fMaxY, child.fMaxY);
+            }
+            m_vecBoxes.push_back(node);
+            m_vecRefs.push_back(static_cast<int>(nFirst));
+        }
+        nLevelBegin = nLevelEnd;
+        nLevelEnd = m_vecBoxes.size();
+        m_vecLevelEnds.push_back(nLevelEnd);
+    }
+}
@@ -0,0 +1,84 @@
+﻿/*!
+ * @brief 页面对象的二维空间索引。
+ *
+ * 本文件定义了 `SpatialIndex`，一个按 Hilbert 曲线排序、批量构建的紧凑 R 树，
+ * 用于在页面坐标系中按点或按矩形快速查找注释、链接等对象。
+ * 树以连续数组存储，查询不做任何内存分配（结果容器除外）。
+ *
+ * @author LiuYe
+ * @date 2026-10-19
+ * @copyright (c) 2013-2026 Honghu Yuntu Corporation
+ */
+
+#pragma once
+
+#include <QPointF>
+#include <QRectF>
+
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/*!
+ * @brief 紧凑 R 树，支持批量构建、点/矩形查询以及增量更新。
+ *
+ * 批量构建时按包围盒中心的 Hilbert 值排序，每 16 个相邻项打包成一个节点，逐层向上构建。
+ * 构建后的增删改不修改打包好的树：删除或移动的项记为失效，新增或移动后的项放入一个
+ * 小的待合并列表线性扫描；待合并项和失效项累积到一定比例后整体重建。
+ *
+ * 对象以整数 id 标识，包围盒使用页面坐标（PDF 用户空间，y 轴向上），
+ * QRectF 的 top() 即最小 y 值。
+ *
+ * @date 2026.10.19
+ */
+class SpatialIndex
+{
+public:
+    SpatialIndex();
+
+    // 以一批对象重建索引，已有内容全部丢弃
+    void build(const std::vector<std::pair<int, QRectF>>& vecEntries);
+    void clear();
+
+    // 增量更新：插入或更新同 id 对象、删除对象
+    void insert(int nId, const QRectF& oBounds);
+    void remove(int nId);
+
+    bool contains(int nId) const;
+    size_t size() const;
+
+    // 查询与矩形相交的对象，结果追加到 vecIds
+    void queryRect(const QRectF& oRect, std::vector<int>& vecIds) const;
+
+    // 查询包含该点（允许 dTolerance 误差）的对象，结果追加到 vecIds
+    void queryPoint(const QPointF& oPoint, double dTolerance, std::vector<int>& vecIds) const;
+
+private:
+    struct Box
+    {
+        float fMinX;
+        float fMinY;
+        float fMaxX;
+        float fMaxY;
+
+        bool intersects(const Box& other) const
+        {
+            return fMinX <= other.fMaxX && other.fMinX <= fMaxX && fMinY <= other.fMaxY && other.fMinY <= fMaxY;
+        }
+    };
+
+    static Box toBox(const QRectF& oRect);
+    void query(const Box& oBox, std::vector<int>& vecIds) const;
+    void rebuildIfNeeded();
+    void rebuild();
+
+    std::vector<Box> m_vecBoxes;            // 叶子项在前，其后逐层存放内部节点，根节点在最后
+    std::vector<int> m_vecRefs;             // 叶子项对应对象 id，内部节点对应首个子节点下标
+    std::vector<size_t> m_vecLevelEnds;     // 每一层在 m_vecBoxes 中的结束下标
+    size_t m_nLeafCount;                    // 打包进树的叶子项数量
+
+    std::unordered_map<int, Box> m_mapLive;  // 当前有效对象及其包围盒
+    std::unordered_set<int> m_setPacked;     // 打包进树的对象 id
+    std::unordered_set<int> m_setStale;      // 树中已删除或已移动的对象 id
+    std::vector<int> m_vecPending;           // 尚未打包进树的对象 id
+};
@@ -0,0 +1,167 @@
+﻿/*!
+ * @brief 启动阶段计时的实现。
+ *
+ * @author LiuYe
+ * @date 2026-10-19
+ * @copyright (c) 2013-2026 Honghu Yuntu Corporation
+ */
+
+#include "startup_profiler.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QStandardPaths>
+#include <QTextStream>
+
+#include <iostream>
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#elif defined(Q_OS_LINUX)
+#include <unistd.h>
+#endif
+
+namespace
+{
+    const char* const kPhaseNames[StartupProfiler::PhaseCount] =
+    {
+        "process start",
+        "Qt init",
+        "window shown",
+        "PDFium init",
+        "first page painted"
+    };
+
+    /*!
+     * @brief 进程已存在的毫秒数，无法获取时返回 0。
+     *
+     * Linux 上精度为一个时钟节拍（通常 10 ms）。
+     */
+    double processAgeMs()
+    {
+#if defined(Q_OS_WIN)
+        FILETIME creation;
+        FILETIME exit;
+        FILETIME kernel;
+        FILETIME user;
+        if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user))
+        {
+            return 0.0;
+        }
+        FILETIME now;
+        GetSystemTimeAsFileTime(&now);
+        const quint64 nCreation = (static_cast<quint64>(creation.dwHighDateTime) << 32) | creation.dwLowDateTime;
+        const quint64 nNow = (static_cast<quint64>(now.dwHighDateTime) << 32) | now.dwLowDateTime;
+        return nNow > nCreation ? (nNow - nCreation) / 10000.0 : 0.0; // 100 ns 为单位
+#elif defined(Q_OS_LINUX)
+        // /proc/self/stat 第 22 项为进程启动时刻（开机后的时钟节拍数），/proc/uptime 为开机时长（秒）
+        QFile stat("/proc/self/stat");
+        QFile uptime("/proc/uptime");
+        if (!stat.open(QIODevice::ReadOnly) || !uptime.open(QIODevice::ReadOnly))
+        {
+            return 0.0;
+        }
+        const QByteArray statLine = stat.readAll();
+        const int nCommEnd = statLine.lastIndexOf(')');   // 进程名可能含空格，从其后开始分割
+        const QList<QByteArray> lstFields = statLine.mid(nCommEnd + 2).split(' ');
+        const double dUptime = uptime.readAll().split(' ').value(0).toDouble();
+        if (nCommEnd < 0 || lstFields.size() < 20 || dUptime <= 0.0)
+        {
+            return 0.0;
+        }
+        const double dStart = lstFields[19].toDouble() / sysconf(_SC_CLK_TCK);  // 第 22 项
+        return dUptime > dStart ? (dUptime - dStart) * 1000.0 : 0.0;
+#else
+        return 0.0;
+#endif
+    }
+}
+
+StartupProfiler& StartupProfiler::instance()
+{
+    static StartupProfiler profiler;
+    return profiler;
+}
+
+StartupProfiler::StartupProfiler()
+    : m_dProcessAgeMs(processAgeMs()), m_eReportPhase(FirstPagePainted), m_bReported(false)
+{
+    m_oTimer.start();
+    for (int i = 0; i < PhaseCount; ++i)
+    {
+        m_aMarks[i] = -1.0;
+    }
+}
+
+void StartupProfiler::mark(const Phase ePhase)
+{
+    bool bReport = false;
+    {
+        std::lock_guard<std::mutex> lock(m_oMutex);
+        if (m_aMarks[ePhase] >= 0.0)
+        {
+            return;
+        }
+        m_aMarks[ePhase] = m_dProcessAgeMs + m_oTimer.nsecsElapsed() / 1000000.0;
+        bReport = ePhase == m_eReportPhase && !m_bReported;
+        m_bReported = m_bReported || bReport;
+    }
+    if (bReport)
+    {
+        report();
+    }
+}
+
+void StartupProfiler::setReportPhase(const Phase ePhase)
+{
+    bool bReport = false;
+    {
+        std::lock_guard<std::mutex> lock(m_oMutex);
+        m_eReportPhase = ePhase;
+        bReport = m_aMarks[ePhase] >= 0.0 && !m_bReported;
+        m_bReported = m_bReported || bReport;
+    }
+    if (bReport)
+    {
+        report();
+    }
+}
+
+double StartupProfiler::elapsedMs(const Phase ePhase) const
+{
+    std::lock_guard<std::mutex> lock(m_oMutex);
+    return m_aMarks[ePhase];
+}
+
+/*!
+ * @brief 按完成顺序输出各阶段时刻。
+ */
+void StartupProfiler::report()
+{
+    QString strLine = "startup:";
+    for (int i = 0; i < PhaseCount; ++i)
+    {
+        const double dMs = elapsedMs(static_cast<Phase>(i));
+        if (dMs >= 0.0)
+        {
+            strLine += QString(" %1 %2 ms,").arg(kPhaseNames[i]).arg(dMs, 0, 'f', 1);
+        }
+    }
+    strLine.chop(1);
+    const double dWindowShown = elapsedMs(WindowShown);
+    if (dWindowShown > kWindowShownBudgetMs)
+    {
+        strLine += QString(" (window shown over %1 ms budget)").arg(kWindowShownBudgetMs);
+    }
+
+    std::cerr << strLine.toStdString() << '\n';
+
+    const QString strDir = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation);
+    QDir().mkpath(strDir);
+    QFile log(strDir + "/startup.log");
+    if (log.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text))
+    {
+        QTextStream(&log) << QDateTime::currentDateTime().toString(Qt::ISODate) << ' ' << strLine << '\n';
+    }
+}
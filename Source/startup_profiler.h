@@ -0,0 +1,64 @@
+﻿/*!
+ * @brief 启动阶段计时。
+ *
+ * `StartupProfiler` 记录从进程创建开始各启动阶段完成的时刻：进入 main、Qt 初始化完成、主窗口首帧
+ * 绘制、PDFium 初始化完成、首个页面绘制。最后一个关注的阶段完成后，把结果写到标准错误和
+ * 本地数据目录下的 `startup.log`，冷启动到窗口显示超出 200 ms 预算时在日志中注明。
+ *
+ * 各阶段只记录第一次发生的时刻，可在任意线程调用。
+ *
+ * @author LiuYe
+ * @date 2026-10-19
+ * @copyright (c) 2013-2026 Honghu Yuntu Corporation
+ */
+
+#pragma once
+
+#include <QElapsedTimer>
+
+#include <mutex>
+
+/*!
+ * @brief 启动阶段计时器，进程内唯一。
+ *
+ * @date 2026.10.19
+ */
+class StartupProfiler
+{
+public:
+    enum Phase
+    {
+        ProcessStart = 0,             // 进入 main，包含动态库加载时间
+        QtInitialized,                // QApplication 构造完成
+        WindowShown,                  // 主窗口首帧绘制
+        PdfiumInitialized,            // PDFium 库初始化完成（首次打开文档时）
+        FirstPagePainted,             // 首个页面位图绘制到屏幕
+        PhaseCount
+    };
+
+    // 冷启动到窗口显示的目标时间
+    static const int kWindowShownBudgetMs = 200;
+
+    static StartupProfiler& instance();
+
+    // 记录阶段完成的时刻，重复调用忽略；完成的是报告阶段时输出报告
+    void mark(Phase ePhase);
+
+    // 设置输出报告的阶段，默认为首个页面绘制；没有要打开的文档时设为窗口显示
+    void setReportPhase(Phase ePhase);
+
+    // 阶段完成时刻（距进程创建的毫秒数），未完成返回负数
+    double elapsedMs(Phase ePhase) const;
+
+private:
+    StartupProfiler();
+
+    void report();
+
+    mutable std::mutex m_oMutex;
+    QElapsedTimer m_oTimer;
+    double m_dProcessAgeMs;           // 计时器启动时进程已存在的时间
+    double m_aMarks[PhaseCount];
+    Phase m_eReportPhase;
+    bool m_bReported;
+};
@@ -0,0 +1,987 @@
+﻿/*!
+ * @brief 基于预建索引的系统字体提供者的实现。
+ *
+ * @author LiuYe
+ * @date 2026-10-19
+ * @copyright (c) 2013-2026 Honghu Yuntu Corporation
+ */
+
+#include "system_font_index.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QSet>
+#include <QStandardPaths>
+#include <QtEndian>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+/*!
+ * @brief 索引文件布局：Header、FileRecord[nFileCount]、FaceRecord[nFaceCount]、字符串区。
+ *
+ * 字符串均为 UTF-8，不含结尾的 NUL，以（偏移，长度）引用。
+ */
+struct SystemFontIndex::Header
+{
+    quint32 nMagic;
+    quint32 nVersion;
+    quint64 nFingerprint;             // 字体目录树的指纹
+    quint32 nFileCount;
+    quint32 nFaceCount;
+    quint32 nStringBytes;
+    quint32 nReserved;
+};
+
+struct SystemFontIndex::FileRecord
+{
+    quint32 nPathOffset;
+    quint32 nPathLength;
+    qint64 nSize;
+    qint64 nModified;                 // 修改时间（毫秒），映射前校验
+};
+
+struct SystemFontIndex::FaceRecord
+{
+    quint32 nFile;
+    quint32 nFaceOffset;              // 表目录在文件中的偏移，TTC 中各字体不同
+    quint32 nFamilyOffset;
+    quint32 nFamilyLength;
+    quint32 nFamilyKeyOffset;         // 规范化的家族名
+    quint32 nFamilyKeyLength;
+    quint32 nPostScriptKeyOffset;     // 规范化的 PostScript 名
+    quint32 nPostScriptKeyLength;
+    quint32 nCharsetMask;             // kCharsets 中各字符集对应的位
+    quint16 nWeight;
+    quint8 nItalic;
+    quint8 nPitchFamily;              // FXFONT_FF_* 组合
+    quint8 nCollection;               // 是否来自 TTC/OTC
+    quint8 aReserved[3];
+};
+
+namespace
+{
+    const quint32 kIndexMagic = 0x4B504649;   // "KPFI"
+    const quint32 kIndexVersion = 1;
+    const quint32 kTagTtcf = 0x74746366;      // 'ttcf'
+    const quint32 kTagName = 0x6E616D65;      // 'name'
+    const quint32 kTagOs2 = 0x4F532F32;       // 'OS/2'
+    const quint32 kTagPost = 0x706F7374;      // 'post'
+    const quint32 kTagHead = 0x68656164;      // 'head'
+
+    // 字符集与 OS/2 ulCodePageRange1 中对应位
+    const struct
+    {
+        int nCharset;
+        int nCodePageBit;
+    } kCharsets[] =
+    {
+        { FXFONT_ANSI_CHARSET, 0 },
+        { FXFONT_EASTERNEUROPEAN_CHARSET, 1 },
+        { FXFONT_CYRILLIC_CHARSET, 2 },
+        { FXFONT_GREEK_CHARSET, 3 },
+        { FXFONT_HEBREW_CHARSET, 5 },
+        { FXFONT_ARABIC_CHARSET, 6 },
+        { FXFONT_VIETNAMESE_CHARSET, 8 },
+        { FXFONT_THAI_CHARSET, 16 },
+        { FXFONT_SHIFTJIS_CHARSET, 17 },
+        { FXFONT_GB2312_CHARSET, 18 },
+        { FXFONT_HANGEUL_CHARSET, 19 },
+        { FXFONT_CHINESEBIG5_CHARSET, 20 },
+        { FXFONT_SYMBOL_CHARSET, 31 }
+    };
+    const int kCharsetCount = static_cast<int>(sizeof(kCharsets) / sizeof(kCharsets[0]));
+
+    static_assert(sizeof(quint32) * 8 >= kCharsetCount, "charset mask overflow");
+
+    int charsetBit(const int nCharset)
+    {
+        for (int i = 0; i < kCharsetCount; ++i)
+        {
+            if (kCharsets[i].nCharset == nCharset)
+            {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    quint16 readU16(const uchar* p)
+    {
+        return qFromBigEndian<quint16>(p);
+    }
+
+    quint32 readU32(const uchar* p)
+    {
+        return qFromBigEndian<quint32>(p);
+    }
+
+    // 在 nFaceOffset 处的表目录中查找表，越界时视为不存在
+    bool findTable(const uchar* pData, const qint64 nSize, const quint32 nFaceOffset, const quint32 nTag,
+        quint32* pOffset, quint32* pLength)
+    {
+        if (static_cast<qint64>(nFaceOffset) + 12 > nSize)
+        {
+            return false;
+        }
+        const int nTables = readU16(pData + nFaceOffset + 4);
+        for (int i = 0; i < nTables; ++i)
+        {
+            const qint64 nRecord = static_cast<qint64>(nFaceOffset) + 12 + 16 * i;
+            if (nRecord + 16 > nSize)
+            {
+                return false;
+            }
+            if (readU32(pData + nRecord) != nTag)
+            {
+                continue;
+            }
+            const quint32 nOffset = readU32(pData + nRecord + 8);
+            const quint32 nLength = readU32(pData + nRecord + 12);
+            if (static_cast<qint64>(nOffset) + nLength > nSize)
+            {
+                return false;
+            }
+            *pOffset = nOffset;
+            *pLength = nLength;
+            return true;
+        }
+        return false;
+    }
+
+    // 家族名匹配用的键：去掉子集前缀（ABCDEF+），只保留小写字母和数字
+    QByteArray normalizedKey(const QByteArray& name)
+    {
+        int nStart = 0;
+        if (name.size() > 7 && name[6] == '+')
+        {
+            nStart = 7;
+        }
+        QByteArray key;
+        key.reserve(name.size() - nStart);
+        for (int i = nStart; i < name.size(); ++i)
+        {
+            const char c = name[i];
+            if (c >= 'A' && c <= 'Z')
+            {
+                key.append(static_cast<char>(c - 'A' + 'a'));
+            }
+            else if ((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || (c & 0x80))
+            {
+                key.append(c);
+            }
+        }
+        return key;
+    }
+
+    /*!
+     * @brief 读取 name 表中的名称，优先 Windows 平台英文名，其次任意 Windows 平台名，最后 Mac 罗马字名。
+     */
+    QString readName(const uchar* pData, const qint64 nSize, const quint32 nFaceOffset, const int nNameId)
+    {
+        quint32 nTable = 0;
+        quint32 nTableLength = 0;
+        if (!findTable(pData, nSize, nFaceOffset, kTagName, &nTable, &nTableLength) || nTableLength < 6)
+        {
+            return QString();
+        }
+        const uchar* pTable = pData + nTable;
+        const int nCount = readU16(pTable + 2);
+        const quint32 nStorage = readU16(pTable + 4);
+
+        QString strBest;
+        int nBestRank = 0;
+        for (int i = 0; i < nCount; ++i)
+        {
+            const quint32 nRecord = 6 + 12 * i;
+            if (nRecord + 12 > nTableLength)
+            {
+                break;
+            }
+            const uchar* p = pTable + nRecord;
+            const int nPlatform = readU16(p);
+            const int nEncoding = readU16(p + 2);
+            const int nLanguage = readU16(p + 4);
+            if (readU16(p + 6) != nNameId)
+            {
+                continue;
+            }
+            const quint32 nLength = readU16(p + 8);
+            const quint32 nOffset = nStorage + readU16(p + 10);
+            if (nOffset + nLength > nTableLength)
+            {
+                continue;
+            }
+
+            int nRank = 0;
+            if (nPlatform == 3 && (nEncoding == 1 || nEncoding == 10))
+            {
+                nRank = nLanguage == 0x409 ? 3 : 2;
+            }
+            else if (nPlatform == 1 && nEncoding == 0 && nLanguage == 0)
+            {
+                nRank = 1;
+            }
+            if (nRank <= nBestRank)
+            {
+                continue;
+            }
+
+            const uchar* pString = pTable + nOffset;
+            if (nPlatform == 3)
+            {
+                QString strName;
+                for (quint32 j = 0; j + 1 < nLength; j += 2)
+                {
+                    strName.append(QChar(readU16(pString + j)));
+                }
+                strBest = strName;
+            }
+            else
+            {
+                strBest = QString::fromLatin1(reinterpret_cast<const char*>(pString), static_cast<int>(nLength));
+            }
+            nBestRank = nRank;
+        }
+        return strBest.trimmed();
+    }
+
+    /*!
+     * @brief 待写入索引的一个字体。
+     */
+    struct ScannedFace
+    {
+        quint32 nFile;
+        quint32 nFaceOffset;
+        QByteArray family;
+        QByteArray postScript;
+        quint32 nCharsetMask;
+        int nWeight;
+        bool bItalic;
+        int nPitchFamily;
+        bool bCollection;
+    };
+
+    // 解析一个字体的元数据，没有家族名的字体不收录
+    bool scanFace(const uchar* pData, const qint64 nSize, const quint32 nFaceOffset, ScannedFace& face)
+    {
+        face.family = readName(pData, nSize, nFaceOffset, 1).toUtf8();
+        if (face.family.isEmpty())
+        {
+            return false;
+        }
+        face.postScript = readName(pData, nSize, nFaceOffset, 6).toUtf8();
+        face.nFaceOffset = nFaceOffset;
+        face.nWeight = FXFONT_FW_NORMAL;
+        face.bItalic = false;
+        face.nPitchFamily = 0;
+        face.nCharsetMask = 1u << charsetBit(FXFONT_ANSI_CHARSET);
+
+        quint32 nTable = 0;
+        quint32 nLength = 0;
+        if (findTable(pData, nSize, nFaceOffset, kTagOs2, &nTable, &nLength) && nLength >= 64)
+        {
+            const uchar* pOs2 = pData + nTable;
+            face.nWeight = readU16(pOs2 + 4);
+            face.bItalic = (readU16(pOs2 + 62) & 0x01) != 0;
+            const int nFamilyClass = pOs2[30];
+            if ((nFamilyClass >= 1 && nFamilyClass <= 5) || nFamilyClass == 7)
+            {
+                face.nPitchFamily |= FXFONT_FF_ROMAN;
+            }
+            else if (nFamilyClass == 10)
+            {
+                face.nPitchFamily |= FXFONT_FF_SCRIPT;
+            }
+            if (readU16(pOs2) >= 1 && nLength >= 86)
+            {
+                const quint32 nCodePages = readU32(pOs2 + 78);
+                quint32 nMask = 0;
+                for (int i = 0; i < kCharsetCount; ++i)
+                {
+                    if (nCodePages & (1u << kCharsets[i].nCodePageBit))
+                    {
+                        nMask |= 1u << i;
+                    }
+                }
+                if (nMask != 0)
+                {
+                    face.nCharsetMask = nMask;
+                }
+            }
+        }
+        else if (findTable(pData, nSize, nFaceOffset, kTagHead, &nTable, &nLength) && nLength >= 46)
+        {
+            const int nMacStyle = readU16(pData + nTable + 44);
+            face.nWeight = (nMacStyle & 0x01) ? FXFONT_FW_BOLD : FXFONT_FW_NORMAL;
+            face.bItalic = (nMacStyle & 0x02) != 0;
+        }
+        if (findTable(pData, nSize, nFaceOffset, kTagPost, &nTable, &nLength) && nLength >= 16
+            && readU32(pData + nTable + 12) != 0)
+        {
+            face.nPitchFamily |= FXFONT_FF_FIXEDPITCH;
+        }
+        return true;
+    }
+
+    // FNV-1a
+    quint64 hashBytes(quint64 nHash, const QByteArray& bytes)
+    {
+        for (int i = 0; i < bytes.size(); ++i)
+        {
+            nHash ^= static_cast<uchar>(bytes[i]);
+            nHash *= 1099511628211ull;
+        }
+        return nHash;
+    }
+
+    void* faceHandle(const int nIndex)
+    {
+        return reinterpret_cast<void*>(static_cast<quintptr>(nIndex) + 1);
+    }
+
+    /*!
+     * @brief 注册给 PDFium 的接口，回调转发到 SystemFontIndex。
+     */
+    struct IndexFontInfo : public FPDF_SYSFONTINFO
+    {
+        SystemFontIndex* pIndex;
+    };
+
+    SystemFontIndex& indexOf(FPDF_SYSFONTINFO* pThis)
+    {
+        return *static_cast<IndexFontInfo*>(pThis)->pIndex;
+    }
+
+    void releaseCallback(FPDF_SYSFONTINFO*)
+    {
+    }
+
+    void enumFontsCallback(FPDF_SYSFONTINFO* pThis, void* pMapper)
+    {
+        indexOf(pThis).enumFonts(pMapper);
+    }
+
+    void* mapFontCallback(FPDF_SYSFONTINFO* pThis, int nWeight, FPDF_BOOL bItalic, int nCharset, int nPitchFamily,
+        const char* pFace, FPDF_BOOL* pExact)
+    {
+        bool bExact = false;
+        void* hFont = indexOf(pThis).mapFont(nWeight, bItalic != 0, nCharset, nPitchFamily, pFace, &bExact);
+        if (pExact)
+        {
+            *pExact = bExact;
+        }
+        return hFont;
+    }
+
+    void* getFontCallback(FPDF_SYSFONTINFO* pThis, const char* pFace)
+    {
+        return indexOf(pThis).getFont(pFace);
+    }
+
+    unsigned long getFontDataCallback(FPDF_SYSFONTINFO* pThis, void* hFont, unsigned int nTable,
+        unsigned char* pBuffer, unsigned long nSize)
+    {
+        return indexOf(pThis).getFontData(hFont, nTable, pBuffer, nSize);
+    }
+
+    unsigned long getFaceNameCallback(FPDF_SYSFONTINFO* pThis, void* hFont, char* pBuffer, unsigned long nSize)
+    {
+        return indexOf(pThis).getFaceName(hFont, pBuffer, nSize);
+    }
+
+    int getFontCharsetCallback(FPDF_SYSFONTINFO* pThis, void* hFont)
+    {
+        return indexOf(pThis).getFontCharset(hFont);
+    }
+
+    void deleteFontCallback(FPDF_SYSFONTINFO*, void*)
+    {
+        // 句柄只是索引下标，字体文件映射在进程内复用
+    }
+}
+
+SystemFontIndex& SystemFontIndex::instance()
+{
+    static SystemFontIndex index;
+    return index;
+}
+
+SystemFontIndex::SystemFontIndex()
+    : m_pData(nullptr), m_nSize(0), m_pHeader(nullptr), m_pFiles(nullptr), m_pFaces(nullptr), m_pStrings(nullptr),
+      m_pFontInfo(nullptr)
+{
+    // 索引按原样映射使用，布局不能随编译器变化
+    static_assert(sizeof(Header) == 32, "unexpected index header layout");
+    static_assert(sizeof(FileRecord) == 24, "unexpected index file record layout");
+    static_assert(sizeof(FaceRecord) == 44, "unexpected index face record layout");
+}
+
+/*!
+ * @brief 打开索引：目录指纹与索引头一致时直接映射，否则重新扫描字体目录并写入新索引。
+ *
+ * 新索引经 QSaveFile 原子替换，其他进程已映射的旧索引不受影响。
+ *
+ * @return 索引是否可用
+ */
+bool SystemFontIndex::open()
+{
+    if (m_pHeader)
+    {
+        return true;
+    }
+
+    const QStringList lstDirectories = fontDirectories();
+    if (lstDirectories.isEmpty())
+    {
+        return false;
+    }
+    const quint64 nFingerprint = directoryFingerprint(lstDirectories);
+    const QString strPath = indexPath();
+    if (mapIndex(strPath, nFingerprint))
+    {
+        return true;
+    }
+    return build(strPath, lstDirectories, nFingerprint) && mapIndex(strPath, nFingerprint);
+}
+
+int SystemFontIndex::faceCount() const
+{
+    return m_pHeader ? static_cast<int>(m_pHeader->nFaceCount) : 0;
+}
+
+FPDF_SYSFONTINFO* SystemFontIndex::fontInfo()
+{
+    if (!m_pFontInfo)
+    {
+        IndexFontInfo* pInfo = new IndexFontInfo;
+        std::memset(pInfo, 0, sizeof(IndexFontInfo));
+        pInfo->version = 1;
+        pInfo->Release = releaseCallback;
+        pInfo->EnumFonts = enumFontsCallback;
+        pInfo->MapFont = mapFontCallback;
+        pInfo->GetFont = getFontCallback;
+        pInfo->GetFontData = getFontDataCallback;
+        pInfo->GetFaceName = getFaceNameCallback;
+        pInfo->GetFontCharset = getFontCharsetCallback;
+        pInfo->DeleteFont = deleteFontCallback;
+        pInfo->pIndex = this;
+        m_pFontInfo = pInfo;
+    }
+    return m_pFontInfo;
+}
+
+// 放在公共缓存目录，所有进程共用同一份索引
+QString SystemFontIndex::indexPath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + "/KnowingPDF/font-index.bin";
+}
+
+QStringList SystemFontIndex::fontDirectories()
+{
+    QStringList lstCandidates = QStandardPaths::standardLocations(QStandardPaths::FontsLocation);
+#if defined(Q_OS_MAC)
+    lstCandidates << "/System/Library/Fonts" << "/Library/Fonts" << QDir::homePath() + "/Library/Fonts";
+#elif defined(Q_OS_UNIX)
+    lstCandidates << "/usr/share/fonts" << "/usr/local/share/fonts" << QDir::homePath() + "/.fonts"
+        << QDir::homePath() + "/.local/share/fonts";
+#endif
+
+    QStringList lstDirectories;
+    for (int i = 0; i < lstCandidates.size(); ++i)
+    {
+        const QString strCanonical = QFileInfo(lstCandidates[i]).canonicalFilePath();
+        if (!strCanonical.isEmpty() && QFileInfo(strCanonical).isDir() && !lstDirectories.contains(strCanonical))
+        {
+            lstDirectories << strCanonical;
+        }
+    }
+    lstDirectories.sort();
+    return lstDirectories;
+}
+
+/*!
+ * @brief 计算字体目录树的指纹。
+ *
+ * 只读取目录的修改时间而不打开字体文件：增删字体文件都会改变所在目录的修改时间。
+ */
+quint64 SystemFontIndex::directoryFingerprint(const QStringList& lstDirectories)
+{
+    QStringList lstEntries;
+    for (int i = 0; i < lstDirectories.size(); ++i)
+    {
+        lstEntries << lstDirectories[i] + '|'
+            + QString::number(QFileInfo(lstDirectories[i]).lastModified().toMSecsSinceEpoch());
+        QDirIterator it(lstDirectories[i], QDir::Dirs | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+        while (it.hasNext())
+        {
+            it.next();
+            lstEntries << it.filePath() + '|' + QString::number(it.fileInfo().lastModified().toMSecsSinceEpoch());
+        }
+    }
+    lstEntries.sort();
+
+    quint64 nHash = 14695981039346656037ull;
+    for (int i = 0; i < lstEntries.size(); ++i)
+    {
+        nHash = hashBytes(nHash, lstEntries[i].toUtf8());
+    }
+    return nHash;
+}
+
+/*!
+ * @brief 扫描字体目录中的 TrueType/OpenType 字体（含 TTC/OTC），写入索引文件。
+ *
+ * Type1 字体没有表目录，无法按表提供数据，不收录，由 PDFium 内置字体替代。
+ */
+bool SystemFontIndex::build(const QString& strPath, const QStringList& lstDirectories, const quint64 nFingerprint)
+{
+    QVector<FileRecord> vecFiles;
+    QVector<ScannedFace> vecFaces;
+    QByteArray strings;
+    QSet<QString> setSeen;
+
+    const QStringList lstFilters = QStringList() << "*.ttf" << "*.otf" << "*.ttc" << "*.otc";
+    for (int d = 0; d < lstDirectories.size(); ++d)
+    {
+        QDirIterator it(lstDirectories[d], lstFilters, QDir::Files, QDirIterator::Subdirectories);
+        while (it.hasNext())
+        {
+            it.next();
+            const QString strFile = it.fileInfo().canonicalFilePath();
+            if (strFile.isEmpty() || setSeen.contains(strFile))
+            {
+                continue;
+            }
+            setSeen.insert(strFile);
+
+            QFile file(strFile);
+            if (!file.open(QIODevice::ReadOnly) || file.size() < 12)
+            {
+                continue;
+            }
+            const qint64 nSize = file.size();
+            const uchar* pData = file.map(0, nSize);
+            if (!pData)
+            {
+                continue;
+            }
+
+            QVector<quint32> vecOffsets;
+            const bool bCollection = readU32(pData) == kTagTtcf;
+            if (bCollection)
+            {
+                const quint32 nFaces = readU32(pData + 8);
+                for (quint32 i = 0; i < nFaces && 12 + 4 * static_cast<qint64>(i) + 4 <= nSize; ++i)
+                {
+                    vecOffsets << readU32(pData + 12 + 4 * i);
+                }
+            }
+            else
+            {
+                vecOffsets << 0;
+            }
+
+            const quint32 nFileIndex = static_cast<quint32>(vecFiles.size());
+            bool bAnyFace = false;
+            for (int i = 0; i < vecOffsets.size(); ++i)
+            {
+                ScannedFace face;
+                face.nFile = nFileIndex;
+                face.bCollection = bCollection;
+                if (scanFace(pData, nSize, vecOffsets[i], face))
+                {
+                    vecFaces << face;
+                    bAnyFace = true;
+                }
+            }
+            file.unmap(const_cast<uchar*>(pData));
+
+            if (bAnyFace)
+            {
+                const QByteArray path = strFile.toUtf8();
+                FileRecord record;
+                record.nPathOffset = static_cast<quint32>(strings.size());
+                record.nPathLength = static_cast<quint32>(path.size());
+                record.nSize = nSize;
+                record.nModified = it.fileInfo().lastModified().toMSecsSinceEpoch();
+                strings.append(path);
+                vecFiles << record;
+            }
+        }
+    }
+
+    QVector<FaceRecord> vecRecords;
+    vecRecords.reserve(vecFaces.size());
+    for (int i = 0; i < vecFaces.size(); ++i)
+    {
+        const ScannedFace& face = vecFaces[i];
+        const QByteArray familyKey = normalizedKey(face.family);
+        const QByteArray postScriptKey = normalizedKey(face.postScript);
+
+        FaceRecord record;
+        std::memset(&record, 0, sizeof(record));
+        record.nFile = face.nFile;
+        record.nFaceOffset = face.nFaceOffset;
+        record.nFamilyOffset = static_cast<quint32>(strings.size());
+        record.nFamilyLength = static_cast<quint32>(face.family.size());
+        strings.append(face.family);
+        record.nFamilyKeyOffset = static_cast<quint32>(strings.size());
+        record.nFamilyKeyLength = static_cast<quint32>(familyKey.size());
+        strings.append(familyKey);
+        record.nPostScriptKeyOffset = static_cast<quint32>(strings.size());
+        record.nPostScriptKeyLength = static_cast<quint32>(postScriptKey.size());
+        strings.append(postScriptKey);
+        record.nCharsetMask = face.nCharsetMask;
+        record.nWeight = static_cast<quint16>(face.nWeight);
+        record.nItalic = face.bItalic ? 1 : 0;
+        record.nPitchFamily = static_cast<quint8>(face.nPitchFamily);
+        record.nCollection = face.bCollection ? 1 : 0;
+        vecRecords << record;
+    }
+
+    Header header;
+    header.nMagic = kIndexMagic;
+    header.nVersion = kIndexVersion;
+    header.nFingerprint = nFingerprint;
+    header.nFileCount = static_cast<quint32>(vecFiles.size());
+    header.nFaceCount = static_cast<quint32>(vecRecords.size());
+    header.nStringBytes = static_cast<quint32>(strings.size());
+    header.nReserved = 0;
+
+    QDir().mkpath(QFileInfo(strPath).absolutePath());
+    QSaveFile file(strPath);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(vecFiles.constData()), vecFiles.size() * sizeof(FileRecord));
+    file.write(reinterpret_cast<const char*>(vecRecords.constData()), vecRecords.size() * sizeof(FaceRecord));
+    file.write(strings);
+    return file.commit();
+}
+
+// 映射索引文件并校验；指纹不符、版本不符或大小不一致时返回 false
+bool SystemFontIndex::mapIndex(const QString& strPath, const quint64 nFingerprint)
+{
+    m_oIndexFile.setFileName(strPath);
+    if (!m_oIndexFile.open(QIODevice::ReadOnly) || m_oIndexFile.size() < static_cast<qint64>(sizeof(Header)))
+    {
+        m_oIndexFile.close();
+        return false;
+    }
+    const qint64 nSize = m_oIndexFile.size();
+    const uchar* pData = m_oIndexFile.map(0, nSize);
+    const Header* pHeader = reinterpret_cast<const Header*>(pData);
+    const bool bValid = pData && pHeader->nMagic == kIndexMagic && pHeader->nVersion == kIndexVersion
+        && pHeader->nFingerprint == nFingerprint
+        && nSize == static_cast<qint64>(sizeof(Header)) + pHeader->nFileCount * static_cast<qint64>(sizeof(FileRecord))
+            + pHeader->nFaceCount * static_cast<qint64>(sizeof(FaceRecord)) + pHeader->nStringBytes;
+    if (!bValid)
+    {
+        m_oIndexFile.close();
+        return false;
+    }
+
+    m_pData = pData;
+    m_nSize = nSize;
+    m_pHeader = pHeader;
+    m_pFiles = reinterpret_cast<const FileRecord*>(pData + sizeof(Header));
+    m_pFaces = reinterpret_cast<const FaceRecord*>(m_pFiles + pHeader->nFileCount);
+    m_pStrings = reinterpret_cast<const char*>(m_pFaces + pHeader->nFaceCount);
+
+    m_hashFamilies.clear();
+    for (quint32 i = 0; i < pHeader->nFaceCount; ++i)
+    {
+        const FaceRecord& record = m_pFaces[i];
+        m_hashFamilies[string(record.nFamilyKeyOffset, record.nFamilyKeyLength)] << static_cast<int>(i);
+        const QByteArray postScriptKey = string(record.nPostScriptKeyOffset, record.nPostScriptKeyLength);
+        if (!postScriptKey.isEmpty())
+        {
+            m_hashFamilies[postScriptKey] << static_cast<int>(i);
+        }
+    }
+    return true;
+}
+
+const SystemFontIndex::FaceRecord* SystemFontIndex::face(void* hFont) const
+{
+    const quintptr nHandle = reinterpret_cast<quintptr>(hFont);
+    if (!m_pHeader || nHandle == 0 || nHandle > m_pHeader->nFaceCount)
+    {
+        return nullptr;
+    }
+    return m_pFaces + (nHandle - 1);
+}
+
+QByteArray SystemFontIndex::string(const quint32 nOffset, const quint32 nLength) const
+{
+    if (static_cast<qint64>(nOffset) + nLength > m_pHeader->nStringBytes)
+    {
+        return QByteArray();
+    }
+    return QByteArray::fromRawData(m_pStrings + nOffset, static_cast<int>(nLength));
+}
+
+/*!
+ * @brief 只读映射字体文件，同一文件只映射一次。
+ *
+ * 文件大小或修改时间与索引不符时（例如字体被原地替换）不提供该字体。
+ */
+const uchar* SystemFontIndex::fontFile(const quint32 nFile, qint64* pSize)
+{
+    if (nFile >= m_pHeader->nFileCount)
+    {
+        return nullptr;
+    }
+    const FileRecord& record = m_pFiles[nFile];
+    const uchar* pData = m_hashFontData.value(nFile);
+    if (!pData)
+    {
+        const std::shared_ptr<QFile> pFile = std::make_shared<QFile>(
+            QString::fromUtf8(string(record.nPathOffset, record.nPathLength)));
+        const QFileInfo info(*pFile);
+        if (info.size() != record.nSize || info.lastModified().toMSecsSinceEpoch() != record.nModified
+            || !pFile->open(QIODevice::ReadOnly))
+        {
+            return nullptr;
+        }
+        pData = pFile->map(0, record.nSize);
+        if (!pData)
+        {
+            return nullptr;
+        }
+        m_hashFontFiles.insert(nFile, pFile);
+        m_hashFontData.insert(nFile, pData);
+    }
+    *pSize = record.nSize;
+    return pData;
+}
+
+// 越小越接近请求的样式
+int SystemFontIndex::score(const FaceRecord& record, const int nWeight, const bool bItalic, const int nPitchFamily) const
+{
+    int nScore = std::abs(static_cast<int>(record.nWeight) - nWeight);
+    if ((record.nItalic != 0) != bItalic)
+    {
+        nScore += 300;
+    }
+    if (((record.nPitchFamily ^ nPitchFamily) & FXFONT_FF_FIXEDPITCH) != 0)
+    {
+        nScore += 200;
+    }
+    if (((record.nPitchFamily ^ nPitchFamily) & FXFONT_FF_ROMAN) != 0)
+    {
+        nScore += 50;
+    }
+    return nScore;
+}
+
+void SystemFontIndex::enumFonts(void* pMapper) const
+{
+    if (!m_pHeader)
+    {
+        return;
+    }
+    for (quint32 i = 0; i < m_pHeader->nFaceCount; ++i)
+    {
+        const FaceRecord& record = m_pFaces[i];
+        const QByteArray family(string(record.nFamilyOffset, record.nFamilyLength).constData(),
+            static_cast<int>(record.nFamilyLength));
+        for (int c = 0; c < kCharsetCount; ++c)
+        {
+            if (record.nCharsetMask & (1u << c))
+            {
+                FPDF_AddInstalledFont(pMapper, family.constData(), kCharsets[c].nCharset);
+            }
+        }
+    }
+}
+
+/*!
+ * @brief 按名称、字符集和样式选择字体。
+ *
+ * 先按规范化名称精确匹配家族名或 PostScript 名，再尝试请求名称的最长前缀（"ArialMT"、"Arial,Bold"
+ * 都能匹配 Arial）；名称不匹配时，非西文字符集退回到支持该字符集、样式最接近的字体，
+ * 西文与符号字符集返回空，交给 PDFium 的内置标准字体。
+ */
+void* SystemFontIndex::mapFont(int nWeight, const bool bItalic, const int nCharset, const int nPitchFamily,
+    const char* pFace, bool* pExact) const
+{
+    *pExact = false;
+    if (!m_pHeader)
+    {
+        return nullptr;
+    }
+    if (nWeight <= 0)
+    {
+        nWeight = FXFONT_FW_NORMAL;
+    }
+    const int nBit = charsetBit(nCharset);
+    const quint32 nCharsetMask = nBit >= 0 ? (1u << nBit) : 0;
+    const bool bLatin = nCharset == FXFONT_ANSI_CHARSET || nCharset == FXFONT_DEFAULT_CHARSET
+        || nCharset == FXFONT_SYMBOL_CHARSET;
+
+    const QByteArray key = normalizedKey(QByteArray(pFace ? pFace : ""));
+    for (int nLength = key.size(); nLength >= 3; --nLength)
+    {
+        const QHash<QByteArray, QVector<int>>::const_iterator it = m_hashFamilies.constFind(key.left(nLength));
+        if (it == m_hashFamilies.constEnd())
+        {
+            continue;
+        }
+
+        int nBest = -1;
+        int nBestScore = 0;
+        for (int i = 0; i < it.value().size(); ++i)
+        {
+            const FaceRecord& record = m_pFaces[it.value()[i]];
+            if (!bLatin && nCharsetMask != 0 && !(record.nCharsetMask & nCharsetMask))
+            {
+                continue;
+            }
+            const int nScore = score(record, nWeight, bItalic, nPitchFamily);
+            if (nBest < 0 || nScore < nBestScore)
+            {
+                nBest = it.value()[i];
+                nBestScore = nScore;
+            }
+        }
+        if (nBest >= 0)
+        {
+            *pExact = nLength == key.size();
+            return faceHandle(nBest);
+        }
+    }
+
+    if (bLatin || nCharsetMask == 0)
+    {
+        return nullptr;
+    }
+    int nBest = -1;
+    int nBestScore = 0;
+    for (quint32 i = 0; i < m_pHeader->nFaceCount; ++i)
+    {
+        if (!(m_pFaces[i].nCharsetMask & nCharsetMask))
+        {
+            continue;
+        }
+        const int nScore = score(m_pFaces[i], nWeight, bItalic, nPitchFamily);
+        if (nBest < 0 || nScore < nBestScore)
+        {
+            nBest = static_cast<int>(i);
+            nBestScore = nScore;
+        }
+    }
+    return nBest >= 0 ? faceHandle(nBest) : nullptr;
+}
+
+void* SystemFontIndex::getFont(const char* pFace) const
+{
+    if (!m_pHeader || !pFace)
+    {
+        return nullptr;
+    }
+    const QVector<int> vecFaces = m_hashFamilies.value(normalizedKey(QByteArray(pFace)));
+    int nBest = -1;
+    int nBestScore = 0;
+    for (int i = 0; i < vecFaces.size(); ++i)
+    {
+        const int nScore = score(m_pFaces[vecFaces[i]], FXFONT_FW_NORMAL, false, 0);
+        if (nBest < 0 || nScore < nBestScore)
+        {
+            nBest = vecFaces[i];
+            nBestScore = nScore;
+        }
+    }
+    return nBest >= 0 ? faceHandle(nBest) : nullptr;
+}
+
+/*!
+ * @brief 返回字体数据。
+ *
+ * 与 PDFium 自带的目录字体实现约定一致：普通字体的 table 0 为整个文件；TTC 中的字体以 'ttcf' 返回
+ * 整个集合文件，table 0 返回从该字体表目录到文件末尾的长度，PDFium 用两者之差定位集合中的字体。
+ */
+unsigned long SystemFontIndex::getFontData(void* hFont, const unsigned int nTable, unsigned char* pBuffer,
+    const unsigned long nSize)
+{
+    const FaceRecord* pRecord = face(hFont);
+    if (!pRecord)
+    {
+        return 0;
+    }
+    qint64 nFileSize = 0;
+    const uchar* pData = fontFile(pRecord->nFile, &nFileSize);
+    if (!pData)
+    {
+        return 0;
+    }
+
+    quint32 nOffset = 0;
+    quint32 nLength = 0;
+    if (nTable == 0)
+    {
+        nOffset = pRecord->nCollection ? pRecord->nFaceOffset : 0;
+        nLength = static_cast<quint32>(nFileSize - nOffset);
+    }
+    else if (nTable == kTagTtcf)
+    {
+        if (!pRecord->nCollection)
+        {
+            return 0;
+        }
+        nLength = static_cast<quint32>(nFileSize);
+    }
+    else if (!findTable(pData, nFileSize, pRecord->nFaceOffset, nTable, &nOffset, &nLength))
+    {
+        return 0;
+    }
+
+    if (pBuffer && nSize >= nLength)
+    {
+        std::memcpy(pBuffer, pData + nOffset, nLength);
+    }
+    return nLength;
+}
+
+// 返回值包含结尾的 NUL，与 PDFium 默认实现一致
+unsigned long SystemFontIndex::getFaceName(void* hFont, char* pBuffer, const unsigned long nSize) const
+{
+    const FaceRecord* pRecord = face(hFont);
+    if (!pRecord)
+    {
+        return 0;
+    }
+    const QByteArray family = string(pRecord->nFamilyOffset, pRecord->nFamilyLength);
+    const unsigned long nNeeded = static_cast<unsigned long>(family.size()) + 1;
+    if (pBuffer && nSize >= nNeeded)
+    {
+        std::memcpy(pBuffer, family.constData(), family.size());
+        pBuffer[family.size()] = '\0';
+    }
+    return nNeeded;
+}
+
+// 支持多个字符集时返回其中第一个
+int SystemFontIndex::getFontCharset(void* hFont) const
+{
+    const FaceRecord* pRecord = face(hFont);
+    if (!pRecord)
+    {
+        return FXFONT_DEFAULT_CHARSET;
+    }
+    for (int i = 0; i < kCharsetCount; ++i)
+    {
+        if (pRecord->nCharsetMask & (1u << i))
+        {
+            return kCharsets[i].nCharset;
+        }
+    }
+    return FXFONT_DEFAULT_CHARSET;
+}
@@ -0,0 +1,95 @@
+﻿/*!
+ * @brief 基于预建索引的系统字体提供者。
+ *
+ * PDFium 默认的字体查找在每个进程启动时扫描一遍系统字体目录并解析每个字体文件，非嵌入字体较多的
+ * 文档首次渲染明显变慢。`SystemFontIndex` 把扫描结果写成一个二进制索引文件，放在用户的公共缓存
+ * 目录中，以内存映射方式读取：
+ * - 索引记录每个字体（含 TTC 中的每个字形集合）的文件、家族名、字重、斜体、等宽/衬线以及支持的字符集；
+ * - 索引头保存字体目录树的指纹（各目录路径与修改时间），目录未变化时直接复用，变化时才重新扫描；
+ * - 字体文件同样以只读内存映射方式提供给 PDFium，同一文件的页面由操作系统在文档和进程之间共享。
+ *
+ * 通过 `FPDF_SetSystemFontInfo` 注册后，PDFium 的 `MapFont`/`GetFont`/`GetFontData` 查询都由索引应答。
+ * Windows 上 PDFium 使用 GDI 查找字体，不使用本索引。
+ *
+ * @author LiuYe
+ * @date 2026-10-19
+ * @copyright (c) 2013-2026 Honghu Yuntu Corporation
+ */
+
+#pragma once
+
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include <memory>
+
+#include "fpdf_sysfontinfo.h"
+
+/*!
+ * @brief 内存映射的系统字体索引，实现 FPDF_SYSFONTINFO，只在 PDFium 执行线程上使用。
+ *
+ * @date 2026.10.19
+ */
+class SystemFontIndex
+{
+public:
+    static SystemFontIndex& instance();
+
+    // 打开索引，字体目录有变化或索引无效时重建；返回索引是否可用
+    bool open();
+
+    bool isOpen() const
+    {
+        return m_pHeader != nullptr;
+    }
+
+    int faceCount() const;
+
+    // 注册给 FPDF_SetSystemFontInfo 的接口，生命周期与进程相同
+    FPDF_SYSFONTINFO* fontInfo();
+
+    static QString indexPath();
+    static QStringList fontDirectories();
+
+    // FPDF_SYSFONTINFO 回调的实现
+    void enumFonts(void* pMapper) const;
+    void* mapFont(int nWeight, bool bItalic, int nCharset, int nPitchFamily, const char* pFace, bool* pExact) const;
+    void* getFont(const char* pFace) const;
+    unsigned long getFontData(void* hFont, unsigned int nTable, unsigned char* pBuffer, unsigned long nSize);
+    unsigned long getFaceName(void* hFont, char* pBuffer, unsigned long nSize) const;
+    int getFontCharset(void* hFont) const;
+
+private:
+    struct Header;
+    struct FileRecord;
+    struct FaceRecord;
+
+    SystemFontIndex();
+    SystemFontIndex(const SystemFontIndex&);
+    SystemFontIndex& operator=(const SystemFontIndex&);
+
+    static quint64 directoryFingerprint(const QStringList& lstDirectories);
+    static bool build(const QString& strPath, const QStringList& lstDirectories, quint64 nFingerprint);
+
+    bool mapIndex(const QString& strPath, quint64 nFingerprint);
+    const FaceRecord* face(void* hFont) const;
+    QByteArray string(quint32 nOffset, quint32 nLength) const;
+    const uchar* fontFile(quint32 nFile, qint64* pSize);
+    int score(const FaceRecord& face, int nWeight, bool bItalic, int nPitchFamily) const;
+
+    QFile m_oIndexFile;
+    const uchar* m_pData;
+    qint64 m_nSize;
+    const Header* m_pHeader;
+    const FileRecord* m_pFiles;
+    const FaceRecord* m_pFaces;
+    const char* m_pStrings;
+    QHash<QByteArray, QVector<int>> m_hashFamilies;   // 规范化家族名 -> 字体下标
+    QHash<quint32, std::shared_ptr<QFile>> m_hashFontFiles; // 已映射的字体文件
+    QHash<quint32, const uchar*> m_hashFontData;           // 字体文件的映射地址
+    FPDF_SYSFONTINFO* m_pFontInfo;
+};
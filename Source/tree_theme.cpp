@@ -0,0 +1,318 @@
+﻿/*!
+ * @brief 注释树的原生主题的实现。
+ *
+ * @author LiuYe
+ * @date 2026-10-19
+ * @copyright (c) 2013-2026 Honghu Yuntu Corporation
+ */
+
+#include "tree_theme.h"
+
+#include <QApplication>
+#include <QPainter>
+#include <QScrollBar>
+#include <QStyleOption>
+#include <QTreeView>
+
+#include <algorithm>
+
+namespace
+{
+    // 颜色取自原样式表 styles.qss
+    const QRgb kBaseColor = qRgb(46, 46, 46);
+    const QRgb kTextColor = qRgb(225, 225, 225);
+    const QRgb kBorderColor = qRgb(66, 66, 66);
+    const QRgb kHoverColor = qRgb(62, 62, 62);
+    const QRgb kSelectedColor = qRgb(0x2E, 0x50, 0x84);
+    const QRgb kSelectedTextColor = qRgb(255, 255, 255);
+    const QRgb kGroupColor = qRgb(160, 160, 164);    // Qt::gray
+    const QRgb kGroupTextColor = qRgb(20, 20, 20);   // 浅色文本在灰色分组行上对比度不足
+    const QRgb kBranchHoverColor = qRgb(90, 140, 215);
+    const QRgb kScrollGrooveColor = qRgba(50, 50, 50, 200);
+    const QRgb kScrollHandleColor = qRgb(150, 150, 150);
+    const QRgb kScrollHandleHoverColor = qRgb(180, 180, 180);
+    const QRgb kScrollHandlePressedColor = qRgb(210, 210, 210);
+
+    const int kTreeFontPointSize = 16;
+    const int kBranchArrowSize = 8;
+
+    // 垂直滚动条宽 13 像素，右侧留 3 像素空白；水平滚动条高 10 像素
+    const int kVerticalScrollBarExtent = 13;
+    const int kVerticalScrollBarMargin = 3;
+    const int kHorizontalScrollBarExtent = 10;
+    const int kScrollHandleRadius = 5;
+    const int kScrollHandleMinLength = 20;
+}
+
+TreeItemDelegate::TreeItemDelegate(QObject* pParent)
+    : QStyledItemDelegate(pParent)
+{
+}
+
+/*!
+ * @brief 绘制一个单元格。
+ *
+ * 逐项数据由 initStyleOption() 读入选项，分组行补上默认的背景与文本颜色后交给样式绘制。
+ */
+void TreeItemDelegate::paint(QPainter* pPainter, const QStyleOptionViewItem& option, const QModelIndex& index) const
+{
+    QStyleOptionViewItem opt(option);
+    initStyleOption(&opt, index);
+
+    // 顶层节点为注释分组
+    if (!index.parent().isValid())
+    {
+        if (opt.backgroundBrush.style() == Qt::NoBrush)
+        {
+            opt.backgroundBrush = QColor(kGroupColor);
+        }
+        // 悬停时背景取悬停色，文本保持浅色
+        if (!(opt.state & QStyle::State_MouseOver) && !index.data(Qt::ForegroundRole).isValid())
+        {
+            opt.palette.setColor(QPalette::Text, QColor(kGroupTextColor));
+        }
+    }
+
+    const QWidget* pWidget = opt.widget;
+    QStyle* pStyle = pWidget ? pWidget->style() : QApplication::style();
+    pStyle->drawControl(QStyle::CE_ItemViewItem, &opt, pPainter, pWidget);
+}
+
+TreeProxyStyle::TreeProxyStyle()
+    : QProxyStyle()
+{
+}
+
+int TreeProxyStyle::pixelMetric(const PixelMetric eMetric, const QStyleOption* pOption, const QWidget* pWidget) const
+{
+    switch (eMetric)
+    {
+    case PM_ScrollBarExtent:
+    {
+        const QStyleOptionSlider* pSlider = qstyleoption_cast<const QStyleOptionSlider*>(pOption);
+        return pSlider && pSlider->orientation == Qt::Horizontal ? kHorizontalScrollBarExtent
+            : kVerticalScrollBarExtent;
+    }
+    case PM_ScrollBarSliderMin:
+        return kScrollHandleMinLength;
+    case PM_DefaultFrameWidth:
+        return 1;
+    default:
+        return QProxyStyle::pixelMetric(eMetric, pOption, pWidget);
+    }
+}
+
+void TreeProxyStyle::polish(QWidget* pWidget)
+{
+    QProxyStyle::polish(pWidget);
+    // 滑块的悬停颜色依赖悬停事件
+    if (qobject_cast<QScrollBar*>(pWidget))
+    {
+        pWidget->setAttribute(Qt::WA_Hover, true);
+    }
+}
+
+void TreeProxyStyle::drawPrimitive(const PrimitiveElement eElement, const QStyleOption* pOption, QPainter* pPainter,
+    const QWidget* pWidget) const
+{
+    switch (eElement)
+    {
+    case PE_PanelItemViewRow:
+        // 行背景按单元格绘制，分支区域保持底色
+        return;
+    case PE_PanelItemViewItem:
+    {
+        const QStyleOptionViewItem* pItem = qstyleoption_cast<const QStyleOptionViewItem*>(pOption);
+        if (!pItem)
+        {
+            break;
+        }
+        if (pItem->state & State_Selected)
+        {
+            pPainter->fillRect(pItem->rect, pItem->palette.brush(QPalette::Highlight));
+        }
+        else if (pItem->state & State_MouseOver)
+        {
+            pPainter->fillRect(pItem->rect, QColor(kHoverColor));
+        }
+        else if (pItem->backgroundBrush.style() != Qt::NoBrush)
+        {
+            pPainter->fillRect(pItem->rect, pItem->backgroundBrush);
+        }
+        return;
+    }
+    case PE_IndicatorBranch:
+    {
+        if (!(pOption->state & State_Children))
+        {
+            return;
+        }
+        // 折叠时箭头向右，展开时向下；所在行悬停时换色
+        const QPointF center = QRectF(pOption->rect).center();
+        const qreal dHalf = kBranchArrowSize / 2.0;
+        QPolygonF arrow;
+        if (pOption->state & State_Open)
+        {
+            arrow << QPointF(center.x() - dHalf, center.y() - dHalf / 2)
+                << QPointF(center.x() + dHalf, center.y() - dHalf / 2)
+                << QPointF(center.x(), center.y() + dHalf / 2);
+        }
+        else
+        {
+            arrow << QPointF(center.x() - dHalf / 2, center.y() - dHalf)
+                << QPointF(center.x() + dHalf / 2, center.y())
+                << QPointF(center.x() - dHalf / 2, center.y() + dHalf);
+        }
+        pPainter->save();
+        pPainter->setRenderHint(QPainter::Antialiasing, true);
+        pPainter->setPen(Qt::NoPen);
+        pPainter->setBrush(QColor(pOption->state & State_MouseOver ? kBranchHoverColor : kTextColor));
+        pPainter->drawPolygon(arrow);
+        pPainter->restore();
+        return;
+    }
+    default:
+        break;
+    }
+    QProxyStyle::drawPrimitive(eElement, pOption, pPainter, pWidget);
+}
+
+void TreeProxyStyle::drawControl(const ControlElement eElement, const QStyleOption* pOption, QPainter* pPainter,
+    const QWidget* pWidget) const
+{
+    if (eElement == CE_ShapedFrame)
+    {
+        // 1 像素边框
+        pPainter->save();
+        pPainter->setPen(QColor(kBorderColor));
+        pPainter->setBrush(Qt::NoBrush);
+        pPainter->drawRect(pOption->rect.adjusted(0, 0, -1, -1));
+        pPainter->restore();
+        return;
+    }
+    if (eElement == CE_ItemViewItem)
+    {
+        // 平台样式（如 Windows Vista）以自己的选中效果绘制单元格，这里统一按 QCommonStyle 布局：
+        // 背景、勾选框与焦点框经 proxy() 回到本样式，文本按选项中的字体、颜色与对齐方式绘制
+        QCommonStyle::drawControl(eElement, pOption, pPainter, pWidget);
+        return;
+    }
+    QProxyStyle::drawControl(eElement, pOption, pPainter, pWidget);
+}
+
+void TreeProxyStyle::drawComplexControl(const ComplexControl eControl, const QStyleOptionComplex* pOption,
+    QPainter* pPainter, const QWidget* pWidget) const
+{
+    const QStyleOptionSlider* pSlider = qstyleoption_cast<const QStyleOptionSlider*>(pOption);
+    if (eControl != CC_ScrollBar || !pSlider)
+    {
+        QProxyStyle::drawComplexControl(eControl, pOption, pPainter, pWidget);
+        return;
+    }
+
+    pPainter->fillRect(subControlRect(eControl, pOption, SC_ScrollBarGroove, pWidget), QColor(kScrollGrooveColor));
+
+    QRgb handleColor = kScrollHandleColor;
+    if (pSlider->activeSubControls & SC_ScrollBarSlider)
+    {
+        if (pSlider->state & State_Sunken)
+        {
+            handleColor = kScrollHandlePressedColor;
+        }
+        else if (pSlider->state & State_MouseOver)
+        {
+            handleColor = kScrollHandleHoverColor;
+        }
+    }
+    pPainter->save();
+    pPainter->setRenderHint(QPainter::Antialiasing, true);
+    pPainter->setPen(Qt::NoPen);
+    pPainter->setBrush(QColor(handleColor));
+    pPainter->drawRoundedRect(subControlRect(eControl, pOption, SC_ScrollBarSlider, pWidget), kScrollHandleRadius,
+        kScrollHandleRadius);
+    pPainter->restore();
+}
+
+/*!
+ * @brief 滚动条各部分的位置。
+ *
+ * 没有箭头按钮，滑槽占满滚动条（垂直滚动条除去右侧空白）；点击与拖动的命中测试也按这里的结果进行。
+ */
+QRect TreeProxyStyle::subControlRect(const ComplexControl eControl, const QStyleOptionComplex* pOption,
+    const SubControl eSubControl, const QWidget* pWidget) const
+{
+    const QStyleOptionSlider* pSlider = qstyleoption_cast<const QStyleOptionSlider*>(pOption);
+    if (eControl != CC_ScrollBar || !pSlider)
+    {
+        return QProxyStyle::subControlRect(eControl, pOption, eSubControl, pWidget);
+    }
+
+    const bool bHorizontal = pSlider->orientation == Qt::Horizontal;
+    const QRect groove = bHorizontal ? pSlider->rect : pSlider->rect.adjusted(0, 0, -kVerticalScrollBarMargin, 0);
+    const int nGrooveLength = bHorizontal ? groove.width() : groove.height();
+    const qint64 nRange = static_cast<qint64>(pSlider->maximum) - pSlider->minimum;
+    int nHandleLength = nGrooveLength;
+    if (nRange > 0)
+    {
+        nHandleLength = static_cast<int>(static_cast<qint64>(nGrooveLength) * pSlider->pageStep
+            / (nRange + pSlider->pageStep));
+        nHandleLength = std::min(nGrooveLength, std::max(kScrollHandleMinLength, nHandleLength));
+    }
+    const int nHandleStart = sliderPositionFromValue(pSlider->minimum, pSlider->maximum, pSlider->sliderPosition,
+        nGrooveLength - nHandleLength, pSlider->upsideDown);
+
+    // 以滑块为界把滑槽分为前后两段
+    int nStart = 0;
+    int nLength = 0;
+    switch (eSubControl)
+    {
+    case SC_ScrollBarGroove:
+        return groove;
+    case SC_ScrollBarSlider:
+        nStart = nHandleStart;
+        nLength = nHandleLength;
+        break;
+    case SC_ScrollBarSubPage:
+        nLength = nHandleStart;
+        break;
+    case SC_ScrollBarAddPage:
+        nStart = nHandleStart + nHandleLength;
+        nLength = nGrooveLength - nStart;
+        break;
+    default:
+        return QRect();
+    }
+    const QRect rect = bHorizontal ? QRect(groove.x() + nStart, groove.y(), nLength, groove.height())
+        : QRect(groove.x(), groove.y() + nStart, groove.width(), nLength);
+    return visualRect(pSlider->direction, pSlider->rect, rect);
+}
+
+/*!
+ * @brief 设置树形控件的外观。
+ *
+ * 代理样式分别设置在控件与两个滚动条上（样式不会传递给子控件）。所有行高度相同，
+ * 视图不再逐行查询尺寸，十万行的树滚动时只计算可见行。
+ */
+void applyTreeTheme(QTreeView* pView)
+{
+    QPalette palette = pView->palette();
+    palette.setColor(QPalette::Base, QColor(kBaseColor));
+    palette.setColor(QPalette::Text, QColor(kTextColor));
+    palette.setColor(QPalette::Highlight, QColor(kSelectedColor));
+    palette.setColor(QPalette::HighlightedText, QColor(kSelectedTextColor));
+    pView->setPalette(palette);
+
+    QFont font = pView->font();
+    font.setPointSize(kTreeFontPointSize);
+    pView->setFont(font);
+
+    TreeProxyStyle* pStyle = new TreeProxyStyle;
+    pStyle->setParent(pView);
+    pView->setStyle(pStyle);
+    pView->verticalScrollBar()->setStyle(pStyle);
+    pView->horizontalScrollBar()->setStyle(pStyle);
+
+    pView->setItemDelegate(new TreeItemDelegate(pView));
+    pView->setUniformRowHeights(true);
+    pView->viewport()->setAttribute(Qt::WA_Hover, true);
+}